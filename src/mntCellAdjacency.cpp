@@ -0,0 +1,223 @@
+#include <mntCellAdjacency.h>
+#include <mntLineLineIntersector.h>
+#include <mntQuadPosition.h>
+#include <vtkPoints.h>
+#include <vtkIdList.h>
+#include <algorithm>
+
+/**
+ * Order point indices by coordinates, then by index
+ */
+struct NodeCoordCmpFunctor {
+    NodeCoordCmpFunctor(const std::vector<double>& coords) : xyz(coords) {}
+    bool operator()(size_t i, size_t j) const {
+        for (size_t d = 0; d < 3; ++d) {
+            if (this->xyz[3*i + d] < this->xyz[3*j + d]) return true;
+            if (this->xyz[3*i + d] > this->xyz[3*j + d]) return false;
+        }
+        return i < j;
+    }
+    const std::vector<double>& xyz;
+};
+
+/**
+ * A cell edge, identified by its (sorted) node Ids
+ */
+struct CellEdge_t {
+    vtkIdType n0;
+    vtkIdType n1;
+    vtkIdType cellId;
+    int edgeIndex;
+    bool operator<(const CellEdge_t& other) const {
+        if (this->n0 != other.n0) return this->n0 < other.n0;
+        if (this->n1 != other.n1) return this->n1 < other.n1;
+        if (this->cellId != other.cellId) return this->cellId < other.cellId;
+        return this->edgeIndex < other.edgeIndex;
+    }
+};
+
+
+CellAdjacency::CellAdjacency() {
+}
+
+
+void
+CellAdjacency::build(vtkUnstructuredGrid* grid, const std::vector<vtkIdType>& faceNodeConnectivity) {
+
+    size_t numCells = grid->GetNumberOfCells();
+
+    //
+    // node Id of each cell vertex
+    //
+
+    vtkIdType numNodes = 0;
+    this->nodeIds.resize(4*numCells);
+    if (faceNodeConnectivity.size() == 4*numCells) {
+        for (size_t i = 0; i < 4*numCells; ++i) {
+            this->nodeIds[i] = faceNodeConnectivity[i];
+            numNodes = std::max(numNodes, faceNodeConnectivity[i] + 1);
+        }
+    }
+    else {
+        // points with the same coordinates are the same node
+        vtkIdList* ptIds = vtkIdList::New();
+        std::vector<double> coords(3*4*numCells);
+        for (size_t cellId = 0; cellId < numCells; ++cellId) {
+            grid->GetCellPoints(cellId, ptIds);
+            for (int i = 0; i < 4; ++i) {
+                grid->GetPoint(ptIds->GetId(i), &coords[3*(4*cellId + i)]);
+            }
+        }
+        ptIds->Delete();
+
+        std::vector<size_t> order(4*numCells);
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), NodeCoordCmpFunctor(coords));
+
+        size_t prev = 0;
+        for (size_t k = 0; k < order.size(); ++k) {
+            size_t i = order[k];
+            if (k == 0 ||
+                coords[3*i + 0] != coords[3*prev + 0] ||
+                coords[3*i + 1] != coords[3*prev + 1] ||
+                coords[3*i + 2] != coords[3*prev + 2]) {
+                numNodes++;
+                prev = i;
+            }
+            this->nodeIds[i] = numNodes - 1;
+        }
+    }
+
+    //
+    // cells sharing each node
+    //
+
+    this->nodeCellPtr.assign(numNodes + 1, 0);
+    for (size_t i = 0; i < 4*numCells; ++i) {
+        this->nodeCellPtr[this->nodeIds[i] + 1]++;
+    }
+    for (vtkIdType n = 0; n < numNodes; ++n) {
+        this->nodeCellPtr[n + 1] += this->nodeCellPtr[n];
+    }
+    this->nodeCellIds.resize(4*numCells);
+    std::vector<size_t> next(this->nodeCellPtr.begin(), this->nodeCellPtr.end() - 1);
+    for (size_t i = 0; i < 4*numCells; ++i) {
+        this->nodeCellIds[next[this->nodeIds[i]]++] = i / 4;
+    }
+
+    //
+    // cell across each edge: the edges with the same node Ids are adjacent once sorted
+    //
+
+    std::vector<CellEdge_t> edges;
+    edges.reserve(4*numCells);
+    for (size_t cellId = 0; cellId < numCells; ++cellId) {
+        for (int e = 0; e < 4; ++e) {
+            int i0, i1;
+            LineQuadEdgesIntersector::getCellPointIds(e, &i0, &i1);
+            vtkIdType n0 = this->nodeIds[4*cellId + i0];
+            vtkIdType n1 = this->nodeIds[4*cellId + i1];
+            if (n0 == n1) {
+                // degenerate edge (e.g. at a pole)
+                continue;
+            }
+            CellEdge_t edge;
+            edge.n0 = std::min(n0, n1);
+            edge.n1 = std::max(n0, n1);
+            edge.cellId = cellId;
+            edge.edgeIndex = e;
+            edges.push_back(edge);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    this->edgeNeighbours.assign(4*numCells, -1);
+    size_t beg = 0;
+    while (beg < edges.size()) {
+        size_t end = beg + 1;
+        while (end < edges.size() && edges[end].n0 == edges[beg].n0 && edges[end].n1 == edges[beg].n1) {
+            end++;
+        }
+        // only manifold edges, shared by exactly two cells, have a neighbour
+        if (end - beg == 2) {
+            const CellEdge_t& ea = edges[beg];
+            const CellEdge_t& eb = edges[beg + 1];
+            this->edgeNeighbours[4*ea.cellId + ea.edgeIndex] = eb.cellId;
+            this->edgeNeighbours[4*eb.cellId + eb.edgeIndex] = ea.cellId;
+        }
+        beg = end;
+    }
+}
+
+
+// max number of cells sharing a node with a cell
+static const size_t MAX_NODE_NEIGHBOURS = 64;
+
+size_t
+CellAdjacency::__getNodeNeighbours(vtkIdType cellId, vtkIdType cellIds[]) const {
+    size_t n = 0;
+    for (int i = 0; i < 4; ++i) {
+        const vtkIdType* nodeCellIds;
+        size_t numNodeCells = this->getNodeCells(this->getNodeId(cellId, i), &nodeCellIds);
+        if (n + numNodeCells > MAX_NODE_NEIGHBOURS) {
+            return 0;
+        }
+        for (size_t k = 0; k < numNodeCells; ++k) {
+            cellIds[n++] = nodeCellIds[k];
+        }
+    }
+    std::sort(cellIds, cellIds + n);
+    return std::unique(cellIds, cellIds + n) - cellIds;
+}
+
+
+vtkIdType
+CellAdjacency::__findInCells(vtkDataSet* grid, double x[], const vtkIdType cellIds[], size_t n,
+                             vtkGenericCell* cell, double pcoords[], double weights[]) const {
+    double bounds[6];
+    for (size_t k = 0; k < n; ++k) {
+        grid->GetCellBounds(cellIds[k], bounds);
+        if (x[0] < bounds[0] || x[0] > bounds[1] || 
+            x[1] < bounds[2] || x[1] > bounds[3] ||
+            x[2] < bounds[4] || x[2] > bounds[5]) {
+            continue;
+        }
+        grid->GetCell(cellIds[k], cell);
+        if (mntCellEvaluatePosition(cell, x, pcoords, weights) == 1) {
+            return cellIds[k];
+        }
+    }
+    return -1;
+}
+
+
+vtkIdType
+CellAdjacency::findCell(LocatorQuery& locQuery, double x[], double tol2,
+                        vtkIdType hintCellId, vtkGenericCell* cell,
+                        double pcoords[], double weights[]) const {
+
+    vtkIdType cellId = -1;
+    vtkIdType cellIds[MAX_NODE_NEIGHBOURS];
+    vtkDataSet* grid = locQuery.getLocator()->GetDataSet();
+
+    if (hintCellId >= 0 && (size_t) hintCellId < this->getNumberOfCells()) {
+
+        // lowest cell Id around the hint
+        size_t n = this->__getNodeNeighbours(hintCellId, cellIds);
+        cellId = this->__findInCells(grid, x, cellIds, n, cell, pcoords, weights);
+
+        if (cellId >= 0 && cellId != hintCellId) {
+            // the cells containing the point all share a node with cellId, some of 
+            // them may not touch the hint cell
+            n = this->__getNodeNeighbours(cellId, cellIds);
+            cellId = this->__findInCells(grid, x, cellIds, n, cell, pcoords, weights);
+        }
+    }
+
+    if (cellId < 0) {
+        cellId = locQuery.findCell(x, tol2, cell, pcoords, weights);
+    }
+    return cellId;
+}
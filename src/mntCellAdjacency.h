@@ -0,0 +1,121 @@
+#include <vector>
+#include <vtkUnstructuredGrid.h>
+#include <mntLocatorQuery.h>
+#include <vtkGenericCell.h>
+
+#ifndef MNT_CELL_ADJACENCY
+#define MNT_CELL_ADJACENCY
+
+/**
+ * Neighbour tables of a quad grid: the cell across each cell edge and the cells
+ * sharing each node. Edges are numbered as in QuadEdgeIter.
+ */
+class CellAdjacency {
+
+public:
+
+    /**
+     * Constructor
+     */
+    CellAdjacency();
+
+    /**
+     * Build the tables
+     * @param grid quad grid
+     * @param faceNodeConnectivity flat array of node Ids, 4 per cell (e.g. from a UGRID
+     *                             file). If empty, the node Ids are derived from the
+     *                             grid point coordinates.
+     */
+    void build(vtkUnstructuredGrid* grid, const std::vector<vtkIdType>& faceNodeConnectivity);
+
+    /**
+     * Get the number of cells
+     * @return number
+     */
+    size_t getNumberOfCells() const {
+        return this->edgeNeighbours.size() / 4;
+    }
+
+    /**
+     * Get the cell across an edge
+     * @param cellId cell Id
+     * @param edgeIndex edge index in the range 0...3
+     * @return cell Id, negative if the edge is on the boundary
+     */
+    vtkIdType getEdgeNeighbour(vtkIdType cellId, int edgeIndex) const {
+        return this->edgeNeighbours[4*cellId + edgeIndex];
+    }
+
+    /**
+     * Get the node Id of a cell vertex
+     * @param cellId cell Id
+     * @param vertexIndex vertex index in the range 0...3
+     * @return node Id
+     */
+    vtkIdType getNodeId(vtkIdType cellId, int vertexIndex) const {
+        return this->nodeIds[4*cellId + vertexIndex];
+    }
+
+    /**
+     * Get the cells sharing a node
+     * @param nodeId node Id
+     * @param cellIds pointer to the cell Ids (output)
+     * @return number of cells
+     */
+    size_t getNodeCells(vtkIdType nodeId, const vtkIdType** cellIds) const {
+        size_t beg = this->nodeCellPtr[nodeId];
+        *cellIds = &this->nodeCellIds[beg];
+        return this->nodeCellPtr[nodeId + 1] - beg;
+    }
+
+    /**
+     * Find the cell containing a point, starting from a nearby cell
+     * @param locQuery searches the cell locator attached to the grid, used if the point
+     *                 is not in or around the hint cell (one per thread)
+     * @param x point
+     * @param tol2 tolerance passed to the locator
+     * @param hintCellId cell expected to contain or touch the point, ignored if negative
+     * @param cell work object (one per thread)
+     * @param pcoords parametric coordinates in the cell (output)
+     * @param weights interpolation weights (output)
+     * @return cell Id, negative if the point is outside the grid
+     * @note the hint cell and the cells sharing a node with it are tested in increasing 
+     *       cell Id order with the same bounds and inside tests (mntCellEvaluatePosition)
+     *       as the mvtkCellLocator and mvtkCellLocator2d buckets, so that the cell returned
+     *       is the same as these locators'. Other locators may return another cell for a 
+     *       point on a shared edge, or other parametric coordinates (vtkCellLocator). 
+     *       This method does not modify the tables and can be called concurrently.
+     */
+    vtkIdType findCell(LocatorQuery& locQuery, double x[], double tol2,
+                       vtkIdType hintCellId, vtkGenericCell* cell,
+                       double pcoords[], double weights[]) const;
+
+private:
+
+    /**
+     * Get the cells sharing a node with a cell, including the cell itself
+     * @param cellId cell Id
+     * @param cellIds array of capacity MAX_NODE_NEIGHBOURS, sorted in increasing order (output)
+     * @return number of cells, 0 if there are too many
+     */
+    size_t __getNodeNeighbours(vtkIdType cellId, vtkIdType cellIds[]) const;
+
+    /**
+     * Find the first cell containing a point in a list
+     * @return cell Id, negative if none of the cells contain the point
+     */
+    vtkIdType __findInCells(vtkDataSet* grid, double x[], const vtkIdType cellIds[], size_t n,
+                            vtkGenericCell* cell, double pcoords[], double weights[]) const;
+
+    // node Id of each cell vertex, 4 per cell
+    std::vector<vtkIdType> nodeIds;
+
+    // cell across each cell edge, 4 per cell, -1 on the boundary
+    std::vector<vtkIdType> edgeNeighbours;
+
+    // cells sharing each node, compressed sparse row format
+    std::vector<size_t> nodeCellPtr;
+    std::vector<vtkIdType> nodeCellIds;
+};
+
+#endif // MNT_CELL_ADJACENCY
@@ -1,4 +1,8 @@
 #include <mntCellLocator.h>
+#include <mntParallel.h>
+#include <mntLocatorFile.h>
+#include <mntLocatorFactory.h>
+#include <mntLocatorQuery.h>
 #include <limits>
 #include <cstring>
 #include <string>
@@ -9,6 +13,8 @@ int mnt_celllocator_new(CellLocator_t** self) {
     mnt_grid_new(&(*self)->gridt);
     (*self)->loc = vtkCellLocator::New();
     (*self)->cell = vtkGenericCell::New();
+    (*self)->numThreads = 1;
+    (*self)->adjacency = NULL;
     return 0;
 }
 
@@ -29,6 +35,7 @@ extern "C"
 int mnt_celllocator_del(CellLocator_t** self) {
     (*self)->cell->Delete();
     (*self)->loc->Delete();
+    delete (*self)->adjacency;
     mnt_grid_del(&(*self)->gridt);
     delete *self;
     return 0;
@@ -41,6 +48,37 @@ int mnt_celllocator_setPointsPtr(CellLocator_t** self, int nVertsPerCell, size_t
     return ier;
 }
 
+extern "C"
+int mnt_celllocator_setNumberOfThreads(CellLocator_t** self, int numThreads) {
+    if (numThreads < 1) {
+        std::cerr << "mnt_celllocator_setNumberOfThreads: ERROR number of threads must be >= 1 (got "
+                  << numThreads << ")\n";
+        return 1;
+    }
+    (*self)->numThreads = numThreads;
+    return 0;
+}
+
+extern "C"
+int mnt_celllocator_setLocatorCacheFile(CellLocator_t** self, const char* fort_filename, size_t n) {
+    // Fortran strings don't come with null-termination character
+    (*self)->locCacheFile = std::string(fort_filename, n);
+    return 0;
+}
+
+extern "C"
+int mnt_celllocator_setLocatorType(CellLocator_t** self, const char* fort_name, size_t n) {
+    // Fortran strings don't come with null-termination character
+    std::string name(fort_name, n);
+    if (!LocatorFactory::isValid(name)) {
+        std::cerr << "mnt_celllocator_setLocatorType: ERROR unknown locator \"" << name
+                  << "\", valid names are " << LocatorFactory::getNames() << '\n';
+        return 1;
+    }
+    (*self)->locType = name;
+    return 0;
+}
+
 extern "C"
 int mnt_celllocator_build(CellLocator_t** self, int num_cells_per_bucket) {
 
@@ -48,10 +86,62 @@ int mnt_celllocator_build(CellLocator_t** self, int num_cells_per_bucket) {
     vtkUnstructuredGrid* grd;
     mnt_grid_get(&(*self)->gridt, &grd);
 
-    // build the locator
-    (*self)->loc->SetNumberOfCellsPerBucket(num_cells_per_bucket);
-    (*self)->loc->SetDataSet(grd);
-    (*self)->loc->BuildLocator();
+    // the neighbour tables refer to the previous grid
+    delete (*self)->adjacency;
+    (*self)->adjacency = NULL;
+
+    std::string locType = (*self)->locType;
+    if (locType.empty()) {
+        locType = LocatorFactory::getDefaultName(grd, !(*self)->locCacheFile.empty());
+    }
+    vtkAbstractCellLocator* loc = LocatorFactory::createCached(locType, grd, num_cells_per_bucket,
+                                                               (*self)->locCacheFile,
+                                                               (*self)->numThreads);
+    if (!loc) {
+        std::cerr << "mnt_celllocator_build: ERROR could not build the locator\n";
+        return 1;
+    }
+    (*self)->loc->Delete();
+    (*self)->loc = loc;
+
+    return 0;
+}
+
+extern "C"
+int mnt_celllocator_saveLocator(CellLocator_t** self, const char* fort_filename, size_t n) {
+    std::string filename = std::string(fort_filename, n);
+    if (LocatorFile::save((*self)->loc, filename.c_str()) != 0) {
+        std::cerr << "mnt_celllocator_saveLocator: ERROR could not save the locator in "
+                  << filename << '\n';
+        return 1;
+    }
+    return 0;
+}
+
+extern "C"
+int mnt_celllocator_loadLocator(CellLocator_t** self, const char* fort_filename, size_t n) {
+
+    std::string filename = std::string(fort_filename, n);
+    vtkUnstructuredGrid* grd;
+    mnt_grid_get(&(*self)->gridt, &grd);
+    if (!grd) {
+        std::cerr << "mnt_celllocator_loadLocator: ERROR must set the grid first\n";
+        return 1;
+    }
+
+    vtkAbstractCellLocator* loc = LocatorFile::load(filename.c_str(), grd);
+    if (!loc) {
+        std::cerr << "mnt_celllocator_loadLocator: ERROR could not load a locator of this grid from "
+                  << filename << '\n';
+        return 2;
+    }
+
+    // the neighbour tables refer to the previous grid
+    delete (*self)->adjacency;
+    (*self)->adjacency = NULL;
+
+    (*self)->loc->Delete();
+    (*self)->loc = loc;
 
     return 0;
 }
@@ -198,6 +288,49 @@ int mnt_celllocator_find(CellLocator_t** self, const double point[], long long*
     return 0;
 }
 
+extern "C"
+int mnt_celllocator_findWithHint(CellLocator_t** self, const double point[], long long hintCellId,
+                                 long long* cellId, double pcoords[]) {
+
+    vtkUnstructuredGrid* grid = (*self)->gridt->grid;
+    if (hintCellId < 0 || grid->GetNumberOfCells() == 0 || 
+        grid->GetCellType(0) != VTK_QUAD) {
+        return mnt_celllocator_find(self, point, cellId, pcoords);
+    }
+
+    if (!(*self)->adjacency) {
+        (*self)->adjacency = new CellAdjacency();
+        (*self)->adjacency->build(grid, (*self)->gridt->faceNodeConnectivity);
+    }
+
+    // same tolerance as mnt_celllocator_find
+    const double tol2 = 10 * std::numeric_limits<double>::epsilon();
+    LocatorQuery locQuery((*self)->loc);
+    *cellId = (*self)->adjacency->findCell(locQuery, (double*) point, tol2, hintCellId,
+                                           (*self)->cell, pcoords, (*self)->weights);
+    return 0;
+}
+
+extern "C"
+int mnt_celllocator_findBatch(CellLocator_t** self, size_t npoints, const double points[],
+                              long long cellIds[], double pcoords[]) {
+    // same tolerance as mnt_celllocator_find
+    const double tol2 = 10 * std::numeric_limits<double>::epsilon();
+    vtkAbstractCellLocator* loc = (*self)->loc;
+    // each thread has its own query, cell and weights
+    mntParallelFor((*self)->numThreads, npoints,
+                   [loc, tol2, points, cellIds, pcoords](int /*threadId*/, size_t beg, size_t end) {
+        LocatorQuery locQuery(loc);
+        vtkGenericCell* cell = vtkGenericCell::New();
+        double weights[8];
+        for (size_t i = beg; i < end; ++i) {
+            cellIds[i] = locQuery.findCell((double*) &points[3*i], tol2, cell, &pcoords[3*i], weights);
+        }
+        cell->Delete();
+    });
+    return 0;
+}
+
 extern "C"
 int mnt_celllocator_interpPoint(CellLocator_t** self, long long cellId, const double pcoords[], double point[]) {
     if (cellId < 0) {
@@ -209,6 +342,35 @@ int mnt_celllocator_interpPoint(CellLocator_t** self, long long cellId, const do
     return 0;
 }
 
+extern "C"
+int mnt_celllocator_interpPointBatch(CellLocator_t** self, size_t npoints, const long long cellIds[],
+                                     const double pcoords[], double points[]) {
+    vtkUnstructuredGrid* grid = (*self)->gridt->grid;
+    int numThreads = (*self)->numThreads;
+    std::vector<int> numBad(numThreads, 0);
+    mntParallelFor(numThreads, npoints,
+                   [grid, cellIds, pcoords, points, &numBad](int threadId, size_t beg, size_t end) {
+        vtkGenericCell* cell = vtkGenericCell::New();
+        double weights[8];
+        int subId = 0;
+        for (size_t i = beg; i < end; ++i) {
+            if (cellIds[i] < 0) {
+                numBad[threadId]++;
+                continue;
+            }
+            grid->GetCell(cellIds[i], cell);
+            cell->EvaluateLocation(subId, (double*) &pcoords[3*i], &points[3*i], weights);
+        }
+        cell->Delete();
+    });
+    for (int threadId = 0; threadId < numThreads; ++threadId) {
+        if (numBad[threadId] > 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 extern "C"
 void mnt_celllocator_printAddress(void* something) {
     printf("address is %lld (0x%16zx)\n", (long long) something, (size_t) something);
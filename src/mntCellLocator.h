@@ -1,8 +1,10 @@
 #include <vector>
+#include <string>
 #include <vtkUnstructuredGrid.h>
 #include <vtkCellLocator.h>
 #include <vtkGenericCell.h>
 #include <mntGrid.h>
+#include <mntCellAdjacency.h>
 
 #ifndef MNT_CELL_LOCATOR
 #define MNT_CELL_LOCATOR
@@ -14,8 +16,12 @@
 struct CellLocator_t {
     double weights[8]; /* big enough to accommodate quads and hexs */
     Grid_t* gridt;
-    vtkCellLocator* loc;
+    vtkAbstractCellLocator* loc;
     vtkGenericCell* cell;
+    int numThreads;
+    CellAdjacency* adjacency; /* quad grids only, built on first use */
+    std::string locCacheFile; /* empty if the locator is not cached */
+    std::string locType; /* LocatorFactory name, empty for the default */
 };
 
 /**
@@ -72,6 +78,38 @@ int mnt_celllocator_checkGrid(CellLocator_t** self, double tol, int* numBadCells
 extern "C"
 int mnt_celllocator_runGridDiagnostics(CellLocator_t** self);
 
+/**
+ * Set the number of threads used by the batched queries
+ * @param numThreads number of threads (>= 1)
+ * @return error code (0 is OK)
+ */
+extern "C"
+int mnt_celllocator_setNumberOfThreads(CellLocator_t** self, int numThreads);
+
+/**
+ * Set the file caching the locator. mnt_celllocator_build loads the locator from the
+ * file if it was saved for the same grid and number of cells per bucket, otherwise it
+ * builds the locator and saves it
+ * @param fort_filename file name without '\0'
+ * @param n number of characters in fort_filename
+ * @return error code (0 is OK)
+ */
+extern "C"
+int mnt_celllocator_setLocatorCacheFile(CellLocator_t** self, const char* fort_filename, size_t n);
+
+/**
+ * Set the type of locator built by mnt_celllocator_build
+ * @param fort_name locator name: "auto", "vtk", "octree", "bins2d", "bvh" or "structured"
+ *                  (does not require termination character)
+ * @param n length of name string (excluding '\0' if present)
+ * @return error code (0 is OK)
+ * @note by default the locator is a vtkCellLocator, unless a cache file is set in which 
+ *       case it is "auto" for quads in the z = 0 plane and "octree" otherwise, as the
+ *       vtkCellLocator cannot be saved
+ */
+extern "C"
+int mnt_celllocator_setLocatorType(CellLocator_t** self, const char* fort_name, size_t n);
+
 /**
  * Build the regridder
  * @param num_cells_per_bucket number of cells per tree node (bucket)
@@ -80,6 +118,28 @@ int mnt_celllocator_runGridDiagnostics(CellLocator_t** self);
 extern "C"
 int mnt_celllocator_build(CellLocator_t** self, int num_cells_per_bucket);
 
+/**
+ * Save the search structure of the built locator to a file
+ * @param fort_filename file name without '\0'
+ * @param n number of characters in fort_filename
+ * @return error code (0 is OK)
+ */
+extern "C"
+int mnt_celllocator_saveLocator(CellLocator_t** self, const char* fort_filename, size_t n);
+
+/**
+ * Load the search structure from a file, instead of building the locator
+ * @param fort_filename file name without '\0'
+ * @param n number of characters in fort_filename
+ * @return error code (0 is OK), non zero if the file cannot be read or was saved 
+ *         for a different grid, in which case the locator is left unchanged. The 
+ *         number of cells per bucket is that of the saved locator
+ * @note the grid must be set (or loaded) before. The file is matched to the grid 
+ *       through a fingerprint of the grid's cell vertices
+ */
+extern "C"
+int mnt_celllocator_loadLocator(CellLocator_t** self, const char* fort_filename, size_t n);
+
 /**
  * Save the grid to a VTK file
  * @param filename fortran file name
@@ -99,6 +159,40 @@ int mnt_celllocator_dumpGrid(CellLocator_t** self, const char* fort_filename, si
 extern "C"
 int mnt_celllocator_find(CellLocator_t** self, const double point[], long long* cellId, double pcoords[]);
 
+/**
+ * Find the cell and the parametric coordinates, starting from a nearby cell
+ * @param point target point
+ * @param hintCellId cell expected to contain or touch the point, e.g. the cell of 
+ *                   the previous point along a trajectory (ignored if < 0)
+ * @param cellId cell Id (< 0 if not found)
+ * @param pcoords parametric coordinates in the unit cell (filled in if found)
+ * @return error code (0 is OK)
+ * @note on quad grids the hint cell and its neighbours are tested before falling 
+ *       back to the locator, the hint is ignored on other grids. The cells are tested
+ *       in increasing Id order with mntCellEvaluatePosition, the result is the same as 
+ *       mnt_celllocator_find's with the "octree" and "bins2d" locators, which test the 
+ *       cells of a bucket in the same order. The other locators may attribute a point 
+ *       on a shared edge to another cell and, for the "vtk" locator, the parametric 
+ *       coordinates may differ by round-off.
+ */
+extern "C"
+int mnt_celllocator_findWithHint(CellLocator_t** self, const double point[], long long hintCellId,
+                                 long long* cellId, double pcoords[]);
+
+/**
+ * Find the cells and the parametric coordinates of many points
+ * @param npoints number of points
+ * @param points target points, flat array of size 3*npoints
+ * @param cellIds cell Ids, < 0 if not found (output, size npoints)
+ * @param pcoords parametric coordinates in the unit cell, filled in if found (output, size 3*npoints)
+ * @return error code (0 is OK)
+ * @note the points are split among the threads set by mnt_celllocator_setNumberOfThreads,
+ *       the result does not depend on the number of threads
+ */
+extern "C"
+int mnt_celllocator_findBatch(CellLocator_t** self, size_t npoints, const double points[],
+                              long long cellIds[], double pcoords[]);
+
 /**
  * Interpolate the position
  * @param cellId cell Id (input)
@@ -109,6 +203,20 @@ int mnt_celllocator_find(CellLocator_t** self, const double point[], long long*
 extern "C"
 int mnt_celllocator_interpPoint(CellLocator_t** self, long long cellId, const double pcoords[], double point[]);
 
+/**
+ * Interpolate many positions
+ * @param npoints number of points
+ * @param cellIds cell Ids (input, size npoints)
+ * @param pcoords parametric coordinates in the unit cell (input, size 3*npoints)
+ * @param points target points (output, size 3*npoints)
+ * @return error code (0 is OK), 1 if some cell Ids are < 0, in which case the
+ *         corresponding points are left unchanged
+ * @note the points are split among the threads set by mnt_celllocator_setNumberOfThreads
+ */
+extern "C"
+int mnt_celllocator_interpPointBatch(CellLocator_t** self, size_t npoints, const long long cellIds[],
+                                     const double pcoords[], double points[]);
+
 extern "C"
 void mnt_celllocator_printAddress(void* something);
 
@@ -1,17 +1,126 @@
 #include <mntLineGridIntersector.h>
+#include <vtkCellLocator.h>
 #include <vtkGenericCell.h>
+#include <vtkHexahedron.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 LineGridIntersector::LineGridIntersector(vtkUnstructuredGrid* grid) {
 
     this->tol = 10 * std::numeric_limits<double>::epsilon();
 
-    this->locator = vtkCellLocator::New();
-    this->locator->SetDataSet(grid);
-    this->locator->BuildLocator();
+    this->grid = grid;
+    vtkCellLocator* loc = vtkCellLocator::New();
+    loc->SetDataSet(grid);
+    loc->BuildLocator();
+    this->locator = loc;
+    this->ownsLocator = true;
+    this->locQuery = new LocatorQuery(loc);
+    this->ownsLocQuery = true;
+
+    this->cellIds = vtkIdList::New();
+    this->cell = vtkGenericCell::New();
+}
+
+LineGridIntersector::LineGridIntersector(vtkUnstructuredGrid* grid, vtkAbstractCellLocator* locator) {
+
+    this->tol = 10 * std::numeric_limits<double>::epsilon();
+
+    // borrow the locator
+    this->grid = grid;
+    this->locator = locator;
+    this->ownsLocator = false;
+    this->locQuery = new LocatorQuery(locator);
+    this->ownsLocQuery = true;
+
+    this->cellIds = vtkIdList::New();
+    this->cell = vtkGenericCell::New();
+}
+
+LineGridIntersector::LineGridIntersector(vtkUnstructuredGrid* grid, LocatorQuery* locQuery) {
+
+    this->tol = 10 * std::numeric_limits<double>::epsilon();
+
+    // borrow the query
+    this->grid = grid;
+    this->locator = locQuery->getLocator();
+    this->ownsLocator = false;
+    this->locQuery = locQuery;
+    this->ownsLocQuery = false;
+
+    this->cellIds = vtkIdList::New();
+    this->cell = vtkGenericCell::New();
 }
 
 LineGridIntersector::~LineGridIntersector() {
-    this->locator->Delete();
+    if (this->ownsLocQuery) {
+        delete this->locQuery;
+    }
+    if (this->ownsLocator) {
+        this->locator->Delete();
+    }
+    this->cellIds->Delete();
+    this->cell->Delete();
+}
+
+/**
+ * Order points lexicographically
+ */
+static bool __mnt_linegrid_lessPoint(const double* a, const double* b) {
+    for (size_t i = 0; i < 3; ++i) {
+        if (a[i] < b[i]) return true;
+        if (a[i] > b[i]) return false;
+    }
+    return false;
+}
+
+/**
+ * Intersect a segment with a triangle
+ * @param pa start point of the segment
+ * @param dir direction of the segment (end point minus start point)
+ * @param tri the triangle's vertices, in lexicographic order so that a triangle 
+ *            shared by two cells gives exactly the same result
+ * @param tol tolerance on the triangle's barycentric coordinates
+ * @param t line parametric coordinate of the intersection (output)
+ * @return true if the segment crosses the triangle, false if not or if the segment 
+ *         is parallel to the triangle
+ */
+static bool __mnt_linegrid_intersectTriangle(const double pa[], const double dir[], 
+                                             const double* tri[3], double tol, double& t) {
+
+    double e1[3], e2[3], h[3], s[3], q[3];
+    for (size_t i = 0; i < 3; ++i) {
+        e1[i] = tri[1][i] - tri[0][i];
+        e2[i] = tri[2][i] - tri[0][i];
+        s[i] = pa[i] - tri[0][i];
+    }
+    h[0] = dir[1]*e2[2] - dir[2]*e2[1];
+    h[1] = dir[2]*e2[0] - dir[0]*e2[2];
+    h[2] = dir[0]*e2[1] - dir[1]*e2[0];
+    double det = e1[0]*h[0] + e1[1]*h[1] + e1[2]*h[2];
+
+    // the scale of the determinant, to detect parallel lines
+    double scale = std::sqrt((dir[0]*dir[0] + dir[1]*dir[1] + dir[2]*dir[2]) *
+                             (e1[0]*e1[0] + e1[1]*e1[1] + e1[2]*e1[2]) *
+                             (e2[0]*e2[0] + e2[1]*e2[1] + e2[2]*e2[2]));
+    if (std::abs(det) <= 1.e-12 * scale) {
+        return false;
+    }
+
+    double u = (s[0]*h[0] + s[1]*h[1] + s[2]*h[2]) / det;
+    if (u < -tol || u > 1. + tol) {
+        return false;
+    }
+    q[0] = s[1]*e1[2] - s[2]*e1[1];
+    q[1] = s[2]*e1[0] - s[0]*e1[2];
+    q[2] = s[0]*e1[1] - s[1]*e1[0];
+    double v = (dir[0]*q[0] + dir[1]*q[1] + dir[2]*q[2]) / det;
+    if (v < -tol || u + v > 1. + tol) {
+        return false;
+    }
+    t = (e2[0]*q[0] + e2[1]*q[1] + e2[2]*q[2]) / det;
+    return true;
 }
 
 void 
@@ -19,30 +128,19 @@ LineGridIntersector::setLine(const double pa[], const double pb[]) {
 
     this->pA.resize(3);
     this->direction.resize(3);
-    Vector<double> pBeg(3), pEnd(3), xPoint(3), pB(3);
     double lengthSqr = 0.0;
     for (size_t i = 0; i < 3; ++i) {
         this->direction[i] = pb[i] - pa[i];
         lengthSqr += this->direction[i] * this->direction[i];
         this->pA[i] = pa[i];
-        pB[i] = pb[i];
     }
 
-    // reduce the line by a little bit to be sure that the start/end points 
-    // are included
-    pBeg = pA; //+ 100 * this->tol * this->direction;
-    pEnd = pB; //- 100 * this->tol * this->direction;
-
-    // random perturbation
-    //pBeg[0] += this->tol * 1.4862362;
-    //pBeg[1] -= this->tol * 5.2876536;
-    //pBeg[2] += this->tol * 3.9255956;
-
     this->tValues.clear();
     vtkIdType cellId;
+    double pcoords[3], weights[8];
 
     // add the start point if it is in a cell
-    cellId = this->locator->FindCell( (double*) pa ); // SHOULD WE USE THE VERSION WITH TOL2?
+    cellId = this->locQuery->findCell((double*) pa, 0.0, this->cell, pcoords, weights); // SHOULD WE USE THE VERSION WITH TOL2?
     if (cellId >= 0) {
         this->tValues.push_back(0.0);
     }
@@ -53,44 +151,109 @@ LineGridIntersector::setLine(const double pa[], const double pb[]) {
     }
 
     //
-    // collect the intersection points
+    // collect the intersection points in a single sweep: get the cells along 
+    // the line from the locator once, then intersect the line with the faces 
+    // of these cells
     //
 
-    int found = 1;
-    double tLocal, tVal;
-    double pcoords[3];
-    int subId;
-    vtkGenericCell* cell = vtkGenericCell::New();
-    while (found == 1) {
-
-        cellId = -1;
-        found = this->locator->IntersectWithLine(&pBeg[0], &pEnd[0], this->tol, 
-                                                 tLocal, &xPoint[0], pcoords, subId, cellId, cell);  // output
-        if (found == 1) {
-            // compute the linear parameter using the intersection point
-            tVal = dot(xPoint - pA, direction)/lengthSqr;
-            // add if first intersection or different from previous
-            size_t nValues = this->tValues.size();
-            if (nValues == 0 || std::abs( tVal - this->tValues[nValues - 1] ) > this->tol) {
-                this->tValues.push_back(tVal);
+    // the locators' tolerance is a distance, relative to the length of the line
+    double length = std::sqrt(lengthSqr);
+    this->locQuery->findCellsAlongLine((double*) pa, (double*) pb, 1.e-3*length, this->cellIds);
+
+    // tolerance for a line to cross a face through its boundary
+    const double faceTol = 1.e-10;
+
+    double verts[8][3];
+    for (vtkIdType i = 0; i < this->cellIds->GetNumberOfIds(); ++i) {
+
+        this->grid->GetCell(this->cellIds->GetId(i), this->cell);
+        if (this->cell->GetCellType() != VTK_HEXAHEDRON) {
+            this->__intersectCell(pa, pb, lengthSqr);
+            continue;
+        }
+        for (int k = 0; k < 8; ++k) {
+            this->cell->GetPoints()->GetPoint(k, verts[k]);
+        }
+
+        for (int faceId = 0; faceId < 6; ++faceId) {
+
+            int* faceIds = vtkHexahedron::GetFaceArray(faceId);
+            const double* q[4];
+            for (int k = 0; k < 4; ++k) {
+                q[k] = verts[faceIds[k]];
+            }
+
+            // split the face along the diagonal that starts from the smallest
+            // vertex, so that the neighbouring cell splits the face the same way
+            int k0 = 0;
+            for (int k = 1; k < 4; ++k) {
+                if (__mnt_linegrid_lessPoint(q[k], q[k0])) {
+                    k0 = k;
+                }
+            }
+            for (int itri = 0; itri < 2; ++itri) {
+                const double* tri[] = {q[k0], q[(k0 + 1 + itri) % 4], q[(k0 + 2 + itri) % 4]};
+                std::sort(tri, tri + 3, __mnt_linegrid_lessPoint);
+                double t;
+                if (__mnt_linegrid_intersectTriangle(pa, &this->direction[0], tri, faceTol, t) &&
+                    t >= -faceTol && t <= 1. + faceTol) {
+                    this->tValues.push_back(std::max(0., std::min(1., t)));
+                }
             }
-            // slide the starting point 
-            pBeg = xPoint + this->tol * this->direction;
         }
     }
-    cell->Delete();
 
     // add the end point if it is in a cell
-    cellId = this->locator->FindCell( (double*) pb ); // SHOULD WE USE THE VERSION WITH TOL2?
-    double absDiff = std::numeric_limits<double>::max();
-    size_t nValues = this->tValues.size();
-    if (nValues > 0) {
-        absDiff = std::abs( 1.0 - this->tValues[nValues - 1] );
-    }
-    if (cellId >= 0 && absDiff > this->tol) {
+    cellId = this->locQuery->findCell((double*) pb, 0.0, this->cell, pcoords, weights); // SHOULD WE USE THE VERSION WITH TOL2?
+    if (cellId >= 0) {
         this->tValues.push_back(1.0);
     }
 
+    // order the intersections along the line and remove the duplicates (faces
+    // shared by two cells, triangles sharing an edge...)
+    std::sort(this->tValues.begin(), this->tValues.end());
+    size_t n = 0;
+    for (size_t i = 0; i < this->tValues.size(); ++i) {
+        if (n == 0 || std::abs(this->tValues[i] - this->tValues[n - 1]) > this->tol) {
+            this->tValues[n++] = this->tValues[i];
+        }
+    }
+    this->tValues.resize(n);
+}
+
+void
+LineGridIntersector::__intersectCell(const double pa[], const double pb[], double lengthSqr) {
+
+    // the cell returns the first crossing past the start point, slide the start 
+    // point past each crossing. The number of crossings is bounded by the number of
+    // cell vertices
+    double pBeg[3], xPoint[3], pcoords[3], tLocal;
+    int subId;
+    for (size_t i = 0; i < 3; ++i) {
+        pBeg[i] = pa[i];
+    }
+    double tPrev = -1.0;
+    vtkIdType numPoints = this->cell->GetNumberOfPoints();
+    for (vtkIdType k = 0; k < numPoints; ++k) {
+        if (this->cell->IntersectWithLine(pBeg, (double*) pb, this->tol, tLocal, 
+                                          xPoint, pcoords, subId) != 1) {
+            break;
+        }
+        double tVal = 0.0;
+        for (size_t i = 0; i < 3; ++i) {
+            tVal += (xPoint[i] - pa[i]) * this->direction[i];
+        }
+        tVal /= lengthSqr;
+        if (tVal <= tPrev + this->tol) {
+            // no progress along the line
+            break;
+        }
+        this->tValues.push_back(std::max(0., std::min(1., tVal)));
+        tPrev = tVal;
+        for (size_t i = 0; i < 3; ++i) {
+            pBeg[i] = xPoint[i] + this->tol * this->direction[i];
+        }
+    }
 }
 
 const std::vector<double>& 
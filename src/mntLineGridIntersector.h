@@ -1,5 +1,8 @@
 #include <vtkUnstructuredGrid.h>
-#include <vtkCellLocator.h>
+#include <vtkAbstractCellLocator.h>
+#include <mntLocatorQuery.h>
+#include <vtkIdList.h>
+#include <vtkGenericCell.h>
 #include <MvVector.h>
 #include <vector>
 
@@ -16,13 +19,39 @@ public:
      */
     LineGridIntersector(vtkUnstructuredGrid* grid);
 
+    /**
+     * Constructor
+     * @param grid instance of vtkUnstructuredGrid
+     * @param locator cell locator attached to the above grid, must have 
+     *                been built. The locator is borrowed, not owned.
+     * @note use this constructor when intersecting many lines with the same grid,
+     *       the above constructor builds a new locator each time
+     */
+    LineGridIntersector(vtkUnstructuredGrid* grid, vtkAbstractCellLocator* locator);
+
+    /**
+     * Constructor
+     * @param grid instance of vtkUnstructuredGrid
+     * @param locQuery searches the cell locator attached to the above grid, which must
+     *                 have been built. The query is borrowed, not owned.
+     * @note use this constructor when creating many intersectors in turn, the query's
+     *       scratch space is then allocated once
+     */
+    LineGridIntersector(vtkUnstructuredGrid* grid, LocatorQuery* locQuery);
+
     /**
      * Destructor
      */
     ~LineGridIntersector();
 
     /**
-     * Set start/end points
+     * Set start/end points and compute the intersections
+     * @param pa start point
+     * @param pb end point
+     * @note the locator is queried once for the cells along the line, the crossings
+     *       with the faces of these cells are then sorted along the line. The faces of
+     *       hexahedral cells are split into triangles consistently across cells, other 
+     *       cells are intersected with vtkCell::IntersectWithLine.
      */
     void setLine(const double pa[], const double pb[]);
 
@@ -53,8 +82,31 @@ public:
 
 private:
 
+    /**
+     * Add the crossings of the line with the boundary of the current cell, used for 
+     * the cells that are not hexahedra
+     * @param pa start point
+     * @param pb end point
+     * @param lengthSqr square of the line length
+     */
+    void __intersectCell(const double pa[], const double pb[], double lengthSqr);
+
+    // the grid
+    vtkUnstructuredGrid* grid;
+
     // cell locator
-    vtkCellLocator* locator;
+    vtkAbstractCellLocator* locator;
+
+    // searches the cell locator
+    LocatorQuery* locQuery;
+
+    // work objects, kept between lines
+    vtkIdList* cellIds;
+    vtkGenericCell* cell;
+
+    // whether the locator and the query were created by this instance
+    bool ownsLocator;
+    bool ownsLocQuery;
 
     // start point
     Vector<double> pA;
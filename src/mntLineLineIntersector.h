@@ -1,35 +1,38 @@
-#include <MvMatrix.h>
 #include <MvVector.h>
+#include <cmath>
+#include <algorithm>
+#include <utility>
 
 #ifndef MNT_LINE_LINE_INTERSECTOR
 #define MNT_LINE_LINE_INTERSECTOR
 
+/**
+ * Intersection of two 2d lines (p0, p1) and (q0, q1), solves
+ * p0 + lambda*(p1 - p0) = q0 + mu*(q1 - q0) for (lambda, mu)
+ * @note the 2x2 system is stored on the stack, no memory is allocated
+ *       other than in the methods that return Vector objects
+ */
 struct LineLineIntersector {
 
     /**
      * Constructor
      */
     LineLineIntersector() {
-        this->mat.newsize(2, 2);
-        this->invMatTimesDet.newsize(2, 2);
-        this->invMatTimesDetDotRhs.alloc(2);
-        this->rhs.alloc(2);
-        this->p0.alloc(2);
-        this->p1.alloc(2);
-        this->q0.alloc(2);
-        this->q1.alloc(2);
+        this->lamBeg = 0;
+        this->lamEnd = 0;
+        this->det = 0;
     }
 
     /**
-     * Set points 
+     * Set points
      * @param p0 starting point of first line
      * @param p1 end point of first line
      * @param q0 starting point of second line
      * @param q1 end point of second line
      */
-    void setPoints(const double p0[], 
-                   const double p1[], 
-                   const double q0[], 
+    void setPoints(const double p0[],
+                   const double p1[],
+                   const double q0[],
                    const double q1[]) {
         for (size_t i = 0; i < 2; ++i) {
             this->p0[i] = p0[i];
@@ -37,15 +40,13 @@ struct LineLineIntersector {
             this->q0[i] = q0[i];
             this->q1[i] = q1[i];
             this->rhs[i] = q0[i] - p0[i];
-            this->mat(i, 0) = p1[i] - p0[i];
-            this->mat(i, 1) = q0[i] - q1[i];
+            this->mat[i][0] = p1[i] - p0[i];
+            this->mat[i][1] = q0[i] - q1[i];
         }
-        this->invMatTimesDet(0, 0) = this->mat(1, 1);
-        this->invMatTimesDet(1, 1) = this->mat(0, 0);
-        this->invMatTimesDet(0, 1) = -this->mat(0, 1);
-        this->invMatTimesDet(1, 0) = -this->mat(1, 0);
-        this->solTimesDet = dot(this->invMatTimesDet, this->rhs);
-        this->det = this->mat(0, 0)*this->mat(1, 1) - this->mat(0, 1)*this->mat(1, 0);
+        // inverse of mat times the determinant, dotted with rhs
+        this->solTimesDet[0] = this->mat[1][1]*this->rhs[0] - this->mat[0][1]*this->rhs[1];
+        this->solTimesDet[1] = this->mat[0][0]*this->rhs[1] - this->mat[1][0]*this->rhs[0];
+        this->det = this->mat[0][0]*this->mat[1][1] - this->mat[0][1]*this->mat[1][0];
     }
 
     /**
@@ -72,12 +73,12 @@ struct LineLineIntersector {
      * Compute the begin/end parametric coordinates
     */
     void computeBegEndParamCoords() {
-        const Vector<double> dp = this->p1 - this->p0;
-        double dp2 = dot(dp, dp);
+        double dp[] = {this->p1[0] - this->p0[0], this->p1[1] - this->p0[1]};
+        double dp2 = dp[0]*dp[0] + dp[1]*dp[1];
         // lambda @ q0
-        double lm0 = dot(this->q0 - this->p0, dp)/dp2;
+        double lm0 = ((this->q0[0] - this->p0[0])*dp[0] + (this->q0[1] - this->p0[1])*dp[1])/dp2;
         // lambda @ q1
-        double lm1 = dot(this->q1 - this->p0, dp)/dp2;
+        double lm1 = ((this->q1[0] - this->p0[0])*dp[0] + (this->q1[1] - this->p0[1])*dp[1])/dp2;
 
         this->lamBeg = std::min(std::max(lm0, 0.0), 1.0);
         this->lamEnd = std::max(std::min(lm1, 1.0), 0.0);
@@ -96,10 +97,14 @@ struct LineLineIntersector {
      * @return pair of points
      */
     const std::pair< Vector<double>, Vector<double> > getBegEndPoints() const {
-        Vector<double> dp = this->p1 - this->p0;
-        std::pair< Vector<double>, Vector<double> > p(this->p0 + this->lamBeg*dp, 
-                                                      this->p0 + this->lamEnd*dp);
-        return p;
+        Vector<double> pa(2);
+        Vector<double> pb(2);
+        for (size_t i = 0; i < 2; ++i) {
+            double dp = this->p1[i] - this->p0[i];
+            pa[i] = this->p0[i] + this->lamBeg*dp;
+            pb[i] = this->p0[i] + this->lamEnd*dp;
+        }
+        return std::pair< Vector<double>, Vector<double> >(pa, pb);
     }
 
 
@@ -122,7 +127,9 @@ struct LineLineIntersector {
         if (std::abs(this->getDet()) > tol)
             return true;
 
-        if (std::abs(dot(this->solTimesDet, this->solTimesDet)) < tol) {
+        double solTimesDet2 = this->solTimesDet[0]*this->solTimesDet[0] +
+                              this->solTimesDet[1]*this->solTimesDet[1];
+        if (std::abs(solTimesDet2) < tol) {
             // determinant is zero, p1 - p0 and q1 - q0 are on
             // the same ray
             this->computeBegEndParamCoords();
@@ -135,26 +142,34 @@ struct LineLineIntersector {
     }
 
 
+    /**
+     * Get the solution
+     * @param sol parametric coordinates along the first and second lines (output)
+     */
+    void getSolution(double sol[]) const {
+        sol[0] = this->solTimesDet[0] / this->det;
+        sol[1] = this->solTimesDet[1] / this->det;
+    }
+
+
     /**
      * Get the solution
      * @return solution
      */
-    const Vector<double> getSolution() {
-        Vector<double> res = this->solTimesDet;
-        res /= this->det;
-        return res; 
+    const Vector<double> getSolution() const {
+        Vector<double> res(2);
+        this->getSolution(&res[0]);
+        return res;
     }
 
-    ColMat<double> mat;
-    ColMat<double> invMatTimesDet;
+    double mat[2][2];
 
-    Vector<double> invMatTimesDetDotRhs;
-    Vector<double> rhs;
-    Vector<double> solTimesDet;
-    Vector<double> p0;
-    Vector<double> p1;
-    Vector<double> q0;
-    Vector<double> q1;
+    double rhs[2];
+    double solTimesDet[2];
+    double p0[2];
+    double p1[2];
+    double q0[2];
+    double q1[2];
 
     double lamBeg;
     double lamEnd;
@@ -162,4 +177,164 @@ struct LineLineIntersector {
 
 };
 
+
+/**
+ * Intersection of a 2d line with the four edges of a quadrilateral. Same
+ * as LineLineIntersector applied to each edge, with the edges processed
+ * together in structure of arrays form so the compiler can vectorize the
+ * loops over the edges
+ */
+struct LineQuadEdgesIntersector {
+
+    /**
+     * Get the two cell point Ids for given edge, same convention as QuadEdgeIter
+     * @param edgeId edge index (0 <= edgeId < 4)
+     * @param iBeg index of begin point (output)
+     * @param iEnd index of end point (output)
+     */
+    static void getCellPointIds(int edgeId, int* iBeg, int* iEnd) {
+        // edges always point in the positive parametric direction
+        static const int pointIds[4][2] = {{0, 1}, {1, 2}, {3, 2}, {0, 3}};
+        *iBeg = pointIds[edgeId][0];
+        *iEnd = pointIds[edgeId][1];
+    }
+
+    /**
+     * Set points
+     * @param p0 starting point of the line
+     * @param p1 end point of the line
+     * @param verts quad vertices, verts[i] is vertex i, ordered as in vtkQuad
+     */
+    void setPoints(const double p0[], const double p1[], const double verts[4][3]) {
+
+        // gather the edge start/end points
+        double q0x[4], q0y[4], q1x[4], q1y[4];
+        for (int e = 0; e < 4; ++e) {
+            int i0, i1;
+            getCellPointIds(e, &i0, &i1);
+            q0x[e] = verts[i0][0];
+            q0y[e] = verts[i0][1];
+            q1x[e] = verts[i1][0];
+            q1y[e] = verts[i1][1];
+        }
+
+        this->p0[0] = p0[0];
+        this->p0[1] = p0[1];
+        this->p1[0] = p1[0];
+        this->p1[1] = p1[1];
+        double m00 = p1[0] - p0[0];
+        double m10 = p1[1] - p0[1];
+
+        // same operations as LineLineIntersector::setPoints, for all the edges at once
+        for (int e = 0; e < 4; ++e) {
+            double r0 = q0x[e] - p0[0];
+            double r1 = q0y[e] - p0[1];
+            double m01 = q0x[e] - q1x[e];
+            double m11 = q0y[e] - q1y[e];
+            this->solTimesDet0[e] = m11*r0 - m01*r1;
+            this->solTimesDet1[e] = m00*r1 - m10*r0;
+            this->det[e] = m00*m11 - m01*m10;
+            this->q0x[e] = q0x[e];
+            this->q0y[e] = q0y[e];
+            this->q1x[e] = q1x[e];
+            this->q1y[e] = q1y[e];
+        }
+    }
+
+    /**
+     * Get the determinant
+     * @param edgeId edge index
+     * @return determinant
+     */
+    double getDet(int edgeId) const {
+        return this->det[edgeId];
+    }
+
+    /**
+     * Check if there is a solution
+     * @param edgeId edge index
+     * @param tol tolerance
+     * @return True if there is one or more solutions
+     */
+    bool hasSolution(int edgeId, double tol) {
+
+        if (std::abs(this->det[edgeId]) > tol)
+            return true;
+
+        double solTimesDet2 = this->solTimesDet0[edgeId]*this->solTimesDet0[edgeId] +
+                              this->solTimesDet1[edgeId]*this->solTimesDet1[edgeId];
+        if (std::abs(solTimesDet2) < tol) {
+            // degenerate, fall back to the single edge intersector
+            double q0[] = {this->q0x[edgeId], this->q0y[edgeId]};
+            double q1[] = {this->q1x[edgeId], this->q1y[edgeId]};
+            this->degenerate.setPoints(this->p0, this->p1, q0, q1);
+            return this->degenerate.hasSolution(tol);
+        }
+
+        return false;
+    }
+
+    /**
+     * Get the solution
+     * @param edgeId edge index
+     * @param sol parametric coordinates along the line and along the edge (output)
+     */
+    void getSolution(int edgeId, double sol[]) const {
+        sol[0] = this->solTimesDet0[edgeId] / this->det[edgeId];
+        sol[1] = this->solTimesDet1[edgeId] / this->det[edgeId];
+    }
+
+    /**
+     * Get the cell parametric coordinates of a point on an edge
+     * @param edgeId edge index
+     * @param lamEdg parametric coordinate along the edge, 0 at the start and 1 at the end
+     * @param xi cell parametric coordinates, 3 values (output)
+     * @note exact for quads with straight edges, no Newton iteration required
+     */
+    static void getCellParamCoords(int edgeId, double lamEdg, double xi[]) {
+        // vertex parametric coordinates, ordered as in vtkQuad
+        static const double vertXis[4][2] = {{0., 0.}, {1., 0.}, {1., 1.}, {0., 1.}};
+        int i0, i1;
+        getCellPointIds(edgeId, &i0, &i1);
+        for (int d = 0; d < 2; ++d) {
+            xi[d] = vertXis[i0][d] + lamEdg*(vertXis[i1][d] - vertXis[i0][d]);
+        }
+        xi[2] = 0.;
+    }
+
+    /**
+     * Get the parametric coordinate along an edge of a point
+     * @param edgeId edge index
+     * @param p point, assumed to lie on the edge
+     * @return parametric coordinate, 0 at the start and 1 at the end of the edge
+     */
+    double getEdgeParamCoord(int edgeId, const double p[]) const {
+        double dq[] = {this->q1x[edgeId] - this->q0x[edgeId], this->q1y[edgeId] - this->q0y[edgeId]};
+        double dq2 = dq[0]*dq[0] + dq[1]*dq[1];
+        return ((p[0] - this->q0x[edgeId])*dq[0] + (p[1] - this->q0y[edgeId])*dq[1])/dq2;
+    }
+
+    /**
+     * Get the begin/end parametric coordinates of overlap
+     * @return pair
+     * @note only valid after hasSolution returned true for a degenerate edge
+     */
+    const std::pair< double, double > getBegEndParamCoords() const {
+        return this->degenerate.getBegEndParamCoords();
+    }
+
+    double p0[2];
+    double p1[2];
+    double q0x[4];
+    double q0y[4];
+    double q1x[4];
+    double q1y[4];
+    double solTimesDet0[4];
+    double solTimesDet1[4];
+    double det[4];
+
+    // handles the overlapping case
+    LineLineIntersector degenerate;
+};
+
 #endif // MNT_LINE_LINE_INTERSECTOR
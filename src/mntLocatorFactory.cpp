@@ -0,0 +1,175 @@
+#include <mntLocatorFactory.h>
+#include <mntLocatorFile.h>
+#include <mvtkCellLocator.h>
+#include <mvtkCellLocator2d.h>
+#include <mvtkRectilinearCellLocator.h>
+#include <mvtkCubedSphereCellLocator.h>
+#include <mvtkAdaptiveCellLocator.h>
+#include <vtkCellLocator.h>
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <unistd.h>
+
+/**
+ * Create the analytic locator of a lat-lon or cubed-sphere grid
+ * @param grid grid
+ * @return locator or NULL if the grid is neither lat-lon nor cubed-sphere
+ */
+static vtkAbstractCellLocator* __mnt_locatorfactory_newStructured(vtkDataSet* grid) {
+
+    if (!mvtkCellLocator2d::IsPlanarQuadGrid(grid)) {
+        return NULL;
+    }
+    mvtkRectilinearCellLocator* rloc = mvtkRectilinearCellLocator::New();
+    rloc->SetDataSet(grid);
+    rloc->BuildLocator();
+    if (rloc->IsRectilinear()) {
+        return rloc;
+    }
+    rloc->Delete();
+    mvtkCubedSphereCellLocator* cloc = mvtkCubedSphereCellLocator::New();
+    cloc->SetDataSet(grid);
+    cloc->BuildLocator();
+    if (cloc->IsCubedSphere()) {
+        return cloc;
+    }
+    cloc->Delete();
+    return NULL;
+}
+
+
+const char*
+LocatorFactory::getNames() {
+    return "auto, vtk, octree, bins2d, bvh, structured";
+}
+
+
+bool
+LocatorFactory::isValid(const std::string& name) {
+    return name == "auto" || name == "vtk" || name == "octree" || name == "bins2d" ||
+           name == "bvh" || name == "structured";
+}
+
+
+std::string
+LocatorFactory::getDefaultName(vtkDataSet* grid, bool cached) {
+    if (!cached) {
+        return "vtk";
+    }
+    // quads in the z = 0 plane are located analytically if they form a lat-lon or a 
+    // cubed-sphere grid and binned in 2d otherwise. Other grids go into an octree
+    return mvtkCellLocator2d::IsPlanarQuadGrid(grid)? "auto": "octree";
+}
+
+
+vtkAbstractCellLocator*
+LocatorFactory::create(const std::string& name, vtkDataSet* grid, int numCellsPerBucket,
+                       int numThreads) {
+
+    vtkAbstractCellLocator* loc = NULL;
+    if (name == "auto") {
+        loc = __mnt_locatorfactory_newStructured(grid);
+        if (loc) {
+            return loc;
+        }
+        return LocatorFactory::create(mvtkCellLocator2d::IsPlanarQuadGrid(grid)? "bins2d": "vtk",
+                                      grid, numCellsPerBucket, numThreads);
+    }
+    else if (name == "structured") {
+        return __mnt_locatorfactory_newStructured(grid);
+    }
+    else if (name == "vtk") {
+        loc = vtkCellLocator::New();
+    }
+    else if (name == "octree") {
+        mvtkCellLocator* oloc = mvtkCellLocator::New();
+        oloc->SetNumberOfThreads(numThreads);
+        loc = oloc;
+    }
+    else if (name == "bins2d") {
+        if (!mvtkCellLocator2d::IsPlanarQuadGrid(grid)) {
+            return NULL;
+        }
+        loc = mvtkCellLocator2d::New();
+    }
+    else if (name == "bvh") {
+        loc = mvtkAdaptiveCellLocator::New();
+    }
+    else {
+        return NULL;
+    }
+    loc->SetDataSet(grid);
+    loc->SetNumberOfCellsPerNode(numCellsPerBucket);
+    loc->BuildLocator();
+    return loc;
+}
+
+
+vtkAbstractCellLocator*
+LocatorFactory::createCached(const std::string& name, vtkDataSet* grid, int numCellsPerBucket,
+                             const std::string& cacheFile, int numThreads) {
+
+    if (cacheFile.empty()) {
+        return LocatorFactory::create(name, grid, numCellsPerBucket, numThreads);
+    }
+
+    vtkAbstractCellLocator* loc = LocatorFile::load(cacheFile.c_str(), grid, numCellsPerBucket);
+    if (loc && name != "auto" && LocatorFactory::getName(loc) != name) {
+        // ignore a cached locator of another type than the one requested
+        loc->Delete();
+        loc = NULL;
+    }
+    if (loc) {
+        return loc;
+    }
+
+    loc = LocatorFactory::create(name, grid, numCellsPerBucket, numThreads);
+    if (!loc) {
+        return loc;
+    }
+
+    // write a temporary file in the same directory and move it over the cache file, so
+    // that concurrent jobs never read a partially written file
+    std::ostringstream tmpFile;
+    tmpFile << cacheFile << ".tmp" << getpid();
+    if (LocatorFile::save(loc, tmpFile.str().c_str()) != 0 ||
+        std::rename(tmpFile.str().c_str(), cacheFile.c_str()) != 0) {
+        std::remove(tmpFile.str().c_str());
+        std::cerr << "LocatorFactory::createCached: Warning: could not save the \""
+                  << LocatorFactory::getName(loc) << "\" locator in " << cacheFile << '\n';
+    }
+    return loc;
+}
+
+
+std::string
+LocatorFactory::getName(vtkAbstractCellLocator* locator) {
+
+    if (dynamic_cast<vtkCellLocator*>(locator)) {
+        return "vtk";
+    }
+    if (dynamic_cast<mvtkCellLocator*>(locator)) {
+        return "octree";
+    }
+    if (dynamic_cast<mvtkCellLocator2d*>(locator)) {
+        return "bins2d";
+    }
+    if (dynamic_cast<mvtkAdaptiveCellLocator*>(locator)) {
+        return "bvh";
+    }
+    if (dynamic_cast<mvtkRectilinearCellLocator*>(locator) ||
+        dynamic_cast<mvtkCubedSphereCellLocator*>(locator)) {
+        return "structured";
+    }
+    return "";
+}
+
+
+bool
+LocatorFactory::hasConcurrentQueries(vtkAbstractCellLocator* locator) {
+    // vtkCellLocator marks the visited cells in the locator. mvtkCellLocator keeps them
+    // in the mvtkCellLocatorQuery of each LocatorQuery
+    std::string name = LocatorFactory::getName(locator);
+    return name == "octree" || name == "bins2d" || name == "bvh" || name == "structured";
+}
@@ -0,0 +1,96 @@
+#include <string>
+#include <vtkDataSet.h>
+#include <vtkAbstractCellLocator.h>
+
+#ifndef MNT_LOCATOR_FACTORY
+#define MNT_LOCATOR_FACTORY
+
+/**
+ * Create cell locators from their name, so that the search structure can be
+ * chosen at run time. The available locators are:
+ *
+ *   "auto":       "structured" if the grid is lat-lon or cubed-sphere, "bins2d" for
+ *                 other quad grids in the z = 0 plane and "vtk" otherwise
+ *   "vtk":        vtkCellLocator, uniform octree
+ *   "octree":     mvtkCellLocator, uniform octree with a flat bucket storage
+ *   "bins2d":     mvtkCellLocator2d, uniform 2d buckets (quad grids in the z = 0 plane)
+ *   "bvh":        mvtkAdaptiveCellLocator, adaptive-depth bounding volume hierarchy
+ *   "structured": mvtkRectilinearCellLocator or mvtkCubedSphereCellLocator, analytic
+ *                 location on lat-lon or cubed-sphere grids
+ */
+class LocatorFactory {
+
+public:
+
+    /**
+     * Get the names of the locators
+     * @return comma separated names
+     */
+    static const char* getNames();
+
+    /**
+     * Check that a locator name is valid
+     * @param name locator name
+     * @return true if valid
+     */
+    static bool isValid(const std::string& name);
+
+    /**
+     * Get the name of the locator used when none is specified
+     * @param grid grid
+     * @param cached whether the locator is cached in a file
+     * @return "vtk" if not cached, as the vtkCellLocator cannot be saved, otherwise 
+     *         "auto" for quad grids in the z = 0 plane and "octree" for other grids
+     */
+    static std::string getDefaultName(vtkDataSet* grid, bool cached);
+
+    /**
+     * Create and build a locator
+     * @param name locator name
+     * @param grid grid
+     * @param numCellsPerBucket average number of cells per bucket
+     * @param numThreads number of threads building the locator ("octree" only)
+     * @return locator, NULL if the name is not valid or if the locator does not support
+     *         the grid. The caller should delete it
+     */
+    static vtkAbstractCellLocator* create(const std::string& name, vtkDataSet* grid,
+                                          int numCellsPerBucket, int numThreads=1);
+
+    /**
+     * Load a locator from a cache file, or create and build it and save it in the file
+     * @param name locator name, a cached locator of another type is ignored unless
+     *             the name is "auto"
+     * @param grid grid
+     * @param numCellsPerBucket average number of cells per bucket, a cached bucket
+     *                          locator built with another value is ignored
+     * @param cacheFile cache file name, no caching if empty
+     * @param numThreads number of threads building the locator ("octree" only)
+     * @return locator, NULL if the name is not valid or if the locator does not support
+     *         the grid. The caller should delete it
+     * @note the file is written under a temporary name and renamed, jobs sharing the
+     *       cache file never see it partially written. A warning is printed if the
+     *       locator cannot be saved, as is the case of the "vtk" and "bvh" locators
+     */
+    static vtkAbstractCellLocator* createCached(const std::string& name, vtkDataSet* grid,
+                                                int numCellsPerBucket,
+                                                const std::string& cacheFile,
+                                                int numThreads=1);
+
+    /**
+     * Get the name of the locator that creates a given locator instance
+     * @param locator locator
+     * @return name, never "auto", empty if the locator was not created by this factory
+     */
+    static std::string getName(vtkAbstractCellLocator* locator);
+
+    /**
+     * Check whether a locator can be searched concurrently from several threads, each
+     * thread going through its own LocatorQuery
+     * @param locator locator
+     * @return true if the locator can be shared across threads
+     */
+    static bool hasConcurrentQueries(vtkAbstractCellLocator* locator);
+
+};
+
+#endif // MNT_LOCATOR_FACTORY
@@ -0,0 +1,373 @@
+#include <mntLocatorFile.h>
+#include <mvtkCellLocator.h>
+#include <mvtkCellLocator2d.h>
+#include <mvtkRectilinearCellLocator.h>
+#include <mvtkCubedSphereCellLocator.h>
+#include <vtkIdList.h>
+#include <cstring>
+
+// format of the file, increment when the layout changes
+const uint32_t LOCATOR_FILE_VERSION = 2;
+const size_t LOCATOR_FILE_HEADER_SIZE = 72;
+const size_t LOCATOR_FILE_KIND_SIZE = 32;
+const char LOCATOR_FILE_MAGIC[8] = "MINTLOC";
+// written in native byte order, reads back differently on another byte order
+const uint32_t LOCATOR_FILE_BYTE_ORDER_MARK = 0x01020304;
+
+/**
+ * Header of a locator file, stored as 72 bytes
+ */
+struct LocatorFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    char kind[LOCATOR_FILE_KIND_SIZE];
+    uint64_t fingerprint;
+    uint64_t numCells;
+    int64_t numCellsPerBucket;
+};
+
+static void __mnt_locatorfile_pack(const LocatorFileHeader& header, char buffer[]) {
+    std::memset(buffer, 0, LOCATOR_FILE_HEADER_SIZE);
+    char* p = buffer;
+    std::memcpy(p, header.magic, 8); p += 8;
+    std::memcpy(p, &header.version, 4); p += 4;
+    std::memcpy(p, &header.byteOrderMark, 4); p += 4;
+    std::memcpy(p, header.kind, LOCATOR_FILE_KIND_SIZE); p += LOCATOR_FILE_KIND_SIZE;
+    std::memcpy(p, &header.fingerprint, 8); p += 8;
+    std::memcpy(p, &header.numCells, 8); p += 8;
+    std::memcpy(p, &header.numCellsPerBucket, 8);
+}
+
+static void __mnt_locatorfile_unpack(const char buffer[], LocatorFileHeader& header) {
+    const char* p = buffer;
+    std::memcpy(header.magic, p, 8); p += 8;
+    std::memcpy(&header.version, p, 4); p += 4;
+    std::memcpy(&header.byteOrderMark, p, 4); p += 4;
+    std::memcpy(header.kind, p, LOCATOR_FILE_KIND_SIZE); p += LOCATOR_FILE_KIND_SIZE;
+    std::memcpy(&header.fingerprint, p, 8); p += 8;
+    std::memcpy(&header.numCells, p, 8); p += 8;
+    std::memcpy(&header.numCellsPerBucket, p, 8);
+    header.kind[LOCATOR_FILE_KIND_SIZE - 1] = '\0';
+}
+
+static int __mnt_locatorfile_readHeader(FILE* f, LocatorFileHeader& header) {
+    char buffer[LOCATOR_FILE_HEADER_SIZE];
+    if (fread(buffer, 1, LOCATOR_FILE_HEADER_SIZE, f) != LOCATOR_FILE_HEADER_SIZE) {
+        return 2;
+    }
+    __mnt_locatorfile_unpack(buffer, header);
+    if (std::memcmp(header.magic, LOCATOR_FILE_MAGIC, 8) != 0 ||
+        header.version != LOCATOR_FILE_VERSION ||
+        header.byteOrderMark != LOCATOR_FILE_BYTE_ORDER_MARK) {
+        return 2;
+    }
+    return 0;
+}
+
+
+LocatorFile::LocatorFile() {
+    this->file = NULL;
+}
+
+
+LocatorFile::~LocatorFile() {
+    this->close();
+}
+
+
+uint64_t
+LocatorFile::getFingerprint(vtkDataSet* grid) {
+
+    // 64-bit FNV-1a hash
+    const uint64_t prime = 1099511628211ULL;
+    uint64_t hash = 14695981039346656037ULL;
+
+    vtkIdList* ptIds = vtkIdList::New();
+    double x[3];
+    vtkIdType numCells = grid->GetNumberOfCells();
+    for (vtkIdType cellId = 0; cellId < numCells; ++cellId) {
+
+        int64_t cellType = grid->GetCellType(cellId);
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&cellType);
+        for (size_t k = 0; k < sizeof(cellType); ++k) {
+            hash = (hash ^ bytes[k]) * prime;
+        }
+
+        grid->GetCellPoints(cellId, ptIds);
+        for (vtkIdType i = 0; i < ptIds->GetNumberOfIds(); ++i) {
+            grid->GetPoint(ptIds->GetId(i), x);
+            bytes = reinterpret_cast<const unsigned char*>(x);
+            for (size_t k = 0; k < sizeof(x); ++k) {
+                hash = (hash ^ bytes[k]) * prime;
+            }
+        }
+    }
+    ptIds->Delete();
+
+    return hash;
+}
+
+
+int
+LocatorFile::getKind(const char* filename, std::string& kind, int* numCellsPerBucket) {
+
+    FILE* f = fopen(filename, "rb");
+    if (!f) {
+        return 1;
+    }
+    LocatorFileHeader header;
+    int ier = __mnt_locatorfile_readHeader(f, header);
+    fclose(f);
+    if (ier != 0) {
+        return ier;
+    }
+    kind = std::string(header.kind);
+    if (numCellsPerBucket) {
+        *numCellsPerBucket = (int) header.numCellsPerBucket;
+    }
+    return 0;
+}
+
+
+int
+LocatorFile::save(vtkAbstractCellLocator* locator, const char* filename) {
+
+    int ok = 0;
+    if (mvtkCellLocator* oloc = dynamic_cast<mvtkCellLocator*>(locator)) {
+        ok = oloc->WriteLocator(filename);
+    }
+    else if (mvtkRectilinearCellLocator* rloc = dynamic_cast<mvtkRectilinearCellLocator*>(locator)) {
+        ok = rloc->WriteLocator(filename);
+    }
+    else if (mvtkCubedSphereCellLocator* cloc = dynamic_cast<mvtkCubedSphereCellLocator*>(locator)) {
+        ok = cloc->WriteLocator(filename);
+    }
+    else if (mvtkCellLocator2d* loc2d = dynamic_cast<mvtkCellLocator2d*>(locator)) {
+        ok = loc2d->WriteLocator(filename);
+    }
+    return ok? 0: 1;
+}
+
+
+vtkAbstractCellLocator*
+LocatorFile::load(const char* filename, vtkDataSet* grid, int numCellsPerBucket) {
+
+    std::string kind;
+    int savedNumCellsPerBucket;
+    if (LocatorFile::getKind(filename, kind, &savedNumCellsPerBucket) != 0) {
+        return NULL;
+    }
+    if (numCellsPerBucket < 0) {
+        numCellsPerBucket = savedNumCellsPerBucket;
+    }
+
+    // the bucket locators check the bucket setting when reading the file
+    if (kind == "mvtkCellLocator") {
+        mvtkCellLocator* loc = mvtkCellLocator::New();
+        loc->SetDataSet(grid);
+        loc->SetNumberOfCellsPerNode(numCellsPerBucket);
+        if (loc->ReadLocator(filename)) {
+            return loc;
+        }
+        loc->Delete();
+    }
+    else if (kind == "mvtkRectilinearCellLocator") {
+        mvtkRectilinearCellLocator* loc = mvtkRectilinearCellLocator::New();
+        loc->SetDataSet(grid);
+        if (loc->ReadLocator(filename)) {
+            return loc;
+        }
+        loc->Delete();
+    }
+    else if (kind == "mvtkCubedSphereCellLocator") {
+        mvtkCubedSphereCellLocator* loc = mvtkCubedSphereCellLocator::New();
+        loc->SetDataSet(grid);
+        if (loc->ReadLocator(filename)) {
+            return loc;
+        }
+        loc->Delete();
+    }
+    else if (kind == "mvtkCellLocator2d") {
+        mvtkCellLocator2d* loc = mvtkCellLocator2d::New();
+        loc->SetDataSet(grid);
+        loc->SetNumberOfCellsPerNode(numCellsPerBucket);
+        if (loc->ReadLocator(filename)) {
+            return loc;
+        }
+        loc->Delete();
+    }
+    return NULL;
+}
+
+
+bool
+LocatorFile::checkBuckets(const std::vector<vtkIdType>& offsets,
+                          const std::vector<vtkIdType>& cellIds,
+                          size_t numBuckets, vtkIdType numCells) {
+
+    if (offsets.size() != numBuckets + 1) {
+        return false;
+    }
+    return LocatorFile::checkBuckets(offsets.data(), cellIds.data(), cellIds.size(),
+                                     numBuckets, numCells);
+}
+
+
+bool
+LocatorFile::checkBuckets(const vtkIdType* offsets, const vtkIdType* cellIds,
+                          size_t numCellIds, size_t numBuckets, vtkIdType numCells) {
+
+    if (offsets[0] != 0 || offsets[numBuckets] != (vtkIdType) numCellIds) {
+        return false;
+    }
+    for (size_t i = 0; i < numBuckets; ++i) {
+        if (offsets[i + 1] < offsets[i]) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < numCellIds; ++i) {
+        if (cellIds[i] < 0 || cellIds[i] >= numCells) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+int
+LocatorFile::openForWriting(const char* filename, const char* kind, vtkDataSet* grid,
+                            int numCellsPerBucket) {
+
+    this->close();
+    if (std::strlen(kind) >= LOCATOR_FILE_KIND_SIZE) {
+        return 2;
+    }
+
+    LocatorFileHeader header;
+    std::memcpy(header.magic, LOCATOR_FILE_MAGIC, 8);
+    header.version = LOCATOR_FILE_VERSION;
+    header.byteOrderMark = LOCATOR_FILE_BYTE_ORDER_MARK;
+    std::memset(header.kind, 0, LOCATOR_FILE_KIND_SIZE);
+    std::strcpy(header.kind, kind);
+    header.fingerprint = LocatorFile::getFingerprint(grid);
+    header.numCells = grid->GetNumberOfCells();
+    header.numCellsPerBucket = numCellsPerBucket;
+
+    this->file = fopen(filename, "wb");
+    if (!this->file) {
+        return 1;
+    }
+    char buffer[LOCATOR_FILE_HEADER_SIZE];
+    __mnt_locatorfile_pack(header, buffer);
+    if (fwrite(buffer, 1, LOCATOR_FILE_HEADER_SIZE, this->file) != LOCATOR_FILE_HEADER_SIZE) {
+        this->close();
+        return 1;
+    }
+    return 0;
+}
+
+
+int
+LocatorFile::openForReading(const char* filename, const char* kind, vtkDataSet* grid,
+                            int numCellsPerBucket) {
+
+    this->close();
+    this->file = fopen(filename, "rb");
+    if (!this->file) {
+        return 1;
+    }
+
+    LocatorFileHeader header;
+    int ier = __mnt_locatorfile_readHeader(this->file, header);
+    if (ier != 0) {
+        this->close();
+        return ier;
+    }
+    if (std::strcmp(header.kind, kind) != 0) {
+        this->close();
+        return 3;
+    }
+    if (header.numCells != (uint64_t) grid->GetNumberOfCells() ||
+        header.fingerprint != LocatorFile::getFingerprint(grid)) {
+        this->close();
+        return 4;
+    }
+    if (header.numCellsPerBucket != numCellsPerBucket) {
+        this->close();
+        return 5;
+    }
+    return 0;
+}
+
+
+int
+LocatorFile::close() {
+    int ier = 0;
+    if (this->file) {
+        ier = fclose(this->file);
+        this->file = NULL;
+    }
+    return ier == 0? 0: 1;
+}
+
+
+int
+LocatorFile::__writeArray(const void* data, size_t elemSize, size_t n) {
+
+    if (!this->file) {
+        return 1;
+    }
+    uint64_t sizes[] = {n, elemSize};
+    if (fwrite(sizes, sizeof(uint64_t), 2, this->file) != 2) {
+        return 1;
+    }
+    if (n > 0 && fwrite(data, elemSize, n, this->file) != n) {
+        return 1;
+    }
+    // keep the next array 8 byte aligned
+    const char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    size_t pad = (8 - (elemSize*n) % 8) % 8;
+    if (pad > 0 && fwrite(zeros, 1, pad, this->file) != pad) {
+        return 1;
+    }
+    return 0;
+}
+
+
+int
+LocatorFile::__readArrayHeader(size_t elemSize, uint64_t* n) {
+
+    if (!this->file) {
+        return 1;
+    }
+    uint64_t sizes[2];
+    if (fread(sizes, sizeof(uint64_t), 2, this->file) != 2 || sizes[1] != elemSize) {
+        return 1;
+    }
+    // guard against a truncated or corrupted file before allocating
+    long pos = ftell(this->file);
+    if (fseek(this->file, 0, SEEK_END) != 0) {
+        return 1;
+    }
+    long end = ftell(this->file);
+    if (fseek(this->file, pos, SEEK_SET) != 0 || sizes[0] > (uint64_t) (end - pos) / elemSize) {
+        return 1;
+    }
+    *n = sizes[0];
+    return 0;
+}
+
+
+int
+LocatorFile::__readArrayData(void* data, size_t elemSize, size_t n) {
+
+    if (n > 0 && fread(data, elemSize, n, this->file) != n) {
+        return 1;
+    }
+    size_t pad = (8 - (elemSize*n) % 8) % 8;
+    if (pad > 0 && fseek(this->file, (long) pad, SEEK_CUR) != 0) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,196 @@
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <vtkDataSet.h>
+#include <vtkAbstractCellLocator.h>
+
+#ifndef MNT_LOCATOR_FILE
+#define MNT_LOCATOR_FILE
+
+/**
+ * Binary file holding the search structure of a built cell locator, so that it
+ * can be reloaded instead of rebuilt.
+ *
+ * The file starts with a 72 byte header: the magic string "MINTLOC", the format
+ * version, a byte order mark, the locator class name, a fingerprint of the grid's
+ * cell vertices, the number of grid cells and the number of cells per bucket the
+ * locator was built with (0 if it does not use buckets). It is followed by a sequence of
+ * arrays, each made of its number of elements and element size (8 byte integers)
+ * and of its data, padded to a multiple of 8 bytes. All the arrays are thus 8 byte
+ * aligned and can be memory mapped. The file is only read back on a machine with
+ * the same byte order and element sizes (e.g. of vtkIdType), for a grid with
+ * the same fingerprint and for the same number of cells per bucket.
+ */
+class LocatorFile {
+
+public:
+
+    /**
+     * Constructor
+     */
+    LocatorFile();
+
+    /**
+     * Destructor, closes the file
+     */
+    ~LocatorFile();
+
+    /**
+     * Compute the fingerprint of a grid, a hash of the cell types and of the
+     * coordinates of the cell vertices
+     * @param grid grid
+     * @return fingerprint
+     */
+    static uint64_t getFingerprint(vtkDataSet* grid);
+
+    /**
+     * Get the locator class name stored in a file
+     * @param filename file name
+     * @param kind locator class name (output)
+     * @param numCellsPerBucket number of cells per bucket the locator was built with,
+     *                          0 if it does not use buckets (output, may be NULL)
+     * @return error code (0 is OK)
+     */
+    static int getKind(const char* filename, std::string& kind, int* numCellsPerBucket = NULL);
+
+    /**
+     * Save a built locator. Only the mvtkCellLocator, mvtkCellLocator2d,
+     * mvtkRectilinearCellLocator and mvtkCubedSphereCellLocator locators can be saved
+     * @param locator locator
+     * @param filename file name
+     * @return error code (0 is OK)
+     */
+    static int save(vtkAbstractCellLocator* locator, const char* filename);
+
+    /**
+     * Create a locator from a file
+     * @param filename file name
+     * @param grid grid the locator is attached to, must match the grid of the saved
+     *             locator
+     * @param numCellsPerBucket number of cells per bucket, must match the setting of the
+     *                          saved locator if it uses buckets. A negative value
+     *                          accepts the saved setting
+     * @return locator, NULL if the file cannot be read or does not match the grid or
+     *         the bucket setting. The caller should delete the locator
+     */
+    static vtkAbstractCellLocator* load(const char* filename, vtkDataSet* grid,
+                                        int numCellsPerBucket = -1);
+
+    /**
+     * Check the bucket arrays read from a file
+     * @param offsets offset of each bucket into cellIds, numBuckets + 1 values
+     * @param cellIds cell Ids of all the buckets, concatenated
+     * @param numBuckets expected number of buckets
+     * @param numCells number of grid cells
+     * @return true if the offsets are consistent and the cell Ids are in range
+     */
+    static bool checkBuckets(const std::vector<vtkIdType>& offsets,
+                             const std::vector<vtkIdType>& cellIds,
+                             size_t numBuckets, vtkIdType numCells);
+
+    /**
+     * Check the bucket arrays read from a file
+     * @param offsets offset of each bucket into cellIds, numBuckets + 1 values
+     * @param cellIds cell Ids of all the buckets, concatenated
+     * @param numCellIds size of cellIds
+     * @param numBuckets expected number of buckets
+     * @param numCells number of grid cells
+     * @return true if the offsets are consistent and the cell Ids are in range
+     */
+    static bool checkBuckets(const vtkIdType* offsets, const vtkIdType* cellIds,
+                             size_t numCellIds, size_t numBuckets, vtkIdType numCells);
+
+    /**
+     * Create a file and write the header
+     * @param filename file name
+     * @param kind locator class name
+     * @param grid grid the locator is attached to
+     * @param numCellsPerBucket number of cells per bucket the locator was built with,
+     *                          0 if it does not use buckets
+     * @return error code (0 is OK)
+     */
+    int openForWriting(const char* filename, const char* kind, vtkDataSet* grid,
+                       int numCellsPerBucket);
+
+    /**
+     * Open a file and check its header
+     * @param filename file name
+     * @param kind expected locator class name
+     * @param grid grid the locator is attached to
+     * @param numCellsPerBucket expected number of cells per bucket, 0 if the locator
+     *                          does not use buckets
+     * @return error code (0 is OK, 1 if the file cannot be opened, 2 if the format is
+     *         not supported, 3 if the locator class differs, 4 if the grid differs,
+     *         5 if the number of cells per bucket differs)
+     */
+    int openForReading(const char* filename, const char* kind, vtkDataSet* grid,
+                       int numCellsPerBucket);
+
+    /**
+     * Write an array
+     * @param data array
+     * @return error code (0 is OK)
+     */
+    template <class T>
+    int write(const std::vector<T>& data) {
+        return this->__writeArray(data.data(), sizeof(T), data.size());
+    }
+
+    /**
+     * Read an array
+     * @param data array, resized to the number of elements in the file (output)
+     * @return error code (0 is OK)
+     */
+    template <class T>
+    int read(std::vector<T>& data) {
+        uint64_t n;
+        if (this->__readArrayHeader(sizeof(T), &n) != 0) {
+            return 1;
+        }
+        data.resize(n);
+        return this->__readArrayData(data.data(), sizeof(T), n);
+    }
+
+    /**
+     * Write an array
+     * @param data array
+     * @param n number of elements
+     * @return error code (0 is OK)
+     */
+    template <class T>
+    int write(const T* data, size_t n) {
+        return this->__writeArray(data, sizeof(T), n);
+    }
+
+    /**
+     * Read an array of known size
+     * @param data array of n elements (output)
+     * @param n number of elements, must match the number of elements in the file
+     * @return error code (0 is OK)
+     */
+    template <class T>
+    int read(T* data, size_t n) {
+        uint64_t nFile;
+        if (this->__readArrayHeader(sizeof(T), &nFile) != 0 || nFile != n) {
+            return 1;
+        }
+        return this->__readArrayData(data, sizeof(T), n);
+    }
+
+    /**
+     * Close the file
+     * @return error code (0 is OK)
+     */
+    int close();
+
+private:
+
+    int __writeArray(const void* data, size_t elemSize, size_t n);
+    int __readArrayHeader(size_t elemSize, uint64_t* n);
+    int __readArrayData(void* data, size_t elemSize, size_t n);
+
+    FILE* file;
+};
+
+#endif // MNT_LOCATOR_FILE
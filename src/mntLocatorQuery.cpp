@@ -0,0 +1,69 @@
+#include <mntLocatorQuery.h>
+#include <mvtkCellLocator.h>
+
+LocatorQuery::LocatorQuery(vtkAbstractCellLocator* locator) {
+    this->octreeQuery = NULL;
+    this->__setLocator(locator);
+}
+
+
+LocatorQuery::LocatorQuery(const LocatorQuery& other) {
+    this->octreeQuery = NULL;
+    this->__setLocator(other.locator);
+}
+
+
+LocatorQuery&
+LocatorQuery::operator=(const LocatorQuery& other) {
+    if (this != &other && this->locator != other.locator) {
+        this->__setLocator(other.locator);
+    }
+    return *this;
+}
+
+
+LocatorQuery::~LocatorQuery() {
+    delete this->octreeQuery;
+}
+
+
+void
+LocatorQuery::__setLocator(vtkAbstractCellLocator* locator) {
+    delete this->octreeQuery;
+    this->octreeQuery = NULL;
+    this->locator = locator;
+    this->octree = dynamic_cast<mvtkCellLocator*>(locator);
+    if (this->octree) {
+        this->octreeQuery = new mvtkCellLocatorQuery;
+    }
+}
+
+
+vtkIdType
+LocatorQuery::findCell(double x[], double tol2, vtkGenericCell* cell,
+                       double pcoords[], double weights[]) {
+    if (this->octree) {
+        return this->octree->FindCell(x, tol2, this->octreeQuery, pcoords, weights);
+    }
+    return this->locator->FindCell(x, tol2, cell, pcoords, weights);
+}
+
+
+void
+LocatorQuery::findCellsAlongLine(double p1[], double p2[], double tol, vtkIdList* cellIds) {
+    if (this->octree) {
+        this->octree->FindCellsAlongLine(p1, p2, tol, cellIds, this->octreeQuery);
+        return;
+    }
+    this->locator->FindCellsAlongLine(p1, p2, tol, cellIds);
+}
+
+
+void
+LocatorQuery::findCellsWithinBounds(double bbox[], vtkIdList* cellIds) {
+    if (this->octree) {
+        this->octree->FindCellsWithinBounds(bbox, cellIds, this->octreeQuery);
+        return;
+    }
+    this->locator->FindCellsWithinBounds(bbox, cellIds);
+}
@@ -0,0 +1,95 @@
+#include <vtkAbstractCellLocator.h>
+#include <vtkGenericCell.h>
+#include <vtkIdList.h>
+
+#ifndef MNT_LOCATOR_QUERY
+#define MNT_LOCATOR_QUERY
+
+class mvtkCellLocator;
+class mvtkCellLocatorQuery;
+
+/**
+ * Search a built cell locator through a per-caller object, so that one locator can be
+ * shared by several threads, each with its own LocatorQuery. The searches of an
+ * mvtkCellLocator go through its thread safe overloads with a private
+ * mvtkCellLocatorQuery, those of the other locators are forwarded unchanged.
+ */
+class LocatorQuery {
+
+public:
+
+    /**
+     * Constructor
+     * @param locator cell locator, must have been built. The locator is borrowed, not owned
+     */
+    LocatorQuery(vtkAbstractCellLocator* locator);
+
+    /**
+     * Copy constructor, the copy searches the same locator with its own scratch space
+     * @param other object to copy
+     */
+    LocatorQuery(const LocatorQuery& other);
+
+    /**
+     * Assignment operator, the scratch space is not shared
+     * @param other object to copy
+     * @return this object
+     */
+    LocatorQuery& operator=(const LocatorQuery& other);
+
+    /**
+     * Destructor
+     */
+    ~LocatorQuery();
+
+    /**
+     * Get the locator
+     * @return locator
+     */
+    vtkAbstractCellLocator* getLocator() const {
+        return this->locator;
+    }
+
+    /**
+     * Find the cell containing a point
+     * @param x point
+     * @param tol2 tolerance passed to the locator
+     * @param cell work object, only used by the locators other than mvtkCellLocator
+     * @param pcoords parametric coordinates in the cell (output)
+     * @param weights interpolation weights (output)
+     * @return cell Id, negative if the point is outside the grid
+     */
+    vtkIdType findCell(double x[], double tol2, vtkGenericCell* cell,
+                       double pcoords[], double weights[]);
+
+    /**
+     * Find the cells whose buckets intersect a line
+     * @param p1 start point
+     * @param p2 end point
+     * @param tol tolerance passed to the locator
+     * @param cellIds cell Ids (output)
+     */
+    void findCellsAlongLine(double p1[], double p2[], double tol, vtkIdList* cellIds);
+
+    /**
+     * Find the cells whose buckets intersect a box
+     * @param bbox box xmin, xmax, ymin, ymax, zmin, zmax
+     * @param cellIds cell Ids (output)
+     */
+    void findCellsWithinBounds(double bbox[], vtkIdList* cellIds);
+
+private:
+
+    // the locator
+    vtkAbstractCellLocator* locator;
+
+    // the locator if it is an mvtkCellLocator, NULL otherwise
+    mvtkCellLocator* octree;
+
+    // scratch space of the octree searches
+    mvtkCellLocatorQuery* octreeQuery;
+
+    void __setLocator(vtkAbstractCellLocator* locator);
+};
+
+#endif // MNT_LOCATOR_QUERY
@@ -0,0 +1,54 @@
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+#ifndef MNT_PARALLEL
+#define MNT_PARALLEL
+
+/**
+ * Get the start index of a chunk
+ * @param numThreads number of chunks
+ * @param n number of items
+ * @param threadId chunk index, 0 <= threadId <= numThreads
+ * @return index
+ * @note chunk threadId covers [mntChunkBegin(threadId), mntChunkBegin(threadId + 1))
+ */
+inline size_t mntChunkBegin(int numThreads, size_t n, int threadId) {
+    return (n * (size_t) threadId) / (size_t) numThreads;
+}
+
+/**
+ * Execute a task over the index range [0, n), split into contiguous chunks
+ * @param numThreads number of threads (values < 1 are treated as 1)
+ * @param n number of items
+ * @param task callable with signature void(int threadId, size_t begin, size_t end)
+ * @note chunks are ordered by threadId. Chunk 0 runs on the calling thread, the
+ *       function returns after all the chunks have been processed.
+ */
+template <class Task>
+void mntParallelFor(int numThreads, size_t n, Task task) {
+
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+    // no point in having threads without work
+    if ((size_t) numThreads > n) {
+        numThreads = n > 0? (int) n: 1;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(numThreads - 1);
+    for (int threadId = 1; threadId < numThreads; ++threadId) {
+        workers.push_back(std::thread(task, threadId,
+                                      mntChunkBegin(numThreads, n, threadId),
+                                      mntChunkBegin(numThreads, n, threadId + 1)));
+    }
+
+    task(0, mntChunkBegin(numThreads, n, 0), mntChunkBegin(numThreads, n, 1));
+
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+}
+
+#endif // MNT_PARALLEL
@@ -0,0 +1,87 @@
+#include <mntPointLocationCache.h>
+#include <mntParallel.h>
+#include <mntLocatorQuery.h>
+#include <vtkGenericCell.h>
+#include <algorithm>
+#include <limits>
+
+/**
+ * Order point indices by coordinates, then by index
+ */
+struct PointCoordCmpFunctor {
+    PointCoordCmpFunctor(const std::vector<double>& coords) : xyz(coords) {}
+    bool operator()(size_t i, size_t j) const {
+        for (size_t d = 0; d < 3; ++d) {
+            if (this->xyz[3*i + d] < this->xyz[3*j + d]) return true;
+            if (this->xyz[3*i + d] > this->xyz[3*j + d]) return false;
+        }
+        return i < j;
+    }
+    const std::vector<double>& xyz;
+};
+
+
+PointLocationCache::PointLocationCache(int ndims) {
+    this->ndims = ndims;
+}
+
+
+void
+PointLocationCache::build(vtkPoints* points, vtkAbstractCellLocator* locator, int numThreads) {
+
+    // same tolerance as PolysegmentIter
+    const double eps = 10 * std::numeric_limits<double>::epsilon();
+
+    size_t numPoints = points->GetNumberOfPoints();
+    std::vector<double> coords(3*numPoints);
+    for (size_t i = 0; i < numPoints; ++i) {
+        points->GetPoint(i, &coords[3*i]);
+        if (this->ndims == 2) {
+            coords[3*i + 2] = 0.0;
+        }
+    }
+
+    // gather the points with the same coordinates
+    std::vector<size_t> order(numPoints);
+    for (size_t i = 0; i < numPoints; ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), PointCoordCmpFunctor(coords));
+
+    this->uniqueIds.resize(numPoints);
+    std::vector<size_t> repPtIds; // a representative point Id for each unique point
+    repPtIds.reserve(numPoints);
+    for (size_t k = 0; k < numPoints; ++k) {
+        size_t i = order[k];
+        if (k == 0 ||
+            coords[3*i + 0] != coords[3*repPtIds.back() + 0] ||
+            coords[3*i + 1] != coords[3*repPtIds.back() + 1] ||
+            coords[3*i + 2] != coords[3*repPtIds.back() + 2]) {
+            repPtIds.push_back(i);
+        }
+        this->uniqueIds[i] = repPtIds.size() - 1;
+    }
+
+    // locate each unique point once
+    size_t numUniquePoints = repPtIds.size();
+    this->cellIds.resize(numUniquePoints);
+    this->xis.assign(3*numUniquePoints, 0.0);
+    PointLocationCache* cache = this;
+    mntParallelFor(numThreads, numUniquePoints,
+                   [cache, locator, eps, &coords, &repPtIds](int /*threadId*/, size_t beg, size_t end) {
+        LocatorQuery locQuery(locator);
+        vtkGenericCell* cell = vtkGenericCell::New();
+        double weights[8];
+        for (size_t k = beg; k < end; ++k) {
+            cache->cellIds[k] = locQuery.findCell(&coords[3*repPtIds[k]], eps, cell,
+                                                  &cache->xis[3*k], weights);
+        }
+        cell->Delete();
+    });
+}
+
+
+size_t
+PointLocationCache::getNumberOfUniquePoints() const {
+    return this->cellIds.size();
+}
@@ -0,0 +1,74 @@
+#include <vector>
+#include <vtkPoints.h>
+#include <vtkUnstructuredGrid.h>
+#include <vtkAbstractCellLocator.h>
+
+#ifndef MNT_POINT_LOCATION_CACHE
+#define MNT_POINT_LOCATION_CACHE
+
+/**
+ * Cache of the (cell Id, cell parametric coordinates) locations of a set of
+ * points in a grid. Points that are shared by several cells (and possibly
+ * duplicated in the vtkPoints array) are located only once.
+ */
+class PointLocationCache {
+
+public:
+
+    /**
+     * Constructor
+     * @param ndims number of dimensions (2 or 3). In 2d, the z coordinate of the
+     *              points is ignored and set to zero
+     */
+    PointLocationCache(int ndims);
+
+    /**
+     * Locate the points in the grid
+     * @param points points to locate
+     * @param locator cell locator attached to the grid, must have been built
+     * @param numThreads number of threads
+     * @note the locator is shared across the threads, each thread searches it
+     *       through its own LocatorQuery
+     */
+    void build(vtkPoints* points, vtkAbstractCellLocator* locator, int numThreads);
+
+    /**
+     * Get the number of distinct points
+     * @return number
+     */
+    size_t getNumberOfUniquePoints() const;
+
+    /**
+     * Get the cell Id of a point
+     * @param ptId point Id (index into the points array passed to build)
+     * @return cell Id, negative if the point is outside the grid
+     */
+    vtkIdType getCellId(vtkIdType ptId) const {
+        return this->cellIds[this->uniqueIds[ptId]];
+    }
+
+    /**
+     * Get the cell parametric coordinates of a point
+     * @param ptId point Id (index into the points array passed to build)
+     * @return 3 values, only valid if getCellId(ptId) >= 0
+     */
+    const double* getParamCoords(vtkIdType ptId) const {
+        return &this->xis[3*this->uniqueIds[ptId]];
+    }
+
+private:
+
+    // number of space dimensions
+    int ndims;
+
+    // maps a point Id to its unique point index
+    std::vector<size_t> uniqueIds;
+
+    // cell Id of each unique point
+    std::vector<vtkIdType> cellIds;
+
+    // cell parametric coordinates of each unique point, 3 values per point
+    std::vector<double> xis;
+};
+
+#endif // MNT_POINT_LOCATION_CACHE
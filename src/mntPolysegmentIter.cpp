@@ -1,56 +1,151 @@
 #include <mntPolysegmentIter.h>
-#include <mntQuadEdgeIter.h>
-#include <vtkIdList.h>
-#include <vtkGenericCell.h>
 #include <MvVector.h>
 #include <limits>
 
-struct TCmpFunctor {
-    TCmpFunctor(const std::vector<double>& ts) {
-        this->tVals = ts;
+/**
+ * Order indices by cell Id first, then by index
+ */
+struct CellIdCmpFunctor {
+    CellIdCmpFunctor(const std::vector<vtkIdType>& cellIds) : cIds(cellIds) {}
+    bool operator()(size_t i, size_t j) const {
+        return (this->cIds[i] < this->cIds[j]) || (this->cIds[i] == this->cIds[j] && i < j);
     }
-    bool operator()(size_t i, size_t j) {
+    const std::vector<vtkIdType>& cIds;
+};
+
+/**
+ * Order indices by t values
+ */
+struct TCmpFunctor {
+    TCmpFunctor(const std::vector<double>& ts) : tVals(ts) {}
+    bool operator()(size_t i, size_t j) const {
         return (this->tVals[i] < this->tVals[j]);
     }
-    std::vector<double> tVals;
+    const std::vector<double>& tVals;
 };
 
 
-PolysegmentIter::PolysegmentIter(vtkUnstructuredGrid* grid, vtkCellLocator* locator, 
-                                 const double p0[], const double p1[]) {
+PolysegmentIter::PolysegmentIter(vtkUnstructuredGrid* grid, vtkAbstractCellLocator* locator, 
+                                 const double p0[], const double p1[]) : locQuery(locator) {
 
-    // small tolerances 
-    this->eps = 10 * std::numeric_limits<double>::epsilon();
-    this->eps100 = 100. * this->eps;
-    this->tol = 1.e-3; // to determine if a point is inside a cell
+    // set the grid
+    this->grid = grid;
+    this->__init();
 
-    // set the grid and the grid locator
+    this->setLine(p0, p1);
+}
+
+
+PolysegmentIter::PolysegmentIter(vtkUnstructuredGrid* grid, vtkAbstractCellLocator* locator) :
+    locQuery(locator) {
+
+    // set the grid
     this->grid = grid;
-    this->locator = locator;
+    this->__init();
+
+    this->totalT = 0.0;
+    this->numSegs = 0;
+    this->reset();
+}
+
+
+PolysegmentIter::PolysegmentIter(const PolysegmentIter& other) : locQuery(other.locQuery) {
+    this->grid = other.grid;
+    this->__init();
+    *this = other;
+}
+
+
+PolysegmentIter&
+PolysegmentIter::operator=(const PolysegmentIter& other) {
+
+    if (this == &other) {
+        return *this;
+    }
+
+    // the VTK work objects are not shared
+    this->grid = other.grid;
+    this->locQuery = other.locQuery;
+    this->adjacency = other.adjacency;
+    this->cellIds = other.cellIds;
+    this->xis = other.xis;
+    this->ts = other.ts;
+    this->segCellIds = other.segCellIds;
+    this->segTas = other.segTas;
+    this->segTbs = other.segTbs;
+    this->segXias = other.segXias;
+    this->segXibs = other.segXibs;
+    this->segCoeffs = other.segCoeffs;
+    this->xia = other.xia;
+    this->xib = other.xib;
+    this->totalT = other.totalT;
+    this->index = other.index;
+    this->numSegs = other.numSegs;
+
+    return *this;
+}
+
+
+PolysegmentIter::~PolysegmentIter() {
+    this->cellIdsAlongLine->Delete();
+    this->ptIds->Delete();
+    this->cell->Delete();
+}
+
+
+void
+PolysegmentIter::setCellAdjacency(const CellAdjacency* adjacency) {
+    this->adjacency = adjacency;
+}
+
+
+void 
+PolysegmentIter::setLine(const double p0[], const double p1[]) {
+
+    double xi0[] = {0., 0., 0.};
+    double xi1[] = {0., 0., 0.};
+    double weights[8];
+
+    // VTK wants 3d positions
+    double pBeg[] = {p0[0], p0[1], 0.};
+    double pEnd[] = {p1[0], p1[1], 0.};
+
+    // locate the start/end points. The end point is usually in, or next to, the 
+    // start point's cell
+    vtkIdType cellId0 = this->locQuery.findCell(pBeg, this->eps, this->cell, xi0, weights);
+    vtkIdType cellId1;
+    if (this->adjacency) {
+        cellId1 = this->adjacency->findCell(this->locQuery, pEnd, this->eps, cellId0, 
+                                            this->cell, xi1, weights);
+    }
+    else {
+        cellId1 = this->locQuery.findCell(pEnd, this->eps, this->cell, xi1, weights);
+    }
+
+    this->setLine(p0, p1, cellId0, xi0, cellId1, xi1);
+}
+
+
+void 
+PolysegmentIter::setLine(const double p0[], const double p1[],
+                         vtkIdType cellId0, const double xi0[],
+                         vtkIdType cellId1, const double xi1[]) {
 
     // cellIds, xis and ts are output
     this->cellIds.resize(0); // cell of each intersection point
     this->xis.resize(0);     // cell parametric coords for each intersection point
     this->ts.resize(0);      // linear param coord for each intersction point
-    this->__collectLineGridSegments(p0, p1);
-
-    // gather the intersection points attached to a cell: cellId -> [indx0, indx1, ...] 
-    // indx is index in the cellIds, xis and ts arrays
-    std::map< vtkIdType, std::vector<size_t> > c2Inds;
-    for (size_t i = 0; i < this->cellIds.size(); ++i) {
-        vtkIdType cId = this->cellIds[i];
-        std:map< vtkIdType, std::vector<size_t> >::iterator it = c2Inds.find(cId);
-        if (it != c2Inds.end()) {
-            // push_back into existing list value
-            it->second.push_back(i);
-        }
-        else {
-            // create new list value entry
-            std::vector<size_t> index(1, i);
-            std::pair< vtkIdType, std::vector<size_t> > p(cId, index);
-            c2Inds.insert(p);
-        }
+    this->__collectLineGridSegments(p0, p1, cellId0, xi0, cellId1, xi1);
+
+    // gather the intersection points attached to a cell, the points are ordered
+    // by cell Id and, for each cell, in the order in which they were found.
+    // pointOrder holds the indices into the cellIds, xis and ts arrays
+    size_t numPoints = this->cellIds.size();
+    this->pointOrder.resize(numPoints);
+    for (size_t i = 0; i < numPoints; ++i) {
+        this->pointOrder[i] = i;
     }
+    std::sort(this->pointOrder.begin(), this->pointOrder.end(), CellIdCmpFunctor(this->cellIds));
 
     //
     // build the subsegments
@@ -58,88 +153,74 @@ PolysegmentIter::PolysegmentIter(vtkUnstructuredGrid* grid, vtkCellLocator* loca
 
     // arrays of cell Ids, start/end t values, start/end xi param coords, and 
     // duplicity coefficients for each subsegment
-    this->segCellIds.resize(0);
-    this->segTas.resize(0);
-    this->segTbs.resize(0);
-    this->segXias.resize(0);
-    this->segXibs.resize(0);
-    this->segCoeffs.resize(0);
+    this->sCellIds.resize(0);
+    this->sTas.resize(0);
+    this->sTbs.resize(0);
+    this->sXias.resize(0);
+    this->sXibs.resize(0);
 
     // iterate over all the cells for which we have intersection points
-    for (std::map< vtkIdType, std::vector<size_t> >::const_iterator it = c2Inds.begin();
-        it != c2Inds.end(); ++it) {
+    size_t beg = 0;
+    while (beg < numPoints) {
 
         // cell Id
-        vtkIdType cId = it->first;
-
-        // index array into this->ts, this->cellIds and this->xis
-        const std::vector<size_t>& inds = it->second;
-
-        // compute the corresponding linear param coord t's
-        size_t n = inds.size();
-        std::vector<size_t> iVals(n);
-        std::vector<double> tVals(n);
-        for (size_t i = 0; i < n; ++i) {
-            iVals[i] = i;
-            tVals[i] = this->ts[ inds[i] ];
+        vtkIdType cId = this->cellIds[ this->pointOrder[beg] ];
+
+        // range of points in this cell
+        size_t end = beg + 1;
+        while (end < numPoints && this->cellIds[ this->pointOrder[end] ] == cId) {
+            end++;
         }
 
-        // sort the indices inds by t values
-        std::sort(iVals.begin(), iVals.end(), TCmpFunctor(tVals));
+        // sort the points of this cell by t values
+        std::sort(this->pointOrder.begin() + beg, this->pointOrder.begin() + end,
+                  TCmpFunctor(this->ts));
 
         // create subsegments. Each subsegment has start and end points. Both
         // the start/end points are in the same cell.
-        for (int j = 0; j < (int) n - 1; ++j) {
-            // indices into the inds lists
-            size_t i0 = iVals[j    ];
-            size_t i1 = iVals[j + 1];
+        for (size_t j = beg; j + 1 < end; ++j) {
             // indices into this->ts, this->xis... 
-            size_t ia = inds[i0];
-            size_t ib = inds[i1];
-            double ta = this->ts[ia];
-            double tb = this->ts[ib];
-            const Vector<double>& xia = this->xis[ia];
-            const Vector<double>& xib = this->xis[ib];
+            size_t ia = this->pointOrder[j    ];
+            size_t ib = this->pointOrder[j + 1];
 
             // add the cell index, start linear param coord, etc.
-            this->segCellIds.push_back(cId);
-            this->segTas.push_back(ta);
-            this->segTbs.push_back(tb);
-            this->segXias.push_back(xia);
-            this->segXibs.push_back(xib);
-            // will deal with duplicity later
-            this->segCoeffs.push_back(1.0);
+            this->sCellIds.push_back(cId);
+            this->sTas.push_back(this->ts[ia]);
+            this->sTbs.push_back(this->ts[ib]);
+            this->sXias.insert(this->sXias.end(), &this->xis[3*ia], &this->xis[3*ia + 3]);
+            this->sXibs.insert(this->sXibs.end(), &this->xis[3*ib], &this->xis[3*ib + 3]);
         }
+
+        beg = end;
     }
 
     // sort all the segments by start linear param coord t values
 
-    size_t n = this->segCellIds.size();
-    std::vector<size_t> iVals(n);
-    std::vector<double> tVals(n);
+    size_t n = this->sCellIds.size();
+    this->segOrder.resize(n);
     for (size_t i = 0; i < n; ++i) {
-        iVals[i] = i;
-        tVals[i] = this->segTas[i];
+        this->segOrder[i] = i;
     }
 
-    std::sort(iVals.begin(), iVals.end(), TCmpFunctor(tVals));
-
-    // copy
-    std::vector<vtkIdType> sCellIds = this->segCellIds;
-    std::vector<double> sTas = this->segTas;
-    std::vector<double> sTbs = this->segTbs;
-    std::vector< Vector<double> > sXias = this->segXias;
-    std::vector< Vector<double> > sXibs = this->segXibs;
+    std::sort(this->segOrder.begin(), this->segOrder.end(), TCmpFunctor(this->sTas));
 
-    // no need to sort this->segCoeffs since all the values are one
+    this->segCellIds.resize(n);
+    this->segTas.resize(n);
+    this->segTbs.resize(n);
+    this->segXias.resize(3*n);
+    this->segXibs.resize(3*n);
     for (size_t j = 0; j < n; ++j) {
-        size_t i = iVals[j];
-        this->segCellIds[j] = sCellIds[i];
-        this->segTas[j] = sTas[i];
-        this->segTbs[j] = sTbs[i];
-        this->segXias[j] = sXias[i];
-        this->segXibs[j] = sXibs[i];
+        size_t i = this->segOrder[j];
+        this->segCellIds[j] = this->sCellIds[i];
+        this->segTas[j] = this->sTas[i];
+        this->segTbs[j] = this->sTbs[i];
+        for (size_t d = 0; d < 3; ++d) {
+            this->segXias[3*j + d] = this->sXias[3*i + d];
+            this->segXibs[3*j + d] = this->sXibs[3*i + d];
+        }
     }
+    // will deal with duplicity later
+    this->segCoeffs.assign(n, 1.0);
 
     // assign coefficients that account for duplicity, ie segments 
     // that are shared between two cells. Output is this->segCoeffs
@@ -172,13 +253,15 @@ PolysegmentIter::getIntegratedParamCoord() const {
 void 
 PolysegmentIter::reset() {
     this->index = 0;
+    this->__setCurrent();
 }
 
 
 bool
 PolysegmentIter::next() {
-    if (this->index < this->numSegs - 1) {
+    if (this->index + 1 < this->numSegs) {
         this->index++;
+        this->__setCurrent();
         return true;
     }
     return false;
@@ -192,33 +275,33 @@ PolysegmentIter::getCellId() const {
 
 const Vector<double>& 
 PolysegmentIter::getBegCellParamCoord() const {
-    return this->segXias[this->index];
-}        
+    return this->xia;
+}
 
 
 const Vector<double>& 
 PolysegmentIter::getEndCellParamCoord() const {
-    return this->segXibs[this->index];
+    return this->xib;
 }
- 
 
-double
+
+double 
 PolysegmentIter::getBegLineParamCoord() const {
     return this->segTas[this->index];
 }
-        
+
 
 double 
 PolysegmentIter::getEndLineParamCoord() const {
     return this->segTbs[this->index];
 }
-     
+
 
 double 
 PolysegmentIter::getCoefficient() const {
     return this->segCoeffs[this->index];
 }
- 
+
 size_t
 PolysegmentIter::getNumberOfSegments() const {
     return this->numSegs;
@@ -227,36 +310,65 @@ PolysegmentIter::getNumberOfSegments() const {
 ///////////////////////////////////////////////////////////////////////////////
 // private methods
 
-void
+void 
+PolysegmentIter::__init() {
+
+    // small tolerances 
+    this->eps = 10 * std::numeric_limits<double>::epsilon();
+    this->eps100 = 100. * this->eps;
+    this->tol = 1.e-3; // to determine if a point is inside a cell
+
+    this->adjacency = NULL;
+
+    this->cellIdsAlongLine = vtkIdList::New();
+    this->ptIds = vtkIdList::New();
+    this->cell = vtkGenericCell::New();
+
+    this->xia.alloc(3);
+    this->xib.alloc(3);
+    this->xia = 0.0;
+    this->xib = 0.0;
+}
+
+
+void 
+PolysegmentIter::__setCurrent() {
+    if (this->index < this->numSegs) {
+        for (size_t d = 0; d < 3; ++d) {
+            this->xia[d] = this->segXias[3*this->index + d];
+            this->xib[d] = this->segXibs[3*this->index + d];
+        }
+    }
+}
+
+
+void 
 PolysegmentIter::__assignCoefficientsToSegments() {
 
+    // remove the zero length sub-segments, in place
     size_t n = this->segCellIds.size();
-
-    // copy
-    std::vector<vtkIdType> sCellIds = this->segCellIds;
-    std::vector<double> sTas = this->segTas;
-    std::vector<double> sTbs = this->segTbs;
-    std::vector< Vector<double> > sXias = this->segXias;
-    std::vector< Vector<double> > sXibs = this->segXibs;
-    std::vector<double> sCoeffs = this->segCoeffs;
-    this->segCellIds.resize(0);
-    this->segTas.resize(0);
-    this->segTbs.resize(0);
-    this->segXias.resize(0);
-    this->segXibs.resize(0);
-    this->segCoeffs.resize(0);
+    size_t m = 0;
     for (size_t i = 0; i < n; ++i) {
-        double ta = sTas[i];
-        double tb = sTbs[i];
+        double ta = this->segTas[i];
+        double tb = this->segTbs[i];
         if (std::abs(tb - ta) > this->eps100) {
-            this->segCellIds.push_back(sCellIds[i]);
-            this->segTas.push_back(sTas[i]);
-            this->segTbs.push_back(sTbs[i]);
-            this->segXias.push_back(sXias[i]);
-            this->segXibs.push_back(sXibs[i]);
-            this->segCoeffs.push_back(sCoeffs[i]);
+            this->segCellIds[m] = this->segCellIds[i];
+            this->segTas[m] = this->segTas[i];
+            this->segTbs[m] = this->segTbs[i];
+            for (size_t d = 0; d < 3; ++d) {
+                this->segXias[3*m + d] = this->segXias[3*i + d];
+                this->segXibs[3*m + d] = this->segXibs[3*i + d];
+            }
+            this->segCoeffs[m] = this->segCoeffs[i];
+            m++;
         }
     }
+    this->segCellIds.resize(m);
+    this->segTas.resize(m);
+    this->segTbs.resize(m);
+    this->segXias.resize(3*m);
+    this->segXibs.resize(3*m);
+    this->segCoeffs.resize(m);
 
     // reduce contribution for overlapping segments. If two 
     // segments overlap then the coefficient of first segment
@@ -276,142 +388,221 @@ PolysegmentIter::__assignCoefficientsToSegments() {
 
 }
 
-void
+void 
 PolysegmentIter::__collectIntersectionPoints(const double pBeg[], 
                                              const double pEnd[],
-                                             std::vector<vtkIdType>& cIds,
-                                             std::vector<double>& lambRays,
-                                             std::vector< std::vector<double> >& points) {
-    LineLineIntersector intersector;
-    vtkIdList* cellIds = vtkIdList::New();
-    vtkIdList* ptIds = vtkIdList::New();
+                                             vtkIdType cellId0, vtkIdType cellId1) {
 
-    std::vector<double> v0(3);
-    std::vector<double> v1(3);
+    this->xCellIds.resize(0);
+    this->xLambRays.resize(0);
+    this->xXis.resize(0);
 
-    // vector from start to finish
-    double dp[] = {pEnd[0] - pBeg[0], pEnd[1] - pBeg[1], pEnd[2] - pBeg[2]};
+    // walk from cell to cell if we can
+    if (this->adjacency && cellId0 >= 0 && cellId1 >= 0) {
+        if (this->__walkIntersectionPoints(pBeg, pEnd, cellId0, cellId1)) {
+            return;
+        }
+        // some of the line is not covered, start again using the locator
+        this->xCellIds.resize(0);
+        this->xLambRays.resize(0);
+        this->xXis.resize(0);
+    }
 
     // find all the cells intersected by the line
-    this->locator->FindCellsAlongLine((double*) &pBeg[0], 
+    this->locQuery.findCellsAlongLine((double*) &pBeg[0], 
                                       (double*) &pEnd[0], 
-                                      this->tol, cellIds);
+                                      this->tol, this->cellIdsAlongLine);
 
     //
     // collect the intersection points
     //
 
     // iterate over the cells along the line
-    for (vtkIdType i = 0; i < cellIds->GetNumberOfIds(); ++i) {
+    for (vtkIdType i = 0; i < this->cellIdsAlongLine->GetNumberOfIds(); ++i) {
+        this->__collectCellIntersectionPoints(this->cellIdsAlongLine->GetId(i), pBeg, pEnd);
+    }
 
-        // this cell Id
-        vtkIdType cId = cellIds->GetId(i);
+}
 
-        // vertices, ptIds.GetNumberOfIds() should return 4
-        // since we're dealing with quads only
-        this->grid->GetCellPoints(cId, ptIds);
 
+void 
+PolysegmentIter::__collectCellIntersectionPoints(vtkIdType cId,
+                                                 const double pBeg[], 
+                                                 const double pEnd[]) {
+    LineQuadEdgesIntersector intersector;
+
+    double verts[4][3];
+    double xi[3];
+
+    // vector from start to finish
+    double dp[] = {pEnd[0] - pBeg[0], pEnd[1] - pBeg[1], pEnd[2] - pBeg[2]};
 
-        // iterate over the quads' edges
-        QuadEdgeIter edgeIt;
-        for (int edgeId = 0; edgeId < edgeIt.getNumberOfEdges(); ++edgeId) {
+    // vertices, ptIds.GetNumberOfIds() should return 4
+    // since we're dealing with quads only
+    this->grid->GetCellPoints(cId, this->ptIds);
+    for (int j = 0; j < 4; ++j) {
+        this->grid->GetPoint(this->ptIds->GetId(j), verts[j]);
+    }
 
-            int j0, j1;
-            edgeIt.getCellPointIds(edgeId, &j0, &j1);
+    // look for intersections with all the quad's edges
+    intersector.setPoints(&pBeg[0], &pEnd[0], verts);
 
-            this->grid->GetPoint(ptIds->GetId(j0), &v0[0]);
-            this->grid->GetPoint(ptIds->GetId(j1), &v1[0]);
+    // iterate over the quads' edges
+    for (int edgeId = 0; edgeId < 4; ++edgeId) {
 
-            // look for an intersection
-            intersector.setPoints(&pBeg[0], &pEnd[0], &v0[0], &v1[0]);
+        if (! intersector.hasSolution(edgeId, this->eps)) {
+            // skip if no solution. FindCellsAlongLine may be too generous with
+            // returning the list of intersected cells
+            continue;
+        }
 
-            if (! intersector.hasSolution(this->eps)) {
-                // skip if no solution. FindCellsAlongLine may be too generous with
-                // returning the list of intersected cells
-                continue;
+        // we have a solution but it could be degenerate
+
+        if (std::abs(intersector.getDet(edgeId)) > this->eps) {
+            // normal intersection, 1 solution
+            double sol[2];
+            intersector.getSolution(edgeId, sol);
+            double lambRay = sol[0];
+            double lambEdg = sol[1];
+
+            // is it valid? Intersection must be within (p0, p1) and (q0, q1)
+            if (lambRay >= (0. - this->eps100) && lambRay <= (1. + this->eps100)  && 
+                lambEdg >= (0. - this->eps100) && lambEdg <= (1. + this->eps100)) {
+
+                // add the intersection point to the list. The point is on the 
+                // edge so its cell parametric coordinates follow from lambEdg
+                this->xCellIds.push_back(cId);
+                this->xLambRays.push_back(lambRay);
+                intersector.getCellParamCoords(edgeId, lambEdg, xi);
+                this->xXis.insert(this->xXis.end(), xi, xi + 3);
             }
+        }
+        else {
+            // det is almost zero
+            // looks like the two lines (p0, p1) and (q0, q1) are overlapping
+            // add the starting/ending points
+            const std::pair<double, double> sol = intersector.getBegEndParamCoords();
+            // linear param coord along line
+            double lama = sol.first;
+            double lamb = sol.second;
+
+            // add to lists both points, with their param coords along the edge
+            double pa[] = {pBeg[0] + lama*dp[0], pBeg[1] + lama*dp[1]};
+            double pb[] = {pBeg[0] + lamb*dp[0], pBeg[1] + lamb*dp[1]};
+
+            this->xCellIds.push_back(cId);
+            this->xLambRays.push_back(lama);
+            intersector.getCellParamCoords(edgeId, intersector.getEdgeParamCoord(edgeId, pa), xi);
+            this->xXis.insert(this->xXis.end(), xi, xi + 3);
+
+            this->xCellIds.push_back(cId);
+            this->xLambRays.push_back(lamb); // same Id as before
+            intersector.getCellParamCoords(edgeId, intersector.getEdgeParamCoord(edgeId, pb), xi);
+            this->xXis.insert(this->xXis.end(), xi, xi + 3);
 
-            // we have a solution but it could be degenerate
+        }
 
-            if (std::abs(intersector.getDet()) > this->eps) {
-                // normal intersection, 1 solution
-                std::vector<double> sol = intersector.getSolution();
-                double lambRay = sol[0];
-                double lambEdg = sol[1];
+    } // end of edge loop
 
-                // is it valid? Intersection must be within (p0, p1) and (q0, q1)
-                if (lambRay >= (0. - this->eps100) && lambRay <= (1. + this->eps100)  && 
-                    lambEdg >= (0. - this->eps100) && lambEdg <= (1. + this->eps100)) {
+}
 
-                    // compute the intersection point
-                    double p[] = {pBeg[0] + lambRay*dp[0], pBeg[1] + lambRay*dp[1]};
 
-                    // add to list
-                    cIds.push_back(cId);
-                    lambRays.push_back(lambRay);
-                    points.push_back(std::vector<double>(p, p + 2)); // copies
-                }
-            }
-            else {
-                // det is almost zero
-                // looks like the two lines (p0, p1) and (q0, q1) are overlapping
-                // add the starting/ending points
-                const std::pair<double, double> sol = intersector.getBegEndParamCoords();
-                // linear param coord along line
-                double lama = sol.first;
-                double lamb = sol.second;
-                // compute the points
-                double pa[] = {pBeg[0] + lama*dp[0], pBeg[1] + lama*dp[1]};
-                double pb[] = {pBeg[0] + lamb*dp[0], pBeg[1] + lamb*dp[1]};
-
-                // add to lists both points
-                cIds.push_back(cId);
-                lambRays.push_back(lama);
-                points.push_back(std::vector<double>(pa, pa + 2));
-
-                cIds.push_back(cId);
-                lambRays.push_back(lamb); // same Id as before
-                points.push_back(std::vector<double>(pb, pb + 2));
+bool
+PolysegmentIter::__walkIntersectionPoints(const double pBeg[], 
+                                          const double pEnd[],
+                                          vtkIdType cellId0, vtkIdType cellId1) {
+
+    // points closer than this (in parametric space) to a vertex are at the vertex
+    const double vertTol = 1.e-10;
+
+    // vertex index as a function of the parametric coordinates (0 or 1), as in vtkQuad
+    static const int vertexIndices[2][2] = {{0, 3}, {1, 2}};
+
+    // the cells visited, in the order in which they were found. Cells touched by the
+    // line are added, starting from the cell of the start point
+    this->walkCellIds.resize(0);
+    this->walkIntervals.resize(0);
+    this->walkCellIds.push_back(cellId0);
 
+    for (size_t iCell = 0; iCell < this->walkCellIds.size(); ++iCell) {
+
+        vtkIdType cId = this->walkCellIds[iCell];
+        size_t n0 = this->xCellIds.size();
+        this->__collectCellIntersectionPoints(cId, pBeg, pEnd);
+        size_t n1 = this->xCellIds.size();
+
+        // range of line parametric coordinates covered by this cell
+        double ta = (cId == cellId0)? 0.: 1.;
+        double tb = (cId == cellId1)? 1.: 0.;
+
+        for (size_t k = n0; k < n1; ++k) {
+
+            ta = std::min(ta, this->xLambRays[k]);
+            tb = std::max(tb, this->xLambRays[k]);
+
+            // the point is on the boundary of the cell, find the vertex or the edge
+            const double* xi = &this->xXis[3*k];
+            int at[2]; // 0 or 1 if the parametric coordinate is at the boundary, -1 otherwise
+            for (size_t d = 0; d < 2; ++d) {
+                at[d] = std::abs(xi[d]) < vertTol? 0: (std::abs(xi[d] - 1.) < vertTol? 1: -1);
             }
 
-        } // end of edge loop
+            if (at[0] >= 0 && at[1] >= 0) {
+                // vertex, add all the cells sharing the vertex
+                vtkIdType nodeId = this->adjacency->getNodeId(cId, vertexIndices[at[0]][at[1]]);
+                const vtkIdType* nodeCellIds;
+                size_t numNodeCells = this->adjacency->getNodeCells(nodeId, &nodeCellIds);
+                for (size_t j = 0; j < numNodeCells; ++j) {
+                    if (std::find(this->walkCellIds.begin(), this->walkCellIds.end(), 
+                                  nodeCellIds[j]) == this->walkCellIds.end()) {
+                        this->walkCellIds.push_back(nodeCellIds[j]);
+                    }
+                }
+            }
+            else if (at[0] >= 0 || at[1] >= 0) {
+                // edge, add the cell across the edge
+                int edgeIndex = (at[1] == 0)? 0: (at[0] == 1)? 1: (at[1] == 1)? 2: 3;
+                vtkIdType nb = this->adjacency->getEdgeNeighbour(cId, edgeIndex);
+                if (nb >= 0 && std::find(this->walkCellIds.begin(), this->walkCellIds.end(), 
+                                         nb) == this->walkCellIds.end()) {
+                    this->walkCellIds.push_back(nb);
+                }
+            }
+        }
 
-    } // end of cell loop
+        if (ta <= tb) {
+            this->walkIntervals.push_back(std::pair<double, double>(ta, tb));
+        }
+    }
 
-    // clean up
-    cellIds->Delete();
-    ptIds->Delete();
-  
+    // check that the cells cover the line from start to end, gaps occur if the 
+    // line leaves the grid or the neighbours are not adjacent in space (e.g. across
+    // a periodic boundary)
+    std::sort(this->walkIntervals.begin(), this->walkIntervals.end());
+    double reach = 0.;
+    for (size_t i = 0; i < this->walkIntervals.size(); ++i) {
+        if (this->walkIntervals[i].first > reach + this->eps100) {
+            return false;
+        }
+        reach = std::max(reach, this->walkIntervals[i].second);
+    }
+    return reach >= 1. - this->eps100;
 }
 
 
 void 
-PolysegmentIter::__collectLineGridSegments(const double p0[], const double p1[]) {
-
-    // things we need to define
-    vtkIdList* ptIds = vtkIdList::New();
-    vtkGenericCell* cell = vtkGenericCell::New();
-    vtkIdList* cellIds = vtkIdList::New();
-
-    Vector<double> xi(3);
-    double closestPoint[] = {0., 0., 0.};
-    double weights[8];
+PolysegmentIter::__collectLineGridSegments(const double p0[], const double p1[],
+                                           vtkIdType cellId0, const double xi0[],
+                                           vtkIdType cellId1, const double xi1[]) {
 
-    int subId;
-    double dist;
-    std::vector<double> point(3, 0.0);
-    
     // VTK wants 3d positions
     double pBeg[] = {p0[0], p0[1], 0.};
     double pEnd[] = {p1[0], p1[1], 0.};
 
     // add starting point
-    vtkIdType cId = this->locator->FindCell(pBeg, this->eps, cell, &xi[0], weights);
-    if (cId >= 0) {
-        // success
-        this->cellIds.push_back(cId);
-        this->xis.push_back(xi); // copy
+    if (cellId0 >= 0) {
+        this->cellIds.push_back(cellId0);
+        this->xis.insert(this->xis.end(), xi0, xi0 + 3);
         this->ts.push_back(0.); // start of line
     }
 
@@ -419,46 +610,18 @@ PolysegmentIter::__collectLineGridSegments(const double p0[], const double p1[])
     // find all intersection points in between
     //
 
-    std::vector<vtkIdType> cIds;
-    std::vector<double> lambRays;
-    std::vector< std::vector<double> > points;
-    this->__collectIntersectionPoints(pBeg, pEnd, cIds, lambRays, points);
-
-    // find the cell Id of the neighbouring cells
-    size_t nXPts = cIds.size();
-    for (size_t i = 0; i < nXPts; ++i) {
-
-        vtkIdType cId = cIds[i];
-        double lambRay = lambRays[i];
-	      // need to copy because points are 2-tuples and VTK always works with 3-tuples
-        point.assign(&points[i][0], &points[i][2]);
-
-        int found = this->grid->GetCell(cId)->EvaluatePosition((double*) &point[0], closestPoint, 
-                                                               subId, &xi[0], dist, weights);
-        if (found) {
-            this->cellIds.push_back(cId);
-            this->xis.push_back(xi);
-            this->ts.push_back(lambRay);
-        }
-        else {
-            std::cerr << "Warning: param coord search failed for point " << point[0] << ", " << point[1] 
-                                                                         << " in cell " << cId << '\n';
-        }
-    }
- 
+    this->__collectIntersectionPoints(pBeg, pEnd, cellId0, cellId1);
+
+    // the intersection points, their cell parametric coordinates are known
+    this->cellIds.insert(this->cellIds.end(), this->xCellIds.begin(), this->xCellIds.end());
+    this->xis.insert(this->xis.end(), this->xXis.begin(), this->xXis.end());
+    this->ts.insert(this->ts.end(), this->xLambRays.begin(), this->xLambRays.end());
+
     // add end point 
-    cId = this->locator->FindCell(pEnd, this->eps, cell, &xi[0], weights);
-    if (cId >= 0) {
-        // success
-        this->cellIds.push_back(cId);
-        this->xis.push_back(xi);
+    if (cellId1 >= 0) {
+        this->cellIds.push_back(cellId1);
+        this->xis.insert(this->xis.end(), xi1, xi1 + 3);
         this->ts.push_back(1.); // end of line
     }
 
-    // clean up
-    ptIds->Delete();
-    cell->Delete();
-    cellIds->Delete();
-
 }
-
@@ -1,8 +1,12 @@
 #include "MvVector.h"
 #include <mntLineLineIntersector.h>
+#include <mntCellAdjacency.h>
+#include <mntLocatorQuery.h>
 #include <vtkUnstructuredGrid.h>
-#include <vtkCellLocator.h>
-#include <map>
+#include <vtkAbstractCellLocator.h>
+#include <vtkIdList.h>
+#include <vtkGenericCell.h>
+#include <vector>
 #include <algorithm>
 
 #ifndef MNT_POLYSEGMENT_ITER
@@ -15,13 +19,73 @@ public:
     /**
      * Constructor
      * @param grid instance of vtkUnstructuredGrid
-     * @param locator vtkCellLocator instance attached to the above grid
+     * @param locator cell locator attached to the above grid
      * @param p0 start point
      * @param p1 end point
      */
-    PolysegmentIter(vtkUnstructuredGrid* grid, vtkCellLocator* locator, 
+    PolysegmentIter(vtkUnstructuredGrid* grid, vtkAbstractCellLocator* locator, 
                     const double p0[], const double p1[]);
 
+    /**
+     * Constructor, call setLine before iterating
+     * @param grid instance of vtkUnstructuredGrid
+     * @param locator cell locator attached to the above grid
+     * @note the same iterator can be used for many lines. All the work arrays
+     *       are kept between calls to setLine, so that no memory is allocated 
+     *       once the arrays have grown to their steady-state sizes. Each thread 
+     *       should have its own iterator.
+     */
+    PolysegmentIter(vtkUnstructuredGrid* grid, vtkAbstractCellLocator* locator);
+
+    /**
+     * Copy constructor
+     * @param other iterator
+     */
+    PolysegmentIter(const PolysegmentIter& other);
+
+    /**
+     * Assignment operator
+     * @param other iterator
+     * @return iterator
+     */
+    PolysegmentIter& operator=(const PolysegmentIter& other);
+
+    /**
+     * Destructor
+     */
+    ~PolysegmentIter();
+
+    /**
+     * Set the line and compute the segments, resets the iterator
+     * @param p0 start point
+     * @param p1 end point
+     */
+    void setLine(const double p0[], const double p1[]);
+
+    /**
+     * Set the line and compute the segments, resets the iterator. Same as above 
+     * but with the locations of the start/end points already known
+     * @param p0 start point
+     * @param p1 end point
+     * @param cellId0 cell Id of the start point, negative if outside the grid
+     * @param xi0 cell parametric coordinates of the start point
+     * @param cellId1 cell Id of the end point, negative if outside the grid
+     * @param xi1 cell parametric coordinates of the end point
+     */
+    void setLine(const double p0[], const double p1[],
+                 vtkIdType cellId0, const double xi0[],
+                 vtkIdType cellId1, const double xi1[]);
+
+    /**
+     * Set the cell neighbour tables of the grid. When set, the cells intersected
+     * by the line are found by walking from the cell of the start point to the
+     * neighbouring cells instead of querying the locator
+     * @param adjacency neighbour tables, NULL to always use the locator
+     * @note the locator is still used if the walk cannot cover the whole line, 
+     *       e.g. if the line leaves the grid
+     */
+    void setCellAdjacency(const CellAdjacency* adjacency);
+
     /**
      * Get the integrated linear parametric coordinates
      * @return value
@@ -92,36 +156,75 @@ public:
 
 private:
 
+    /**
+     * Allocate the VTK work objects and set the tolerances
+     */
+    void __init();
+
+    /**
+     * Update the current begin/end cell parametric coordinates
+     */
+    void __setCurrent();
+
     void __assignCoefficientsToSegments();
 
     /**
-     * Collect all the intersection points
+     * Collect all the intersection points, results are stored in 
+     * xCellIds, xLambRays and xXis
      * @param pBeg starting point
      * @param pEnd end point
-     * @param cIds cell Ids (output)
-     * @param lambRay line paramatric coordinates (output)
-     * @param points intersection points (output)
+     * @param cellId0 cell Id of the starting point, negative if outside the grid
+     * @param cellId1 cell Id of the end point, negative if outside the grid
      */
     void __collectIntersectionPoints(const double pBeg[], 
                                      const double pEnd[],
-                                     std::vector<vtkIdType>& cIds,
-                                     std::vector<double>& lambRays,
-                                     std::vector< std::vector<double> >& points);
+                                     vtkIdType cellId0, vtkIdType cellId1);
+
+    /**
+     * Collect the intersection points of the line with the edges of one cell, 
+     * results are appended to xCellIds, xLambRays and xXis
+     * @param cId cell Id
+     * @param pBeg starting point
+     * @param pEnd end point
+     */
+    void __collectCellIntersectionPoints(vtkIdType cId,
+                                         const double pBeg[], 
+                                         const double pEnd[]);
+
+    /**
+     * Collect all the intersection points by walking from the start cell to the 
+     * neighbouring cells that the line touches, results are stored in xCellIds, 
+     * xLambRays and xXis
+     * @param pBeg starting point
+     * @param pEnd end point
+     * @param cellId0 cell Id of the starting point
+     * @param cellId1 cell Id of the end point
+     * @return true if the cells visited cover the whole line
+     */
+    bool __walkIntersectionPoints(const double pBeg[], 
+                                  const double pEnd[],
+                                  vtkIdType cellId0, vtkIdType cellId1);
 
     /**
      * Collect and store all the line-grid intersection points
      * @param p0 starting point of the line
      * @param p1 end point of the line 
+     * @param cellId0 cell Id of the starting point, negative if outside the grid
+     * @param xi0 cell parametric coordinates of the starting point
+     * @param cellId1 cell Id of the end point, negative if outside the grid
+     * @param xi1 cell parametric coordinates of the end point
      */
     void __collectLineGridSegments(const double p0[],
-                                   const double p1[]);
+                                   const double p1[],
+                                   vtkIdType cellId0, const double xi0[],
+                                   vtkIdType cellId1, const double xi1[]);
 
 
     // cell Ids for each intersection point
     std::vector<vtkIdType> cellIds;
     
-    // 2d cell parametric coordinates for each intersection point
-    std::vector< Vector<double> > xis;
+    // cell parametric coordinates for each intersection point, 3 values per point
+    std::vector<double> xis;
 
     // 1d line parametric coordinates for each intersection point
     std::vector<double> ts;
@@ -133,16 +236,42 @@ private:
     std::vector<double> segTas;
     std::vector<double> segTbs;
 
-    // start/end cell parametric coordinates
-    std::vector< Vector<double> > segXias;
-    std::vector< Vector<double> > segXibs;
+    // start/end cell parametric coordinates, 3 values per segment
+    std::vector<double> segXias;
+    std::vector<double> segXibs;
 
     // duplicity coefficient
     std::vector<double> segCoeffs;
 
+    // work arrays, kept between lines
+    std::vector<vtkIdType> xCellIds;
+    std::vector<double> xLambRays;
+    std::vector<double> xXis;
+    std::vector<size_t> pointOrder;
+    std::vector<size_t> segOrder;
+    std::vector<vtkIdType> sCellIds;
+    std::vector<double> sTas;
+    std::vector<double> sTbs;
+    std::vector<double> sXias;
+    std::vector<double> sXibs;
+    std::vector<vtkIdType> walkCellIds;
+    std::vector< std::pair<double, double> > walkIntervals;
+    vtkIdList* cellIdsAlongLine;
+    vtkIdList* ptIds;
+    vtkGenericCell* cell;
+
+    // current start/end cell parametric coordinates
+    Vector<double> xia;
+    Vector<double> xib;
+
     vtkUnstructuredGrid* grid;
 
-    vtkCellLocator* locator;
+    // searches the cell locator attached to the grid, one per instance so that
+    // instances in different threads can share the locator
+    LocatorQuery locQuery;
+
+    // neighbour tables, may be NULL
+    const CellAdjacency* adjacency;
 
     double eps;
     double eps100;
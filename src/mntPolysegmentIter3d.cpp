@@ -8,16 +8,53 @@
 #define DEBUG_PRINT 1
 
 
-PolysegmentIter3d::PolysegmentIter3d(vtkUnstructuredGrid* grid, vtkCellLocator* locator, 
+PolysegmentIter3d::PolysegmentIter3d(vtkUnstructuredGrid* grid, vtkAbstractCellLocator* locator, 
                                      const double pa[], const double pb[]) {
 
-    // small tolerances 
-    this->eps = 10 * std::numeric_limits<double>::epsilon();
+    // store the grid and the grid locator
+    this->grid = grid;
+    this->locator = locator;
+
+    LocatorQuery locQuery(locator);
+    this->__build(locQuery, pa, pb, -1, NULL, -1, NULL);
+}
+
+
+PolysegmentIter3d::PolysegmentIter3d(vtkUnstructuredGrid* grid, vtkAbstractCellLocator* locator, 
+                                     const double pa[], const double pb[],
+                                     vtkIdType cellIdA, const double xiA[],
+                                     vtkIdType cellIdB, const double xiB[]) {
 
     // store the grid and the grid locator
     this->grid = grid;
     this->locator = locator;
 
+    LocatorQuery locQuery(locator);
+    this->__build(locQuery, pa, pb, cellIdA, xiA, cellIdB, xiB);
+}
+
+
+PolysegmentIter3d::PolysegmentIter3d(vtkUnstructuredGrid* grid, LocatorQuery& locQuery, 
+                                     const double pa[], const double pb[],
+                                     vtkIdType cellIdA, const double xiA[],
+                                     vtkIdType cellIdB, const double xiB[]) {
+
+    // store the grid and the grid locator
+    this->grid = grid;
+    this->locator = locQuery.getLocator();
+
+    this->__build(locQuery, pa, pb, cellIdA, xiA, cellIdB, xiB);
+}
+
+
+void
+PolysegmentIter3d::__build(LocatorQuery& locQuery, const double pa[], const double pb[],
+                           vtkIdType cellIdA, const double xiA[],
+                           vtkIdType cellIdB, const double xiB[]) {
+
+    // small tolerances 
+    this->eps = 10 * std::numeric_limits<double>::epsilon();
+
     Vector<double> pcoords0(3);
     Vector<double> pcoords1(3);
     double weights[8];
@@ -32,7 +69,8 @@ PolysegmentIter3d::PolysegmentIter3d(vtkUnstructuredGrid* grid, vtkCellLocator*
     this->segXias.resize(0);
     this->segXibs.resize(0);
 
-    LineGridIntersector intersector(grid);
+    // use our locator, building one for each line would be expensive
+    LineGridIntersector intersector(this->grid, &locQuery);
 
     intersector.setLine(pa, pb);
     const std::vector<double>& tValues = intersector.getIntersectionLineParamCoords();
@@ -53,6 +91,8 @@ PolysegmentIter3d::PolysegmentIter3d(vtkUnstructuredGrid* grid, vtkCellLocator*
     }
 
     // find all the cells between the t values
+    vtkGenericCell* cell = vtkGenericCell::New();
+    double xiMid[3];
     for (size_t iSeg = 0; iSeg < tValues.size() - 1; ++iSeg) {
 
         if (std::abs(tValues[iSeg + 1] - tValues[iSeg]) < this->eps) {
@@ -72,7 +112,7 @@ PolysegmentIter3d::PolysegmentIter3d(vtkUnstructuredGrid* grid, vtkCellLocator*
         pMid *= tMid;
         pMid += pA;
 
-        vtkIdType cellId = this->locator->FindCell(&pMid[0]);
+        vtkIdType cellId = locQuery.findCell(&pMid[0], 0.0, cell, xiMid, weights);
         if (cellId < 0) {
             std::cerr << "Warning: could not find cell at seg mid point t = " 
                       << tMid << " point = " << pMid << " (cellId = " << cellId << ")\n";
@@ -84,7 +124,14 @@ PolysegmentIter3d::PolysegmentIter3d(vtkUnstructuredGrid* grid, vtkCellLocator*
         Vector<double> pt = direction;
         pt *= tValues[iSeg + 0];
         pt += pA;
-        inside0 = this->grid->GetCell(cellId)->EvaluatePosition(&pt[0], NULL, subId, &pcoords0[0], dist2, weights);
+        if (tValues[iSeg + 0] == 0.0 && cellId == cellIdA) {
+            // start of the line, already located
+            std::copy(xiA, xiA + 3, &pcoords0[0]);
+            inside0 = 1;
+        }
+        else {
+            inside0 = this->grid->GetCell(cellId)->EvaluatePosition(&pt[0], NULL, subId, &pcoords0[0], dist2, weights);
+        }
         if (inside0 != 1) {
             std::cerr << "Warning: could not find pcoords at seg start t = " 
                       << tValues[iSeg + 0] << " point = " << pt << " code = " << inside0 << '\n';
@@ -93,7 +140,14 @@ PolysegmentIter3d::PolysegmentIter3d(vtkUnstructuredGrid* grid, vtkCellLocator*
 
         // parametric coords at the end of the segment
         pt += tDiff * direction;
-        inside1 = this->grid->GetCell(cellId)->EvaluatePosition(&pt[0], NULL, subId, &pcoords1[0], dist2, weights);
+        if (tValues[iSeg + 1] == 1.0 && cellId == cellIdB) {
+            // end of the line, already located
+            std::copy(xiB, xiB + 3, &pcoords1[0]);
+            inside1 = 1;
+        }
+        else {
+            inside1 = this->grid->GetCell(cellId)->EvaluatePosition(&pt[0], NULL, subId, &pcoords1[0], dist2, weights);
+        }
         if (inside1 != 1) {
             std::cerr << "Warning: could not find pcoords at seg end t = " 
                       << tValues[iSeg + 1] << " point = " << pt << " code = " << inside0 << '\n';
@@ -107,6 +161,7 @@ PolysegmentIter3d::PolysegmentIter3d(vtkUnstructuredGrid* grid, vtkCellLocator*
         this->segXibs.push_back(pcoords1);
 
     }
+    cell->Delete();
 
     // reset the iterator
     this->reset();
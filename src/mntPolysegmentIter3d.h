@@ -2,7 +2,8 @@
 #include <mntLineTriangleIntersector.h>
 #include <vtkUnstructuredGrid.h>
 //#include <vtkOBBTree.h>
-#include <vtkCellLocator.h>
+#include <vtkAbstractCellLocator.h>
+#include <mntLocatorQuery.h>
 #include <map>
 #include <algorithm>
 
@@ -16,13 +17,48 @@ public:
     /**
      * Constructor
      * @param grid instance of vtkUnstructuredGrid
-     * @param locator vtkCellLocator instance attached to the above grid
+     * @param locator cell locator attached to the above grid, must have been
+     *                built. It is also used to intersect the line with the grid
      * @param p0 start point
      * @param p1 end point
      */
-    PolysegmentIter3d(vtkUnstructuredGrid* grid, vtkCellLocator* locator, 
+    PolysegmentIter3d(vtkUnstructuredGrid* grid, vtkAbstractCellLocator* locator, 
                       const double p0[], const double p1[]);
 
+    /**
+     * Constructor, with the locations of the start/end points already known
+     * @param grid instance of vtkUnstructuredGrid
+     * @param locator cell locator attached to the above grid
+     * @param p0 start point
+     * @param p1 end point
+     * @param cellId0 cell Id of the start point, negative if unknown
+     * @param xi0 cell parametric coordinates of the start point
+     * @param cellId1 cell Id of the end point, negative if unknown
+     * @param xi1 cell parametric coordinates of the end point
+     */
+    PolysegmentIter3d(vtkUnstructuredGrid* grid, vtkAbstractCellLocator* locator, 
+                      const double p0[], const double p1[],
+                      vtkIdType cellId0, const double xi0[],
+                      vtkIdType cellId1, const double xi1[]);
+
+    /**
+     * Constructor, with the locations of the start/end points already known
+     * @param grid instance of vtkUnstructuredGrid
+     * @param locQuery searches the cell locator attached to the above grid. Use this 
+     *                 constructor when computing many lines, the query's scratch space
+     *                 is then allocated once
+     * @param p0 start point
+     * @param p1 end point
+     * @param cellId0 cell Id of the start point, negative if unknown
+     * @param xi0 cell parametric coordinates of the start point
+     * @param cellId1 cell Id of the end point, negative if unknown
+     * @param xi1 cell parametric coordinates of the end point
+     */
+    PolysegmentIter3d(vtkUnstructuredGrid* grid, LocatorQuery& locQuery, 
+                      const double p0[], const double p1[],
+                      vtkIdType cellId0, const double xi0[],
+                      vtkIdType cellId1, const double xi1[]);
+
     /**
      * Get the integrated linear parametric coordinates
      * @return value
@@ -93,6 +129,20 @@ public:
 
 private:
 
+    /**
+     * Compute the segments
+     * @param locQuery searches the cell locator
+     * @param pa start point
+     * @param pb end point
+     * @param cellIdA cell Id of the start point, negative if unknown
+     * @param xiA cell parametric coordinates of the start point
+     * @param cellIdB cell Id of the end point, negative if unknown
+     * @param xiB cell parametric coordinates of the end point
+     */
+    void __build(LocatorQuery& locQuery, const double pa[], const double pb[],
+                 vtkIdType cellIdA, const double xiA[],
+                 vtkIdType cellIdB, const double xiB[]);
+
     // cell Ids for each intersection point
     std::vector<vtkIdType> cellIds;
 
@@ -107,7 +157,7 @@ private:
     vtkUnstructuredGrid* grid;
 
     //vtkOBBTree* locator;
-    vtkCellLocator* locator;
+    vtkAbstractCellLocator* locator;
 
     double eps;
     double eps100;
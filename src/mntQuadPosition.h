@@ -0,0 +1,153 @@
+#include <vtkGenericCell.h>
+#include <vtkPoints.h>
+#include <cmath>
+#include <algorithm>
+
+#ifndef MNT_QUAD_POSITION
+#define MNT_QUAD_POSITION
+
+/**
+ * Compute the parametric coordinates of a point in a bilinear quad, as
+ * vtkQuad::EvaluatePosition does but without Newton iterations: the point is
+ * projected onto the plane of the quad and the bilinear map is inverted in
+ * closed form, by solving a quadratic equation.
+ * @param verts quad vertices, ordered as in vtkQuad
+ * @param x point
+ * @param pcoords parametric coordinates, pcoords[2] is set to 0 (output)
+ * @param weights the four interpolation weights, may be NULL (output)
+ * @return 1 if the point is inside (both parametric coordinates in [-0.001, 1.001],
+ *         the tolerance of vtkQuad), 0 if outside and -1 if the quad is degenerate
+ */
+inline int mntQuadEvaluatePosition(const double verts[4][3], const double x[3],
+                                   double pcoords[3], double* weights) {
+
+    pcoords[0] = pcoords[1] = 0.5;
+    pcoords[2] = 0.;
+
+    // normal of the quad (Newell's method, as vtkPolygon::ComputeNormal)
+    double n[] = {0., 0., 0.};
+    for (int i = 0; i < 4; ++i) {
+        const double* a = verts[i];
+        const double* b = verts[(i + 1) % 4];
+        n[0] += (a[1] - b[1]) * (a[2] + b[2]);
+        n[1] += (a[2] - b[2]) * (a[0] + b[0]);
+        n[2] += (a[0] - b[0]) * (a[1] + b[1]);
+    }
+    double len = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+    if (len != 0.) {
+        n[0] /= len;
+        n[1] /= len;
+        n[2] /= len;
+    }
+
+    // work in the two coordinates in which the quad has the largest projected area
+    int idx = 0;
+    double maxComponent = 0.;
+    for (int i = 0; i < 3; ++i) {
+        if (std::abs(n[i]) > maxComponent) {
+            maxComponent = std::abs(n[i]);
+            idx = i;
+        }
+    }
+    const int i0 = (idx == 0)? 1: 0;
+    const int i1 = (idx == 2)? 1: 2;
+
+    // project the point onto the plane of the quad
+    double dd = (x[0] - verts[0][0])*n[0] + (x[1] - verts[0][1])*n[1] + (x[2] - verts[0][2])*n[2];
+
+    // x(xi, eta) = v0 + xi*e + eta*f + xi*eta*g
+    double e[] = {verts[1][i0] - verts[0][i0], verts[1][i1] - verts[0][i1]};
+    double f[] = {verts[3][i0] - verts[0][i0], verts[3][i1] - verts[0][i1]};
+    double g[] = {verts[0][i0] - verts[1][i0] + verts[2][i0] - verts[3][i0],
+                  verts[0][i1] - verts[1][i1] + verts[2][i1] - verts[3][i1]};
+    double h[] = {x[i0] - dd*n[i0] - verts[0][i0], x[i1] - dd*n[i1] - verts[0][i1]};
+
+    // k2*eta^2 + k1*eta + k0 = 0
+    double k2 = g[0]*f[1] - g[1]*f[0];
+    double k1 = e[0]*f[1] - e[1]*f[0] + h[0]*g[1] - h[1]*g[0];
+    double k0 = h[0]*e[1] - h[1]*e[0];
+
+    // candidate roots, computed so as to avoid cancellations. A quadratic
+    // without real root means that the point is far outside
+    double etas[2];
+    int numRoots = 0;
+    if (k2 == 0.) {
+        if (k1 == 0.) {
+            return -1;
+        }
+        etas[numRoots++] = -k0/k1;
+    }
+    else {
+        double disc = k1*k1 - 4.*k2*k0;
+        double q = -0.5*(k1 + std::copysign(std::sqrt(disc > 0.? disc: 0.), k1));
+        etas[numRoots++] = q/k2;
+        if (q != 0.) {
+            etas[numRoots++] = k0/q;
+        }
+    }
+
+    // keep the root closest to the unit square
+    double bestDist = HUGE_VAL;
+    for (int r = 0; r < numRoots; ++r) {
+        double eta = etas[r];
+        double den0 = e[0] + g[0]*eta;
+        double den1 = e[1] + g[1]*eta;
+        double xi;
+        if (std::abs(den0) >= std::abs(den1)) {
+            if (den0 == 0.) continue;
+            xi = (h[0] - f[0]*eta)/den0;
+        }
+        else {
+            xi = (h[1] - f[1]*eta)/den1;
+        }
+        double dist = std::max(std::max(-xi, xi - 1.), std::max(-eta, eta - 1.));
+        if (dist < bestDist) {
+            bestDist = dist;
+            pcoords[0] = xi;
+            pcoords[1] = eta;
+        }
+    }
+    if (bestDist == HUGE_VAL || !std::isfinite(pcoords[0]) || !std::isfinite(pcoords[1])) {
+        pcoords[0] = pcoords[1] = 0.5;
+        return -1;
+    }
+
+    if (weights) {
+        weights[0] = (1. - pcoords[0]) * (1. - pcoords[1]);
+        weights[1] = pcoords[0] * (1. - pcoords[1]);
+        weights[2] = pcoords[0] * pcoords[1];
+        weights[3] = (1. - pcoords[0]) * pcoords[1];
+    }
+
+    if (pcoords[0] >= -0.001 && pcoords[0] <= 1.001 &&
+        pcoords[1] >= -0.001 && pcoords[1] <= 1.001) {
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Compute the parametric coordinates of a point in a cell, in closed form for
+ * quads (see mntQuadEvaluatePosition) and with vtkCell::EvaluatePosition otherwise
+ * @param cell cell, e.g. filled by vtkDataSet::GetCell
+ * @param x point
+ * @param pcoords parametric coordinates (output)
+ * @param weights interpolation weights (output)
+ * @return 1 if the point is inside, 0 if outside and -1 if the computation failed
+ */
+inline int mntCellEvaluatePosition(vtkGenericCell* cell, double x[3], double pcoords[3],
+                                   double* weights) {
+    if (cell->GetCellType() == VTK_QUAD) {
+        double verts[4][3];
+        vtkPoints* points = cell->GetPoints();
+        for (int i = 0; i < 4; ++i) {
+            points->GetPoint(i, verts[i]);
+        }
+        return mntQuadEvaluatePosition(verts, x, pcoords, weights);
+    }
+    int subId;
+    double dist2;
+    return cell->EvaluatePosition(x, NULL, subId, pcoords, dist2, weights);
+}
+
+#endif // MNT_QUAD_POSITION
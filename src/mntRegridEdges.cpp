@@ -1,9 +1,14 @@
 #include <mntRegridEdges.h>
 #include <mntPolysegmentIter.h>
+#include <mntPointLocationCache.h>
+#include <mntParallel.h>
+#include <mntLocatorFactory.h>
 #include <iostream>
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
 #include <vtkIdList.h>
+#include <vtkGenericCell.h>
 #include <netcdf.h>
 #include <vtkHexahedron.h> // for 3d grids
 #include <vtkQuad.h>       // for 2d grids
@@ -14,14 +19,15 @@ int mnt_regridedges_new(RegridEdges_t** self) {
     *self = new RegridEdges_t();
     (*self)->srcGrid = NULL;
     (*self)->dstGrid = NULL;
-    (*self)->srcLoc = vtkCellLocator::New();
+    (*self)->srcLoc = NULL;
     (*self)->numSrcCells = 0;
     (*self)->numDstCells = 0;
     (*self)->numPointsPerCell = 4; // 2d
     (*self)->numEdgesPerCell = 4;  // 2d
     (*self)->srcGridObj = NULL;
     (*self)->dstGridObj = NULL;
-
+    (*self)->numThreads = 1;
+    (*self)->srcLocType = "";
 
     return 0;
 }
@@ -30,7 +36,9 @@ extern "C"
 int mnt_regridedges_del(RegridEdges_t** self) {
 
     // destroy the cell locator
-    (*self)->srcLoc->Delete();
+    if ((*self)->srcLoc) {
+        (*self)->srcLoc->Delete();
+    }
    
     // destroy the source and destination grids if this instance owns them
     if ((*self)->srcGridObj) {
@@ -256,69 +264,79 @@ int mnt_regridedges_setDstPointsPtr(RegridEdges_t** self, size_t nVertsPerCell,
     return 0;
 }
 
-extern "C"
-int mnt_regridedges_build(RegridEdges_t** self, int numCellsPerBucket) {
-
-    // checks
-    if (!(*self)->srcGrid) {
-        std::cerr << "mnt_regridedges_build: ERROR must set source grid!\n";
-        return 1;
-    }
-    if (!(*self)->dstGrid) {
-        std::cerr << "mnt_regridedges_build: ERROR must set destination grid!\n";
-        return 2;
-    }
-
-    // build the locator
-    (*self)->srcLoc->SetDataSet((*self)->srcGrid);
-    (*self)->srcLoc->SetNumberOfCellsPerBucket(numCellsPerBucket);
-    (*self)->srcLoc->BuildLocator(); 
+/**
+ * Weights and their cell/edge id arrays computed by a single thread
+ */
+struct RegridEdgesBuffer_t {
+    std::vector<vtkIdType> weightDstCellIds;
+    std::vector<int> weightDstFaceEdgeIds;
+    std::vector<vtkIdType> weightSrcCellIds;
+    std::vector<int> weightSrcFaceEdgeIds;
+    std::vector<double> weights;
+};
+
+/**
+ * Compute the weights for a contiguous range of destination cells
+ * @param self instance of RegridEdges_t
+ * @param srcLoc cell locator attached to the source grid, shared across threads only if its
+ *               queries are thread safe. It is searched through the PolysegmentIter's own
+ *               LocatorQuery
+ * @param dstPointLocations locations of the destination grid points in the source grid
+ * @param srcAdjacency source grid cell neighbour tables
+ * @param dstCellBeg first destination cell
+ * @param dstCellEnd one past the last destination cell
+ * @param buffer weights and cell/edge id arrays (output)
+ */
+static void __mnt_regridedges_computeWeights(RegridEdges_t* self, vtkAbstractCellLocator* srcLoc,
+                                            const PointLocationCache& dstPointLocations,
+                                            const CellAdjacency& srcAdjacency,
+                                            vtkIdType dstCellBeg, vtkIdType dstCellEnd,
+                                            RegridEdgesBuffer_t& buffer) {
 
-    // compute the weights
     vtkIdList* dstPtIds = vtkIdList::New();
-    vtkIdList* srcCellIds = vtkIdList::New();
+    vtkGenericCell* srcCell = vtkGenericCell::New();
     double dstEdgePt0[] = {0., 0., 0.};
     double dstEdgePt1[] = {0., 0., 0.};
-    Vector<double> pcoords0(3);
-    Vector<double> pcoords1(3);
 
-    vtkPoints* dstPoints = (*self)->dstGrid->GetPoints();
+    vtkPoints* dstPoints = self->dstGrid->GetPoints();
 
-    (*self)->numSrcCells = (*self)->srcGrid->GetNumberOfCells();
-    (*self)->numDstCells = (*self)->dstGrid->GetNumberOfCells();
+    // breaks the dst edges into sub-edges, reused for every dst edge
+    PolysegmentIter polySegIter(self->srcGrid, srcLoc);
+    polySegIter.setCellAdjacency(&srcAdjacency);
 
     // reserve some space for the weights and their cell/edge id arrays
-    size_t n = (*self)->numDstCells * (*self)->numEdgesPerCell * 20;
-    (*self)->weights.reserve(n);
-    (*self)->weightSrcFaceEdgeIds.reserve(n);
-    (*self)->weightDstFaceEdgeIds.reserve(n);
-    (*self)->weightSrcCellIds.reserve(n);
-    (*self)->weightDstCellIds.reserve(n);
+    size_t n = (dstCellEnd - dstCellBeg) * self->numEdgesPerCell * 20;
+    buffer.weights.reserve(n);
+    buffer.weightSrcFaceEdgeIds.reserve(n);
+    buffer.weightDstFaceEdgeIds.reserve(n);
+    buffer.weightSrcCellIds.reserve(n);
+    buffer.weightDstCellIds.reserve(n);
 
     // iterate over the dst grid cells
-    for (vtkIdType dstCellId = 0; dstCellId < (*self)->numDstCells; ++dstCellId) {
+    for (vtkIdType dstCellId = dstCellBeg; dstCellId < dstCellEnd; ++dstCellId) {
 
         // get this cell vertex Ids
-        (*self)->dstGrid->GetCellPoints(dstCellId, dstPtIds);
-
-        vtkCell* dstCell = (*self)->dstGrid->GetCell(dstCellId);
-        int numEdges = dstCell->GetNumberOfEdges();
+        self->dstGrid->GetCellPoints(dstCellId, dstPtIds);
 
         // iterate over the four edges of each dst cell
         for (int dstEdgeIndex = 0; 
-             dstEdgeIndex < (*self)->edgeConnectivity.getNumberOfEdges(); 
+             dstEdgeIndex < self->edgeConnectivity.getNumberOfEdges(); 
              ++dstEdgeIndex) {
 
             int id0, id1;
-            (*self)->edgeConnectivity.getCellPointIds(dstEdgeIndex, &id0, &id1);
+            self->edgeConnectivity.getCellPointIds(dstEdgeIndex, &id0, &id1);
               
-            dstPoints->GetPoint(dstCell->GetPointId(id0), dstEdgePt0);
-            dstPoints->GetPoint(dstCell->GetPointId(id1), dstEdgePt1);
-
-            // break the edge into sub-edges
-            PolysegmentIter polySegIter = PolysegmentIter((*self)->srcGrid, 
-                                                          (*self)->srcLoc,
-                                                          dstEdgePt0, dstEdgePt1);
+            vtkIdType dstPtId0 = dstPtIds->GetId(id0);
+            vtkIdType dstPtId1 = dstPtIds->GetId(id1);
+            dstPoints->GetPoint(dstPtId0, dstEdgePt0);
+            dstPoints->GetPoint(dstPtId1, dstEdgePt1);
+
+            // break the edge into sub-edges, the end points have already been located
+            polySegIter.setLine(dstEdgePt0, dstEdgePt1, 
+                                dstPointLocations.getCellId(dstPtId0), 
+                                dstPointLocations.getParamCoords(dstPtId0),
+                                dstPointLocations.getCellId(dstPtId1), 
+                                dstPointLocations.getParamCoords(dstPtId1));
 
             // number of sub-segments
             size_t numSegs = polySegIter.getNumberOfSegments();
@@ -333,21 +351,19 @@ int mnt_regridedges_build(RegridEdges_t** self, int numCellsPerBucket) {
                 const Vector<double>& xib = polySegIter.getEndCellParamCoord();
                 const double coeff = polySegIter.getCoefficient();
 
-                Vector<double> dxi = xib - xia;
-                Vector<double> xiMid = 0.5*(xia + xib);
+                double dxi[] = {xib[0] - xia[0], xib[1] - xia[1]};
+                double xiMid[] = {0.5*(xia[0] + xib[0]), 0.5*(xia[1] + xib[1])};
 
-                // create pair (dstCellId, srcCellId)
-                std::pair<vtkIdType, vtkIdType> k = std::pair<vtkIdType, vtkIdType>(dstCellId, 
-                                                                                    srcCellId);
-                vtkCell* srcCell = (*self)->srcGrid->GetCell(srcCellId);
+                // GetCell(cellId) is not thread safe, use our own cell instead
+                self->srcGrid->GetCell(srcCellId, srcCell);
                 double* srcCellParamCoords = srcCell->GetParametricCoords();
 
                 for (int srcEdgeIndex = 0; 
-                     srcEdgeIndex < (*self)->edgeConnectivity.getNumberOfEdges(); 
+                     srcEdgeIndex < self->edgeConnectivity.getNumberOfEdges(); 
                      ++srcEdgeIndex) {
 
                     int i0, i1;
-                    (*self)->edgeConnectivity.getCellPointIds(srcEdgeIndex, &i0, &i1);
+                    self->edgeConnectivity.getCellPointIds(srcEdgeIndex, &i0, &i1);
 
                     // compute the interpolation weight, a product for every dimension
                     double weight = 1.0;
@@ -378,11 +394,11 @@ int mnt_regridedges_build(RegridEdges_t** self, int numCellsPerBucket) {
 
                     if (std::abs(weight) > 1.e-15) {
                         // only store the weights if they non-zero
-                        (*self)->weights.push_back(weight);
-                        (*self)->weightSrcCellIds.push_back(srcCellId);
-                        (*self)->weightSrcFaceEdgeIds.push_back(srcEdgeIndex);
-                        (*self)->weightDstCellIds.push_back(dstCellId);
-                        (*self)->weightDstFaceEdgeIds.push_back(dstEdgeIndex);
+                        buffer.weights.push_back(weight);
+                        buffer.weightSrcCellIds.push_back(srcCellId);
+                        buffer.weightSrcFaceEdgeIds.push_back(srcEdgeIndex);
+                        buffer.weightDstCellIds.push_back(dstCellId);
+                        buffer.weightDstFaceEdgeIds.push_back(dstEdgeIndex);
                     }
                 }
 
@@ -401,12 +417,143 @@ int mnt_regridedges_build(RegridEdges_t** self, int numCellsPerBucket) {
     }
 
     // clean up
-    srcCellIds->Delete();
+    srcCell->Delete();
     dstPtIds->Delete();
+}
 
+/**
+ * Append src to dst, releasing the memory held by src
+ * @param dst destination vector
+ * @param src source vector
+ */
+template <class T>
+static void __mnt_regridedges_append(std::vector<T>& dst, std::vector<T>& src) {
+    if (dst.size() == 0) {
+        dst.swap(src);
+    }
+    else {
+        dst.insert(dst.end(), src.begin(), src.end());
+    }
+    std::vector<T>().swap(src);
+}
+
+extern "C"
+int mnt_regridedges_setNumberOfThreads(RegridEdges_t** self, int numThreads) {
+    if (numThreads < 1) {
+        std::cerr << "mnt_regridedges_setNumberOfThreads: ERROR number of threads must be >= 1 (got "
+                  << numThreads << ")\n";
+        return 1;
+    }
+    (*self)->numThreads = numThreads;
     return 0;
 }
 
+extern "C"
+int mnt_regridedges_setSrcLocatorCacheFile(RegridEdges_t** self, const char* fort_filename, int n) {
+    // Fortran strings don't come with null-termination character
+    (*self)->srcLocCacheFile = std::string(fort_filename, n);
+    return 0;
+}
+
+extern "C"
+int mnt_regridedges_setSrcLocatorType(RegridEdges_t** self, const char* fort_name, int n) {
+    // Fortran strings don't come with null-termination character
+    std::string name(fort_name, n);
+    if (!LocatorFactory::isValid(name)) {
+        std::cerr << "mnt_regridedges_setSrcLocatorType: ERROR unknown locator \"" << name
+                  << "\", valid names are " << LocatorFactory::getNames() << '\n';
+        return 1;
+    }
+    (*self)->srcLocType = name;
+    return 0;
+}
+
+extern "C"
+int mnt_regridedges_build(RegridEdges_t** self, int numCellsPerBucket) {
+
+    // checks
+    if (!(*self)->srcGrid) {
+        std::cerr << "mnt_regridedges_build: ERROR must set source grid!\n";
+        return 1;
+    }
+    if (!(*self)->dstGrid) {
+        std::cerr << "mnt_regridedges_build: ERROR must set destination grid!\n";
+        return 2;
+    }
+
+    // build the locator
+    if ((*self)->srcLoc) {
+        (*self)->srcLoc->Delete();
+    }
+    std::string locType = (*self)->srcLocType;
+    if (locType.empty()) {
+        locType = LocatorFactory::getDefaultName((*self)->srcGrid, !(*self)->srcLocCacheFile.empty());
+    }
+    (*self)->srcLoc = LocatorFactory::createCached(locType, (*self)->srcGrid,
+                                                   numCellsPerBucket, (*self)->srcLocCacheFile,
+                                                   (*self)->numThreads);
+    if (!(*self)->srcLoc) {
+        std::cerr << "mnt_regridedges_build: ERROR locator \"" << locType
+                  << "\" does not support the source grid\n";
+        return 3;
+    }
+
+    (*self)->numSrcCells = (*self)->srcGrid->GetNumberOfCells();
+    (*self)->numDstCells = (*self)->dstGrid->GetNumberOfCells();
+
+    int numThreads = (*self)->numThreads;
+
+    // locate each dst grid point once, the points are shared by several dst cell edges
+    PointLocationCache dstPointLocations(2);
+    dstPointLocations.build((*self)->dstGrid->GetPoints(), (*self)->srcLoc, numThreads);
+
+    // src cell neighbours, to walk along the dst edges from cell to cell
+    CellAdjacency srcAdjacency;
+    std::vector<vtkIdType> noConnectivity;
+    srcAdjacency.build((*self)->srcGrid, (*self)->srcGridObj? 
+                                         (*self)->srcGridObj->faceNodeConnectivity: noConnectivity);
+
+    // compute the weights. Each thread handles a contiguous range of dst cells
+    // and stores its weights in its own buffer
+    std::vector<RegridEdgesBuffer_t> buffers(numThreads);
+    RegridEdges_t* regridder = *self;
+    mntParallelFor(numThreads, regridder->numDstCells, 
+                   [regridder, numCellsPerBucket, &dstPointLocations, &srcAdjacency, &buffers]
+                   (int threadId, size_t dstCellBeg, size_t dstCellEnd) {
+
+        // locators that can be queried concurrently are shared, each thread searching them
+        // through its own LocatorQuery. The line queries of vtkCellLocator are not thread 
+        // safe, each additional thread then gets its own locator
+        vtkAbstractCellLocator* srcLoc = regridder->srcLoc;
+        bool ownLocator = threadId > 0 && !LocatorFactory::hasConcurrentQueries(srcLoc);
+        if (ownLocator) {
+            srcLoc = LocatorFactory::create(LocatorFactory::getName(srcLoc), 
+                                            regridder->srcGrid, numCellsPerBucket);
+        }
+
+        __mnt_regridedges_computeWeights(regridder, srcLoc, dstPointLocations, srcAdjacency,
+                                        (vtkIdType) dstCellBeg, (vtkIdType) dstCellEnd, 
+                                        buffers[threadId]);
+
+        if (ownLocator) {
+            srcLoc->Delete();
+        }
+    });
+
+    // merge the buffers in dst cell order so the result does not depend on the number 
+    // of threads
+    for (int threadId = 0; threadId < numThreads; ++threadId) {
+        RegridEdgesBuffer_t& buffer = buffers[threadId];
+        __mnt_regridedges_append((*self)->weights, buffer.weights);
+        __mnt_regridedges_append((*self)->weightSrcCellIds, buffer.weightSrcCellIds);
+        __mnt_regridedges_append((*self)->weightSrcFaceEdgeIds, buffer.weightSrcFaceEdgeIds);
+        __mnt_regridedges_append((*self)->weightDstCellIds, buffer.weightDstCellIds);
+        __mnt_regridedges_append((*self)->weightDstFaceEdgeIds, buffer.weightDstFaceEdgeIds);
+    }
+
+    return mnt_regridedges_finalize(self);
+}
+
 extern "C"
 int mnt_regridedges_getNumSrcCells(RegridEdges_t** self, int* n) {
     *n = (*self)->numSrcCells;
@@ -445,44 +592,316 @@ int mnt_regridedges_getNumDstUniqueEdges(RegridEdges_t** self, size_t* nPtr) {
     return ier;
 }
 
-extern "C"
-int mnt_regridedges_applyCellEdge(RegridEdges_t** self, 
-                                  const double src_data[], double dst_data[]) {
+/**
+ * Convert a sparse matrix in coordinate (row, column, value) format into compressed 
+ * sparse row format
+ * @param numRows number of rows, all row indices must be < numRows
+ * @param rows row indices
+ * @param cols column indices
+ * @param vals values
+ * @param rowPtr offsets of the rows, size numRows + 1 (output)
+ * @param colIds column indices, sorted within each row (output)
+ * @param values values, entries with the same row and column indices are summed (output)
+ */
+static void __mnt_regridedges_toCsr(size_t numRows, const std::vector<size_t>& rows,
+                                    const std::vector<size_t>& cols, const std::vector<double>& vals,
+                                    std::vector<size_t>& rowPtr, std::vector<size_t>& colIds,
+                                    std::vector<double>& values) {
+
+    size_t n = vals.size();
+
+    // count the number of entries in each row
+    rowPtr.assign(numRows + 1, 0);
+    for (size_t i = 0; i < n; ++i) {
+        rowPtr[rows[i] + 1]++;
+    }
+    for (size_t row = 0; row < numRows; ++row) {
+        rowPtr[row + 1] += rowPtr[row];
+    }
 
-    // initialize the data to zero
-    size_t n = (*self)->numDstCells * (*self)->numEdgesPerCell;
+    // bucket the entries by row, preserving their original order
+    std::vector<size_t> order(n);
+    std::vector<size_t> next(rowPtr.begin(), rowPtr.end() - 1);
     for (size_t i = 0; i < n; ++i) {
-        dst_data[i] = 0.0;
+        order[next[rows[i]]++] = i;
     }
 
-    // add the contributions from each cell overlaps
-    for (size_t i = 0; i < (*self)->weights.size(); ++i) {
+    // sort each row by column index and merge the entries with the same column index
+    colIds.resize(n);
+    values.resize(n);
+    std::vector< std::pair<size_t, size_t> > rowEntries; // (column index, entry index)
+    size_t nnz = 0;
+    for (size_t row = 0; row < numRows; ++row) {
 
-        vtkIdType dstCellId = (*self)->weightDstCellIds[i];
-        vtkIdType srcCellId = (*self)->weightSrcCellIds[i];
-        int dstEdgeIndex = (*self)->weightDstFaceEdgeIds[i];
-        int srcEdgeIndex = (*self)->weightSrcFaceEdgeIds[i];
+        size_t beg = rowPtr[row];
+        size_t end = rowPtr[row + 1];
 
-        // index into the flat array
-        size_t dstK = dstEdgeIndex + (*self)->numEdgesPerCell * dstCellId;
-        size_t srcK = srcEdgeIndex + (*self)->numEdgesPerCell * srcCellId;
+        rowEntries.clear();
+        for (size_t k = beg; k < end; ++k) {
+            rowEntries.push_back(std::pair<size_t, size_t>(cols[order[k]], order[k]));
+        }
+        std::sort(rowEntries.begin(), rowEntries.end());
+
+        rowPtr[row] = nnz;
+        for (size_t j = 0; j < rowEntries.size(); ++j) {
+            size_t col = rowEntries[j].first;
+            double val = vals[rowEntries[j].second];
+            if (nnz > rowPtr[row] && colIds[nnz - 1] == col) {
+                values[nnz - 1] += val;
+            }
+            else {
+                colIds[nnz] = col;
+                values[nnz] = val;
+                nnz++;
+            }
+        }
+    }
+    rowPtr[numRows] = nnz;
+
+    colIds.resize(nnz);
+    values.resize(nnz);
+}
 
-        dst_data[dstK] += (*self)->weights[i] * src_data[srcK];
+/**
+ * Build the unique edge to unique edge matrix, with the edge signs and the 
+ * multiplicity normalisation folded into the values
+ * @param self instance of RegridEdges_t
+ * @return error code (0 is OK)
+ * @note requires the src and dst grid connectivity (grids read from UGRID files)
+ */
+static int __mnt_regridedges_buildUniqueEdgeOperator(RegridEdges_t* self) {
+
+    int ier;
+    size_t numDstEdges;
+    ier = mnt_grid_getNumberOfUniqueEdges(&self->dstGridObj, &numDstEdges);
+    if (ier != 0) {
+        return ier;
+    }
+
+    size_t numWeights = self->weights.size();
+    std::vector<size_t> rows(numWeights);
+    std::vector<size_t> cols(numWeights);
+    std::vector<double> vals(numWeights);
+
+    // dst_multiplicity keeps track of the cells that share the same edge
+    std::vector<double> dstMultiplicity(numDstEdges, 0.0);
+
+    for (size_t i = 0; i < numWeights; ++i) {
+
+        vtkIdType srcEdgeId, dstEdgeId;
+        int srcEdgeSign, dstEdgeSign;
+        ier = mnt_grid_getEdgeId(&self->srcGridObj, self->weightSrcCellIds[i], 
+                                 self->weightSrcFaceEdgeIds[i], &srcEdgeId, &srcEdgeSign);
+        ier = mnt_grid_getEdgeId(&self->dstGridObj, self->weightDstCellIds[i], 
+                                 self->weightDstFaceEdgeIds[i], &dstEdgeId, &dstEdgeSign);
+        if (srcEdgeId < 0 || dstEdgeId < 0 || (size_t) dstEdgeId >= numDstEdges) {
+            std::cerr << "ERROR: could not find the unique edge Ids of weight " << i << '\n';
+            return 1;
+        }
+
+        rows[i] = dstEdgeId;
+        cols[i] = srcEdgeId;
+        vals[i] = srcEdgeSign * dstEdgeSign * self->weights[i];
+        dstMultiplicity[dstEdgeId] += vals[i];
+    }
+
+    __mnt_regridedges_toCsr(numDstEdges, rows, cols, vals, self->uniqueEdgeRowPtr, 
+                            self->uniqueEdgeSrcIds, self->uniqueEdgeWeights);
+
+    // correct for multiplicity
+    for (size_t row = 0; row < numDstEdges; ++row) {
+        for (size_t k = self->uniqueEdgeRowPtr[row]; k < self->uniqueEdgeRowPtr[row + 1]; ++k) {
+            self->uniqueEdgeWeights[k] /= dstMultiplicity[row];
+        }
     }
 
     return 0;
 }
 
+/**
+ * Check that the grid has the unique edge connectivity
+ * @param gridObj grid object
+ * @return true if the connectivity is set
+ */
+static bool __mnt_regridedges_hasEdgeConnectivity(Grid_t* gridObj) {
+    return gridObj &&
+           gridObj->faceNodeConnectivity.size() != 0 &&
+           gridObj->faceEdgeConnectivity.size() != 0 &&
+           gridObj->edgeNodeConnectivity.size() != 0;
+}
+
+extern "C"
+int mnt_regridedges_finalize(RegridEdges_t** self) {
+
+    RegridEdges_t* rg = *self;
+    if (rg->srcGrid) {
+        rg->numSrcCells = rg->srcGrid->GetNumberOfCells();
+    }
+    if (rg->dstGrid) {
+        rg->numDstCells = rg->dstGrid->GetNumberOfCells();
+    }
+
+    size_t numEdgesPerCell = rg->numEdgesPerCell;
+    size_t numWeights = rg->weights.size();
+
+    // flat cell edge indices, one row per dst cell edge
+    size_t numRows = rg->numDstCells * numEdgesPerCell;
+    std::vector<size_t> rows(numWeights);
+    std::vector<size_t> cols(numWeights);
+    for (size_t i = 0; i < numWeights; ++i) {
+        rows[i] = rg->weightDstFaceEdgeIds[i] + numEdgesPerCell * rg->weightDstCellIds[i];
+        cols[i] = rg->weightSrcFaceEdgeIds[i] + numEdgesPerCell * rg->weightSrcCellIds[i];
+        if (rows[i] >= numRows) {
+            // can happen if the weights were loaded before the dst grid was set
+            numRows = rows[i] + 1;
+        }
+    }
+    __mnt_regridedges_toCsr(numRows, rows, cols, rg->weights,
+                            rg->cellEdgeRowPtr, rg->cellEdgeSrcIds, rg->cellEdgeWeights);
+
+    // the unique edge matrix refers to the previous weights, it is rebuilt on the 
+    // next call to mnt_regridedges_applyUniqueEdge(Batch)
+    rg->uniqueEdgeRowPtr.clear();
+    rg->uniqueEdgeSrcIds.clear();
+    rg->uniqueEdgeWeights.clear();
+
+    return 0;
+}
+
+/**
+ * Apply a CSR matrix to a batch of fields
+ * @param rowPtr offsets of the rows
+ * @param colIds column indices
+ * @param values matrix values
+ * @param numSrc number of src edges per field
+ * @param numDst number of dst edges per field, rows beyond the matrix size are set to zero
+ * @param nfields number of fields
+ * @param fieldFastest 1 if the field index varies fastest, 0 if the edge index varies fastest
+ * @param numThreads number of threads
+ * @param src_data src fields
+ * @param dst_data dst fields (output)
+ * @note each weight is loaded once for all the fields, the result for each field is the 
+ *       same, bit for bit, as applying the matrix to that field alone. The rows are 
+ *       distributed among threads and each row is summed in the same order by a single
+ *       thread, hence the result does not depend on the number of threads
+ */
+static void __mnt_regridedges_applyCsr(const std::vector<size_t>& rowPtr, 
+                                       const std::vector<size_t>& colIds, 
+                                       const std::vector<double>& values,
+                                       size_t numSrc, size_t numDst,
+                                       int nfields, int fieldFastest, int numThreads,
+                                       const double src_data[], double dst_data[]) {
+
+    const size_t* srcIds = colIds.empty()? NULL: &colIds[0];
+    const double* weights = values.empty()? NULL: &values[0];
+    size_t numRows = rowPtr.size() - 1;
+    size_t nf = (size_t) nfields;
+
+    // strides between two consecutive edges and between two consecutive fields
+    size_t srcEdgeStride = fieldFastest? nf: 1;
+    size_t dstEdgeStride = fieldFastest? nf: 1;
+    size_t srcFieldStride = fieldFastest? 1: numSrc;
+    size_t dstFieldStride = fieldFastest? 1: numDst;
+
+    mntParallelFor(numThreads, numDst, [&](int /*threadId*/, size_t rowBeg, size_t rowEnd) {
+
+        std::vector<double> sums(nf);
+        for (size_t row = rowBeg; row < rowEnd; ++row) {
+
+            for (size_t f = 0; f < nf; ++f) {
+                sums[f] = 0.0;
+            }
+
+            if (row < numRows) {
+                for (size_t k = rowPtr[row]; k < rowPtr[row + 1]; ++k) {
+                    double w = weights[k];
+                    const double* src = &src_data[srcIds[k]*srcEdgeStride];
+                    if (fieldFastest) {
+                        // contiguous
+                        for (size_t f = 0; f < nf; ++f) {
+                            sums[f] += w * src[f];
+                        }
+                    }
+                    else {
+                        for (size_t f = 0; f < nf; ++f) {
+                            sums[f] += w * src[f*srcFieldStride];
+                        }
+                    }
+                }
+            }
+
+            double* dst = &dst_data[row*dstEdgeStride];
+            for (size_t f = 0; f < nf; ++f) {
+                dst[f*dstFieldStride] = sums[f];
+            }
+        }
+    });
+}
+
+extern "C"
+int mnt_regridedges_applyCellEdge(RegridEdges_t** self, 
+                                  const double src_data[], double dst_data[]) {
+    return mnt_regridedges_applyCellEdgeBatch(self, 1, 1, src_data, dst_data);
+}
+
+extern "C"
+int mnt_regridedges_applyCellEdgeBatch(RegridEdges_t** self, int nfields, int fieldFastest,
+                                       const double src_data[], double dst_data[]) {
+
+    if (nfields < 1) {
+        std::cerr << "mnt_regridedges_applyCellEdgeBatch: ERROR number of fields must be >= 1 (got "
+                  << nfields << ")\n";
+        return 1;
+    }
+
+    if ((*self)->cellEdgeRowPtr.size() == 0) {
+        int ier = mnt_regridedges_finalize(self);
+        if (ier != 0) {
+            return ier;
+        }
+    }
+
+    size_t numSrc = (*self)->numSrcCells * (*self)->numEdgesPerCell;
+    size_t numDst = std::max((*self)->numDstCells * (*self)->numEdgesPerCell, 
+                             (*self)->cellEdgeRowPtr.size() - 1);
+    // the field strides are the numbers of src and dst edges, which are only known
+    // from the grids (the weights may not reference the last edges)
+    if (nfields > 1 && !fieldFastest && numSrc == 0) {
+        std::cerr << "mnt_regridedges_applyCellEdgeBatch: ERROR must set the source grid\n";
+        return 2;
+    }
+    if (nfields > 1 && !fieldFastest && (*self)->numDstCells == 0) {
+        std::cerr << "mnt_regridedges_applyCellEdgeBatch: ERROR must set the destination grid\n";
+        return 3;
+    }
+
+    __mnt_regridedges_applyCsr((*self)->cellEdgeRowPtr, (*self)->cellEdgeSrcIds, 
+                               (*self)->cellEdgeWeights, numSrc, numDst, 
+                               nfields, fieldFastest, (*self)->numThreads, 
+                               src_data, dst_data);
+
+    return 0;
+}
+
 extern "C"
 int mnt_regridedges_applyUniqueEdge(RegridEdges_t** self, 
 	                                const double src_data[], double dst_data[]) {
+    return mnt_regridedges_applyUniqueEdgeBatch(self, 1, 1, src_data, dst_data);
+}
 
+extern "C"
+int mnt_regridedges_applyUniqueEdgeBatch(RegridEdges_t** self, int nfields, int fieldFastest,
+                                         const double src_data[], double dst_data[]) {
+
+    if (nfields < 1) {
+        std::cerr << "mnt_regridedges_applyUniqueEdgeBatch: ERROR number of fields must be >= 1 (got "
+                  << nfields << ")\n";
+        return 1;
+    }
 
     // make sure (*self)->srcGridObj.faceNodeConnectivity and the rest have been allocated
-    if (!(*self)->srcGridObj ||
-        (*self)->srcGridObj->faceNodeConnectivity.size() == 0 || 
-        (*self)->srcGridObj->faceEdgeConnectivity.size() == 0 ||
-        (*self)->srcGridObj->edgeNodeConnectivity.size() == 0) {
+    if (!__mnt_regridedges_hasEdgeConnectivity((*self)->srcGridObj) || 
+        !__mnt_regridedges_hasEdgeConnectivity((*self)->dstGridObj)) {
         std::cerr << "ERROR: looks like the src grid connectivity is not set.\n";
         std::cerr << "Typically this would occur if you did not read the grid\n";
         std::cerr << "from the netcdf Ugrid file.\n";
@@ -491,46 +910,35 @@ int mnt_regridedges_applyUniqueEdge(RegridEdges_t** self,
 
     int ier;
 
-    // number of unique edges on the destination grid
-    size_t numDstEdges;
-    ier = mnt_grid_getNumberOfUniqueEdges(&((*self)->dstGridObj), &numDstEdges);
-
-    // dst_multiplicity keeps track of the cells that share the same edge
-    std::vector<double> dst_multiplicity(numDstEdges);
-    
-    // initialize the data to zero
-    for (size_t i = 0; i < numDstEdges; ++i) {
-        dst_multiplicity[i] = 0.0;
-        dst_data[i] = 0.0;
+    // built on first use, callers that only apply cell by cell weights do not pay 
+    // for it
+    if ((*self)->uniqueEdgeRowPtr.size() == 0) {
+        ier = __mnt_regridedges_buildUniqueEdgeOperator(*self);
+        if (ier != 0) {
+            return ier;
+        }
     }
 
-    // add the contributions from each cell overlaps
-    for (size_t i = 0; i < (*self)->weights.size(); ++i) {
-
-        vtkIdType dstCellId = (*self)->weightDstCellIds[i];
-        vtkIdType srcCellId = (*self)->weightSrcCellIds[i];
-        int dstEdgeIndex = (*self)->weightDstFaceEdgeIds[i];
-        int srcEdgeIndex = (*self)->weightSrcFaceEdgeIds[i];
-
-        vtkIdType srcEdgeId, dstEdgeId;
-        int srcEdgeSign, dstEdgeSign;
-        ier = mnt_grid_getEdgeId(&((*self)->srcGridObj), srcCellId, srcEdgeIndex, &srcEdgeId, &srcEdgeSign);
-        ier = mnt_grid_getEdgeId(&((*self)->dstGridObj), dstCellId, dstEdgeIndex, &dstEdgeId, &dstEdgeSign);
-
-        // index into the flat array
-        size_t dstK = dstEdgeIndex + (*self)->numEdgesPerCell * dstCellId;
-        size_t srcK = srcEdgeIndex + (*self)->numEdgesPerCell * srcCellId;
-
-        dst_data[dstEdgeId] += srcEdgeSign * dstEdgeSign * (*self)->weights[i] * src_data[srcEdgeId];
-        dst_multiplicity[dstEdgeId] += srcEdgeSign * dstEdgeSign * (*self)->weights[i];
+    size_t numSrcEdges = 0;
+    ier = mnt_grid_getNumberOfUniqueEdges(&((*self)->srcGridObj), &numSrcEdges);
+    size_t numDstEdges = (*self)->uniqueEdgeRowPtr.size() - 1;
 
+    // the field strides are the numbers of src and dst edges
+    if (nfields > 1 && !fieldFastest && (ier != 0 || numSrcEdges == 0)) {
+        std::cerr << "mnt_regridedges_applyUniqueEdgeBatch: ERROR must set the source grid\n";
+        return 2;
     }
-
-    // correct for multiplicity
-    for (size_t i = 0; i < numDstEdges; ++i) {
-       dst_data[i] /= dst_multiplicity[i];
+    if (nfields > 1 && !fieldFastest && numDstEdges == 0) {
+        std::cerr << "mnt_regridedges_applyUniqueEdgeBatch: ERROR must set the destination grid\n";
+        return 3;
     }
 
+    // the edge signs and multiplicity are already included in the weights
+    __mnt_regridedges_applyCsr((*self)->uniqueEdgeRowPtr, (*self)->uniqueEdgeSrcIds, 
+                               (*self)->uniqueEdgeWeights, numSrcEdges, numDstEdges, 
+                               nfields, fieldFastest, (*self)->numThreads, 
+                               src_data, dst_data);
+
     return 0;
 }
 
@@ -651,7 +1059,7 @@ int mnt_regridedges_loadWeights(RegridEdges_t** self,
         return 13;
     }
 
-    return 0;
+    return mnt_regridedges_finalize(self);
 }
 
 extern "C"
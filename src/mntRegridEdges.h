@@ -19,8 +19,9 @@ struct RegridEdges_t {
     vtkUnstructuredGrid* srcGrid;
     vtkUnstructuredGrid* dstGrid;
 
-    // cell locator (octree-based) for fast cell search
-    vtkCellLocator* srcLoc;
+    // cell locator for fast cell search, uniform buckets for planar quad grids and
+    // octree-based otherwise
+    vtkAbstractCellLocator* srcLoc;
 
     // interpolation weights and corresponding src/dst grid cell
     // indices and edges indices
@@ -32,6 +33,21 @@ struct RegridEdges_t {
 
     std::vector<double> weights;
 
+    // compressed sparse row (CSR) representation of the above weights, one row per 
+    // destination cell edge, with flat source cell edge indices and no duplicate
+    // entries. Set by mnt_regridedges_finalize
+    std::vector<size_t> cellEdgeRowPtr;
+    std::vector<size_t> cellEdgeSrcIds;
+    std::vector<double> cellEdgeWeights;
+
+    // CSR representation of the unique edge to unique edge operator, with the edge 
+    // signs and multiplicity folded into the weights. Built on the first call to 
+    // mnt_regridedges_applyUniqueEdge(Batch), requires the grids' edge connectivity 
+    // (i.e. grids read from UGRID files)
+    std::vector<size_t> uniqueEdgeRowPtr;
+    std::vector<size_t> uniqueEdgeSrcIds;
+    std::vector<double> uniqueEdgeWeights;
+
     size_t numSrcCells;
     size_t numDstCells;
     size_t numPointsPerCell;
@@ -41,6 +57,16 @@ struct RegridEdges_t {
     Grid_t* dstGridObj;
 
     QuadEdgeIter edgeConnectivity;
+
+    // number of threads used to compute and apply the weights
+    int numThreads;
+
+    // file the source grid locator is loaded from, or saved to if the file does not
+    // match the source grid. No caching if empty
+    std::string srcLocCacheFile;
+
+    // name of the source grid locator, see LocatorFactory. Empty for the default
+    std::string srcLocType;
 };
 
 /**
@@ -145,6 +171,44 @@ int mnt_regridedges_setDstPointsPtr(RegridEdges_t** self,
                                     size_t nVertsPerCell, size_t ncells, 
                                     const double verts[]);
 
+/**
+ * Set the number of threads used to compute and apply the weights
+ * @param numThreads number of threads (>= 1)
+ * @return error code (0 is OK)
+ * @note the weights, and the result of applying them, are the same regardless of 
+ *       the number of threads
+ */
+extern "C"
+int mnt_regridedges_setNumberOfThreads(RegridEdges_t** self, int numThreads);
+
+/**
+ * Set the file caching the source grid locator. The locator is loaded from the file
+ * if it was saved for the same source grid and number of cells per bucket, otherwise
+ * it is built and saved
+ * @param fort_filename file name (does not require termination character)
+ * @param n length of filename string (excluding '\0' if present)
+ * @return error code (0 is OK)
+ * @note the "vtk" and "bvh" locators are not cached, see mnt_regridedges_setSrcLocatorType
+ *       for the default locator of a cached regridder
+ */
+extern "C"
+int mnt_regridedges_setSrcLocatorCacheFile(RegridEdges_t** self, const char* fort_filename, int n);
+
+/**
+ * Set the type of source grid locator built by mnt_regridedges_build
+ * @param fort_name locator name: "auto", "vtk", "octree", "bins2d", "bvh" or 
+ *                  "structured" (does not require termination character)
+ * @param n length of name string (excluding '\0' if present)
+ * @return error code (0 is OK)
+ * @note build fails if the locator does not support the source grid, e.g. "structured"
+ *       for a grid that is neither lat-lon nor cubed-sphere. By default the locator is
+ *       a vtkCellLocator ("vtk") unless a cache file is set, in which case it is "auto"
+ *       for quads in the z = 0 plane and "octree" otherwise, as the vtkCellLocator 
+ *       cannot be saved
+ */
+extern "C"
+int mnt_regridedges_setSrcLocatorType(RegridEdges_t** self, const char* fort_name, int n);
+
 /**
  * Build the regridder
  * @param numCellsPerBucket average number of cells per bucket
@@ -153,6 +217,17 @@ int mnt_regridedges_setDstPointsPtr(RegridEdges_t** self,
 extern "C"
 int mnt_regridedges_build(RegridEdges_t** self, int numCellsPerBucket);
 
+/**
+ * Convert the weights into compressed sparse row matrices for fast application, 
+ * one acting on cell by cell edge fields and, if the grid connectivity is known,
+ * one acting on unique edge fields
+ * @return error code (0 is OK)
+ * @note called by mnt_regridedges_build and mnt_regridedges_loadWeights, only needs 
+ *       to be called again if the weights are modified
+ */
+extern "C"
+int mnt_regridedges_finalize(RegridEdges_t** self);
+
 /**
  * Get number of source grid cells
  * @param n number of cells
@@ -205,12 +280,46 @@ int mnt_regridedges_applyCellEdge(RegridEdges_t** self,
  * @param numDstEdges number of destination grid edges
  * @param dst_data edge centred data on the destination grid
  * @return error code (0 is OK)
- * @note edges go anticlockwise
+ * @note edges go anticlockwise. The first call builds the unique edge operator. 
+ *       Destination edges that receive no contribution are set to zero (they 
+ *       used to be 0/0 = NaN before the multiplicity was folded into the weights)
  */
 extern "C"
 int mnt_regridedges_applyUniqueEdge(RegridEdges_t** self, 
                                     const double src_data[], double dst_data[]);
 
+/**
+ * Apply interpolation weights to a batch of cell by cell fields, each cell having four independent edges
+ * @param nfields number of fields (e.g. vertical levels times number of variables)
+ * @param fieldFastest 1 if the field index varies fastest (data[field + nfields*edge]), 
+ *                     0 if the edge index varies fastest (data[edge + numEdges*field])
+ * @param src_data edge centred data on the source grid, array of size nfields * 4 * number of source cells
+ * @param dst_data edge centred data on the destination grid, array of size nfields * 4 * number of 
+ *                 destination cells (output)
+ * @return error code (0 is OK)
+ * @note the weights are read once for all the fields. Each field is the same as would be 
+ *       obtained by calling mnt_regridedges_applyCellEdge on that field
+ */
+extern "C"
+int mnt_regridedges_applyCellEdgeBatch(RegridEdges_t** self, int nfields, int fieldFastest,
+                                       const double src_data[], double dst_data[]);
+
+/**
+ * Apply interpolation weights to a batch of edge fields with unique edge Ids
+ * @param nfields number of fields (e.g. vertical levels times number of variables)
+ * @param fieldFastest 1 if the field index varies fastest (data[field + nfields*edge]), 
+ *                     0 if the edge index varies fastest (data[edge + numEdges*field])
+ * @param src_data edge centred data on the source grid, array of size nfields * number of source edges
+ * @param dst_data edge centred data on the destination grid, array of size nfields * number of 
+ *                 destination edges (output)
+ * @return error code (0 is OK)
+ * @note the weights are read once for all the fields. Each field is the same as would be 
+ *       obtained by calling mnt_regridedges_applyUniqueEdge on that field
+ */
+extern "C"
+int mnt_regridedges_applyUniqueEdgeBatch(RegridEdges_t** self, int nfields, int fieldFastest,
+                                         const double src_data[], double dst_data[]);
+
 /**
  * Load the weights from file
  * @param fort_filename file name (does not require termination character)
@@ -1,6 +1,10 @@
 #include <mntRegridEdges3d.h>
 #include <mntPolysegmentIter3d.h>
+#include <mntPointLocationCache.h>
+#include <mntParallel.h>
+#include <mntLocatorFactory.h>
 #include <iostream>
+#include <algorithm>
 #include <cstdio>
 #include <vtkIdList.h>
 #include <netcdf.h>
@@ -12,7 +16,7 @@ int mnt_regridedges3d_new(RegridEdges3d_t** self) {
     *self = new RegridEdges3d_t();
     (*self)->srcGrid = NULL;
     (*self)->dstGrid = NULL;
-    (*self)->srcLoc = vtkCellLocator::New();
+    (*self)->srcLoc = NULL;
     (*self)->weights.clear();
     (*self)->numSrcCells = 0;
     (*self)->numDstCells = 0;
@@ -20,6 +24,8 @@ int mnt_regridedges3d_new(RegridEdges3d_t** self) {
     (*self)->numEdgesPerCell = 12; // 3d
     (*self)->srcGridObj = NULL;
     (*self)->dstGridObj = NULL;
+    (*self)->numThreads = 1;
+    (*self)->srcLocType = "";
     return 0;
 }
 
@@ -36,7 +42,9 @@ int mnt_regridedges3d_del(RegridEdges3d_t** self) {
     if ((*self)->dstGridObj) {
         mnt_grid_del(&(*self)->dstGridObj);
     }
-    (*self)->srcLoc->Delete();
+    if ((*self)->srcLoc) {
+        (*self)->srcLoc->Delete();
+    }
     delete *self;
     return 0;
 }
@@ -86,6 +94,70 @@ int mnt_regridedges3d_setDstPointsPtr(RegridEdges3d_t** self, size_t nVertsPerCe
     return 0;
 }
 
+/**
+ * Store the weights by dst cell
+ * @param self instance of RegridEdges3d_t
+ */
+static void __mnt_regridedges3d_flattenWeights(RegridEdges3d_t* self) {
+
+    size_t numEdgesPerCell = self->numEdgesPerCell;
+    size_t numRows = self->numDstCells;
+    if (self->weights.size() > 0) {
+        // can exceed the number of dst cells if the weights were loaded without a dst grid
+        numRows = std::max(numRows, (size_t) self->weights.rbegin()->first.first + 1);
+    }
+
+    self->dstCellPtr.assign(numRows + 1, 0);
+    self->dstCellSrcCellIds.resize(self->weights.size());
+    self->dstCellWeights.resize(self->weights.size() * numEdgesPerCell);
+
+    // the map is ordered by (dst cell, src cell)
+    size_t k = 0;
+    for (std::map< std::pair<vtkIdType, vtkIdType>, std::vector<double> >::const_iterator 
+         it = self->weights.begin(); it != self->weights.end(); ++it) {
+        self->dstCellPtr[it->first.first + 1]++;
+        self->dstCellSrcCellIds[k] = it->first.second;
+        for (size_t ie = 0; ie < numEdgesPerCell; ++ie) {
+            self->dstCellWeights[k*numEdgesPerCell + ie] = it->second[ie];
+        }
+        k++;
+    }
+    for (size_t row = 0; row < numRows; ++row) {
+        self->dstCellPtr[row + 1] += self->dstCellPtr[row];
+    }
+}
+
+extern "C"
+int mnt_regridedges3d_setNumberOfThreads(RegridEdges3d_t** self, int numThreads) {
+    if (numThreads < 1) {
+        std::cerr << "mnt_regridedges3d_setNumberOfThreads: ERROR number of threads must be >= 1 (got "
+                  << numThreads << ")\n";
+        return 1;
+    }
+    (*self)->numThreads = numThreads;
+    return 0;
+}
+
+extern "C"
+int mnt_regridedges3d_setSrcLocatorType(RegridEdges3d_t** self, const char* fort_name, int n) {
+    // Fortran strings don't come with null-termination character
+    std::string name(fort_name, n);
+    if (!LocatorFactory::isValid(name)) {
+        std::cerr << "mnt_regridedges3d_setSrcLocatorType: ERROR unknown locator \"" << name
+                  << "\", valid names are " << LocatorFactory::getNames() << '\n';
+        return 1;
+    }
+    (*self)->srcLocType = name;
+    return 0;
+}
+
+extern "C"
+int mnt_regridedges3d_setSrcLocatorCacheFile(RegridEdges3d_t** self, const char* fort_filename, int n) {
+    // Fortran strings don't come with null-termination character
+    (*self)->srcLocCacheFile = std::string(fort_filename, n);
+    return 0;
+}
+
 extern "C"
 int mnt_regridedges3d_build(RegridEdges3d_t** self, int numCellsPerBucket) {
 
@@ -100,9 +172,21 @@ int mnt_regridedges3d_build(RegridEdges3d_t** self, int numCellsPerBucket) {
     }
 
     // build the locator
-    (*self)->srcLoc->SetDataSet((*self)->srcGrid);
-    (*self)->srcLoc->SetNumberOfCellsPerBucket(numCellsPerBucket);
-    (*self)->srcLoc->BuildLocator(); 
+    if ((*self)->srcLoc) {
+        (*self)->srcLoc->Delete();
+    }
+    std::string locType = (*self)->srcLocType;
+    if (locType.empty()) {
+        locType = LocatorFactory::getDefaultName((*self)->srcGrid, !(*self)->srcLocCacheFile.empty());
+    }
+    (*self)->srcLoc = LocatorFactory::createCached(locType, (*self)->srcGrid,
+                                                   numCellsPerBucket, (*self)->srcLocCacheFile,
+                                                   (*self)->numThreads);
+    if (!(*self)->srcLoc) {
+        std::cerr << "mnt_regridedges3d_build: ERROR locator \"" << locType
+                  << "\" does not support the source grid\n";
+        return 3;
+    }
 
     // compute the weights
     vtkIdList* dstPtIds = vtkIdList::New();
@@ -123,6 +207,13 @@ int mnt_regridedges3d_build(RegridEdges3d_t** self, int numCellsPerBucket) {
     (*self)->numSrcCells = (*self)->srcGrid->GetNumberOfCells();
     (*self)->numDstCells = (*self)->dstGrid->GetNumberOfCells();
 
+    // locate each dst grid point once, the points are shared by several dst cell edges
+    PointLocationCache dstPointLocations(3);
+    dstPointLocations.build(dstPoints, (*self)->srcLoc, (*self)->numThreads);
+
+    // searches the src locator, its scratch space is reused for every dst edge
+    LocatorQuery srcLocQuery((*self)->srcLoc);
+
     // iterate over the dst grid cells
     for (vtkIdType dstCellId = 0; dstCellId < (*self)->numDstCells; ++dstCellId) {
 
@@ -144,8 +235,12 @@ int mnt_regridedges3d_build(RegridEdges3d_t** self, int numCellsPerBucket) {
 
             // break the edge into sub-edges
             PolysegmentIter3d polySegIter = PolysegmentIter3d((*self)->srcGrid, 
-                                                              (*self)->srcLoc,
-                                                              dstEdgePt0, dstEdgePt1);
+                                                              srcLocQuery,
+                                                              dstEdgePt0, dstEdgePt1,
+                                                              dstPointLocations.getCellId(id0),
+                                                              dstPointLocations.getParamCoords(id0),
+                                                              dstPointLocations.getCellId(id1),
+                                                              dstPointLocations.getParamCoords(id1));
 
             // number of sub-segments
             size_t numSegs = polySegIter.getNumberOfSegments();
@@ -238,6 +333,8 @@ int mnt_regridedges3d_build(RegridEdges3d_t** self, int numCellsPerBucket) {
     srcCellIds->Delete();
     dstPtIds->Delete();
 
+    __mnt_regridedges3d_flattenWeights(*self);
+
     return 0;
 }
 
@@ -263,26 +360,42 @@ int mnt_regridedges3d_getNumEdgesPerCell(RegridEdges3d_t** self, int* n) {
 extern "C"
 int mnt_regridedges3d_applyWeights(RegridEdges3d_t** self, const double src_data[], double dst_data[]) {
 
-    // initialize the data to zero
-    size_t numEdges = (*self)->numDstCells * (*self)->numEdgesPerCell;
-    for (size_t i = 0; i < numEdges; ++i) {
-        dst_data[i] = 0.0;
+    RegridEdges3d_t* rg = *self;
+    if (rg->dstCellPtr.size() == 0) {
+        __mnt_regridedges3d_flattenWeights(rg);
     }
 
-    for (std::map< std::pair<vtkIdType, vtkIdType>, std::vector<double> >::const_iterator 
-         it = (*self)->weights.begin(); it != (*self)->weights.end(); ++it) {
+    size_t numEdgesPerCell = rg->numEdgesPerCell;
+    size_t numRows = rg->dstCellPtr.size() - 1;
+    size_t numDstCells = std::max(rg->numDstCells, numRows);
+
+    // each dst cell is handled by a single thread, the result does not depend on the 
+    // number of threads
+    mntParallelFor(rg->numThreads, numDstCells, [&](int /*threadId*/, size_t dstCellBeg, size_t dstCellEnd) {
 
-        vtkIdType dstCellId = it->first.first;
-        vtkIdType srcCellId = it->first.second;
-        const std::vector<double>& weights = it->second;
+        std::vector<double> sums(numEdgesPerCell);
+        for (size_t dstCellId = dstCellBeg; dstCellId < dstCellEnd; ++dstCellId) {
 
-        size_t kd = dstCellId * (*self)->numEdgesPerCell;
-        size_t ks = srcCellId * (*self)->numEdgesPerCell;
+            for (size_t ie = 0; ie < numEdgesPerCell; ++ie) {
+                sums[ie] = 0.0;
+            }
 
-        for (size_t ie = 0; ie < (*self)->numEdgesPerCell; ++ie) {
-            dst_data[kd + ie] += weights[ie] * src_data[ks + ie];
+            if (dstCellId < numRows) {
+                for (size_t k = rg->dstCellPtr[dstCellId]; k < rg->dstCellPtr[dstCellId + 1]; ++k) {
+                    const double* weights = &rg->dstCellWeights[k*numEdgesPerCell];
+                    const double* src = &src_data[rg->dstCellSrcCellIds[k]*numEdgesPerCell];
+                    for (size_t ie = 0; ie < numEdgesPerCell; ++ie) {
+                        sums[ie] += weights[ie] * src[ie];
+                    }
+                }
+            }
+
+            double* dst = &dst_data[dstCellId*numEdgesPerCell];
+            for (size_t ie = 0; ie < numEdgesPerCell; ++ie) {
+                dst[ie] = sums[ie];
+            }
         }
-    }
+    });
 
     return 0;
 }
@@ -334,6 +447,8 @@ int mnt_regridedges3d_load(RegridEdges3d_t** self, const char* filename) {
         (*self)->weights.insert(kv);
     }
 
+    __mnt_regridedges3d_flattenWeights(*self);
+
     return 0;
 }
 
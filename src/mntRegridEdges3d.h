@@ -2,7 +2,7 @@
 #include <map>
 #include <string>
 #include <vtkUnstructuredGrid.h>
-#include <vtkCellLocator.h>
+#include <vtkAbstractCellLocator.h>
 #include <mntGrid.h>
 
 #ifndef MNT_REGRID_EDGES_3D
@@ -15,7 +15,7 @@
 struct RegridEdges3d_t {
     vtkUnstructuredGrid* srcGrid;
     vtkUnstructuredGrid* dstGrid;
-    vtkCellLocator* srcLoc;
+    vtkAbstractCellLocator* srcLoc;
     std::map< std::pair<vtkIdType, vtkIdType>, std::vector<double> > weights;
     size_t numSrcCells;
     size_t numDstCells;
@@ -23,6 +23,22 @@ struct RegridEdges3d_t {
     size_t numEdgesPerCell;
     Grid_t* srcGridObj;
     Grid_t* dstGridObj;
+
+    // the above weights, ordered by dst cell for fast application. The src cell Ids 
+    // and weights of dst cell dstCellId are stored in 
+    // [dstCellPtr[dstCellId], dstCellPtr[dstCellId + 1])
+    std::vector<size_t> dstCellPtr;
+    std::vector<vtkIdType> dstCellSrcCellIds;
+    std::vector<double> dstCellWeights; // numEdgesPerCell values per src cell
+
+    // number of threads used to apply the weights
+    int numThreads;
+
+    // name of the source grid locator, see LocatorFactory. Empty for the default
+    std::string srcLocType;
+
+    // file caching the source grid locator, empty if not cached
+    std::string srcLocCacheFile;
 };
 
 /**
@@ -80,6 +96,40 @@ int mnt_regridedges3d_setDstPointsPtr(RegridEdges3d_t** self,
                                     size_t nVertsPerCell, size_t ncells, 
                                     const double verts[]);
 
+/**
+ * Set the number of threads used to apply the weights
+ * @param numThreads number of threads (>= 1)
+ * @return error code (0 is OK)
+ * @note the result of applying the weights does not depend on the number of threads
+ */
+extern "C"
+int mnt_regridedges3d_setNumberOfThreads(RegridEdges3d_t** self, int numThreads);
+
+/**
+ * Set the type of source grid locator built by mnt_regridedges3d_build
+ * @param fort_name locator name: "auto", "vtk", "octree" or "bvh" (does not require
+ *                  termination character)
+ * @param n length of name string (excluding '\0' if present)
+ * @return error code (0 is OK)
+ * @note by default the locator is a vtkCellLocator ("vtk") unless a cache file is 
+ *       set, in which case it is an "octree" as the vtkCellLocator cannot be saved
+ */
+extern "C"
+int mnt_regridedges3d_setSrcLocatorType(RegridEdges3d_t** self, const char* fort_name, int n);
+
+/**
+ * Set the file caching the source grid locator. The locator is loaded from the file
+ * if it was saved for the same source grid and number of cells per bucket, otherwise
+ * it is built and saved
+ * @param fort_filename file name (does not require termination character)
+ * @param n length of filename string (excluding '\0' if present)
+ * @return error code (0 is OK)
+ * @note the "vtk" and "bvh" locators are not cached, see mnt_regridedges3d_setSrcLocatorType
+ *       for the default locator of a cached regridder
+ */
+extern "C"
+int mnt_regridedges3d_setSrcLocatorCacheFile(RegridEdges3d_t** self, const char* fort_filename, int n);
+
 /**
  * Build the regridder
  * @param numCellsPerBucket average number of cells per bucket
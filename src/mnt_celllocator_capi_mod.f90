@@ -56,6 +56,19 @@ module mnt_celllocator_capi_mod
       integer(c_int)                           :: mnt_celllocator_setpointsptr
     end function mnt_celllocator_setPointsPtr
 
+    function mnt_celllocator_setNumberOfThreads(obj, num_threads) &
+                                              & bind(C, name='mnt_celllocator_setNumberOfThreads')
+      ! Set the number of threads used by the batched queries
+      ! @param obj instance of mntcellLocator_t (opaque handle)
+      ! @param num_threads number of threads (>= 1)
+      ! @return 0 if successful
+      use, intrinsic :: iso_c_binding, only: c_int, c_ptr
+      implicit none
+      type(c_ptr), intent(inout)       :: obj ! void**
+      integer(c_int), value            :: num_threads
+      integer(c_int)                   :: mnt_celllocator_setNumberOfThreads
+    end function mnt_celllocator_setNumberOfThreads
+
     function mnt_celllocator_build(obj, num_cells_per_bucket) &
                                  & bind(C, name='mnt_celllocator_build')
       ! Build locator object
@@ -69,6 +82,70 @@ module mnt_celllocator_capi_mod
       integer(c_int)                   :: mnt_celllocator_build
     end function mnt_celllocator_build
 
+    function mnt_celllocator_saveLocator(obj, filename, n) &
+                                       & bind(C, name='mnt_celllocator_saveLocator')
+      ! Save the search structure of the built locator to a file
+      ! @param obj instance of mntcellLocator_t (opaque handle)
+      ! @param filename file name
+      ! @param n length of filename
+      ! @return 0 if successful
+      use, intrinsic :: iso_c_binding, only: c_size_t, c_int, c_ptr, c_char
+      implicit none
+      type(c_ptr), intent(inout)               :: obj ! void**
+      character(kind=c_char), intent(in)       :: filename(*)
+      integer(c_size_t), value                 :: n
+      integer(c_int)                           :: mnt_celllocator_saveLocator
+    end function mnt_celllocator_saveLocator
+
+    function mnt_celllocator_loadLocator(obj, filename, n) &
+                                       & bind(C, name='mnt_celllocator_loadLocator')
+      ! Load the search structure from a file saved for the same grid, instead of
+      ! building the locator
+      ! @param obj instance of mntcellLocator_t (opaque handle)
+      ! @param filename file name
+      ! @param n length of filename
+      ! @return 0 if successful, non zero if the file does not match the grid
+      ! @note must set or load the grid prior to this call
+      use, intrinsic :: iso_c_binding, only: c_size_t, c_int, c_ptr, c_char
+      implicit none
+      type(c_ptr), intent(inout)               :: obj ! void**
+      character(kind=c_char), intent(in)       :: filename(*)
+      integer(c_size_t), value                 :: n
+      integer(c_int)                           :: mnt_celllocator_loadLocator
+    end function mnt_celllocator_loadLocator
+
+    function mnt_celllocator_setLocatorCacheFile(obj, filename, n) &
+                                               & bind(C, name='mnt_celllocator_setLocatorCacheFile')
+      ! Set the file caching the locator, the locator is loaded from the file by
+      ! mnt_celllocator_build if it matches the grid and is otherwise built and saved
+      ! @param obj instance of mntcellLocator_t (opaque handle)
+      ! @param filename file name
+      ! @param n length of filename
+      ! @return 0 if successful
+      use, intrinsic :: iso_c_binding, only: c_size_t, c_int, c_ptr, c_char
+      implicit none
+      type(c_ptr), intent(inout)               :: obj ! void**
+      character(kind=c_char), intent(in)       :: filename(*)
+      integer(c_size_t), value                 :: n
+      integer(c_int)                           :: mnt_celllocator_setLocatorCacheFile
+    end function mnt_celllocator_setLocatorCacheFile
+
+    function mnt_celllocator_setLocatorType(obj, name, n) &
+                                          & bind(C, name='mnt_celllocator_setLocatorType')
+      ! Set the type of locator built by mnt_celllocator_build, by default a vtkCellLocator
+      ! unless a cache file is set
+      ! @param obj instance of mntcellLocator_t (opaque handle)
+      ! @param name "auto", "vtk", "octree", "bins2d", "bvh" or "structured"
+      ! @param n length of name
+      ! @return 0 if successful
+      use, intrinsic :: iso_c_binding, only: c_size_t, c_int, c_ptr, c_char
+      implicit none
+      type(c_ptr), intent(inout)               :: obj ! void**
+      character(kind=c_char), intent(in)       :: name(*)
+      integer(c_size_t), value                 :: n
+      integer(c_int)                           :: mnt_celllocator_setLocatorType
+    end function mnt_celllocator_setLocatorType
+
     function mnt_celllocator_find(obj, point, cell_id, pcoords) &
                                 & bind(C, name='mnt_celllocator_find')
       ! Find point
@@ -86,6 +163,45 @@ module mnt_celllocator_capi_mod
       integer(c_int)                           :: mnt_celllocator_find
     end function mnt_celllocator_find
 
+    function mnt_celllocator_findWithHint(obj, point, hint_cell_id, cell_id, pcoords) &
+                                        & bind(C, name='mnt_celllocator_findWithHint')
+      ! Find point, starting from a nearby cell
+      ! @param obj instance of mntcellLocator_t (opaque handle)
+      ! @param point 3d point
+      ! @param hint_cell_id cell expected to contain or touch the point (zero-based, ignored if < 0)
+      ! @param cell_id output cell Id (zero-based)
+      ! @param output parametric coordinates
+      ! @return 0 if successful
+      use, intrinsic :: iso_c_binding, only: c_long_long, c_int, c_double, c_ptr
+      implicit none
+      type(c_ptr), intent(inout)               :: obj ! void**
+      real(c_double), intent(in)               :: point(3) ! const double*
+      integer(c_long_long), value              :: hint_cell_id
+      integer(c_long_long), intent(out)        :: cell_id
+      real(c_double), intent(out)              :: pcoords(3) ! double*
+      integer(c_int)                           :: mnt_celllocator_findwithhint
+    end function mnt_celllocator_findWithHint
+
+    function mnt_celllocator_findBatch(obj, npoints, points, cell_ids, pcoords) &
+                                     & bind(C, name='mnt_celllocator_findBatch')
+      ! Find the cells and the parametric coordinates of many points, using
+      ! the number of threads set by mnt_celllocator_setNumberOfThreads
+      ! @param obj instance of mntcellLocator_t (opaque handle)
+      ! @param npoints number of points
+      ! @param points target points, size 3*npoints
+      ! @param cell_ids cell Ids, < 0 if not found (output)
+      ! @param pcoords parametric coordinates, size 3*npoints (output)
+      ! @return 0 if successful
+      use, intrinsic :: iso_c_binding, only: c_size_t, c_long_long, c_int, c_double, c_ptr
+      implicit none
+      type(c_ptr), intent(inout)               :: obj ! void**
+      integer(c_size_t), value                 :: npoints
+      real(c_double), intent(in)               :: points(*) ! const double*
+      integer(c_long_long), intent(out)        :: cell_ids(*)
+      real(c_double), intent(out)              :: pcoords(*) ! double*
+      integer(c_int)                           :: mnt_celllocator_findbatch
+    end function mnt_celllocator_findBatch
+
     function mnt_celllocator_interpPoint(obj, cell_id, pcoords, point) &
                                       &  bind(C, name='mnt_celllocator_interpPoint')
       ! Interpolate point
@@ -104,6 +220,26 @@ module mnt_celllocator_capi_mod
       integer(c_int)                           :: mnt_celllocator_interppoint
     end function mnt_celllocator_interpPoint
 
+    function mnt_celllocator_interpPointBatch(obj, npoints, cell_ids, pcoords, points) &
+                                           & bind(C, name='mnt_celllocator_interpPointBatch')
+      ! Interpolate many positions, using the number of threads set by
+      ! mnt_celllocator_setNumberOfThreads
+      ! @param obj instance of mntcellLocator_t (opaque handle)
+      ! @param npoints number of points
+      ! @param cell_ids cell Ids
+      ! @param pcoords parametric coordinates, size 3*npoints
+      ! @param points interpolated points, size 3*npoints (output)
+      ! @return 0 if successful, 1 if some cell Ids are < 0
+      use, intrinsic :: iso_c_binding, only: c_size_t, c_long_long, c_int, c_double, c_ptr
+      implicit none
+      type(c_ptr), intent(inout)               :: obj ! void**
+      integer(c_size_t), value                 :: npoints
+      integer(c_long_long), intent(in)         :: cell_ids(*)
+      real(c_double), intent(in)               :: pcoords(*) ! const double*
+      real(c_double), intent(out)              :: points(*)  ! double*
+      integer(c_int)                           :: mnt_celllocator_interppointbatch
+    end function mnt_celllocator_interpPointBatch
+
     function mnt_celllocator_dumpGrid(obj, filename, n) & 
                                     & bind(C, name='mnt_celllocator_dumpGrid')
       ! Dump grid to VTK file
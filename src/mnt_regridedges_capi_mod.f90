@@ -56,6 +56,51 @@ module mnt_regridedges_capi_mod
       integer(c_int)                           :: mnt_regridedges_loadDstGrid
     end function mnt_regridedges_loadDstGrid
 
+    function mnt_regridedges_setNumberOfThreads(obj, num_threads) &
+                                                bind(C, name='mnt_regridedges_setNumberOfThreads')
+      ! Set the number of threads used to compute and apply the weights
+      ! @param obj instance of mntregridedges_t (opaque handle)
+      ! @param num_threads number of threads (>= 1)
+      ! @return 0 if successful
+      use, intrinsic :: iso_c_binding, only: c_int, c_ptr
+      implicit none
+      type(c_ptr), intent(inout)       :: obj ! void**
+      integer(c_int), value            :: num_threads
+      integer(c_int)                   :: mnt_regridedges_setNumberOfThreads
+    end function mnt_regridedges_setNumberOfThreads
+
+    function mnt_regridedges_setSrcLocatorCacheFile(obj, filename, n) &
+                                                    bind(C, name='mnt_regridedges_setSrcLocatorCacheFile')
+      ! Set the file caching the source grid locator, the locator is loaded from the
+      ! file if it matches the source grid and is otherwise built and saved
+      ! @param obj instance of mntregridedges_t (opaque handle)
+      ! @param filename file name
+      ! @param n length of filename
+      ! @return 0 if successful
+      use, intrinsic :: iso_c_binding, only: c_int, c_ptr, c_char
+      implicit none
+      type(c_ptr), intent(inout)               :: obj ! void**
+      character(kind=c_char), intent(in)       :: filename(*)
+      integer(c_int), value                    :: n
+      integer(c_int)                           :: mnt_regridedges_setSrcLocatorCacheFile
+    end function mnt_regridedges_setSrcLocatorCacheFile
+
+    function mnt_regridedges_setSrcLocatorType(obj, name, n) &
+                                               bind(C, name='mnt_regridedges_setSrcLocatorType')
+      ! Set the type of source grid locator built by mnt_regridedges_build, by default a
+      ! vtkCellLocator unless a cache file is set
+      ! @param obj instance of mntregridedges_t (opaque handle)
+      ! @param name "auto", "vtk", "octree", "bins2d", "bvh" or "structured"
+      ! @param n length of name
+      ! @return 0 if successful
+      use, intrinsic :: iso_c_binding, only: c_int, c_ptr, c_char
+      implicit none
+      type(c_ptr), intent(inout)               :: obj ! void**
+      character(kind=c_char), intent(in)       :: name(*)
+      integer(c_int), value                    :: n
+      integer(c_int)                           :: mnt_regridedges_setSrcLocatorType
+    end function mnt_regridedges_setSrcLocatorType
+
     function mnt_regridedges_build(obj, num_cells_per_bucket) &
                                    bind(C, name='mnt_regridedges_build')
       ! Build locator object
@@ -69,6 +114,17 @@ module mnt_regridedges_capi_mod
       integer(c_int)                   :: mnt_regridedges_build
     end function mnt_regridedges_build
 
+    function mnt_regridedges_finalize(obj) &
+                                      bind(C, name='mnt_regridedges_finalize')
+      ! Convert the weights into a compressed sparse row matrix, called by build and loadWeights
+      ! @param obj instance of mntregridedges_t (opaque handle)
+      ! @return 0 if successful
+      use, intrinsic :: iso_c_binding, only: c_int, c_ptr
+      implicit none
+      type(c_ptr), intent(inout)       :: obj ! void**
+      integer(c_int)                   :: mnt_regridedges_finalize
+    end function mnt_regridedges_finalize
+
     function mnt_regridedges_loadWeights(obj, filename, n) & 
                                          bind(C, name='mnt_regridedges_loadWeights')
       ! Load interpolation weights from NetCDF file
@@ -140,6 +196,46 @@ module mnt_regridedges_capi_mod
       integer(c_int)                           :: mnt_regridedges_applyUniqueEdge
     end	function mnt_regridedges_applyUniqueEdge
 
+    function mnt_regridedges_applyCellEdgeBatch(obj, nfields, field_fastest, src_data, dst_data) &
+                                                bind(C, name='mnt_regridedges_applyCellEdgeBatch')
+      ! Apply weights to a batch of cell by cell edge fields
+      ! @param obj instance of mntregridedges_t (opaque handle)
+      ! @param nfields number of fields (e.g. number of vertical levels)
+      ! @param field_fastest 1 if the data are dimensioned (nfields, 4*num_cells), 
+      !                      0 if the data are dimensioned (4*num_cells, nfields)
+      ! @param src_data edge fields defined cell by cell on the source grid (array of size nfields*4*num_src_cells)
+      ! @param dst_data edge fields defined cell by cell on the destination grid (array of size nfields*4*num_dst_cells)
+      ! @return 0 if successful
+      use, intrinsic :: iso_c_binding, only: c_int, c_double, c_ptr
+      implicit none
+      type(c_ptr), intent(inout)               :: obj ! void**
+      integer(c_int), value                    :: nfields
+      integer(c_int), value                    :: field_fastest
+      real(c_double), intent(in)               :: src_data(*)
+      real(c_double), intent(out)              :: dst_data(*)
+      integer(c_int)                           :: mnt_regridedges_applyCellEdgeBatch
+    end	function mnt_regridedges_applyCellEdgeBatch
+
+    function mnt_regridedges_applyUniqueEdgeBatch(obj, nfields, field_fastest, src_data, dst_data) &
+                                                  bind(C, name='mnt_regridedges_applyUniqueEdgeBatch')
+      ! Apply weights to a batch of unique cell Id edge fields
+      ! @param obj instance of mntregridedges_t (opaque handle)
+      ! @param nfields number of fields (e.g. number of vertical levels)
+      ! @param field_fastest 1 if the data are dimensioned (nfields, num_edges), 
+      !                      0 if the data are dimensioned (num_edges, nfields)
+      ! @param src_data source fields defined for each unique edge Id
+      ! @param dst_data destination fields defined for each for each unique edge Id
+      ! @return 0 if successful
+      use, intrinsic :: iso_c_binding, only: c_int, c_double, c_ptr
+      implicit none
+      type(c_ptr), intent(inout)               :: obj ! void**
+      integer(c_int), value                    :: nfields
+      integer(c_int), value                    :: field_fastest
+      real(c_double), intent(in)               :: src_data(*)
+      real(c_double), intent(out)              :: dst_data(*)
+      integer(c_int)                           :: mnt_regridedges_applyUniqueEdgeBatch
+    end	function mnt_regridedges_applyUniqueEdgeBatch
+
   end interface
 
 end module mnt_regridedges_capi_mod
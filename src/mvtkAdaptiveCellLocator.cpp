@@ -0,0 +1,428 @@
+#include "mvtkAdaptiveCellLocator.h"
+
+#include "vtkCellArray.h"
+#include "vtkDataSet.h"
+#include "vtkGenericCell.h"
+#include "vtkIdList.h"
+#include "vtkObjectFactory.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "mntQuadPosition.h"
+
+#include <algorithm>
+#include <cmath>
+
+vtkStandardNewMacro(mvtkAdaptiveCellLocator);
+
+// the traversal stacks hold at most one entry per level plus one
+#define MVTK_ADAPTIVE_MAX_LEVEL 62
+
+//----------------------------------------------------------------------------
+mvtkAdaptiveCellLocator::mvtkAdaptiveCellLocator()
+{
+  this->NumberOfCellsPerNode = 8;
+  this->MaxLevel = MVTK_ADAPTIVE_MAX_LEVEL;
+  this->Level = 0;
+}
+
+//----------------------------------------------------------------------------
+mvtkAdaptiveCellLocator::~mvtkAdaptiveCellLocator()
+{
+  this->FreeSearchStructure();
+}
+
+//----------------------------------------------------------------------------
+void mvtkAdaptiveCellLocator::FreeSearchStructure()
+{
+  std::vector<Node>().swap(this->Nodes);
+  std::vector<vtkIdType>().swap(this->SortedCellIds);
+  std::vector<double>().swap(this->CellBounds3d);
+  this->Level = 0;
+}
+
+//----------------------------------------------------------------------------
+//  Split the cells at the median of their centres along the direction of
+//  largest spread, until the nodes hold at most NumberOfCellsPerNode cells.
+//  The nodes are processed depth first from an explicit stack, the two
+//  children of a node are stored next to each other.
+//
+void mvtkAdaptiveCellLocator::BuildLocator()
+{
+  vtkIdType numCells;
+  if ( !this->DataSet || (numCells = this->DataSet->GetNumberOfCells()) < 1 )
+  {
+    vtkErrorMacro( << "No cells to subdivide");
+    return;
+  }
+
+  this->FreeSearchStructure();
+
+  // cell bounds and centres
+  std::vector<double> centres(3*numCells);
+  this->CellBounds3d.resize(6*numCells);
+  for (vtkIdType cellId = 0; cellId < numCells; cellId++)
+  {
+    double *cb = &this->CellBounds3d[6*cellId];
+    this->DataSet->GetCellBounds(cellId, cb);
+    for (int d = 0; d < 3; d++)
+    {
+      centres[3*cellId + d] = 0.5*(cb[2*d] + cb[2*d + 1]);
+    }
+  }
+
+  this->SortedCellIds.resize(numCells);
+  for (vtkIdType cellId = 0; cellId < numCells; cellId++)
+  {
+    this->SortedCellIds[cellId] = cellId;
+  }
+
+  int maxLevel = std::max(0, std::min(this->MaxLevel, MVTK_ADAPTIVE_MAX_LEVEL));
+  vtkIdType maxCellsPerLeaf = std::max(1, this->NumberOfCellsPerNode);
+  this->Nodes.reserve(2*(numCells/maxCellsPerLeaf) + 1);
+
+  Node root;
+  root.Begin = 0;
+  root.End = numCells;
+  root.Child = -1;
+  this->Nodes.push_back(root);
+
+  std::vector< std::pair<vtkIdType, int> > stack(1, std::make_pair(vtkIdType(0), 0));
+  while (!stack.empty())
+  {
+    vtkIdType nodeId = stack.back().first;
+    int level = stack.back().second;
+    stack.pop_back();
+    this->Level = std::max(this->Level, level);
+
+    // bounds of the cells and of their centres
+    vtkIdType *ids = &this->SortedCellIds[0];
+    vtkIdType beg = this->Nodes[nodeId].Begin;
+    vtkIdType end = this->Nodes[nodeId].End;
+    double bounds[6], centreBounds[6];
+    for (int d = 0; d < 3; d++)
+    {
+      bounds[2*d] = centreBounds[2*d] = VTK_DOUBLE_MAX;
+      bounds[2*d + 1] = centreBounds[2*d + 1] = -VTK_DOUBLE_MAX;
+    }
+    for (vtkIdType k = beg; k < end; k++)
+    {
+      const double *cb = &this->CellBounds3d[6*ids[k]];
+      const double *c = &centres[3*ids[k]];
+      for (int d = 0; d < 3; d++)
+      {
+        bounds[2*d] = std::min(bounds[2*d], cb[2*d]);
+        bounds[2*d + 1] = std::max(bounds[2*d + 1], cb[2*d + 1]);
+        centreBounds[2*d] = std::min(centreBounds[2*d], c[d]);
+        centreBounds[2*d + 1] = std::max(centreBounds[2*d + 1], c[d]);
+      }
+    }
+    std::copy(bounds, bounds + 6, this->Nodes[nodeId].Bounds);
+
+    int axis = 0;
+    for (int d = 1; d < 3; d++)
+    {
+      if (centreBounds[2*d + 1] - centreBounds[2*d] >
+          centreBounds[2*axis + 1] - centreBounds[2*axis])
+      {
+        axis = d;
+      }
+    }
+
+    if (end - beg <= maxCellsPerLeaf || level >= maxLevel ||
+        centreBounds[2*axis + 1] == centreBounds[2*axis])
+    {
+      // leaf, the cells are tested in increasing id order
+      std::sort(ids + beg, ids + end);
+      continue;
+    }
+
+    // median split, ties broken by cell id so the tree does not depend on
+    // the implementation of nth_element
+    vtkIdType mid = beg + (end - beg)/2;
+    std::nth_element(ids + beg, ids + mid, ids + end,
+      [&centres, axis](vtkIdType a, vtkIdType b) {
+        double ca = centres[3*a + axis];
+        double cb = centres[3*b + axis];
+        return ca < cb || (ca == cb && a < b);
+      });
+
+    vtkIdType child = static_cast<vtkIdType>(this->Nodes.size());
+    this->Nodes[nodeId].Child = child;
+    Node node;
+    node.Child = -1;
+    node.Begin = beg;
+    node.End = mid;
+    this->Nodes.push_back(node);
+    node.Begin = mid;
+    node.End = end;
+    this->Nodes.push_back(node);
+    stack.push_back(std::make_pair(child + 1, level + 1));
+    stack.push_back(std::make_pair(child, level + 1));
+  }
+
+  this->BuildTime.Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkIdType mvtkAdaptiveCellLocator::GetMaxNumberOfCellsInLeaf()
+{
+  vtkIdType res = 0;
+  for (size_t i = 0; i < this->Nodes.size(); i++)
+  {
+    if (this->Nodes[i].Child < 0)
+    {
+      res = std::max(res, this->Nodes[i].End - this->Nodes[i].Begin);
+    }
+  }
+  return res;
+}
+
+//----------------------------------------------------------------------------
+// Whether the segment p1 + t*dir, 0 <= t <= 1, intersects the box expanded
+// by tolerance (slab test)
+int mvtkAdaptiveCellLocator::SegmentHitsBox(const double p1[3], const double dir[3],
+                                            const double bounds[6], double tolerance)
+{
+  double ta = 0.0;
+  double tb = 1.0;
+  for (int d = 0; d < 3; d++)
+  {
+    double lo = bounds[2*d] - tolerance;
+    double hi = bounds[2*d + 1] + tolerance;
+    if (dir[d] == 0.0)
+    {
+      if (p1[d] < lo || p1[d] > hi)
+      {
+        return 0;
+      }
+      continue;
+    }
+    double t0 = (lo - p1[d]) / dir[d];
+    double t1 = (hi - p1[d]) / dir[d];
+    ta = std::max(ta, std::min(t0, t1));
+    tb = std::min(tb, std::max(t0, t1));
+    if (ta > tb)
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType mvtkAdaptiveCellLocator::FindCell(
+  double x[3], double vtkNotUsed(tol2), vtkGenericCell *cell,
+  double pcoords[3], double *weights)
+{
+  if (this->Nodes.empty())
+  {
+    return -1;
+  }
+
+  vtkIdType best = -1;
+  vtkIdType lastEvaluated = -1;
+  vtkIdType stack[MVTK_ADAPTIVE_MAX_LEVEL + 2];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0)
+  {
+    const Node &node = this->Nodes[stack[--top]];
+    const double *nb = node.Bounds;
+    if (x[0] < nb[0] || x[0] > nb[1] || x[1] < nb[2] || x[1] > nb[3] ||
+        x[2] < nb[4] || x[2] > nb[5])
+    {
+      continue;
+    }
+    if (node.Child >= 0)
+    {
+      stack[top++] = node.Child + 1;
+      stack[top++] = node.Child;
+      continue;
+    }
+
+    // only cells with a lower id than the best so far can improve on it
+    for (vtkIdType k = node.Begin; k < node.End; k++)
+    {
+      vtkIdType cellId = this->SortedCellIds[k];
+      if (best >= 0 && cellId >= best)
+      {
+        break;
+      }
+      const double *cb = &this->CellBounds3d[6*cellId];
+      if (x[0] < cb[0] || x[0] > cb[1] || x[1] < cb[2] || x[1] > cb[3] ||
+          x[2] < cb[4] || x[2] > cb[5])
+      {
+        continue;
+      }
+      this->DataSet->GetCell(cellId, cell);
+      lastEvaluated = cellId;
+      if (mntCellEvaluatePosition(cell, x, pcoords, weights) == 1)
+      {
+        best = cellId;
+        break;
+      }
+    }
+  }
+
+  if (best >= 0 && lastEvaluated != best)
+  {
+    // pcoords and weights were overwritten by a later candidate
+    this->DataSet->GetCell(best, cell);
+    mntCellEvaluatePosition(cell, x, pcoords, weights);
+  }
+  return best;
+}
+
+//----------------------------------------------------------------------------
+void mvtkAdaptiveCellLocator::FindCellsWithinBounds(double *bbox, vtkIdList *cells)
+{
+  cells->Reset();
+  if (this->Nodes.empty())
+  {
+    return;
+  }
+
+  std::vector<vtkIdType> found;
+  vtkIdType stack[MVTK_ADAPTIVE_MAX_LEVEL + 2];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0)
+  {
+    const Node &node = this->Nodes[stack[--top]];
+    const double *nb = node.Bounds;
+    if (nb[1] < bbox[0] || nb[0] > bbox[1] || nb[3] < bbox[2] || nb[2] > bbox[3] ||
+        nb[5] < bbox[4] || nb[4] > bbox[5])
+    {
+      continue;
+    }
+    if (node.Child >= 0)
+    {
+      stack[top++] = node.Child + 1;
+      stack[top++] = node.Child;
+      continue;
+    }
+    for (vtkIdType k = node.Begin; k < node.End; k++)
+    {
+      vtkIdType cellId = this->SortedCellIds[k];
+      const double *cb = &this->CellBounds3d[6*cellId];
+      if (cb[1] >= bbox[0] && cb[0] <= bbox[1] && cb[3] >= bbox[2] && cb[2] <= bbox[3] &&
+          cb[5] >= bbox[4] && cb[4] <= bbox[5])
+      {
+        found.push_back(cellId);
+      }
+    }
+  }
+
+  // each cell belongs to a single leaf, no duplicates
+  std::sort(found.begin(), found.end());
+  cells->SetNumberOfIds(static_cast<vtkIdType>(found.size()));
+  for (size_t k = 0; k < found.size(); k++)
+  {
+    cells->SetId(static_cast<vtkIdType>(k), found[k]);
+  }
+}
+
+//----------------------------------------------------------------------------
+void mvtkAdaptiveCellLocator::FindCellsAlongLine(double p1[3], double p2[3],
+                                                 double tolerance, vtkIdList *cells)
+{
+  cells->Reset();
+  if (this->Nodes.empty())
+  {
+    return;
+  }
+
+  double dir[] = {p2[0] - p1[0], p2[1] - p1[1], p2[2] - p1[2]};
+  std::vector<vtkIdType> found;
+  vtkIdType stack[MVTK_ADAPTIVE_MAX_LEVEL + 2];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0)
+  {
+    const Node &node = this->Nodes[stack[--top]];
+    if (!mvtkAdaptiveCellLocator::SegmentHitsBox(p1, dir, node.Bounds, tolerance))
+    {
+      continue;
+    }
+    if (node.Child >= 0)
+    {
+      stack[top++] = node.Child + 1;
+      stack[top++] = node.Child;
+      continue;
+    }
+    for (vtkIdType k = node.Begin; k < node.End; k++)
+    {
+      vtkIdType cellId = this->SortedCellIds[k];
+      if (mvtkAdaptiveCellLocator::SegmentHitsBox(p1, dir, &this->CellBounds3d[6*cellId],
+                                                  tolerance))
+      {
+        found.push_back(cellId);
+      }
+    }
+  }
+
+  std::sort(found.begin(), found.end());
+  cells->SetNumberOfIds(static_cast<vtkIdType>(found.size()));
+  for (size_t k = 0; k < found.size(); k++)
+  {
+    cells->SetId(static_cast<vtkIdType>(k), found[k]);
+  }
+}
+
+//----------------------------------------------------------------------------
+// Outline of the nodes at a given level, and of the shallower leaves. All
+// the leaves if level is negative.
+void mvtkAdaptiveCellLocator::GenerateRepresentation(int level, vtkPolyData *pd)
+{
+  // vertex indices of the 6 faces of a box, bit 0/1/2 selects max x/y/z
+  const int faces[6][4] = {{0, 2, 6, 4}, {1, 5, 7, 3}, {0, 4, 5, 1},
+                           {2, 3, 7, 6}, {0, 1, 3, 2}, {4, 6, 7, 5}};
+
+  vtkPoints *pts = vtkPoints::New();
+  vtkCellArray *polys = vtkCellArray::New();
+  std::vector< std::pair<vtkIdType, int> > stack;
+  if (!this->Nodes.empty())
+  {
+    stack.push_back(std::make_pair(vtkIdType(0), 0));
+  }
+  while (!stack.empty())
+  {
+    const Node &node = this->Nodes[stack.back().first];
+    int nodeLevel = stack.back().second;
+    stack.pop_back();
+    if (node.Child >= 0 && (level < 0 || nodeLevel < level))
+    {
+      stack.push_back(std::make_pair(node.Child + 1, nodeLevel + 1));
+      stack.push_back(std::make_pair(node.Child, nodeLevel + 1));
+      continue;
+    }
+    vtkIdType corners[8];
+    for (int c = 0; c < 8; c++)
+    {
+      corners[c] = pts->InsertNextPoint(node.Bounds[(c & 1) ? 1 : 0],
+                                        node.Bounds[(c & 2) ? 3 : 2],
+                                        node.Bounds[(c & 4) ? 5 : 4]);
+    }
+    for (int f = 0; f < 6; f++)
+    {
+      vtkIdType ptIds[4];
+      for (int v = 0; v < 4; v++)
+      {
+        ptIds[v] = corners[faces[f][v]];
+      }
+      polys->InsertNextCell(4, ptIds);
+    }
+  }
+  pd->SetPoints(pts);
+  pts->Delete();
+  pd->SetPolys(polys);
+  polys->Delete();
+}
+
+//----------------------------------------------------------------------------
+void mvtkAdaptiveCellLocator::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Number Of Nodes: " << this->Nodes.size() << "\n";
+}
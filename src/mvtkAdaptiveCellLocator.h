@@ -0,0 +1,122 @@
+/**
+ * @class   mvtkAdaptiveCellLocator
+ * @brief   adaptive-depth bounding volume hierarchy to locate cells
+ *
+ * mvtkAdaptiveCellLocator recursively splits the cells into two halves at
+ * the median of their centres, along the direction in which the centres are
+ * most spread out. The subdivision stops once a node holds no more than
+ * NumberOfCellsPerNode cells, or at MaxLevel (GetLevel() returns the depth
+ * of the deepest leaf after BuildLocator). Each cell belongs to a single
+ * leaf, and each node stores the bounding box of its cells. Unlike the
+ * uniform octree of mvtkCellLocator, the depth adapts to the local cell
+ * density, so that stretched or regionally refined grids (e.g. the polar
+ * caps of lat-lon grids or variable resolution cubed-spheres) do not end up
+ * with some buckets holding thousands of cells.
+ *
+ * The queries descend into the nodes whose bounding box overlaps the point,
+ * box or line. They do not modify the locator and can be issued concurrently.
+ *
+ * @sa
+ * mvtkCellLocator mvtkCellLocator2d vtkCellLocator
+*/
+
+#ifndef mvtkAdaptiveCellLocator_h
+#define mvtkAdaptiveCellLocator_h
+
+#include "vtkAbstractCellLocator.h"
+#include <vector>
+
+class vtkIdList;
+
+class mvtkAdaptiveCellLocator : public vtkAbstractCellLocator
+{
+public:
+  vtkTypeMacro(mvtkAdaptiveCellLocator,vtkAbstractCellLocator);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /**
+   * Construct with at most 8 cells per leaf.
+   */
+  static mvtkAdaptiveCellLocator *New();
+
+  /**
+   * Specify the maximum number of cells in a leaf (unless MaxLevel is
+   * reached first).
+   */
+  void SetNumberOfCellsPerBucket(int N)
+  { this->SetNumberOfCellsPerNode(N); }
+  int GetNumberOfCellsPerBucket()
+  { return this->NumberOfCellsPerNode; }
+
+  // Re-use any superclass signatures that we don't override.
+  using vtkAbstractCellLocator::FindCell;
+
+  /**
+   * Find the cell containing a given point, -1 if no cell is found. Among
+   * the cells whose bounds contain the point, the one with the lowest id
+   * that contains the point is returned, as with vtkCellLocator.
+   */
+  vtkIdType FindCell(
+    double x[3], double tol2, vtkGenericCell *GenCell,
+    double pcoords[3], double *weights) override;
+
+  /**
+   * Return the sorted list of unique cell ids whose bounds overlap a given
+   * bounding box.
+   */
+  void FindCellsWithinBounds(double *bbox, vtkIdList *cells) override;
+
+  /**
+   * Return the sorted list of unique cell ids whose bounds, expanded by
+   * tolerance, intersect the segment (p1, p2).
+   */
+  void FindCellsAlongLine(double p1[3], double p2[3],
+                          double tolerance, vtkIdList *cells) override;
+
+  /**
+   * Get the number of nodes of the hierarchy, leaves included.
+   */
+  vtkIdType GetNumberOfNodes()
+  { return static_cast<vtkIdType>(this->Nodes.size()); }
+
+  /**
+   * Get the largest number of cells in a leaf.
+   */
+  vtkIdType GetMaxNumberOfCellsInLeaf();
+
+  //@{
+  /**
+   * Satisfy vtkLocator abstract interface.
+   */
+  void FreeSearchStructure() override;
+  void BuildLocator() override;
+  void GenerateRepresentation(int level, vtkPolyData *pd) override;
+  //@}
+
+protected:
+  mvtkAdaptiveCellLocator();
+  ~mvtkAdaptiveCellLocator() override;
+
+  // a node covers the cells SortedCellIds[Begin...End), its children are
+  // Child and Child + 1 (Child < 0 for leaves)
+  struct Node
+  {
+    double Bounds[6];
+    vtkIdType Begin;
+    vtkIdType End;
+    vtkIdType Child;
+  };
+
+  static int SegmentHitsBox(const double p1[3], const double dir[3],
+                            const double bounds[6], double tolerance);
+
+  std::vector<Node> Nodes; // root first
+  std::vector<vtkIdType> SortedCellIds; // cell ids grouped by leaf, increasing in each leaf
+  std::vector<double> CellBounds3d; // xmin, xmax, ymin, ymax, zmin, zmax of each cell
+
+private:
+  mvtkAdaptiveCellLocator(const mvtkAdaptiveCellLocator&) = delete;
+  void operator=(const mvtkAdaptiveCellLocator&) = delete;
+};
+
+#endif
@@ -21,14 +21,21 @@
 #include "vtkObjectFactory.h"
 #include "vtkPolyData.h"
 #include "vtkBox.h"
+#include "mntParallel.h"
+#include "mntQuadPosition.h"
+#include "mntLocatorFile.h"
 
 #include <cmath>
+#include <algorithm>
 
 vtkStandardNewMacro(mvtkCellLocator);
 
 #define VTK_CELL_OUTSIDE 0
 #define VTK_CELL_INSIDE 1
 
+// number of cell bounds tested at once by FindCell, before any cell is evaluated
+#define MVTK_CELL_LOCATOR_BATCH_SIZE 8
+
 typedef vtkIdList *vtkIdListPtr;
 
 //----------------------------------------------------------------------------
@@ -57,6 +64,35 @@ inline int vtkNeighborCells::InsertNextPoint(int *x)
   return id/3;
 }
 
+//----------------------------------------------------------------------------
+mvtkCellLocatorQuery::mvtkCellLocatorQuery()
+{
+  this->Cell = vtkGenericCell::New();
+  this->QueryNumber = 0;
+}
+
+//----------------------------------------------------------------------------
+mvtkCellLocatorQuery::~mvtkCellLocatorQuery()
+{
+  this->Cell->Delete();
+}
+
+//----------------------------------------------------------------------------
+void mvtkCellLocatorQuery::Begin(vtkIdType numCells)
+{
+  if (this->Visited.size() != static_cast<size_t>(numCells))
+  {
+    this->Visited.assign(numCells, 0);
+    this->QueryNumber = 0;
+  }
+  this->QueryNumber++;
+  if (this->QueryNumber == 0)
+  {
+    std::fill(this->Visited.begin(), this->Visited.end(), 0);
+    this->QueryNumber++;    // can't use 0 as a marker
+  }
+}
+
 //----------------------------------------------------------------------------
 // Construct with automatic computation of divisions, averaging
 // 25 cells per bucket.
@@ -66,8 +102,15 @@ mvtkCellLocator::mvtkCellLocator()
   this->Level                = 8;
   this->NumberOfCellsPerNode = 25;
   this->Tree                 = nullptr;
+  this->UseFlatStorage       = 1;
+  this->NumberOfThreads      = 1;
+  this->FlatCellIds          = nullptr;
+  this->FlatOffsets          = nullptr;
+  this->FlatBucket           = nullptr;
+  this->FlatBounds           = nullptr;
   this->CellHasBeenVisited   = nullptr;
   this->QueryNumber          = 0;
+  this->Query                = new mvtkCellLocatorQuery;
   this->NumberOfDivisions    = 1;
   this->H[0] = this->H[1] = this->H[2] = 1.0;
 
@@ -87,11 +130,20 @@ mvtkCellLocator::~mvtkCellLocator()
   delete this->Buckets;
   this->Buckets = nullptr;
 
+  delete this->Query;
+  this->Query = nullptr;
+
   this->FreeSearchStructure();
   this->FreeCellBounds();
 
   delete [] this->CellHasBeenVisited;
   this->CellHasBeenVisited = nullptr;
+
+  if (this->FlatBucket)
+  {
+    this->FlatBucket->Delete();
+    this->FlatBucket = nullptr;
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -117,6 +169,13 @@ void mvtkCellLocator::FreeSearchStructure()
     delete [] this->Tree;
     this->Tree = nullptr;
   }
+
+  delete [] this->FlatCellIds;
+  this->FlatCellIds = nullptr;
+  delete [] this->FlatOffsets;
+  this->FlatOffsets = nullptr;
+  delete [] this->FlatBounds;
+  this->FlatBounds = nullptr;
 }
 
 //----------------------------------------------------------------------------
@@ -167,6 +226,8 @@ int mvtkCellLocator::IntersectWithLine(double a0[3], double a1[3], double tol,
   double bounds2[6];
   int i, leafStart, prod, loop;
   vtkIdType bestCellId = -1, cId;
+  const vtkIdType *cellIds;
+  vtkIdType numCellIds;
   int idx;
   double tMax, dist[3];
   int npos[3];
@@ -254,13 +315,13 @@ int mvtkCellLocator::IntersectWithLine(double a0[3], double a1[3], double tol,
       (pos[2] <= this->NumberOfDivisions) &&
       (currDist < stopDist))
     {
-      if (this->Tree[idx])
+      if ((numCellIds = this->GetLeafCells(idx, &cellIds)) > 0)
       {
         this->ComputeOctantBounds(pos[0]-1,pos[1]-1,pos[2]-1);
         for (tMax = VTK_DOUBLE_MAX, cellId=0;
-        cellId < this->Tree[idx]->GetNumberOfIds(); cellId++)
+        cellId < numCellIds; cellId++)
         {
-          cId = this->Tree[idx]->GetId(cellId);
+          cId = cellIds[cellId];
           if (this->CellHasBeenVisited[cId] != this->QueryNumber)
           {
             this->CellHasBeenVisited[cId] = this->QueryNumber;
@@ -401,7 +462,8 @@ void mvtkCellLocator::FindClosestPoint(double x[3], double closestPoint[3],
   double pcoords[3], point[3], cachedPoint[3], weightsArray[6];
   double *weights = weightsArray;
   int nWeights = 6, nPoints;
-  vtkIdList *cellIds;
+  const vtkIdType *cellIds;
+  vtkIdType numCellIds;
   int stat;
   //int minStat=0; //save this variable it is used for debugging
 
@@ -459,9 +521,8 @@ void mvtkCellLocator::FindClosestPoint(double x[3], double closestPoint[3],
       nei = this->Buckets->GetPoint(i);
 
       // if a neighboring bucket has cells,
-      if ( (cellIds =
-        this->Tree[leafStart + nei[0] + nei[1]*this->NumberOfDivisions +
-          nei[2]*this->NumberOfDivisions*this->NumberOfDivisions]) != nullptr )
+      if ( (numCellIds = this->GetLeafCells(leafStart + nei[0] + nei[1]*this->NumberOfDivisions +
+          nei[2]*this->NumberOfDivisions*this->NumberOfDivisions, &cellIds)) > 0 )
       {
         // do we still need to test this bucket?
         distance2ToBucket = this->Distance2ToBucket(x, nei);
@@ -469,10 +530,10 @@ void mvtkCellLocator::FindClosestPoint(double x[3], double closestPoint[3],
         if (distance2ToBucket < refinedRadius2)
         {
           // still a viable bucket
-          for (j=0; j < cellIds->GetNumberOfIds(); j++)
+          for (j=0; j < numCellIds; j++)
           {
             // get the cell
-            cellId = cellIds->GetId(j);
+            cellId = cellIds[j];
             if (this->CellHasBeenVisited[cellId] != this->QueryNumber)
             {
               this->CellHasBeenVisited[cellId] = this->QueryNumber;
@@ -569,9 +630,8 @@ void mvtkCellLocator::FindClosestPoint(double x[3], double closestPoint[3],
     {
       nei = this->Buckets->GetPoint(i);
 
-      if ( (cellIds =
-          this->Tree[leafStart + nei[0] + nei[1]*this->NumberOfDivisions +
-            nei[2]*this->NumberOfDivisions*this->NumberOfDivisions]) != nullptr )
+      if ( (numCellIds = this->GetLeafCells(leafStart + nei[0] + nei[1]*this->NumberOfDivisions +
+            nei[2]*this->NumberOfDivisions*this->NumberOfDivisions, &cellIds)) > 0 )
       {
         // do we still need to test this bucket?
         distance2ToBucket = this->Distance2ToBucket(x, nei);
@@ -579,10 +639,10 @@ void mvtkCellLocator::FindClosestPoint(double x[3], double closestPoint[3],
         if (distance2ToBucket < refinedRadius2)
         {
           // still a viable bucket
-          for (j=0; j < cellIds->GetNumberOfIds(); j++)
+          for (j=0; j < numCellIds; j++)
           {
             // get the cell
-            cellId = cellIds->GetId(j);
+            cellId = cellIds[j];
             if (this->CellHasBeenVisited[cellId] != this->QueryNumber)
             {
               this->CellHasBeenVisited[cellId] = this->QueryNumber;
@@ -673,7 +733,8 @@ vtkIdType mvtkCellLocator::FindClosestPointWithinRadius(double x[3], double radi
   double *weights = weightsArray;
   int nWeights = 6, nPoints;
   int returnVal = 0;
-  vtkIdList *cellIds;
+  const vtkIdType *cellIds;
+  vtkIdType numCellIds;
 
   double distance2ToBucket;
   double distance2ToCellBounds, cellBounds[6], currentRadius;
@@ -725,15 +786,14 @@ vtkIdType mvtkCellLocator::FindClosestPointWithinRadius(double x[3], double radi
 
   // Start by searching the bucket that the point is in.
   //
-  if ((cellIds =
-      this->Tree[leafStart + ijk[0] + ijk[1]*this->NumberOfDivisions +
-      ijk[2]*this->NumberOfDivisions*this->NumberOfDivisions]) != nullptr )
+  if ((numCellIds = this->GetLeafCells(leafStart + ijk[0] + ijk[1]*this->NumberOfDivisions +
+      ijk[2]*this->NumberOfDivisions*this->NumberOfDivisions, &cellIds)) > 0 )
   {
     // query each cell
-    for (j=0; j < cellIds->GetNumberOfIds(); j++)
+    for (j=0; j < numCellIds; j++)
     {
       // get the cell
-      cellId = cellIds->GetId(j);
+      cellId = cellIds[j];
       if (this->CellHasBeenVisited[cellId] != this->QueryNumber)
       {
         this->CellHasBeenVisited[cellId] = this->QueryNumber;
@@ -852,9 +912,8 @@ vtkIdType mvtkCellLocator::FindClosestPointWithinRadius(double x[3], double radi
     {
       nei = this->Buckets->GetPoint(i);
 
-      if ( (cellIds =
-        this->Tree[leafStart + nei[0] + nei[1]*this->NumberOfDivisions +
-          nei[2]*numberOfBucketsPerPlane]) != nullptr )
+      if ( (numCellIds = this->GetLeafCells(leafStart + nei[0] + nei[1]*this->NumberOfDivisions +
+          nei[2]*numberOfBucketsPerPlane, &cellIds)) > 0 )
       {
         // do we still need to test this bucket?
         distance2ToBucket = this->Distance2ToBucket(x, nei);
@@ -862,10 +921,10 @@ vtkIdType mvtkCellLocator::FindClosestPointWithinRadius(double x[3], double radi
         if (distance2ToBucket < refinedRadius2)
         {
           // still a viable bucket
-          for (j=0; j < cellIds->GetNumberOfIds(); j++)
+          for (j=0; j < numCellIds; j++)
           {
             // get the cell
-            cellId = cellIds->GetId(j);
+            cellId = cellIds[j];
             if (this->CellHasBeenVisited[cellId] != this->QueryNumber)
             {
               this->CellHasBeenVisited[cellId] = this->QueryNumber;
@@ -1150,8 +1209,32 @@ int mvtkCellLocator::GetNumberOfBuckets(void)
 // Get the cells in a bucket.
 vtkIdList* mvtkCellLocator::GetCells(int octantId)
 {
-  // handle parents ?
-  return this->Tree[octantId];
+  int leafStart = this->NumberOfOctants
+    - this->NumberOfDivisions*this->NumberOfDivisions*this->NumberOfDivisions;
+
+  if (!this->FlatOffsets || octantId < leafStart)
+  {
+    // handle parents ?
+    return this->Tree[octantId];
+  }
+
+  // copy the leaf octant's span, the list is reused by the next call
+  const vtkIdType *cellIds;
+  vtkIdType numCellIds = this->GetLeafCells(octantId, &cellIds);
+  if (numCellIds == 0)
+  {
+    return nullptr;
+  }
+  if (!this->FlatBucket)
+  {
+    this->FlatBucket = vtkIdList::New();
+  }
+  this->FlatBucket->SetNumberOfIds(numCellIds);
+  for (vtkIdType i=0; i < numCellIds; i++)
+  {
+    this->FlatBucket->SetId(i, cellIds[i]);
+  }
+  return this->FlatBucket;
 }
 
 //---------------------------------------------------------------------------
@@ -1265,11 +1348,6 @@ void mvtkCellLocator::BuildLocatorInternal()
   this->ClearCellHasBeenVisited();
   this->QueryNumber = 0;
 
-  if (this->CacheCellBounds)
-  {
-    this->StoreCellBounds();
-  }
-
   //  Compute width of leaf octant in three directions
   //
   for (i=0; i<3; i++)
@@ -1278,6 +1356,18 @@ void mvtkCellLocator::BuildLocatorInternal()
     hTol[i] = this->H[i]/100.0;
   }
 
+  if (this->UseFlatStorage)
+  {
+    this->BuildFlatStorage(numCells, hTol);
+    this->BuildTime.Modified();
+    return;
+  }
+
+  if (this->CacheCellBounds)
+  {
+    this->StoreCellBounds();
+  }
+
   //  Insert each cell into the appropriate octant.  Make sure cell
   //  falls within octant.
   //
@@ -1340,6 +1430,378 @@ void mvtkCellLocator::BuildLocatorInternal()
   this->BuildTime.Modified();
 }
 
+//----------------------------------------------------------------------------
+//  Fill the flat leaf storage. The cells are split into NumberOfThreads
+//  contiguous chunks. Each thread computes the bounds and octant range of
+//  its cells and counts them per leaf octant; a prefix sum over (leaf
+//  octant, chunk) turns the counts into offsets; each thread then writes its
+//  cells into its own part of each leaf octant's span. The cell ids of a
+//  leaf octant thus end up in increasing order, as with the serial build.
+//
+void mvtkCellLocator::BuildFlatStorage(vtkIdType numCells, double hTol[3])
+{
+  int ndivs = this->NumberOfDivisions;
+  vtkIdType product = static_cast<vtkIdType>(ndivs) * ndivs;
+  vtkIdType numLeaves = product * ndivs;
+  int i;
+
+  int numThreads = (this->NumberOfThreads > 1 ? this->NumberOfThreads : 1);
+  if (numThreads > numCells)
+  {
+    numThreads = static_cast<int>(numCells);
+  }
+  int numLeafThreads = numThreads;
+  if (numLeafThreads > numLeaves)
+  {
+    numLeafThreads = static_cast<int>(numLeaves);
+  }
+
+  if (this->CacheCellBounds)
+  {
+    this->CellBounds = new double[numCells][6];
+  }
+
+  // octant range of each cell, ijkMin followed by ijkMax
+  int *cellRanges = new int [6*numCells];
+
+  // number of cells of each chunk in each leaf octant, later the position
+  // at which the chunk writes its next cell
+  vtkIdType *chunkCounts = new vtkIdType [numThreads*numLeaves];
+  memset (chunkCounts, 0, numThreads*numLeaves*sizeof(vtkIdType));
+
+  mntParallelFor(numThreads, numCells,
+                 [this, ndivs, product, numLeaves, hTol, cellRanges, chunkCounts]
+                 (int threadId, size_t beg, size_t end)
+  {
+    double cellBounds[6], *boundsPtr = cellBounds;
+    vtkIdType *counts = chunkCounts + threadId*numLeaves;
+    for (vtkIdType cellId = beg; cellId < static_cast<vtkIdType>(end); cellId++)
+    {
+      if (this->CellBounds)
+      {
+        boundsPtr = this->CellBounds[cellId];
+      }
+      this->DataSet->GetCellBounds(cellId, boundsPtr);
+
+      // find min/max locations of bounding box
+      int *ijkMin = cellRanges + 6*cellId;
+      int *ijkMax = ijkMin + 3;
+      for (int ii=0; ii<3; ii++)
+      {
+        ijkMin[ii] = static_cast<int>(
+          (boundsPtr[2*ii] - this->Bounds[2*ii] - hTol[ii])/ this->H[ii]);
+        ijkMax[ii] = static_cast<int>(
+          (boundsPtr[2*ii+1] - this->Bounds[2*ii] + hTol[ii]) / this->H[ii]);
+
+        if (ijkMin[ii] < 0)
+        {
+          ijkMin[ii] = 0;
+        }
+        if (ijkMax[ii] >= ndivs)
+        {
+          ijkMax[ii] = ndivs-1;
+        }
+      }
+
+      for (int kk = ijkMin[2]; kk <= ijkMax[2]; kk++)
+      {
+        for (int jj = ijkMin[1]; jj <= ijkMax[1]; jj++)
+        {
+          for (int ii = ijkMin[0]; ii <= ijkMax[0]; ii++)
+          {
+            counts[ii + jj*ndivs + kk*product]++;
+          }
+        }
+      }
+    }
+  });
+
+  //  Prefix sum: total number of cells of each range of leaf octants, then
+  //  the offsets within each range.
+  //
+  vtkIdType *rangeOffsets = new vtkIdType [numLeafThreads + 1];
+  rangeOffsets[0] = 0;
+  mntParallelFor(numLeafThreads, numLeaves,
+                 [numThreads, numLeaves, chunkCounts, rangeOffsets]
+                 (int threadId, size_t beg, size_t end)
+  {
+    vtkIdType sum = 0;
+    for (size_t l = beg; l < end; l++)
+    {
+      for (int t = 0; t < numThreads; t++)
+      {
+        sum += chunkCounts[t*numLeaves + l];
+      }
+    }
+    rangeOffsets[threadId + 1] = sum;
+  });
+  for (i=0; i<numLeafThreads; i++)
+  {
+    rangeOffsets[i + 1] += rangeOffsets[i];
+  }
+
+  this->FlatOffsets = new vtkIdType [numLeaves + 1];
+  vtkIdType *offsets = this->FlatOffsets;
+  mntParallelFor(numLeafThreads, numLeaves,
+                 [numThreads, numLeaves, chunkCounts, rangeOffsets, offsets]
+                 (int threadId, size_t beg, size_t end)
+  {
+    vtkIdType offset = rangeOffsets[threadId];
+    for (size_t l = beg; l < end; l++)
+    {
+      offsets[l] = offset;
+      for (int t = 0; t < numThreads; t++)
+      {
+        vtkIdType count = chunkCounts[t*numLeaves + l];
+        chunkCounts[t*numLeaves + l] = offset;
+        offset += count;
+      }
+    }
+  });
+  offsets[numLeaves] = rangeOffsets[numLeafThreads];
+  delete [] rangeOffsets;
+
+  //  Fill pass
+  //
+  this->FlatCellIds = new vtkIdType [offsets[numLeaves]];
+  vtkIdType *flatCellIds = this->FlatCellIds;
+  mntParallelFor(numThreads, numCells,
+                 [ndivs, product, numLeaves, cellRanges, chunkCounts, flatCellIds]
+                 (int threadId, size_t beg, size_t end)
+  {
+    vtkIdType *next = chunkCounts + threadId*numLeaves;
+    for (vtkIdType cellId = beg; cellId < static_cast<vtkIdType>(end); cellId++)
+    {
+      const int *range = cellRanges + 6*cellId;
+      for (int kk = range[2]; kk <= range[5]; kk++)
+      {
+        for (int jj = range[1]; jj <= range[4]; jj++)
+        {
+          for (int ii = range[0]; ii <= range[3]; ii++)
+          {
+            flatCellIds[next[ii + jj*ndivs + kk*product]++] = cellId;
+          }
+        }
+      }
+    }
+  });
+
+  delete [] chunkCounts;
+  delete [] cellRanges;
+
+  //  Copy the cached bounds in leaf order, so that FindCell scans them
+  //  contiguously
+  //
+  if (this->CellBounds)
+  {
+    vtkIdType numEntries = offsets[numLeaves];
+    this->FlatBounds = new double [6*numEntries];
+    double *flatBounds = this->FlatBounds;
+    double (*cellBounds)[6] = this->CellBounds;
+    mntParallelFor(numThreads, numEntries,
+                   [numEntries, flatCellIds, flatBounds, cellBounds]
+                   (int vtkNotUsed(threadId), size_t beg, size_t end)
+    {
+      for (size_t n = beg; n < end; n++)
+      {
+        const double *b = cellBounds[flatCellIds[n]];
+        for (int d = 0; d < 6; d++)
+        {
+          flatBounds[d*numEntries + n] = b[d];
+        }
+      }
+    });
+  }
+
+  this->MarkNonEmptyLeaves();
+}
+
+//----------------------------------------------------------------------------
+//  Mark the non-empty leaf octants of the flat storage and their parents
+//
+void mvtkCellLocator::MarkNonEmptyLeaves()
+{
+  int ndivs = this->NumberOfDivisions;
+  vtkIdType product = static_cast<vtkIdType>(ndivs) * ndivs;
+  vtkIdType numLeaves = product * ndivs;
+  vtkIdType leafStart = this->NumberOfOctants - numLeaves;
+  const vtkIdType *offsets = this->FlatOffsets;
+  vtkIdType leaf;
+  int i, j, k;
+
+  for (leaf=0; leaf<numLeaves; leaf++)
+  {
+    if (offsets[leaf + 1] > offsets[leaf])
+    {
+      i = static_cast<int>(leaf % ndivs);
+      j = static_cast<int>((leaf / ndivs) % ndivs);
+      k = static_cast<int>(leaf / product);
+      this->Tree[leafStart + leaf] = static_cast<vtkIdList *>(
+        reinterpret_cast<void*>(VTK_CELL_INSIDE));
+      this->MarkParents(reinterpret_cast<void*>(VTK_CELL_INSIDE),i,j,k,
+                        ndivs,this->Level);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+int mvtkCellLocator::WriteLocator(const char *filename)
+{
+  if ( !this->DataSet || !this->FlatOffsets )
+  {
+    vtkErrorMacro( << "Locator must be built with flat storage");
+    return 0;
+  }
+
+  vtkIdType numLeaves = static_cast<vtkIdType>(this->NumberOfDivisions) *
+    this->NumberOfDivisions * this->NumberOfDivisions;
+  vtkIdType numEntries = this->FlatOffsets[numLeaves];
+  std::vector<double> geometry(this->Bounds, this->Bounds + 6);
+  geometry.insert(geometry.end(), this->H, this->H + 3);
+  std::vector<int> divs = {this->Level, this->NumberOfDivisions,
+                           this->NumberOfOctants, this->FlatBounds ? 1 : 0};
+
+  LocatorFile file;
+  if (file.openForWriting(filename, "mvtkCellLocator", this->DataSet,
+                          this->NumberOfCellsPerNode) != 0 ||
+      file.write(geometry) != 0 || file.write(divs) != 0 ||
+      file.write(this->FlatOffsets, numLeaves + 1) != 0 ||
+      file.write(this->FlatCellIds, numEntries) != 0 ||
+      (this->FlatBounds && file.write(this->FlatBounds, 6*numEntries) != 0) ||
+      file.close() != 0)
+  {
+    vtkErrorMacro( << "Cannot write " << filename);
+    return 0;
+  }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int mvtkCellLocator::ReadLocator(const char *filename)
+{
+  vtkIdType numCells;
+  if ( !this->DataSet || (numCells = this->DataSet->GetNumberOfCells()) < 1 )
+  {
+    vtkErrorMacro( << "No data set");
+    return 0;
+  }
+  if ( !this->UseFlatStorage )
+  {
+    vtkErrorMacro( << "Reading requires flat storage");
+    return 0;
+  }
+
+  this->FreeSearchStructure();
+  delete [] this->CellHasBeenVisited;
+  this->CellHasBeenVisited = nullptr;
+  this->FreeCellBounds();
+
+  std::vector<double> geometry;
+  std::vector<int> divs;
+  LocatorFile file;
+  if (file.openForReading(filename, "mvtkCellLocator", this->DataSet,
+                          this->NumberOfCellsPerNode) != 0 ||
+      file.read(geometry) != 0 || file.read(divs) != 0 ||
+      geometry.size() != 9 || divs.size() != 4 ||
+      divs[0] < 0 || divs[0] > 10 || divs[1] != (1 << divs[0]) ||
+      (this->CacheCellBounds && !divs[3]))
+  {
+    // not a locator file of this grid, or without the cell bounds
+    return 0;
+  }
+
+  int ndivs = divs[1];
+  int numOctants = 1;
+  for (int i=0, prod=1; i<divs[0]; i++)
+  {
+    prod *= 8;
+    numOctants += prod;
+  }
+  vtkIdType numLeaves = static_cast<vtkIdType>(ndivs) * ndivs * ndivs;
+  if (divs[2] != numOctants)
+  {
+    return 0;
+  }
+
+  // the offsets give the number of cell Ids, which are read in place
+  this->FlatOffsets = new vtkIdType [numLeaves + 1];
+  if (file.read(this->FlatOffsets, numLeaves + 1) != 0 ||
+      this->FlatOffsets[numLeaves] < 0)
+  {
+    this->FreeSearchStructure();
+    return 0;
+  }
+  vtkIdType numEntries = this->FlatOffsets[numLeaves];
+  this->FlatCellIds = new vtkIdType [numEntries];
+  if (file.read(this->FlatCellIds, numEntries) != 0 ||
+      !LocatorFile::checkBuckets(this->FlatOffsets, this->FlatCellIds,
+                                 numEntries, numLeaves, numCells))
+  {
+    this->FreeSearchStructure();
+    return 0;
+  }
+
+  // the bounds are not kept if the locator does not cache them
+  if (this->CacheCellBounds)
+  {
+    this->FlatBounds = new double [6*numEntries];
+    if (file.read(this->FlatBounds, 6*numEntries) != 0)
+    {
+      this->FreeSearchStructure();
+      return 0;
+    }
+  }
+
+  for (int i=0; i<3; i++)
+  {
+    this->Bounds[2*i] = geometry[2*i];
+    this->Bounds[2*i+1] = geometry[2*i+1];
+    this->H[i] = geometry[6 + i];
+  }
+  this->Level = divs[0];
+  this->NumberOfDivisions = ndivs;
+  this->NumberOfOctants = numOctants;
+
+  this->Tree = new vtkIdListPtr[numOctants];
+  memset (this->Tree, 0, numOctants*sizeof(vtkIdListPtr));
+  this->MarkNonEmptyLeaves();
+
+  this->CellHasBeenVisited = new unsigned char [ numCells ];
+  this->ClearCellHasBeenVisited();
+  this->QueryNumber = 0;
+
+  //  Recover the cached bounds of each cell from its first entry. Cells
+  //  outside of all the leaf octants cannot occur but are handled anyway.
+  //
+  if (this->CacheCellBounds)
+  {
+    this->CellBounds = new double[numCells][6];
+    std::vector<unsigned char> hasBounds(numCells, 0);
+    for (vtkIdType n=0; n<numEntries; n++)
+    {
+      vtkIdType cellId = this->FlatCellIds[n];
+      if (!hasBounds[cellId])
+      {
+        for (int d=0; d<6; d++)
+        {
+          this->CellBounds[cellId][d] = this->FlatBounds[d*numEntries + n];
+        }
+        hasBounds[cellId] = 1;
+      }
+    }
+    for (vtkIdType cellId=0; cellId<numCells; cellId++)
+    {
+      if (!hasBounds[cellId])
+      {
+        this->DataSet->GetCellBounds(cellId, this->CellBounds[cellId]);
+      }
+    }
+  }
+
+  this->BuildTime.Modified();
+  return 1;
+}
+
 //----------------------------------------------------------------------------
 void mvtkCellLocator::MarkParents(void* a, int i, int j, int k,
                                  int ndivs, int level)
@@ -1664,13 +2126,33 @@ vtkIdType mvtkCellLocator::FindCell(
   double x[3], double vtkNotUsed(tol2), vtkGenericCell *cell,
   double pcoords[3], double *weights)
 {
-  vtkIdList *cellIds;
+  this->BuildLocatorIfNeeded();
+
+  return this->FindCellInLeaf(x, cell, pcoords, weights);
+}
+
+//----------------------------------------------------------------------------
+vtkIdType mvtkCellLocator::FindCell(
+  double x[3], double vtkNotUsed(tol2), mvtkCellLocatorQuery *query,
+  double pcoords[3], double *weights) const
+{
+  return this->FindCellInLeaf(x, query->GetCell(), pcoords, weights);
+}
+
+//----------------------------------------------------------------------------
+// Search the leaf octant the point is in. Only reads the locator.
+vtkIdType mvtkCellLocator::FindCellInLeaf(
+  double x[3], vtkGenericCell *cell, double pcoords[3], double *weights) const
+{
+  const vtkIdType *cellIds;
+  vtkIdType numCellIds;
   int ijk[3];
-  int subId;
-  double dist2;
   double cellBounds[6];
 
-  this->BuildLocatorIfNeeded();
+  if (this->NumberOfOctants == 0)
+  {
+    return -1;
+  }
 
   int leafStart = this->NumberOfOctants
     - this->NumberOfDivisions*this->NumberOfDivisions*this->NumberOfDivisions;
@@ -1691,25 +2173,68 @@ vtkIdType mvtkCellLocator::FindCell(
     }
   }
 
-  // Search the bucket that the point is in.
+  // Search the bucket that the point is in. With the flat bounds, the
+  // bounds of a batch of cells are tested in a branch free loop that the
+  // compiler can vectorize, and only the cells whose bounds contain the
+  // point are evaluated, in the bucket order.
   //
-  if ((cellIds =
-      this->Tree[leafStart + ijk[0] + ijk[1]*this->NumberOfDivisions +
-      ijk[2]*this->NumberOfDivisions*this->NumberOfDivisions]) != nullptr )
+  if (this->FlatBounds)
+  {
+    vtkIdType leaf = ijk[0] + ijk[1]*this->NumberOfDivisions +
+      ijk[2]*this->NumberOfDivisions*this->NumberOfDivisions;
+    vtkIdType numEntries = this->FlatOffsets[this->NumberOfOctants - leafStart];
+    const double *xmin = this->FlatBounds;
+    const double *xmax = xmin + numEntries;
+    const double *ymin = xmax + numEntries;
+    const double *ymax = ymin + numEntries;
+    const double *zmin = ymax + numEntries;
+    const double *zmax = zmin + numEntries;
+    const double x0 = x[0], x1 = x[1], x2 = x[2];
+    unsigned char inside[MVTK_CELL_LOCATOR_BATCH_SIZE];
+    vtkIdType end = this->FlatOffsets[leaf + 1];
+    for (vtkIdType beg = this->FlatOffsets[leaf]; beg < end;
+         beg += MVTK_CELL_LOCATOR_BATCH_SIZE)
+    {
+      int n = static_cast<int>(std::min(static_cast<vtkIdType>(MVTK_CELL_LOCATOR_BATCH_SIZE),
+                                        end - beg));
+      for (int l = 0; l < n; l++)
+      {
+        inside[l] = !(x0 < xmin[beg + l]) & !(x0 > xmax[beg + l]) &
+                    !(x1 < ymin[beg + l]) & !(x1 > ymax[beg + l]) &
+                    !(x2 < zmin[beg + l]) & !(x2 > zmax[beg + l]);
+      }
+      for (int l = 0; l < n; l++)
+      {
+        if (inside[l])
+        {
+          vtkIdType cellId = this->FlatCellIds[beg + l];
+          this->DataSet->GetCell(cellId, cell);
+          if (mntCellEvaluatePosition(cell, x, pcoords, weights)==1)
+          {
+            return cellId;
+          }
+        }
+      }
+    }
+    return -1;
+  }
+
+  if ((numCellIds = this->GetLeafCells(leafStart + ijk[0] + ijk[1]*this->NumberOfDivisions +
+      ijk[2]*this->NumberOfDivisions*this->NumberOfDivisions, &cellIds)) > 0 )
   {
     // query each cell
-    for (int j=0; j < cellIds->GetNumberOfIds(); j++)
+    for (int j=0; j < numCellIds; j++)
     {
       // get the cell
-      int cellId = cellIds->GetId(j);
+      vtkIdType cellId = cellIds[j];
       // check whether we could be close enough to the cell by
       // testing the cell bounds
       if (this->CacheCellBounds)
       {
-        if (this->InsideCellBounds(x, cellId))
+        if (mvtkCellLocator_Inside(this->CellBounds[cellId], x))
         {
           this->DataSet->GetCell(cellId, cell);
-          if (cell->EvaluatePosition(x, nullptr, subId, pcoords, dist2, weights)==1)
+          if (mntCellEvaluatePosition(cell, x, pcoords, weights)==1)
           {
             return cellId;
           }
@@ -1721,7 +2246,7 @@ vtkIdType mvtkCellLocator::FindCell(
         if (mvtkCellLocator_Inside(cellBounds, x))
         {
           this->DataSet->GetCell(cellId, cell);
-          if (cell->EvaluatePosition(x, nullptr, subId, pcoords, dist2, weights)==1)
+          if (mntCellEvaluatePosition(cell, x, pcoords, weights)==1)
           {
             return cellId;
           }
@@ -1738,8 +2263,20 @@ void mvtkCellLocator::FindCellsWithinBounds(double *bbox, vtkIdList *cells)
 {
   this->BuildLocatorIfNeeded();
 
+  this->FindCellsWithinBounds(bbox, cells, this->Query);
+}
+
+//----------------------------------------------------------------------------
+void mvtkCellLocator::FindCellsWithinBounds(double *bbox, vtkIdList *cells,
+                                            mvtkCellLocatorQuery *query) const
+{
   cells->Reset();
 
+  if (this->NumberOfOctants == 0)
+  {
+    return;
+  }
+
   // Get the locator locations for the two extreme corners of the bounding box
   double p1[3], p2[3], *p[2];
   p1[0] = bbox[0];
@@ -1772,10 +2309,15 @@ void mvtkCellLocator::FindCellsWithinBounds(double *bbox, vtkIdList *cells)
     }
   }
 
+  // the visited marks replace the linear search of InsertUniqueId, the ids
+  // are returned in the same order
+  query->Begin(this->DataSet->GetNumberOfCells());
+
   // Now loop over block to load in ids
   int leafStart = this->NumberOfOctants
     - this->NumberOfDivisions*this->NumberOfDivisions*this->NumberOfDivisions;
-  vtkIdList *cellIds;
+  const vtkIdType *cellIds;
+  vtkIdType numCellIds;
   vtkIdType idx;
   for (k=ijk[0][2]; k <= ijk[1][2]; k++)
   {
@@ -1783,12 +2325,15 @@ void mvtkCellLocator::FindCellsWithinBounds(double *bbox, vtkIdList *cells)
     {
       for (i=ijk[0][0]; i <= ijk[1][0]; i++)
       {
-        if ( (cellIds = this->Tree[leafStart + i + j*this->NumberOfDivisions +
-                                  k*this->NumberOfDivisions*this->NumberOfDivisions]) != nullptr )
+        if ( (numCellIds = this->GetLeafCells(leafStart + i + j*this->NumberOfDivisions +
+                                  k*this->NumberOfDivisions*this->NumberOfDivisions, &cellIds)) > 0 )
         {
-          for ( idx=0; idx < cellIds->GetNumberOfIds(); idx++)
+          for ( idx=0; idx < numCellIds; idx++)
           {
-            cells->InsertUniqueId( cellIds->GetId(idx) );
+            if (query->Visit(cellIds[idx]))
+            {
+              cells->InsertNextId( cellIds[idx] );
+            }
           }
         }
       }
@@ -1797,13 +2342,25 @@ void mvtkCellLocator::FindCellsWithinBounds(double *bbox, vtkIdList *cells)
 }
 
 //----------------------------------------------------------------------------
-void mvtkCellLocator::FindCellsAlongLine(double p1[3], double p2[3], double vtkNotUsed(tol),
+void mvtkCellLocator::FindCellsAlongLine(double p1[3], double p2[3], double tol,
                                         vtkIdList *cells)
 {
   this->BuildLocatorIfNeeded();
 
+  this->FindCellsAlongLine(p1, p2, tol, cells, this->Query);
+}
+
+//----------------------------------------------------------------------------
+void mvtkCellLocator::FindCellsAlongLine(double p1[3], double p2[3], double vtkNotUsed(tol),
+                                        vtkIdList *cells, mvtkCellLocatorQuery *query) const
+{
   cells->Reset();
 
+  if (this->NumberOfOctants == 0)
+  {
+    return;
+  }
+
   double origin[3];
   double direction1[3];
   double direction2[3];
@@ -1815,6 +2372,8 @@ void mvtkCellLocator::FindCellsAlongLine(double p1[3], double p2[3], double vtkN
   double bounds2[6];
   int i, leafStart, prod, loop;
   vtkIdType cellId, cId;
+  const vtkIdType *cellIds;
+  vtkIdType numCellIds;
   int idx;
   double tMax, dist[3];
   int npos[3];
@@ -1841,7 +2400,6 @@ void mvtkCellLocator::FindCellsAlongLine(double p1[3], double p2[3], double vtkN
     tMax += direction2[i]*direction2[i];
   }
   tMax = sqrt(tMax);
-  std::cerr << "*** tMax = " << tMax << " direction2 = " << direction2[0] << ',' << direction2[1] << ',' << direction2[2] << '\n';
 
   // create a parametric range around the tolerance
   stopDist = tMax*this->NumberOfDivisions;
@@ -1850,28 +2408,14 @@ void mvtkCellLocator::FindCellsAlongLine(double p1[3], double p2[3], double vtkN
     direction3[i] = direction2[i]/tMax;
   }
 
-  std::cerr << "--- bounds2 = "; for (size_t i = 0; i < 6; ++i) std::cerr << bounds2[i] << ','; 
-  cerr << " origin "; for (size_t i = 0; i < 3; ++i) std::cerr << origin[i] << ',';
-  cerr << " direction2 "; for (size_t i = 0; i < 3; ++i) std::cerr << direction2[i] << ',';
-  cerr << " hitPosition "; for (size_t i = 0; i < 3; ++i) std::cerr << hitPosition[i] << ',';
-  std::cerr << '\n';
-
   if (vtkBox::IntersectBox(bounds2, origin, direction2, hitPosition, result))
   {
-  	std::cerr << "*** there is an intersection\n";
     // start walking through the octants
     prod = this->NumberOfDivisions*this->NumberOfDivisions;
     leafStart = this->NumberOfOctants - this->NumberOfDivisions*prod;
 
-    // Clear the array that indicates whether we have visited this cell.
-    // The array is only cleared when the query number rolls over.  This
-    // saves a number of calls to memset.
-    this->QueryNumber++;
-    if (this->QueryNumber == 0)
-    {
-      this->ClearCellHasBeenVisited();
-      this->QueryNumber++;    // can't use 0 as a marker
-    }
+    // Start a new query on the caller's visited marks.
+    query->Begin(this->DataSet->GetNumberOfCells());
 
     // set up curr and stop dist
     currDist = 0;
@@ -1896,7 +2440,6 @@ void mvtkCellLocator::FindCellsAlongLine(double p1[3], double p2[3], double vtkN
 
     idx = leafStart + pos[0] - 1 + (pos[1] - 1)*this->NumberOfDivisions
       + (pos[2] - 1)*prod;
-    std::cerr << "*** leafStart = " << leafStart << " num div = " << this->NumberOfDivisions << " idx = " << idx << " prod = " << prod << " pos = " << pos[0] << ',' << pos[1] << '\n';
 
     while ( (pos[0] > 0) && (pos[1] > 0) && (pos[2] > 0) &&
       (pos[0] <= this->NumberOfDivisions) &&
@@ -1904,17 +2447,13 @@ void mvtkCellLocator::FindCellsAlongLine(double p1[3], double p2[3], double vtkN
       (pos[2] <= this->NumberOfDivisions) &&
       (currDist < stopDist))
     {
-      if (this->Tree[idx])
+      if ((numCellIds = this->GetLeafCells(idx, &cellIds)) > 0)
       {
-        this->ComputeOctantBounds(pos[0]-1,pos[1]-1,pos[2]-1);
-        for (cellId=0; cellId < this->Tree[idx]->GetNumberOfIds(); cellId++)
+        for (cellId=0; cellId < numCellIds; cellId++)
         {
-          cId = this->Tree[idx]->GetId(cellId);
-          std::cerr << "+++ idx = " << idx << " cId = " << cId << '\n';
-          if (this->CellHasBeenVisited[cId] != this->QueryNumber)
+          cId = cellIds[cellId];
+          if (query->Visit(cId))
           {
-            this->CellHasBeenVisited[cId] = this->QueryNumber;
-
             // check whether we intersect the cell bounds
             if (this->CacheCellBounds)
             {
@@ -1932,9 +2471,10 @@ void mvtkCellLocator::FindCellsAlongLine(double p1[3], double p2[3], double vtkN
 
             if (hitCellBounds)
             {
-              cells->InsertUniqueId(cId);
+              // each cell is visited once, no need for InsertUniqueId
+              cells->InsertNextId(cId);
             } // if (hitCellBounds)
-          } // if (!this->CellHasBeenVisited[cId])
+          } // if (query->Visit(cId))
         }
       }
 
@@ -1996,9 +2536,11 @@ void mvtkCellLocator::FindCellsAlongLine(double p1[3], double p2[3], double vtkN
   }
 }
 
-
 //----------------------------------------------------------------------------
 void mvtkCellLocator::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Use Flat Storage: " << this->UseFlatStorage << "\n";
+  os << indent << "Number Of Threads: " << this->NumberOfThreads << "\n";
 }
@@ -40,8 +40,62 @@
 
 #include "vtkCommonDataModelModule.h" // For export macro
 #include "vtkAbstractCellLocator.h"
+#include "vtkIdList.h" // For GetLeafCells
+#include <vector> // For mvtkCellLocatorQuery
 
 class vtkNeighborCells;
+class vtkGenericCell;
+
+/**
+ * @class   mvtkCellLocatorQuery
+ * @brief   per-query scratch space of mvtkCellLocator
+ *
+ * mvtkCellLocatorQuery holds the state that a search modifies: the marks of
+ * the cells already visited and a generic cell. It is owned by the caller and
+ * passed to the const queries of mvtkCellLocator, so that one built locator
+ * can be searched from several threads at once, each thread with its own
+ * mvtkCellLocatorQuery.
+ */
+class VTKCOMMONDATAMODEL_EXPORT mvtkCellLocatorQuery
+{
+public:
+  mvtkCellLocatorQuery();
+  ~mvtkCellLocatorQuery();
+
+  /**
+   * Get the generic cell used to evaluate the positions.
+   */
+  vtkGenericCell *GetCell()
+  { return this->Cell; }
+
+  /**
+   * Start a new query over a data set of numCells cells. The visited marks
+   * are only cleared when the query number rolls over.
+   */
+  void Begin(vtkIdType numCells);
+
+  /**
+   * Mark a cell as visited, return 1 if it was not visited before during
+   * the current query and 0 otherwise.
+   */
+  int Visit(vtkIdType cellId)
+  {
+    if (this->Visited[cellId] == this->QueryNumber)
+    {
+      return 0;
+    }
+    this->Visited[cellId] = this->QueryNumber;
+    return 1;
+  }
+
+private:
+  vtkGenericCell *Cell;
+  std::vector<unsigned int> Visited; // query number of the last visit of each cell
+  unsigned int QueryNumber;
+
+  mvtkCellLocatorQuery(const mvtkCellLocatorQuery&) = delete;
+  void operator=(const mvtkCellLocatorQuery&) = delete;
+};
 
 class VTKCOMMONDATAMODEL_EXPORT mvtkCellLocator : public vtkAbstractCellLocator
 {
@@ -63,6 +117,48 @@ public:
   int GetNumberOfCellsPerBucket()
   { return this->NumberOfCellsPerNode; }
 
+  //@{
+  /**
+   * Store the cell ids of all the leaf octants in one contiguous array with
+   * per-octant offsets (compressed sparse row format) rather than in one
+   * vtkIdList per octant. The array is sized with a counting pass over the
+   * cells before being filled. On by default.
+   */
+  void SetUseFlatStorage(int flag)
+  {
+    if (this->UseFlatStorage != flag)
+    {
+      this->UseFlatStorage = flag;
+      this->Modified();
+    }
+  }
+  int GetUseFlatStorage()
+  { return this->UseFlatStorage; }
+  void UseFlatStorageOn()
+  { this->SetUseFlatStorage(1); }
+  void UseFlatStorageOff()
+  { this->SetUseFlatStorage(0); }
+  //@}
+
+  //@{
+  /**
+   * Set the number of threads used to build the flat storage. The result
+   * does not depend on the number of threads. The data set's GetCellBounds
+   * must be thread safe, as is the case for vtkUnstructuredGrid. Defaults
+   * to 1.
+   */
+  void SetNumberOfThreads(int numThreads)
+  {
+    if (this->NumberOfThreads != numThreads)
+    {
+      this->NumberOfThreads = numThreads;
+      this->Modified();
+    }
+  }
+  int GetNumberOfThreads()
+  { return this->NumberOfThreads; }
+  //@}
+
   // Re-use any superclass signatures that we don't override.
   using vtkAbstractCellLocator::IntersectWithLine;
   using vtkAbstractCellLocator::FindCell;
@@ -154,6 +250,37 @@ public:
   void FindCellsAlongLine(double p1[3], double p2[3],
                           double tolerance, vtkIdList *cells) override;
 
+  //@{
+  /**
+   * Thread safe versions of FindCell, FindCellsWithinBounds and
+   * FindCellsAlongLine. All the scratch space lives in the caller's query
+   * object (FindCell evaluates the positions with query->GetCell()), so
+   * several threads can search the same locator concurrently provided each
+   * has its own mvtkCellLocatorQuery. The locator must have been built
+   * beforehand, as these methods do not rebuild it.
+   */
+  vtkIdType FindCell(
+    double x[3], double tol2, mvtkCellLocatorQuery *query,
+    double pcoords[3], double *weights) const;
+  void FindCellsWithinBounds(double *bbox, vtkIdList *cells,
+                             mvtkCellLocatorQuery *query) const;
+  void FindCellsAlongLine(double p1[3], double p2[3], double tolerance,
+                          vtkIdList *cells, mvtkCellLocatorQuery *query) const;
+  //@}
+
+  //@{
+  /**
+   * Write the search structure of the built locator to a file, or read it
+   * back instead of building the locator. Only the flat storage is saved,
+   * with the cached cell bounds if any. ReadLocator requires the data set to
+   * be set and fails if the file was written for another grid, for another
+   * number of cells per bucket (see LocatorFile) or, when CacheCellBounds is
+   * on, without the cell bounds. Return 1 on success and 0 otherwise.
+   */
+  int WriteLocator(const char *filename);
+  int ReadLocator(const char *filename);
+  //@}
+
   //@{
   /**
    * Satisfy vtkLocator abstract interface.
@@ -187,6 +314,46 @@ protected:
   int NumberOfDivisions; // number of "leaf" octant sub-divisions
   vtkIdList **Tree; // octree
 
+  int UseFlatStorage; // leaf cell ids in FlatCellIds rather than in Tree
+  vtkIdType *FlatCellIds; // cell ids of all the leaf octants, concatenated
+  vtkIdType *FlatOffsets; // offset of each leaf octant into FlatCellIds, if built flat
+  vtkIdList *FlatBucket; // returned by GetCells when UseFlatStorage is on
+  double *FlatBounds; // cached cell bounds in FlatCellIds order, stored as the six
+                      // arrays xmin, xmax, ymin, ymax, zmin and zmax
+  int NumberOfThreads; // number of threads building the flat storage
+
+  void BuildFlatStorage(vtkIdType numCells, double hTol[3]);
+  void MarkNonEmptyLeaves();
+
+  mvtkCellLocatorQuery *Query; // scratch space of the non thread safe queries
+
+  vtkIdType FindCellInLeaf(double x[3], vtkGenericCell *cell,
+                           double pcoords[3], double *weights) const;
+
+  /**
+   * Get the cells in an octant of the leaf layer
+   * @param idx index of the octant in the tree
+   * @param cellIds pointer to the cell ids (output)
+   * @return number of cells, zero if the octant is empty
+   */
+  vtkIdType GetLeafCells(vtkIdType idx, const vtkIdType **cellIds) const
+  {
+    if (this->FlatOffsets)
+    {
+      vtkIdType leaf = idx - (this->NumberOfOctants - this->NumberOfDivisions*
+        this->NumberOfDivisions*this->NumberOfDivisions);
+      *cellIds = this->FlatCellIds + this->FlatOffsets[leaf];
+      return this->FlatOffsets[leaf + 1] - this->FlatOffsets[leaf];
+    }
+    vtkIdList *octant = this->Tree[idx];
+    if (!octant)
+    {
+      return 0;
+    }
+    *cellIds = octant->GetPointer(0);
+    return octant->GetNumberOfIds();
+  }
+
   void MarkParents(void*, int, int, int, int, int);
   void GetChildren(int idx, int level, int children[8]);
   int GenerateIndex(int offset, int numDivs, int i, int j, int k,
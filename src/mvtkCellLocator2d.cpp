@@ -0,0 +1,507 @@
+#include "mvtkCellLocator2d.h"
+
+#include "vtkCellArray.h"
+#include "vtkDataSet.h"
+#include "vtkGenericCell.h"
+#include "vtkIdList.h"
+#include "vtkObjectFactory.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "mntLocatorFile.h"
+#include "mntQuadPosition.h"
+
+#include <algorithm>
+#include <cmath>
+
+vtkStandardNewMacro(mvtkCellLocator2d);
+
+//----------------------------------------------------------------------------
+mvtkCellLocator2d::mvtkCellLocator2d()
+{
+  this->NumberOfCellsPerNode = 25;
+  this->Origin[0] = this->Origin[1] = 0.0;
+  this->H[0] = this->H[1] = 1.0;
+  this->NumberOfDivisions[0] = this->NumberOfDivisions[1] = 0;
+}
+
+//----------------------------------------------------------------------------
+mvtkCellLocator2d::~mvtkCellLocator2d()
+{
+  this->FreeSearchStructure();
+}
+
+//----------------------------------------------------------------------------
+void mvtkCellLocator2d::FreeSearchStructure()
+{
+  std::vector<double>().swap(this->CellBounds2d);
+  std::vector<vtkIdType>().swap(this->BucketOffsets);
+  std::vector<vtkIdType>().swap(this->BucketCellIds);
+  this->NumberOfDivisions[0] = this->NumberOfDivisions[1] = 0;
+}
+
+//----------------------------------------------------------------------------
+int mvtkCellLocator2d::IsPlanarQuadGrid(vtkDataSet *grid)
+{
+  vtkIdType numCells = grid->GetNumberOfCells();
+  if (numCells < 1)
+  {
+    return 0;
+  }
+  for (vtkIdType cellId = 0; cellId < numCells; cellId++)
+  {
+    if (grid->GetCellType(cellId) != VTK_QUAD)
+    {
+      return 0;
+    }
+  }
+  const double *bounds = grid->GetBounds();
+  return (bounds[4] == bounds[5] ? 1 : 0);
+}
+
+//----------------------------------------------------------------------------
+// Index of the bucket containing coordinate x along direction dim, clamped
+// to the bucket array
+int mvtkCellLocator2d::GetBucketIndex(double x, int dim)
+{
+  double s = (x - this->Origin[dim]) / this->H[dim];
+  if (s < 0.0)
+  {
+    return 0;
+  }
+  int n = this->NumberOfDivisions[dim];
+  if (s >= static_cast<double>(n))
+  {
+    return n - 1;
+  }
+  return static_cast<int>(s);
+}
+
+//----------------------------------------------------------------------------
+//  Bin the cells into nx * ny buckets whose aspect ratio follows that of the
+//  grid, with NumberOfCellsPerNode cells per bucket on average. Each cell
+//  goes into all the buckets overlapping its bounds. The bucket sizes are
+//  counted first, then the cell ids are written in increasing order.
+//
+void mvtkCellLocator2d::BuildLocator()
+{
+  vtkIdType numCells;
+  if ( !this->DataSet || (numCells = this->DataSet->GetNumberOfCells()) < 1 )
+  {
+    vtkErrorMacro( << "No cells to subdivide");
+    return;
+  }
+
+  this->FreeSearchStructure();
+
+  // cell bounds
+  double bounds[6];
+  double xmin[] = {VTK_DOUBLE_MAX, VTK_DOUBLE_MAX};
+  double xmax[] = {-VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX};
+  this->CellBounds2d.resize(4*numCells);
+  for (vtkIdType cellId = 0; cellId < numCells; cellId++)
+  {
+    this->DataSet->GetCellBounds(cellId, bounds);
+    for (int d = 0; d < 2; d++)
+    {
+      this->CellBounds2d[4*cellId + 2*d] = bounds[2*d];
+      this->CellBounds2d[4*cellId + 2*d + 1] = bounds[2*d + 1];
+      xmin[d] = std::min(xmin[d], bounds[2*d]);
+      xmax[d] = std::max(xmax[d], bounds[2*d + 1]);
+    }
+  }
+
+  // number of buckets along each direction
+  double numBuckets = std::max(1.0,
+    static_cast<double>(numCells) / std::max(1, this->NumberOfCellsPerNode));
+  double lx = xmax[0] - xmin[0];
+  double ly = xmax[1] - xmin[1];
+  int nx = 1;
+  int ny = 1;
+  if (lx > 0.0 && ly > 0.0)
+  {
+    nx = std::max(1, static_cast<int>(std::round(std::sqrt(numBuckets*lx/ly))));
+    ny = std::max(1, static_cast<int>(std::round(numBuckets/nx)));
+  }
+  else if (lx > 0.0)
+  {
+    nx = std::max(1, static_cast<int>(std::round(numBuckets)));
+  }
+  else if (ly > 0.0)
+  {
+    ny = std::max(1, static_cast<int>(std::round(numBuckets)));
+  }
+  this->NumberOfDivisions[0] = nx;
+  this->NumberOfDivisions[1] = ny;
+  this->Origin[0] = xmin[0];
+  this->Origin[1] = xmin[1];
+  this->H[0] = (lx > 0.0 ? lx/nx : 1.0);
+  this->H[1] = (ly > 0.0 ? ly/ny : 1.0);
+
+  // count the cells of each bucket
+  this->BucketOffsets.assign(static_cast<size_t>(nx)*ny + 1, 0);
+  std::vector<int> cellRanges(4*numCells);
+  for (vtkIdType cellId = 0; cellId < numCells; cellId++)
+  {
+    const double *cb = &this->CellBounds2d[4*cellId];
+    int *range = &cellRanges[4*cellId];
+    range[0] = this->GetBucketIndex(cb[0], 0);
+    range[1] = this->GetBucketIndex(cb[1], 0);
+    range[2] = this->GetBucketIndex(cb[2], 1);
+    range[3] = this->GetBucketIndex(cb[3], 1);
+    for (int j = range[2]; j <= range[3]; j++)
+    {
+      for (int i = range[0]; i <= range[1]; i++)
+      {
+        this->BucketOffsets[i + nx*j + 1]++;
+      }
+    }
+  }
+  for (size_t b = 0; b < static_cast<size_t>(nx)*ny; b++)
+  {
+    this->BucketOffsets[b + 1] += this->BucketOffsets[b];
+  }
+
+  // fill
+  this->BucketCellIds.resize(this->BucketOffsets.back());
+  std::vector<vtkIdType> next(this->BucketOffsets.begin(), this->BucketOffsets.end() - 1);
+  for (vtkIdType cellId = 0; cellId < numCells; cellId++)
+  {
+    const int *range = &cellRanges[4*cellId];
+    for (int j = range[2]; j <= range[3]; j++)
+    {
+      for (int i = range[0]; i <= range[1]; i++)
+      {
+        this->BucketCellIds[next[i + nx*j]++] = cellId;
+      }
+    }
+  }
+
+  this->BuildTime.Modified();
+}
+
+//----------------------------------------------------------------------------
+int mvtkCellLocator2d::GetNumberOfBuckets()
+{
+  return this->NumberOfDivisions[0] * this->NumberOfDivisions[1];
+}
+
+//----------------------------------------------------------------------------
+void mvtkCellLocator2d::GetNumberOfDivisions(int divs[2])
+{
+  divs[0] = this->NumberOfDivisions[0];
+  divs[1] = this->NumberOfDivisions[1];
+}
+
+//----------------------------------------------------------------------------
+vtkIdType mvtkCellLocator2d::GetBucketCells(int bucket, const vtkIdType **cellIds)
+{
+  vtkIdType beg = this->BucketOffsets[bucket];
+  *cellIds = this->BucketCellIds.data() + beg;
+  return this->BucketOffsets[bucket + 1] - beg;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType mvtkCellLocator2d::FindCell(
+  double x[3], double vtkNotUsed(tol2), vtkGenericCell *cell,
+  double pcoords[3], double *weights)
+{
+  if (this->BucketOffsets.empty())
+  {
+    return -1;
+  }
+
+  const vtkIdType *cellIds;
+  int bucket = this->GetBucketIndex(x[0], 0)
+    + this->NumberOfDivisions[0]*this->GetBucketIndex(x[1], 1);
+  vtkIdType numCellIds = this->GetBucketCells(bucket, &cellIds);
+  for (vtkIdType k = 0; k < numCellIds; k++)
+  {
+    vtkIdType cellId = cellIds[k];
+    const double *cb = &this->CellBounds2d[4*cellId];
+    if (x[0] < cb[0] || x[0] > cb[1] || x[1] < cb[2] || x[1] > cb[3])
+    {
+      continue;
+    }
+    this->DataSet->GetCell(cellId, cell);
+    if (mntCellEvaluatePosition(cell, x, pcoords, weights) == 1)
+    {
+      return cellId;
+    }
+  }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+void mvtkCellLocator2d::FindCellsWithinBounds(double *bbox, vtkIdList *cells)
+{
+  cells->Reset();
+  if (this->BucketOffsets.empty())
+  {
+    return;
+  }
+
+  std::vector<vtkIdType> found;
+  const vtkIdType *cellIds;
+  int iBeg = this->GetBucketIndex(bbox[0], 0);
+  int iEnd = this->GetBucketIndex(bbox[1], 0);
+  int jBeg = this->GetBucketIndex(bbox[2], 1);
+  int jEnd = this->GetBucketIndex(bbox[3], 1);
+  for (int j = jBeg; j <= jEnd; j++)
+  {
+    for (int i = iBeg; i <= iEnd; i++)
+    {
+      vtkIdType numCellIds = this->GetBucketCells(i + this->NumberOfDivisions[0]*j, &cellIds);
+      for (vtkIdType k = 0; k < numCellIds; k++)
+      {
+        const double *cb = &this->CellBounds2d[4*cellIds[k]];
+        if (cb[1] >= bbox[0] && cb[0] <= bbox[1] && cb[3] >= bbox[2] && cb[2] <= bbox[3])
+        {
+          found.push_back(cellIds[k]);
+        }
+      }
+    }
+  }
+
+  std::sort(found.begin(), found.end());
+  found.erase(std::unique(found.begin(), found.end()), found.end());
+  cells->SetNumberOfIds(static_cast<vtkIdType>(found.size()));
+  for (size_t k = 0; k < found.size(); k++)
+  {
+    cells->SetId(static_cast<vtkIdType>(k), found[k]);
+  }
+}
+
+//----------------------------------------------------------------------------
+void mvtkCellLocator2d::FindCellsAlongLine(double p1[3], double p2[3],
+                                           double tolerance, vtkIdList *cells)
+{
+  cells->Reset();
+  if (this->BucketOffsets.empty())
+  {
+    return;
+  }
+
+  const int *n = this->NumberOfDivisions;
+  double dir[] = {p2[0] - p1[0], p2[1] - p1[1]};
+
+  // clip the segment to the bucket array, expanded by the tolerance
+  double tBeg = 0.0;
+  double tEnd = 1.0;
+  for (int d = 0; d < 2; d++)
+  {
+    double lo = this->Origin[d] - tolerance;
+    double hi = this->Origin[d] + n[d]*this->H[d] + tolerance;
+    if (dir[d] == 0.0)
+    {
+      if (p1[d] < lo || p1[d] > hi)
+      {
+        return;
+      }
+      continue;
+    }
+    double ta = (lo - p1[d]) / dir[d];
+    double tb = (hi - p1[d]) / dir[d];
+    tBeg = std::max(tBeg, std::min(ta, tb));
+    tEnd = std::min(tEnd, std::max(ta, tb));
+  }
+  if (tBeg > tEnd)
+  {
+    return;
+  }
+
+  // digital differential analyser: step from bucket to bucket, crossing the
+  // bucket face that is nearest along the segment
+  int ijk[2], ijkEnd[2], step[2];
+  double tMax[2], tDelta[2];
+  for (int d = 0; d < 2; d++)
+  {
+    ijk[d] = this->GetBucketIndex(p1[d] + tBeg*dir[d], d);
+    ijkEnd[d] = this->GetBucketIndex(p1[d] + tEnd*dir[d], d);
+    if (dir[d] > 0.0)
+    {
+      step[d] = 1;
+      tMax[d] = (this->Origin[d] + (ijk[d] + 1)*this->H[d] - p1[d]) / dir[d];
+      tDelta[d] = this->H[d] / dir[d];
+    }
+    else if (dir[d] < 0.0)
+    {
+      step[d] = -1;
+      tMax[d] = (this->Origin[d] + ijk[d]*this->H[d] - p1[d]) / dir[d];
+      tDelta[d] = -this->H[d] / dir[d];
+    }
+    else
+    {
+      step[d] = 0;
+      tMax[d] = VTK_DOUBLE_MAX;
+      tDelta[d] = VTK_DOUBLE_MAX;
+    }
+  }
+
+  // segment's bounding box, to prune the cells of each bucket
+  double segBounds[] = {std::min(p1[0], p2[0]) - tolerance, std::max(p1[0], p2[0]) + tolerance,
+                        std::min(p1[1], p2[1]) - tolerance, std::max(p1[1], p2[1]) + tolerance};
+
+  std::vector<vtkIdType> found;
+  const vtkIdType *cellIds;
+  int maxSteps = n[0] + n[1];
+  for (int s = 0; s <= maxSteps; s++)
+  {
+    vtkIdType numCellIds = this->GetBucketCells(ijk[0] + n[0]*ijk[1], &cellIds);
+    for (vtkIdType k = 0; k < numCellIds; k++)
+    {
+      vtkIdType cellId = cellIds[k];
+      const double *cb = &this->CellBounds2d[4*cellId];
+      if (cb[1] < segBounds[0] || cb[0] > segBounds[1] ||
+          cb[3] < segBounds[2] || cb[2] > segBounds[3])
+      {
+        continue;
+      }
+      // slab test of the segment against the expanded cell bounds
+      double ta = 0.0;
+      double tb = 1.0;
+      for (int d = 0; d < 2 && ta <= tb; d++)
+      {
+        if (dir[d] != 0.0)
+        {
+          double t0 = (cb[2*d] - tolerance - p1[d]) / dir[d];
+          double t1 = (cb[2*d + 1] + tolerance - p1[d]) / dir[d];
+          ta = std::max(ta, std::min(t0, t1));
+          tb = std::min(tb, std::max(t0, t1));
+        }
+      }
+      if (ta <= tb)
+      {
+        found.push_back(cellId);
+      }
+    }
+
+    if (ijk[0] == ijkEnd[0] && ijk[1] == ijkEnd[1])
+    {
+      break;
+    }
+    int d = (tMax[0] <= tMax[1] ? 0 : 1);
+    ijk[d] += step[d];
+    tMax[d] += tDelta[d];
+    if (ijk[d] < 0 || ijk[d] >= n[d])
+    {
+      break;
+    }
+  }
+
+  std::sort(found.begin(), found.end());
+  found.erase(std::unique(found.begin(), found.end()), found.end());
+  cells->SetNumberOfIds(static_cast<vtkIdType>(found.size()));
+  for (size_t k = 0; k < found.size(); k++)
+  {
+    cells->SetId(static_cast<vtkIdType>(k), found[k]);
+  }
+}
+
+//----------------------------------------------------------------------------
+// Outline of the non-empty buckets
+void mvtkCellLocator2d::GenerateRepresentation(int vtkNotUsed(level), vtkPolyData *pd)
+{
+  vtkPoints *pts = vtkPoints::New();
+  vtkCellArray *polys = vtkCellArray::New();
+  vtkIdType ptIds[4];
+  for (int j = 0; j < this->NumberOfDivisions[1]; j++)
+  {
+    for (int i = 0; i < this->NumberOfDivisions[0]; i++)
+    {
+      if (this->BucketOffsets[i + this->NumberOfDivisions[0]*j + 1] ==
+          this->BucketOffsets[i + this->NumberOfDivisions[0]*j])
+      {
+        continue;
+      }
+      double x0 = this->Origin[0] + i*this->H[0];
+      double y0 = this->Origin[1] + j*this->H[1];
+      ptIds[0] = pts->InsertNextPoint(x0, y0, 0.0);
+      ptIds[1] = pts->InsertNextPoint(x0 + this->H[0], y0, 0.0);
+      ptIds[2] = pts->InsertNextPoint(x0 + this->H[0], y0 + this->H[1], 0.0);
+      ptIds[3] = pts->InsertNextPoint(x0, y0 + this->H[1], 0.0);
+      polys->InsertNextCell(4, ptIds);
+    }
+  }
+  pd->SetPoints(pts);
+  pts->Delete();
+  pd->SetPolys(polys);
+  polys->Delete();
+}
+
+//----------------------------------------------------------------------------
+int mvtkCellLocator2d::WriteLocator(const char *filename)
+{
+  if ( !this->DataSet || this->BucketOffsets.empty() )
+  {
+    vtkErrorMacro( << "Locator must be built before being written");
+    return 0;
+  }
+
+  std::vector<double> geometry = {this->Origin[0], this->Origin[1],
+                                  this->H[0], this->H[1]};
+  std::vector<int> divs(this->NumberOfDivisions, this->NumberOfDivisions + 2);
+
+  LocatorFile file;
+  if (file.openForWriting(filename, "mvtkCellLocator2d", this->DataSet,
+                          this->NumberOfCellsPerNode) != 0 ||
+      file.write(geometry) != 0 || file.write(divs) != 0 ||
+      file.write(this->CellBounds2d) != 0 ||
+      file.write(this->BucketOffsets) != 0 ||
+      file.write(this->BucketCellIds) != 0 || file.close() != 0)
+  {
+    vtkErrorMacro( << "Cannot write " << filename);
+    return 0;
+  }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int mvtkCellLocator2d::ReadLocator(const char *filename)
+{
+  if ( !this->DataSet )
+  {
+    vtkErrorMacro( << "No data set");
+    return 0;
+  }
+
+  this->FreeSearchStructure();
+
+  std::vector<double> geometry;
+  std::vector<int> divs;
+  LocatorFile file;
+  if (file.openForReading(filename, "mvtkCellLocator2d", this->DataSet,
+                          this->NumberOfCellsPerNode) != 0 ||
+      file.read(geometry) != 0 || file.read(divs) != 0 ||
+      file.read(this->CellBounds2d) != 0 ||
+      file.read(this->BucketOffsets) != 0 ||
+      file.read(this->BucketCellIds) != 0 ||
+      geometry.size() != 4 || divs.size() != 2 || divs[0] < 1 || divs[1] < 1 ||
+      this->CellBounds2d.size() != 4*static_cast<size_t>(this->DataSet->GetNumberOfCells()) ||
+      !LocatorFile::checkBuckets(this->BucketOffsets, this->BucketCellIds,
+                                 static_cast<size_t>(divs[0])*divs[1],
+                                 this->DataSet->GetNumberOfCells()))
+  {
+    // not a locator file of this grid
+    this->FreeSearchStructure();
+    return 0;
+  }
+
+  this->Origin[0] = geometry[0];
+  this->Origin[1] = geometry[1];
+  this->H[0] = geometry[2];
+  this->H[1] = geometry[3];
+  this->NumberOfDivisions[0] = divs[0];
+  this->NumberOfDivisions[1] = divs[1];
+
+  this->BuildTime.Modified();
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void mvtkCellLocator2d::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Number Of Divisions: (" << this->NumberOfDivisions[0] << ", "
+     << this->NumberOfDivisions[1] << ")\n";
+}
@@ -0,0 +1,134 @@
+/**
+ * @class   mvtkCellLocator2d
+ * @brief   uniform bucket locator for planar grids
+ *
+ * mvtkCellLocator2d bins the cells of a grid lying in the z = 0 plane (e.g.
+ * a lon-lat grid) into nx * ny uniform buckets. Unlike an octree, the
+ * degenerate z direction is not subdivided, so that the number of cells per
+ * bucket is close to NumberOfCellsPerNode. The cell ids of all the buckets
+ * are stored in one contiguous array with per-bucket offsets. Points and
+ * lines are projected onto the z = 0 plane.
+ *
+ * The queries do not modify the locator and can be issued concurrently.
+ *
+ * @sa
+ * vtkCellLocator mvtkCellLocator
+*/
+
+#ifndef mvtkCellLocator2d_h
+#define mvtkCellLocator2d_h
+
+#include "vtkAbstractCellLocator.h"
+#include <vector>
+
+class vtkIdList;
+
+class mvtkCellLocator2d : public vtkAbstractCellLocator
+{
+public:
+  vtkTypeMacro(mvtkCellLocator2d,vtkAbstractCellLocator);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /**
+   * Construct with 25 cells per bucket on average.
+   */
+  static mvtkCellLocator2d *New();
+
+  /**
+   * Specify the average number of cells in each bucket.
+   */
+  void SetNumberOfCellsPerBucket(int N)
+  { this->SetNumberOfCellsPerNode(N); }
+  int GetNumberOfCellsPerBucket()
+  { return this->NumberOfCellsPerNode; }
+
+  /**
+   * Check whether a grid is made of quads lying in the z = 0 plane
+   * @param grid grid
+   * @return 1 if the locator applies, 0 otherwise
+   */
+  static int IsPlanarQuadGrid(vtkDataSet *grid);
+
+  // Re-use any superclass signatures that we don't override.
+  using vtkAbstractCellLocator::FindCell;
+
+  /**
+   * Find the cell containing a given point, -1 if no cell is found. The
+   * candidate cells are those of the point's bucket whose bounds contain the
+   * point, in increasing cell id order.
+   */
+  vtkIdType FindCell(
+    double x[3], double tol2, vtkGenericCell *GenCell,
+    double pcoords[3], double *weights) override;
+
+  /**
+   * Return the sorted list of unique cell ids whose bounds overlap a given
+   * bounding box. Only the x and y bounds are used.
+   */
+  void FindCellsWithinBounds(double *bbox, vtkIdList *cells) override;
+
+  /**
+   * Return the sorted list of unique cell ids whose bounds, expanded by
+   * tolerance, intersect the segment (p1, p2). The buckets along the segment
+   * are traversed with a 2D digital differential analyser.
+   */
+  void FindCellsAlongLine(double p1[3], double p2[3],
+                          double tolerance, vtkIdList *cells) override;
+
+  /**
+   * Return the number of buckets, nx * ny.
+   */
+  int GetNumberOfBuckets();
+
+  /**
+   * Get the number of buckets along x and y.
+   */
+  void GetNumberOfDivisions(int divs[2]);
+
+  /**
+   * Get the cells in a bucket
+   * @param bucket bucket index, i + nx*j
+   * @param cellIds pointer to the cell ids (output)
+   * @return number of cells
+   */
+  vtkIdType GetBucketCells(int bucket, const vtkIdType **cellIds);
+
+  //@{
+  /**
+   * Write the search structure of the built locator to a file, or read it
+   * back instead of building the locator. ReadLocator requires the data set
+   * to be set and fails if the file was written for another grid (see
+   * LocatorFile). Return 1 on success and 0 otherwise.
+   */
+  int WriteLocator(const char *filename);
+  int ReadLocator(const char *filename);
+  //@}
+
+  //@{
+  /**
+   * Satisfy vtkLocator abstract interface.
+   */
+  void FreeSearchStructure() override;
+  void BuildLocator() override;
+  void GenerateRepresentation(int level, vtkPolyData *pd) override;
+  //@}
+
+protected:
+  mvtkCellLocator2d();
+  ~mvtkCellLocator2d() override;
+
+  int GetBucketIndex(double x, int dim);
+
+  double Origin[2]; // low corner of the bucket array
+  double H[2]; // bucket widths
+  int NumberOfDivisions[2]; // number of buckets along x and y
+  std::vector<double> CellBounds2d; // xmin, xmax, ymin, ymax of each cell
+  std::vector<vtkIdType> BucketOffsets; // offset of each bucket into BucketCellIds
+  std::vector<vtkIdType> BucketCellIds; // cell ids of all the buckets, concatenated
+
+private:
+  mvtkCellLocator2d(const mvtkCellLocator2d&) = delete;
+  void operator=(const mvtkCellLocator2d&) = delete;
+};
+
+#endif
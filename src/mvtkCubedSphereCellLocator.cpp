@@ -0,0 +1,658 @@
+#include "mvtkCubedSphereCellLocator.h"
+#include "mvtkCellLocator2d.h"
+
+#include "vtkDataSet.h"
+#include "vtkGenericCell.h"
+#include "vtkIdList.h"
+#include "vtkObjectFactory.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "mntLocatorFile.h"
+#include "mntQuadPosition.h"
+
+#include <algorithm>
+#include <cmath>
+
+vtkStandardNewMacro(mvtkCubedSphereCellLocator);
+
+// minimum number of sub-quads along each side of a cell used to register
+// the cell, each sub-quad spans a quarter of a slot at most
+static const int SUBDIVISIONS = 4;
+
+// largest cell, in slots, accepted on a cubed-sphere grid
+static const double MAX_CELL_SIZE = 4.0;
+
+//----------------------------------------------------------------------------
+mvtkCubedSphereCellLocator::mvtkCubedSphereCellLocator()
+{
+  this->NumberOfPanelDivisions = 0;
+  this->Equiangular = 1;
+  this->MaxCellReach = 0.0;
+}
+
+//----------------------------------------------------------------------------
+mvtkCubedSphereCellLocator::~mvtkCubedSphereCellLocator()
+{
+  this->FreeSearchStructure();
+}
+
+//----------------------------------------------------------------------------
+void mvtkCubedSphereCellLocator::FreeSearchStructure()
+{
+  std::vector<double>().swap(this->CellBounds2d);
+  std::vector<vtkIdType>().swap(this->SlotOffsets);
+  std::vector<vtkIdType>().swap(this->SlotCellIds);
+  this->NumberOfPanelDivisions = 0;
+  this->MaxCellReach = 0.0;
+}
+
+//----------------------------------------------------------------------------
+// Upper bound of the distance on the sphere from a point within the lon-lat
+// bounds xmin, xmax, ymin, ymax of a cell to the cell. The cell touches each
+// side of its bounds, the point is thus joined to the cell by a meridian up
+// to the side closer to a pole and by that side's parallel.
+static double mvtkCubedSphereCellLocator_BoundsReach(const double cb[4])
+{
+  const double deg2rad = M_PI / 180.0;
+  double cosLat = std::cos(std::min(90.0, std::max(std::abs(cb[2]), std::abs(cb[3]))) * deg2rad);
+  return ((cb[3] - cb[2]) + (cb[1] - cb[0]) * cosLat) * deg2rad;
+}
+
+//----------------------------------------------------------------------------
+// Point on the unit sphere from longitude and latitude in degrees
+void mvtkCubedSphereCellLocator::GetXyz(const double lonLat[2], double xyz[3])
+{
+  const double deg2rad = M_PI / 180.0;
+  double lon = lonLat[0] * deg2rad;
+  double lat = lonLat[1] * deg2rad;
+  double rho = std::cos(lat);
+  xyz[0] = rho * std::cos(lon);
+  xyz[1] = rho * std::sin(lon);
+  xyz[2] = std::sin(lat);
+}
+
+//----------------------------------------------------------------------------
+// Panel 2*d (+ 1) faces the positive (negative) d axis
+int mvtkCubedSphereCellLocator::GetPanel(const double xyz[3])
+{
+  int d = 0;
+  for (int k = 1; k < 3; k++)
+  {
+    if (std::abs(xyz[k]) > std::abs(xyz[d]))
+    {
+      d = k;
+    }
+  }
+  return 2*d + (xyz[d] < 0.0 ? 1 : 0);
+}
+
+//----------------------------------------------------------------------------
+// Gnomonic coordinates of a point in a panel's frame, in units of slots so
+// that the panel spans [0, N]^2. Returns 0 if the point is too far from the
+// panel for the projection to make sense.
+int mvtkCubedSphereCellLocator::GetPanelCoords(const double xyz[3], int panel, double st[2])
+{
+  int d = panel / 2;
+  double c = (panel % 2 == 0 ? xyz[d] : -xyz[d]);
+  if (c <= 0.1 * std::sqrt(xyz[0]*xyz[0] + xyz[1]*xyz[1] + xyz[2]*xyz[2]))
+  {
+    return 0;
+  }
+  double n = static_cast<double>(this->NumberOfPanelDivisions);
+  for (int k = 0; k < 2; k++)
+  {
+    double a = xyz[(d + 1 + k) % 3] / c;
+    st[k] = (this->Equiangular ? (std::atan(a) + M_PI/4.0) * n / (M_PI/2.0)
+                               : (a + 1.0) * n / 2.0);
+  }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+// Lower bound of the arc length (in radians) spanned by a slot
+double mvtkCubedSphereCellLocator::GetSlotArc()
+{
+  return (this->Equiangular ? 0.9 : 0.5) * (M_PI/2.0) / this->NumberOfPanelDivisions;
+}
+
+//----------------------------------------------------------------------------
+int mvtkCubedSphereCellLocator::GetSlotIndex(double s)
+{
+  int n = this->NumberOfPanelDivisions;
+  return std::max(0, std::min(n - 1, static_cast<int>(std::floor(s))));
+}
+
+//----------------------------------------------------------------------------
+void mvtkCubedSphereCellLocator::ComputeMaxCellReach()
+{
+  this->MaxCellReach = 0.0;
+  for (size_t k = 0; k < this->CellBounds2d.size(); k += 4)
+  {
+    this->MaxCellReach = std::max(this->MaxCellReach,
+                                  mvtkCubedSphereCellLocator_BoundsReach(&this->CellBounds2d[k]));
+  }
+}
+
+//----------------------------------------------------------------------------
+// Check that each slot holds the centre of exactly one cell
+int mvtkCubedSphereCellLocator::AssignCellCentres(int equiangular)
+{
+  this->Equiangular = equiangular;
+  int n = this->NumberOfPanelDivisions;
+  vtkIdType numCells = this->DataSet->GetNumberOfCells();
+  std::vector<char> taken(6*static_cast<size_t>(n)*n, 0);
+  vtkGenericCell *cell = vtkGenericCell::New();
+  double x[3], xyz[3], st[2];
+  int ok = 1;
+  for (vtkIdType cellId = 0; cellId < numCells && ok; cellId++)
+  {
+    this->DataSet->GetCell(cellId, cell);
+    double centre[] = {0.0, 0.0, 0.0};
+    for (int k = 0; k < 4; k++)
+    {
+      cell->GetPoints()->GetPoint(k, x);
+      this->GetXyz(x, xyz);
+      for (int d = 0; d < 3; d++)
+      {
+        centre[d] += xyz[d];
+      }
+    }
+    int panel = this->GetPanel(centre);
+    this->GetPanelCoords(centre, panel, st);
+    char &slot = taken[this->GetSlotIndex(st[0])
+      + n*(this->GetSlotIndex(st[1]) + static_cast<size_t>(n)*panel)];
+    ok = (slot == 0 ? 1 : 0);
+    slot = 1;
+  }
+  cell->Delete();
+  return ok;
+}
+
+//----------------------------------------------------------------------------
+//  Each cell is split into sub-quads in lon-lat space, small enough for any
+//  of their points to lie within a quarter of a slot of a corner on the
+//  sphere. The sub-quad corners are projected onto the panels they are close
+//  to, and the cell is registered in the slots overlapping the projected
+//  sub-quads, padded by a quarter of a slot and some.
+//
+void mvtkCubedSphereCellLocator::BuildLocator()
+{
+  vtkIdType numCells;
+  if ( !this->DataSet || (numCells = this->DataSet->GetNumberOfCells()) < 1 )
+  {
+    vtkErrorMacro( << "No cells to subdivide");
+    return;
+  }
+
+  this->FreeSearchStructure();
+
+  // 6 * N * N quads in the z = 0 plane
+  int n = static_cast<int>(std::round(std::sqrt(numCells / 6.0)));
+  if (6*static_cast<vtkIdType>(n)*n != numCells ||
+      !mvtkCellLocator2d::IsPlanarQuadGrid(this->DataSet))
+  {
+    return;
+  }
+  this->NumberOfPanelDivisions = n;
+  if (!this->AssignCellCentres(1) && !this->AssignCellCentres(0))
+  {
+    this->NumberOfPanelDivisions = 0;
+    return;
+  }
+
+  // cell bounds
+  double bounds[6];
+  this->CellBounds2d.resize(4*numCells);
+  for (vtkIdType cellId = 0; cellId < numCells; cellId++)
+  {
+    this->DataSet->GetCellBounds(cellId, bounds);
+    std::copy(bounds, bounds + 4, &this->CellBounds2d[4*cellId]);
+  }
+
+  this->ComputeMaxCellReach();
+
+  // slots of each cell
+  const double deg2rad = M_PI / 180.0;
+  const double pad = 0.3;
+  double slotArc = this->GetSlotArc();
+  std::vector<double> xyz;
+  std::vector<vtkIdType> cellSlots;
+  std::vector<vtkIdType> allCellSlots;
+  std::vector<vtkIdType> cellSlotOffsets(numCells + 1, 0);
+  vtkGenericCell *cell = vtkGenericCell::New();
+  double v[4][3], st[4][2];
+  for (vtkIdType cellId = 0; cellId < numCells; cellId++)
+  {
+    this->DataSet->GetCell(cellId, cell);
+    for (int k = 0; k < 4; k++)
+    {
+      cell->GetPoints()->GetPoint(k, v[k]);
+    }
+    // upper bound of the length on the sphere of any path within the cell
+    const double *cb = &this->CellBounds2d[4*cellId];
+    double cosLat = 1.0;
+    if (cb[2] > 0.0 || cb[3] < 0.0)
+    {
+      cosLat = std::cos(std::min(std::abs(cb[2]), std::abs(cb[3])) * deg2rad);
+    }
+    double arc = std::sqrt(std::pow((cb[1] - cb[0]) * cosLat, 2) + std::pow(cb[3] - cb[2], 2)) * deg2rad;
+    if (arc > MAX_CELL_SIZE * slotArc)
+    {
+      // not a cubed-sphere cell, e.g. not fixed across the dateline
+      cell->Delete();
+      this->FreeSearchStructure();
+      return;
+    }
+    int ns = std::max(SUBDIVISIONS, static_cast<int>(std::ceil(SUBDIVISIONS * arc / slotArc)));
+    xyz.resize(3*(ns + 1)*(ns + 1));
+    // sample the quad in lon-lat space
+    for (int j = 0; j <= ns; j++)
+    {
+      double s = static_cast<double>(j) / ns;
+      for (int i = 0; i <= ns; i++)
+      {
+        double r = static_cast<double>(i) / ns;
+        double lonLat[2];
+        for (int d = 0; d < 2; d++)
+        {
+          lonLat[d] = (1.0 - r)*(1.0 - s)*v[0][d] + r*(1.0 - s)*v[1][d]
+                    + r*s*v[2][d] + (1.0 - r)*s*v[3][d];
+        }
+        this->GetXyz(lonLat, &xyz[3*(i + (ns + 1)*j)]);
+      }
+    }
+    cellSlots.resize(0);
+    for (int j = 0; j < ns; j++)
+    {
+      for (int i = 0; i < ns; i++)
+      {
+        const double *corners[] = {&xyz[3*(i + (ns + 1)*j)],
+                                   &xyz[3*(i + 1 + (ns + 1)*j)],
+                                   &xyz[3*(i + 1 + (ns + 1)*(j + 1))],
+                                   &xyz[3*(i + (ns + 1)*(j + 1))]};
+        for (int panel = 0; panel < 6; panel++)
+        {
+          bool inFrame = true;
+          for (int k = 0; k < 4 && inFrame; k++)
+          {
+            inFrame = (this->GetPanelCoords(corners[k], panel, st[k]) == 1);
+          }
+          if (!inFrame)
+          {
+            continue;
+          }
+          double lo[] = {st[0][0], st[0][1]};
+          double hi[] = {st[0][0], st[0][1]};
+          for (int k = 1; k < 4; k++)
+          {
+            for (int d = 0; d < 2; d++)
+            {
+              lo[d] = std::min(lo[d], st[k][d]);
+              hi[d] = std::max(hi[d], st[k][d]);
+            }
+          }
+          if (hi[0] + pad < 0.0 || hi[1] + pad < 0.0 || lo[0] - pad > n || lo[1] - pad > n)
+          {
+            continue;
+          }
+          int iBeg = this->GetSlotIndex(lo[0] - pad);
+          int iEnd = this->GetSlotIndex(hi[0] + pad);
+          int jBeg = this->GetSlotIndex(lo[1] - pad);
+          int jEnd = this->GetSlotIndex(hi[1] + pad);
+          for (int jj = jBeg; jj <= jEnd; jj++)
+          {
+            for (int ii = iBeg; ii <= iEnd; ii++)
+            {
+              cellSlots.push_back(ii + n*(jj + static_cast<vtkIdType>(n)*panel));
+            }
+          }
+        }
+      }
+    }
+    std::sort(cellSlots.begin(), cellSlots.end());
+    cellSlots.erase(std::unique(cellSlots.begin(), cellSlots.end()), cellSlots.end());
+    allCellSlots.insert(allCellSlots.end(), cellSlots.begin(), cellSlots.end());
+    cellSlotOffsets[cellId + 1] = static_cast<vtkIdType>(allCellSlots.size());
+  }
+  cell->Delete();
+
+  // count the cells of each slot
+  vtkIdType numSlots = 6*static_cast<vtkIdType>(n)*n;
+  this->SlotOffsets.assign(numSlots + 1, 0);
+  for (size_t k = 0; k < allCellSlots.size(); k++)
+  {
+    this->SlotOffsets[allCellSlots[k] + 1]++;
+  }
+  for (vtkIdType slot = 0; slot < numSlots; slot++)
+  {
+    this->SlotOffsets[slot + 1] += this->SlotOffsets[slot];
+  }
+
+  // fill, in increasing cell id order
+  this->SlotCellIds.resize(this->SlotOffsets.back());
+  std::vector<vtkIdType> next(this->SlotOffsets.begin(), this->SlotOffsets.end() - 1);
+  for (vtkIdType cellId = 0; cellId < numCells; cellId++)
+  {
+    for (vtkIdType k = cellSlotOffsets[cellId]; k < cellSlotOffsets[cellId + 1]; k++)
+    {
+      this->SlotCellIds[next[allCellSlots[k]]++] = cellId;
+    }
+  }
+
+  this->BuildTime.Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkIdType mvtkCubedSphereCellLocator::FindCell(
+  double x[3], double vtkNotUsed(tol2), vtkGenericCell *cell,
+  double pcoords[3], double *weights)
+{
+  if (this->SlotOffsets.empty())
+  {
+    return -1;
+  }
+
+  double xyz[3], st[2];
+  this->GetXyz(x, xyz);
+  int panel = this->GetPanel(xyz);
+  this->GetPanelCoords(xyz, panel, st);
+
+  const vtkIdType *cellIds;
+  vtkIdType numCellIds = this->GetSlotCells(panel, this->GetSlotIndex(st[0]),
+                                            this->GetSlotIndex(st[1]), &cellIds);
+  for (vtkIdType k = 0; k < numCellIds; k++)
+  {
+    vtkIdType cellId = cellIds[k];
+    const double *cb = &this->CellBounds2d[4*cellId];
+    if (x[0] < cb[0] || x[0] > cb[1] || x[1] < cb[2] || x[1] > cb[3])
+    {
+      continue;
+    }
+    this->DataSet->GetCell(cellId, cell);
+    if (mntCellEvaluatePosition(cell, x, pcoords, weights) == 1)
+    {
+      return cellId;
+    }
+  }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+//  The part of the box within the grid's bounds is sampled at intervals of a
+//  quarter of a slot or less on the sphere, and the slot coordinates of the
+//  samples are bracketed in each panel they are close to. A point within
+//  the bounds of a cell lies within MaxCellReach of the cell, so the
+//  brackets are padded by that distance, plus the sampling interval and the
+//  registration padding, before collecting the cells of their slots. The
+//  cells whose bounds overlap the box are kept.
+//
+void mvtkCubedSphereCellLocator::FindCellsWithinBounds(double *bbox, vtkIdList *cells)
+{
+  cells->Reset();
+  if (this->SlotOffsets.empty())
+  {
+    return;
+  }
+
+  const double deg2rad = M_PI / 180.0;
+  const double *bounds = this->DataSet->GetBounds();
+  double lonMin = std::max(bbox[0], bounds[0]);
+  double lonMax = std::min(bbox[1], bounds[1]);
+  double latMin = std::max(bbox[2], std::max(bounds[2], -90.0));
+  double latMax = std::min(bbox[3], std::min(bounds[3], 90.0));
+  if (lonMin > lonMax || latMin > latMax)
+  {
+    return;
+  }
+
+  int n = this->NumberOfPanelDivisions;
+  double slotArc = this->GetSlotArc();
+  double step = 0.25 * slotArc;
+  double reach = this->MaxCellReach + step;
+  double pad = reach / slotArc + 0.3;
+
+  std::vector<vtkIdType> found;
+  const vtkIdType *cellIds;
+  if (reach > M_PI / 8.0)
+  {
+    // the padded brackets may reach beyond the panel frames, e.g. on a
+    // very coarse grid
+    vtkIdType numCells = static_cast<vtkIdType>(this->CellBounds2d.size() / 4);
+    for (vtkIdType cellId = 0; cellId < numCells; cellId++)
+    {
+      found.push_back(cellId);
+    }
+  }
+  else
+  {
+    // sample the box on a lon-lat lattice, spaced by at most step on the
+    // sphere
+    double cosLat = 1.0;
+    if (latMin > 0.0 || latMax < 0.0)
+    {
+      cosLat = std::cos(std::min(std::abs(latMin), std::abs(latMax)) * deg2rad);
+    }
+    int numLon = std::max(1, static_cast<int>(std::ceil((lonMax - lonMin) * deg2rad * cosLat / step)));
+    int numLat = std::max(1, static_cast<int>(std::ceil((latMax - latMin) * deg2rad / step)));
+
+    double lo[6][2], hi[6][2];
+    for (int panel = 0; panel < 6; panel++)
+    {
+      lo[panel][0] = lo[panel][1] = VTK_DOUBLE_MAX;
+      hi[panel][0] = hi[panel][1] = -VTK_DOUBLE_MAX;
+    }
+    double xyz[3], st[2];
+    for (int j = 0; j <= numLat; j++)
+    {
+      for (int i = 0; i <= numLon; i++)
+      {
+        double x[] = {lonMin + (lonMax - lonMin) * i / numLon,
+                      latMin + (latMax - latMin) * j / numLat};
+        this->GetXyz(x, xyz);
+        for (int panel = 0; panel < 6; panel++)
+        {
+          if (!this->GetPanelCoords(xyz, panel, st) ||
+              st[0] < -pad || st[0] > n + pad || st[1] < -pad || st[1] > n + pad)
+          {
+            continue;
+          }
+          for (int d = 0; d < 2; d++)
+          {
+            lo[panel][d] = std::min(lo[panel][d], st[d]);
+            hi[panel][d] = std::max(hi[panel][d], st[d]);
+          }
+        }
+      }
+    }
+
+    for (int panel = 0; panel < 6; panel++)
+    {
+      if (lo[panel][0] > hi[panel][0])
+      {
+        continue;
+      }
+      int iBeg = this->GetSlotIndex(lo[panel][0] - pad);
+      int iEnd = this->GetSlotIndex(hi[panel][0] + pad);
+      int jBeg = this->GetSlotIndex(lo[panel][1] - pad);
+      int jEnd = this->GetSlotIndex(hi[panel][1] + pad);
+      for (int j = jBeg; j <= jEnd; j++)
+      {
+        for (int i = iBeg; i <= iEnd; i++)
+        {
+          vtkIdType numCellIds = this->GetSlotCells(panel, i, j, &cellIds);
+          found.insert(found.end(), cellIds, cellIds + numCellIds);
+        }
+      }
+    }
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+  }
+
+  // keep the cells whose bounds overlap the box
+  for (size_t k = 0; k < found.size(); k++)
+  {
+    const double *cb = &this->CellBounds2d[4*found[k]];
+    if (cb[1] >= bbox[0] && cb[0] <= bbox[1] && cb[3] >= bbox[2] && cb[2] <= bbox[3])
+    {
+      cells->InsertNextId(found[k]);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+//  The segment is sampled at intervals of a quarter of a slot or less (the
+//  length of a lon-lat segment on the sphere is at most its length in
+//  radians). The cells of the 3 x 3 slots around each sample, in each panel
+//  the sample is close to, are kept if their bounds intersect the segment.
+//
+void mvtkCubedSphereCellLocator::FindCellsAlongLine(double p1[3], double p2[3],
+                                                    double tolerance, vtkIdList *cells)
+{
+  cells->Reset();
+  if (this->SlotOffsets.empty())
+  {
+    return;
+  }
+
+  int n = this->NumberOfPanelDivisions;
+  double dir[] = {p2[0] - p1[0], p2[1] - p1[1]};
+  double length = std::sqrt(dir[0]*dir[0] + dir[1]*dir[1]) * M_PI / 180.0;
+  double step = 0.25 * this->GetSlotArc();
+  int numSteps = std::max(1, static_cast<int>(std::ceil(length / step)));
+
+  std::vector<vtkIdType> found;
+  const vtkIdType *cellIds;
+  double xyz[3], st[2];
+  for (int k = 0; k <= numSteps; k++)
+  {
+    double t = static_cast<double>(k) / numSteps;
+    double x[] = {p1[0] + t*dir[0], p1[1] + t*dir[1]};
+    this->GetXyz(x, xyz);
+    for (int panel = 0; panel < 6; panel++)
+    {
+      if (!this->GetPanelCoords(xyz, panel, st) ||
+          st[0] < -1.0 || st[0] > n + 1.0 || st[1] < -1.0 || st[1] > n + 1.0)
+      {
+        continue;
+      }
+      int iBeg = this->GetSlotIndex(st[0] - 1.0);
+      int iEnd = this->GetSlotIndex(st[0] + 1.0);
+      int jBeg = this->GetSlotIndex(st[1] - 1.0);
+      int jEnd = this->GetSlotIndex(st[1] + 1.0);
+      for (int j = jBeg; j <= jEnd; j++)
+      {
+        for (int i = iBeg; i <= iEnd; i++)
+        {
+          vtkIdType numCellIds = this->GetSlotCells(panel, i, j, &cellIds);
+          found.insert(found.end(), cellIds, cellIds + numCellIds);
+        }
+      }
+    }
+  }
+  std::sort(found.begin(), found.end());
+  found.erase(std::unique(found.begin(), found.end()), found.end());
+
+  // keep the cells whose expanded bounds intersect the segment
+  for (size_t k = 0; k < found.size(); k++)
+  {
+    const double *cb = &this->CellBounds2d[4*found[k]];
+    double ta = 0.0;
+    double tb = 1.0;
+    for (int d = 0; d < 2 && ta <= tb; d++)
+    {
+      double lo = cb[2*d] - tolerance;
+      double hi = cb[2*d + 1] + tolerance;
+      if (dir[d] == 0.0)
+      {
+        if (p1[d] < lo || p1[d] > hi)
+        {
+          ta = 2.0;
+        }
+        continue;
+      }
+      double t0 = (lo - p1[d]) / dir[d];
+      double t1 = (hi - p1[d]) / dir[d];
+      ta = std::max(ta, std::min(t0, t1));
+      tb = std::min(tb, std::max(t0, t1));
+    }
+    if (ta <= tb)
+    {
+      cells->InsertNextId(found[k]);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void mvtkCubedSphereCellLocator::GenerateRepresentation(int vtkNotUsed(level),
+                                                        vtkPolyData *vtkNotUsed(pd))
+{
+  // the slots are not planar in lon-lat space
+}
+
+//----------------------------------------------------------------------------
+int mvtkCubedSphereCellLocator::WriteLocator(const char *filename)
+{
+  if ( !this->DataSet || !this->IsCubedSphere() )
+  {
+    vtkErrorMacro( << "Locator must be built on a cubed-sphere grid before being written");
+    return 0;
+  }
+
+  std::vector<int> divs = {this->NumberOfPanelDivisions, this->Equiangular};
+
+  LocatorFile file;
+  if (file.openForWriting(filename, "mvtkCubedSphereCellLocator", this->DataSet, 0) != 0 ||
+      file.write(divs) != 0 || file.write(this->CellBounds2d) != 0 ||
+      file.write(this->SlotOffsets) != 0 || file.write(this->SlotCellIds) != 0 ||
+      file.close() != 0)
+  {
+    vtkErrorMacro( << "Cannot write " << filename);
+    return 0;
+  }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int mvtkCubedSphereCellLocator::ReadLocator(const char *filename)
+{
+  if ( !this->DataSet )
+  {
+    vtkErrorMacro( << "No data set");
+    return 0;
+  }
+
+  this->FreeSearchStructure();
+
+  vtkIdType numCells = this->DataSet->GetNumberOfCells();
+  std::vector<int> divs;
+  LocatorFile file;
+  if (file.openForReading(filename, "mvtkCubedSphereCellLocator", this->DataSet, 0) != 0 ||
+      file.read(divs) != 0 || file.read(this->CellBounds2d) != 0 ||
+      file.read(this->SlotOffsets) != 0 || file.read(this->SlotCellIds) != 0 ||
+      divs.size() != 2 || divs[0] < 1 ||
+      6*static_cast<vtkIdType>(divs[0])*divs[0] != numCells ||
+      this->CellBounds2d.size() != 4*static_cast<size_t>(numCells) ||
+      !LocatorFile::checkBuckets(this->SlotOffsets, this->SlotCellIds,
+                                 static_cast<size_t>(numCells), numCells))
+  {
+    // not a locator file of this grid
+    this->FreeSearchStructure();
+    return 0;
+  }
+
+  this->NumberOfPanelDivisions = divs[0];
+  this->Equiangular = divs[1];
+  this->ComputeMaxCellReach();
+
+  this->BuildTime.Modified();
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void mvtkCubedSphereCellLocator::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Number Of Panel Divisions: " << this->NumberOfPanelDivisions << "\n";
+  os << indent << "Equiangular: " << this->Equiangular << "\n";
+}
@@ -0,0 +1,142 @@
+/**
+ * @class   mvtkCubedSphereCellLocator
+ * @brief   panel-aware locator for cubed-sphere grids in lon-lat coordinates
+ *
+ * mvtkCubedSphereCellLocator applies to cubed-sphere grids of 6 * N * N
+ * quads whose vertices are stored as (longitude, latitude, 0) in degrees, as
+ * read from UGRID files by mntGrid. The panels are assumed to face the +/-x,
+ * +/-y and +/-z axes, i.e. to be centred on longitudes 0, 90, 180 and 270
+ * and on the poles. Each panel is an N x N block of slots in equiangular
+ * (or, failing that, equidistant) gnomonic coordinates. BuildLocator checks
+ * that each slot holds the centre of exactly one cell. It then registers
+ * every cell in the slots covered by its lon-lat quad.
+ *
+ * A point is mapped to a panel and slot in closed form. The cell containing
+ * it is then found among the few cells of that slot. The cells along a line
+ * or within a box are gathered from the slots of points sampled along the
+ * line or over the box.
+ *
+ * If the grid is not a cubed-sphere, IsCubedSphere() returns 0 after
+ * BuildLocator and all queries return no cell.
+ *
+ * The queries do not modify the locator and can be issued concurrently.
+ *
+ * @sa
+ * mvtkRectilinearCellLocator mvtkCellLocator2d vtkCellLocator
+*/
+
+#ifndef mvtkCubedSphereCellLocator_h
+#define mvtkCubedSphereCellLocator_h
+
+#include "vtkAbstractCellLocator.h"
+#include <vector>
+
+class vtkIdList;
+
+class mvtkCubedSphereCellLocator : public vtkAbstractCellLocator
+{
+public:
+  vtkTypeMacro(mvtkCubedSphereCellLocator,vtkAbstractCellLocator);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  static mvtkCubedSphereCellLocator *New();
+
+  /**
+   * Whether the last BuildLocator found a cubed-sphere grid
+   * @return 1 if cubed-sphere, 0 otherwise
+   */
+  int IsCubedSphere()
+  { return this->SlotOffsets.empty() ? 0 : 1; }
+
+  /**
+   * Get the number of cells along each panel edge (N).
+   */
+  int GetNumberOfPanelDivisions()
+  { return this->NumberOfPanelDivisions; }
+
+  /**
+   * Whether the panels are divided uniformly in angle (1) or in gnomonic
+   * distance (0).
+   */
+  int GetEquiangular()
+  { return this->Equiangular; }
+
+  // Re-use any superclass signatures that we don't override.
+  using vtkAbstractCellLocator::FindCell;
+
+  /**
+   * Find the cell containing a given point, -1 if no cell is found. The
+   * candidate cells are those of the point's slot, in increasing cell id
+   * order, so the cell returned is the same as vtkCellLocator's.
+   */
+  vtkIdType FindCell(
+    double x[3], double tol2, vtkGenericCell *GenCell,
+    double pcoords[3], double *weights) override;
+
+  /**
+   * Return the sorted list of unique cell ids whose bounds overlap a given
+   * bounding box. Only the x and y bounds are used. The candidate cells are
+   * those of the slots covered by the box, padded by the size of the
+   * largest cell.
+   */
+  void FindCellsWithinBounds(double *bbox, vtkIdList *cells) override;
+
+  /**
+   * Return the sorted list of unique cell ids lying near the segment (p1, p2)
+   * whose bounds, expanded by tolerance, intersect the segment.
+   */
+  void FindCellsAlongLine(double p1[3], double p2[3],
+                          double tolerance, vtkIdList *cells) override;
+
+  //@{
+  /**
+   * Write the search structure of the built locator to a file, or read it
+   * back instead of building the locator. ReadLocator requires the data set
+   * to be set and fails if the file was written for another grid (see
+   * LocatorFile). Return 1 on success and 0 otherwise.
+   */
+  int WriteLocator(const char *filename);
+  int ReadLocator(const char *filename);
+  //@}
+
+  //@{
+  /**
+   * Satisfy vtkLocator abstract interface.
+   */
+  void FreeSearchStructure() override;
+  void BuildLocator() override;
+  void GenerateRepresentation(int level, vtkPolyData *pd) override;
+  //@}
+
+protected:
+  mvtkCubedSphereCellLocator();
+  ~mvtkCubedSphereCellLocator() override;
+
+  static void GetXyz(const double lonLat[2], double xyz[3]);
+  static int GetPanel(const double xyz[3]);
+  int GetPanelCoords(const double xyz[3], int panel, double st[2]);
+  double GetSlotArc();
+  int GetSlotIndex(double s);
+  int AssignCellCentres(int equiangular);
+  void ComputeMaxCellReach();
+  vtkIdType GetSlotCells(int panel, int i, int j, const vtkIdType **cellIds)
+  {
+    vtkIdType slot = i + this->NumberOfPanelDivisions*(j + this->NumberOfPanelDivisions*panel);
+    vtkIdType beg = this->SlotOffsets[slot];
+    *cellIds = this->SlotCellIds.data() + beg;
+    return this->SlotOffsets[slot + 1] - beg;
+  }
+
+  int NumberOfPanelDivisions; // N, number of cells along a panel edge
+  int Equiangular; // whether the slots are uniform in angle
+  double MaxCellReach; // largest distance (in radians) from a point within a cell's bounds to the cell
+  std::vector<double> CellBounds2d; // xmin, xmax, ymin, ymax of each cell
+  std::vector<vtkIdType> SlotOffsets; // 6*N*N + 1 offsets into SlotCellIds
+  std::vector<vtkIdType> SlotCellIds; // cell ids of each slot, increasing
+
+private:
+  mvtkCubedSphereCellLocator(const mvtkCubedSphereCellLocator&) = delete;
+  void operator=(const mvtkCubedSphereCellLocator&) = delete;
+};
+
+#endif
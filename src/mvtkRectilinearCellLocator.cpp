@@ -0,0 +1,483 @@
+#include "mvtkRectilinearCellLocator.h"
+
+#include "vtkDataSet.h"
+#include "vtkGenericCell.h"
+#include "vtkIdList.h"
+#include "vtkObjectFactory.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "mntLocatorFile.h"
+
+#include <algorithm>
+#include <cmath>
+
+vtkStandardNewMacro(mvtkRectilinearCellLocator);
+
+//----------------------------------------------------------------------------
+mvtkRectilinearCellLocator::mvtkRectilinearCellLocator()
+{
+  this->Uniform[0] = this->Uniform[1] = 0;
+  this->NumberOfDivisions[0] = this->NumberOfDivisions[1] = 0;
+}
+
+//----------------------------------------------------------------------------
+mvtkRectilinearCellLocator::~mvtkRectilinearCellLocator()
+{
+  this->FreeSearchStructure();
+}
+
+//----------------------------------------------------------------------------
+void mvtkRectilinearCellLocator::FreeSearchStructure()
+{
+  std::vector<double>().swap(this->Coords[0]);
+  std::vector<double>().swap(this->Coords[1]);
+  std::vector<vtkIdType>().swap(this->CellIndex);
+  this->Uniform[0] = this->Uniform[1] = 0;
+  this->NumberOfDivisions[0] = this->NumberOfDivisions[1] = 0;
+}
+
+//----------------------------------------------------------------------------
+void mvtkRectilinearCellLocator::GetNumberOfDivisions(int divs[2])
+{
+  divs[0] = this->NumberOfDivisions[0];
+  divs[1] = this->NumberOfDivisions[1];
+}
+
+//----------------------------------------------------------------------------
+//  Recover the grid lines from the cell bounds. The grid is rectilinear if
+//  all the cells are axis-aligned quads in the z = 0 plane, spanning one
+//  interval of grid lines in each direction, and no two cells share a slot.
+//
+void mvtkRectilinearCellLocator::BuildLocator()
+{
+  vtkIdType numCells;
+  if ( !this->DataSet || (numCells = this->DataSet->GetNumberOfCells()) < 1 )
+  {
+    vtkErrorMacro( << "No cells to subdivide");
+    return;
+  }
+
+  this->FreeSearchStructure();
+
+  const double *bounds = this->DataSet->GetBounds();
+  if (bounds[4] != bounds[5])
+  {
+    return;
+  }
+
+  // cell bounds, checking that each cell is an axis-aligned rectangle
+  vtkGenericCell *cell = vtkGenericCell::New();
+  std::vector<double> cellBounds(4*numCells);
+  double x[3];
+  bool ok = true;
+  for (vtkIdType cellId = 0; cellId < numCells && ok; cellId++)
+  {
+    if (this->DataSet->GetCellType(cellId) != VTK_QUAD)
+    {
+      ok = false;
+      break;
+    }
+    this->DataSet->GetCell(cellId, cell);
+    double *cb = &cellBounds[4*cellId];
+    cb[0] = cb[2] = VTK_DOUBLE_MAX;
+    cb[1] = cb[3] = -VTK_DOUBLE_MAX;
+    for (int k = 0; k < 4; k++)
+    {
+      cell->GetPoints()->GetPoint(k, x);
+      for (int d = 0; d < 2; d++)
+      {
+        cb[2*d] = std::min(cb[2*d], x[d]);
+        cb[2*d + 1] = std::max(cb[2*d + 1], x[d]);
+      }
+    }
+    for (int k = 0; k < 4 && ok; k++)
+    {
+      cell->GetPoints()->GetPoint(k, x);
+      ok = (x[0] == cb[0] || x[0] == cb[1]) && (x[1] == cb[2] || x[1] == cb[3]);
+    }
+    ok = ok && cb[0] < cb[1] && cb[2] < cb[3];
+  }
+  cell->Delete();
+  if (!ok)
+  {
+    return;
+  }
+
+  // grid lines
+  for (int d = 0; d < 2; d++)
+  {
+    std::vector<double> &xs = this->Coords[d];
+    xs.reserve(2*numCells);
+    for (vtkIdType cellId = 0; cellId < numCells; cellId++)
+    {
+      xs.push_back(cellBounds[4*cellId + 2*d]);
+      xs.push_back(cellBounds[4*cellId + 2*d + 1]);
+    }
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+    this->NumberOfDivisions[d] = static_cast<int>(xs.size()) - 1;
+  }
+  double numSlots = static_cast<double>(this->NumberOfDivisions[0]) * this->NumberOfDivisions[1];
+  if (numSlots > 2.0*numCells)
+  {
+    // too sparse to be a rectilinear grid
+    this->FreeSearchStructure();
+    return;
+  }
+
+  // cell of each slot
+  this->CellIndex.assign(static_cast<size_t>(numSlots), -1);
+  for (vtkIdType cellId = 0; cellId < numCells; cellId++)
+  {
+    int ij[2];
+    for (int d = 0; d < 2; d++)
+    {
+      const std::vector<double> &xs = this->Coords[d];
+      ij[d] = static_cast<int>(std::lower_bound(xs.begin(), xs.end(),
+                                                cellBounds[4*cellId + 2*d]) - xs.begin());
+      if (xs[ij[d] + 1] != cellBounds[4*cellId + 2*d + 1])
+      {
+        // the cell spans more than one interval
+        this->FreeSearchStructure();
+        return;
+      }
+    }
+    vtkIdType &slot = this->CellIndex[ij[0] + this->NumberOfDivisions[0]*ij[1]];
+    if (slot >= 0)
+    {
+      // overlapping cells
+      this->FreeSearchStructure();
+      return;
+    }
+    slot = cellId;
+  }
+
+  // equally spaced grid lines are located arithmetically
+  for (int d = 0; d < 2; d++)
+  {
+    const std::vector<double> &xs = this->Coords[d];
+    int n = this->NumberOfDivisions[d];
+    double h = (xs[n] - xs[0]) / n;
+    this->Uniform[d] = 1;
+    for (int i = 0; i < n; i++)
+    {
+      if (std::abs(xs[i + 1] - xs[i] - h) > 1.e-10*h)
+      {
+        this->Uniform[d] = 0;
+        break;
+      }
+    }
+  }
+
+  this->BuildTime.Modified();
+}
+
+//----------------------------------------------------------------------------
+// Index i of the interval xs[i] <= x < xs[i + 1], clamped to [0, n - 1]
+int mvtkRectilinearCellLocator::FindInterval(double x, int dim)
+{
+  const std::vector<double> &xs = this->Coords[dim];
+  int n = this->NumberOfDivisions[dim];
+  int i;
+  if (this->Uniform[dim])
+  {
+    i = static_cast<int>(std::floor((x - xs[0]) * n / (xs[n] - xs[0])));
+    i = std::max(0, std::min(n - 1, i));
+    // correct for round off
+    if (i > 0 && x < xs[i])
+    {
+      i--;
+    }
+    else if (i < n - 1 && x >= xs[i + 1])
+    {
+      i++;
+    }
+  }
+  else
+  {
+    i = static_cast<int>(std::upper_bound(xs.begin(), xs.end(), x) - xs.begin()) - 1;
+    i = std::max(0, std::min(n - 1, i));
+  }
+  return i;
+}
+
+//----------------------------------------------------------------------------
+// Range of the intervals overlapping [xmin, xmax], returns 0 if there are none
+int mvtkRectilinearCellLocator::FindIntervalRange(double xmin, double xmax, int dim,
+                                                  int range[2])
+{
+  const std::vector<double> &xs = this->Coords[dim];
+  int n = this->NumberOfDivisions[dim];
+  if (xmax < xs[0] || xmin > xs[n] || xmin > xmax)
+  {
+    return 0;
+  }
+  range[0] = this->FindInterval(xmin, dim);
+  if (range[0] > 0 && xmin <= xs[range[0]])
+  {
+    // the interval on the left touches xmin
+    range[0]--;
+  }
+  range[1] = this->FindInterval(xmax, dim);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType mvtkRectilinearCellLocator::FindCell(
+  double x[3], double vtkNotUsed(tol2), vtkGenericCell *cell,
+  double pcoords[3], double *weights)
+{
+  if (this->CellIndex.empty())
+  {
+    return -1;
+  }
+
+  // cells containing the point, the point may be on a grid line. Points just
+  // outside the outer grid lines belong to the outer cells, within vtkQuad's
+  // parametric tolerance
+  const double ptol = 0.001;
+  int range[2][2];
+  for (int d = 0; d < 2; d++)
+  {
+    const std::vector<double> &xs = this->Coords[d];
+    int n = this->NumberOfDivisions[d];
+    double xd = x[d];
+    if (xd < xs[0] && xd >= xs[0] - ptol*(xs[1] - xs[0]))
+    {
+      xd = xs[0];
+    }
+    else if (xd > xs[n] && xd <= xs[n] + ptol*(xs[n] - xs[n - 1]))
+    {
+      xd = xs[n];
+    }
+    if (!this->FindIntervalRange(xd, xd, d, range[d]))
+    {
+      return -1;
+    }
+  }
+  vtkIdType cellId = -1;
+  for (int j = range[1][0]; j <= range[1][1]; j++)
+  {
+    for (int i = range[0][0]; i <= range[0][1]; i++)
+    {
+      vtkIdType id = this->GetCellId(i, j);
+      if (id >= 0 && (cellId < 0 || id < cellId))
+      {
+        cellId = id;
+      }
+    }
+  }
+  if (cellId < 0)
+  {
+    return -1;
+  }
+
+  // the cell is a parallelogram, x = p0 + xi*(p1 - p0) + eta*(p3 - p0)
+  this->DataSet->GetCell(cellId, cell);
+  double p0[3], p1[3], p3[3];
+  cell->GetPoints()->GetPoint(0, p0);
+  cell->GetPoints()->GetPoint(1, p1);
+  cell->GetPoints()->GetPoint(3, p3);
+  double a[] = {p1[0] - p0[0], p1[1] - p0[1]};
+  double b[] = {p3[0] - p0[0], p3[1] - p0[1]};
+  double c[] = {x[0] - p0[0], x[1] - p0[1]};
+  double det = a[0]*b[1] - a[1]*b[0];
+  pcoords[0] = (c[0]*b[1] - c[1]*b[0]) / det;
+  pcoords[1] = (a[0]*c[1] - a[1]*c[0]) / det;
+  pcoords[2] = 0.0;
+
+  // bilinear interpolation weights, in vtkQuad order
+  weights[0] = (1.0 - pcoords[0])*(1.0 - pcoords[1]);
+  weights[1] = pcoords[0]*(1.0 - pcoords[1]);
+  weights[2] = pcoords[0]*pcoords[1];
+  weights[3] = (1.0 - pcoords[0])*pcoords[1];
+
+  return cellId;
+}
+
+//----------------------------------------------------------------------------
+void mvtkRectilinearCellLocator::FindCellsWithinBounds(double *bbox, vtkIdList *cells)
+{
+  cells->Reset();
+  if (this->CellIndex.empty())
+  {
+    return;
+  }
+
+  int range[2][2];
+  for (int d = 0; d < 2; d++)
+  {
+    if (!this->FindIntervalRange(bbox[2*d], bbox[2*d + 1], d, range[d]))
+    {
+      return;
+    }
+  }
+
+  std::vector<vtkIdType> found;
+  for (int j = range[1][0]; j <= range[1][1]; j++)
+  {
+    for (int i = range[0][0]; i <= range[0][1]; i++)
+    {
+      vtkIdType cellId = this->GetCellId(i, j);
+      if (cellId >= 0)
+      {
+        found.push_back(cellId);
+      }
+    }
+  }
+
+  std::sort(found.begin(), found.end());
+  cells->SetNumberOfIds(static_cast<vtkIdType>(found.size()));
+  for (size_t k = 0; k < found.size(); k++)
+  {
+    cells->SetId(static_cast<vtkIdType>(k), found[k]);
+  }
+}
+
+//----------------------------------------------------------------------------
+void mvtkRectilinearCellLocator::FindCellsAlongLine(double p1[3], double p2[3],
+                                                    double tolerance, vtkIdList *cells)
+{
+  cells->Reset();
+  if (this->CellIndex.empty())
+  {
+    return;
+  }
+
+  const std::vector<double> &xs = this->Coords[0];
+  double dir[] = {p2[0] - p1[0], p2[1] - p1[1]};
+
+  // columns spanned by the segment
+  int columns[2];
+  if (!this->FindIntervalRange(std::min(p1[0], p2[0]) - tolerance,
+                               std::max(p1[0], p2[0]) + tolerance, 0, columns))
+  {
+    return;
+  }
+
+  std::vector<vtkIdType> found;
+  for (int i = columns[0]; i <= columns[1]; i++)
+  {
+    // part of the segment within the column, expanded by the tolerance
+    double ta = 0.0;
+    double tb = 1.0;
+    if (dir[0] != 0.0)
+    {
+      double t0 = (xs[i] - tolerance - p1[0]) / dir[0];
+      double t1 = (xs[i + 1] + tolerance - p1[0]) / dir[0];
+      ta = std::max(ta, std::min(t0, t1));
+      tb = std::min(tb, std::max(t0, t1));
+    }
+    if (ta > tb)
+    {
+      continue;
+    }
+
+    // rows crossed within the column
+    double ya = p1[1] + ta*dir[1];
+    double yb = p1[1] + tb*dir[1];
+    int rows[2];
+    if (!this->FindIntervalRange(std::min(ya, yb) - tolerance,
+                                 std::max(ya, yb) + tolerance, 1, rows))
+    {
+      continue;
+    }
+    for (int j = rows[0]; j <= rows[1]; j++)
+    {
+      vtkIdType cellId = this->GetCellId(i, j);
+      if (cellId >= 0)
+      {
+        found.push_back(cellId);
+      }
+    }
+  }
+
+  std::sort(found.begin(), found.end());
+  cells->SetNumberOfIds(static_cast<vtkIdType>(found.size()));
+  for (size_t k = 0; k < found.size(); k++)
+  {
+    cells->SetId(static_cast<vtkIdType>(k), found[k]);
+  }
+}
+
+//----------------------------------------------------------------------------
+void mvtkRectilinearCellLocator::GenerateRepresentation(int vtkNotUsed(level),
+                                                        vtkPolyData *vtkNotUsed(pd))
+{
+  // the grid is its own representation
+}
+
+//----------------------------------------------------------------------------
+int mvtkRectilinearCellLocator::WriteLocator(const char *filename)
+{
+  if ( !this->DataSet || !this->IsRectilinear() )
+  {
+    vtkErrorMacro( << "Locator must be built on a rectilinear grid before being written");
+    return 0;
+  }
+
+  std::vector<int> divs = {this->NumberOfDivisions[0], this->NumberOfDivisions[1],
+                           this->Uniform[0], this->Uniform[1]};
+
+  LocatorFile file;
+  if (file.openForWriting(filename, "mvtkRectilinearCellLocator", this->DataSet, 0) != 0 ||
+      file.write(divs) != 0 || file.write(this->Coords[0]) != 0 ||
+      file.write(this->Coords[1]) != 0 || file.write(this->CellIndex) != 0 ||
+      file.close() != 0)
+  {
+    vtkErrorMacro( << "Cannot write " << filename);
+    return 0;
+  }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int mvtkRectilinearCellLocator::ReadLocator(const char *filename)
+{
+  if ( !this->DataSet )
+  {
+    vtkErrorMacro( << "No data set");
+    return 0;
+  }
+
+  this->FreeSearchStructure();
+
+  vtkIdType numCells = this->DataSet->GetNumberOfCells();
+  std::vector<int> divs;
+  LocatorFile file;
+  bool valid = file.openForReading(filename, "mvtkRectilinearCellLocator", this->DataSet, 0) == 0 &&
+    file.read(divs) == 0 && file.read(this->Coords[0]) == 0 &&
+    file.read(this->Coords[1]) == 0 && file.read(this->CellIndex) == 0 &&
+    divs.size() == 4 && divs[0] >= 1 && divs[1] >= 1 &&
+    this->Coords[0].size() == static_cast<size_t>(divs[0]) + 1 &&
+    this->Coords[1].size() == static_cast<size_t>(divs[1]) + 1 &&
+    this->CellIndex.size() == static_cast<size_t>(divs[0])*divs[1];
+  for (size_t k = 0; valid && k < this->CellIndex.size(); k++)
+  {
+    valid = this->CellIndex[k] >= -1 && this->CellIndex[k] < numCells;
+  }
+  if (!valid)
+  {
+    // not a locator file of this grid
+    this->FreeSearchStructure();
+    return 0;
+  }
+
+  this->NumberOfDivisions[0] = divs[0];
+  this->NumberOfDivisions[1] = divs[1];
+  this->Uniform[0] = divs[2];
+  this->Uniform[1] = divs[3];
+
+  this->BuildTime.Modified();
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void mvtkRectilinearCellLocator::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Number Of Divisions: (" << this->NumberOfDivisions[0] << ", "
+     << this->NumberOfDivisions[1] << ")\n";
+  os << indent << "Uniform: (" << this->Uniform[0] << ", " << this->Uniform[1] << ")\n";
+}
@@ -0,0 +1,118 @@
+/**
+ * @class   mvtkRectilinearCellLocator
+ * @brief   analytic locator for rectilinear (e.g. lat-lon) quad grids
+ *
+ * mvtkRectilinearCellLocator applies to grids of axis-aligned quads in the
+ * z = 0 plane whose vertices lie on the lines x = xs[i] and y = ys[j], such
+ * as the uniform lat-lon grids of mntLatLon or UM-style lat-lon grids with
+ * variable spacing. BuildLocator recovers xs, ys and the cell of each (i, j)
+ * slot. A point is then located arithmetically if the spacing is uniform,
+ * by bisection otherwise, and the cells along a line follow from the line's
+ * crossings with the grid lines, without any tree search.
+ *
+ * If the grid is not rectilinear, IsRectilinear() returns 0 after
+ * BuildLocator and all queries return no cell.
+ *
+ * The queries do not modify the locator and can be issued concurrently.
+ *
+ * @sa
+ * mvtkCellLocator2d vtkCellLocator
+*/
+
+#ifndef mvtkRectilinearCellLocator_h
+#define mvtkRectilinearCellLocator_h
+
+#include "vtkAbstractCellLocator.h"
+#include <vector>
+
+class vtkIdList;
+
+class mvtkRectilinearCellLocator : public vtkAbstractCellLocator
+{
+public:
+  vtkTypeMacro(mvtkRectilinearCellLocator,vtkAbstractCellLocator);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  static mvtkRectilinearCellLocator *New();
+
+  /**
+   * Whether the last BuildLocator found a rectilinear grid
+   * @return 1 if rectilinear, 0 otherwise
+   */
+  int IsRectilinear()
+  { return this->CellIndex.empty() ? 0 : 1; }
+
+  /**
+   * Get the number of cells along x and y.
+   */
+  void GetNumberOfDivisions(int divs[2]);
+
+  // Re-use any superclass signatures that we don't override.
+  using vtkAbstractCellLocator::FindCell;
+
+  /**
+   * Find the cell containing a given point, -1 if no cell is found. Among
+   * the cells sharing the point, the one with the lowest id is returned as
+   * vtkCellLocator would. Points outside the grid by less than 0.001 times
+   * the width of the outer cells are found, as with vtkQuad's parametric
+   * tolerance. The parametric coordinates and the weights are computed in
+   * closed form.
+   */
+  vtkIdType FindCell(
+    double x[3], double tol2, vtkGenericCell *GenCell,
+    double pcoords[3], double *weights) override;
+
+  /**
+   * Return the sorted list of unique cell ids whose bounds overlap a given
+   * bounding box. Only the x and y bounds are used.
+   */
+  void FindCellsWithinBounds(double *bbox, vtkIdList *cells) override;
+
+  /**
+   * Return the sorted list of unique cell ids whose bounds, expanded by
+   * tolerance, intersect the segment (p1, p2). The cells are obtained column
+   * by column from the segment's crossings with the x = xs[i] lines.
+   */
+  void FindCellsAlongLine(double p1[3], double p2[3],
+                          double tolerance, vtkIdList *cells) override;
+
+  //@{
+  /**
+   * Write the search structure of the built locator to a file, or read it
+   * back instead of building the locator. ReadLocator requires the data set
+   * to be set and fails if the file was written for another grid (see
+   * LocatorFile). Return 1 on success and 0 otherwise.
+   */
+  int WriteLocator(const char *filename);
+  int ReadLocator(const char *filename);
+  //@}
+
+  //@{
+  /**
+   * Satisfy vtkLocator abstract interface.
+   */
+  void FreeSearchStructure() override;
+  void BuildLocator() override;
+  void GenerateRepresentation(int level, vtkPolyData *pd) override;
+  //@}
+
+protected:
+  mvtkRectilinearCellLocator();
+  ~mvtkRectilinearCellLocator() override;
+
+  int FindInterval(double x, int dim);
+  int FindIntervalRange(double xmin, double xmax, int dim, int range[2]);
+  vtkIdType GetCellId(int i, int j)
+  { return this->CellIndex[i + this->NumberOfDivisions[0]*j]; }
+
+  std::vector<double> Coords[2]; // grid lines along x and y, increasing
+  int Uniform[2]; // whether the grid lines are equally spaced
+  int NumberOfDivisions[2]; // number of cells along x and y
+  std::vector<vtkIdType> CellIndex; // cell id of each (i, j) slot, -1 if none
+
+private:
+  mvtkRectilinearCellLocator(const mvtkRectilinearCellLocator&) = delete;
+  void operator=(const mvtkRectilinearCellLocator&) = delete;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "mntRegridEdges3d.h"
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#undef NDEBUG // turn on asserts
+#include <cassert>
+
+/**
+ * Create the vertices of a uniform hexahedral grid, 8 vertices per cell
+ * @param n number of cells along each direction
+ * @param xmin low corner
+ * @param xmax high corner
+ * @return flat array [x0, y0, z0, x1, y1, z1, ...]
+ */
+std::vector<double> createHexGrid(int n, double xmin, double xmax) {
+
+    // vertex offsets in VTK hexahedron order
+    const int di[] = {0, 1, 1, 0, 0, 1, 1, 0};
+    const int dj[] = {0, 0, 1, 1, 0, 0, 1, 1};
+    const int dk[] = {0, 0, 0, 0, 1, 1, 1, 1};
+
+    double h = (xmax - xmin) / double(n);
+    std::vector<double> verts;
+    for (int k = 0; k < n; ++k) {
+        for (int j = 0; j < n; ++j) {
+            for (int i = 0; i < n; ++i) {
+                for (int iv = 0; iv < 8; ++iv) {
+                    verts.push_back(xmin + h*(i + di[iv]));
+                    verts.push_back(xmin + h*(j + dj[iv]));
+                    verts.push_back(xmin + h*(k + dk[iv]));
+                }
+            }
+        }
+    }
+    return verts;
+}
+
+/**
+ * Time mnt_regridedges3d_build for increasing grid sizes. The build time per
+ * destination cell should remain roughly constant as the grids get refined
+ * (linear scaling), up to the cost of the locator queries.
+ *
+ * Usage: benchRegridEdges3d [nmax]
+ */
+int main(int argc, char** argv) {
+
+    int nmax = 8;
+    if (argc > 1) {
+        nmax = atoi(argv[1]);
+    }
+
+    std::cout << "     n  num src cells  num dst cells   build time [s]   time per dst cell [s]\n";
+    for (int n = 2; n <= nmax; n *= 2) {
+
+        // the dst grid is offset and slightly coarser than the src grid
+        std::vector<double> srcVerts = createHexGrid(n, 0.0, 1.0);
+        std::vector<double> dstVerts = createHexGrid(n - 1, 0.05, 0.95);
+        size_t numSrcCells = srcVerts.size() / 24;
+        size_t numDstCells = dstVerts.size() / 24;
+
+        RegridEdges3d_t* rg;
+        int ier = mnt_regridedges3d_new(&rg);
+        assert(ier == 0);
+        ier = mnt_regridedges3d_setSrcPointsPtr(&rg, 8, numSrcCells, &srcVerts[0]);
+        assert(ier == 0);
+        ier = mnt_regridedges3d_setDstPointsPtr(&rg, 8, numDstCells, &dstVerts[0]);
+        assert(ier == 0);
+
+        std::chrono::steady_clock::time_point tic = std::chrono::steady_clock::now();
+        ier = mnt_regridedges3d_build(&rg, 8);
+        std::chrono::steady_clock::time_point toc = std::chrono::steady_clock::now();
+        assert(ier == 0);
+        assert(rg->weights.size() > 0);
+
+        double seconds = std::chrono::duration<double>(toc - tic).count();
+        printf("%6d %14zu %14zu %16.6f %23.3e\n", n, numSrcCells, numDstCells,
+               seconds, seconds/double(numDstCells));
+
+        ier = mnt_regridedges3d_del(&rg);
+        assert(ier == 0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include <vtkUnstructuredGrid.h>
+#include <vtkPoints.h>
+#include <vtkIdList.h>
+
+/**
+ * Create a grid of nx * ny quads (nz = 0) or nx * ny * nz hexahedra, with the points
+ * duplicated in each cell
+ * @param nx number of cells along the first index
+ * @param ny number of cells along the second index
+ * @param nz number of cells along the third index, 0 for quads
+ * @param vertex function vertex(cell, node, p) setting the coordinates p of the vertex
+ *               of cell (i, j, k) at node (i + di, j + dj, k + dk), di, dj and dk being
+ *               0 or 1. The vertices are visited in VTK quad or hexahedron order
+ * @param points points of the grid (output), must outlive the grid
+ * @param xFastest whether the cells are numbered with the first index varying fastest,
+ *                 or the second (column by column)
+ * @return grid, the caller should delete it
+ */
+template <class VertexFunc>
+vtkUnstructuredGrid* createDuplicatedPointsGrid(int nx, int ny, int nz, VertexFunc vertex,
+                                                vtkPoints* points, bool xFastest=true) {
+
+    // vertex offsets in VTK quad and hexahedron order
+    const int di[] = {0, 1, 1, 0, 0, 1, 1, 0};
+    const int dj[] = {0, 0, 1, 1, 0, 0, 1, 1};
+    const int dk[] = {0, 0, 0, 0, 1, 1, 1, 1};
+    const int numVerts = (nz > 0? 8: 4);
+    const int numLayers = (nz > 0? nz: 1);
+
+    points->SetDataTypeToDouble();
+    vtkUnstructuredGrid* grid = vtkUnstructuredGrid::New();
+    grid->Allocate(nx*ny*numLayers, 1);
+    vtkIdList* ptIds = vtkIdList::New();
+    ptIds->SetNumberOfIds(numVerts);
+    for (int k = 0; k < numLayers; ++k) {
+        for (int m = 0; m < nx*ny; ++m) {
+            int cell[] = {(xFastest? m % nx: m / ny), (xFastest? m / nx: m % ny), k};
+            for (int iv = 0; iv < numVerts; ++iv) {
+                int node[] = {cell[0] + di[iv], cell[1] + dj[iv], cell[2] + dk[iv]};
+                double p[] = {0., 0., 0.};
+                vertex(cell, node, p);
+                ptIds->SetId(iv, points->InsertNextPoint(p));
+            }
+            grid->InsertNextCell(nz > 0? VTK_HEXAHEDRON: VTK_QUAD, ptIds);
+        }
+    }
+    grid->SetPoints(points);
+    ptIds->Delete();
+    return grid;
+}
@@ -0,0 +1,200 @@
+#include <mvtkAdaptiveCellLocator.h>
+#undef NDEBUG // turn on asserts
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <iostream>
+#include <vtkUnstructuredGrid.h>
+#include <vtkPoints.h>
+#include <vtkCellLocator.h>
+#include <vtkIdList.h>
+#include <vtkGenericCell.h>
+#include "duplicatedPointsGrid.h"
+
+/**
+ * Create a lon-lat grid whose latitudes cluster at the poles, with the points
+ * duplicated in each cell. The cells are sheared in longitude
+ */
+vtkUnstructuredGrid* createPolarRefinedGrid(int nx, int ny, vtkPoints* points) {
+    return createDuplicatedPointsGrid(nx, ny, 0, [nx, ny](const int*, const int* node, double p[]) {
+        double t = double(node[1])/double(ny);
+        // cubic clustering towards +-90
+        double s = 2.*t - 1.;
+        double y = 90.*(1.5*s - 0.5*s*s*s);
+        p[0] = 360.*double(node[0])/double(nx) + 0.1*y;
+        p[1] = y;
+    }, points);
+}
+
+/**
+ * Create nx * ny * nz hexahedra over [0, 1]^3, refined towards x = 0
+ */
+vtkUnstructuredGrid* createRefinedHexGrid(int nx, int ny, int nz, vtkPoints* points) {
+    const int di[] = {0, 1, 1, 0, 0, 1, 1, 0};
+    const int dj[] = {0, 0, 1, 1, 0, 0, 1, 1};
+    const int dk[] = {0, 0, 0, 0, 1, 1, 1, 1};
+    points->SetDataTypeToDouble();
+    vtkUnstructuredGrid* grid = vtkUnstructuredGrid::New();
+    grid->Allocate(nx*ny*nz, 1);
+    vtkIdList* ptIds = vtkIdList::New();
+    ptIds->SetNumberOfIds(8);
+    for (int k = 0; k < nz; ++k) {
+        for (int j = 0; j < ny; ++j) {
+            for (int i = 0; i < nx; ++i) {
+                for (int iv = 0; iv < 8; ++iv) {
+                    double x = double(i + di[iv])/double(nx);
+                    ptIds->SetId(iv, points->InsertNextPoint(x*x*x,
+                                                             double(j + dj[iv])/double(ny),
+                                                             double(k + dk[iv])/double(nz)));
+                }
+                grid->InsertNextCell(VTK_HEXAHEDRON, ptIds);
+            }
+        }
+    }
+    grid->SetPoints(points);
+    ptIds->Delete();
+    return grid;
+}
+
+std::vector<vtkIdType> toVector(vtkIdList* ids) {
+    std::vector<vtkIdType> res;
+    for (vtkIdType i = 0; i < ids->GetNumberOfIds(); ++i) {
+        res.push_back(ids->GetId(i));
+    }
+    return res;
+}
+
+/**
+ * Cells whose bounds, expanded by tol, intersect segment p1-p2
+ */
+std::vector<vtkIdType> bruteForceAlongLine(vtkUnstructuredGrid* grid, const double p1[],
+                                           const double p2[], double tol) {
+    std::vector<vtkIdType> res;
+    double b[6];
+    for (vtkIdType cellId = 0; cellId < grid->GetNumberOfCells(); ++cellId) {
+        grid->GetCellBounds(cellId, b);
+        double ta = 0., tb = 1.;
+        for (int d = 0; d < 3; ++d) {
+            double dir = p2[d] - p1[d];
+            if (dir == 0.) {
+                if (p1[d] < b[2*d] - tol || p1[d] > b[2*d + 1] + tol) {
+                    ta = 2.;
+                }
+                continue;
+            }
+            double t0 = (b[2*d] - tol - p1[d])/dir;
+            double t1 = (b[2*d + 1] + tol - p1[d])/dir;
+            ta = std::max(ta, std::min(t0, t1));
+            tb = std::min(tb, std::max(t0, t1));
+        }
+        if (ta <= tb) {
+            res.push_back(cellId);
+        }
+    }
+    return res;
+}
+
+void testGrid(vtkUnstructuredGrid* grid, int numCellsPerBucket) {
+
+    mvtkAdaptiveCellLocator* loc = mvtkAdaptiveCellLocator::New();
+    loc->SetDataSet(grid);
+    loc->SetNumberOfCellsPerBucket(numCellsPerBucket);
+    loc->BuildLocator();
+    std::cout << "testGrid: num cells = " << grid->GetNumberOfCells()
+              << " num nodes = " << loc->GetNumberOfNodes()
+              << " depth = " << loc->GetLevel()
+              << " max cells in leaf = " << loc->GetMaxNumberOfCellsInLeaf() << std::endl;
+    assert(loc->GetMaxNumberOfCellsInLeaf() <= numCellsPerBucket);
+
+    vtkCellLocator* ref = vtkCellLocator::New();
+    ref->SetDataSet(grid);
+    ref->SetNumberOfCellsPerBucket(numCellsPerBucket);
+    ref->BuildLocator();
+
+    // same cells and parametric coordinates as vtkCellLocator, including on the
+    // cell faces and outside the grid
+    const double* bounds = grid->GetBounds();
+    vtkGenericCell* cell = vtkGenericCell::New();
+    double pcoords[3], weights[8], pcoordsRef[3], weightsRef[8];
+    double eps = 1.e-15;
+    int numFound = 0;
+    const int n = 37;
+    int nz = (bounds[5] > bounds[4]? n: 0);
+    for (int k = 0; k <= nz; ++k) {
+        for (int j = -1; j <= n + 1; ++j) {
+            for (int i = -1; i <= n + 1; ++i) {
+                double x[] = {bounds[0] + (bounds[1] - bounds[0])*i/double(n),
+                              bounds[2] + (bounds[3] - bounds[2])*j/double(n),
+                              bounds[4] + (bounds[5] - bounds[4])*k/double(n > 0? n: 1)};
+                vtkIdType cellId = loc->FindCell(x, eps, cell, pcoords, weights);
+                vtkIdType cellIdRef = ref->FindCell(x, eps, cell, pcoordsRef, weightsRef);
+                assert(cellId == cellIdRef);
+                if (cellId < 0) continue;
+                numFound++;
+                for (int d = 0; d < 3; ++d) {
+                    assert(std::abs(pcoords[d] - pcoordsRef[d]) < 1.e-12);
+                }
+            }
+        }
+    }
+    std::cout << "testGrid: found " << numFound << " points" << std::endl;
+    assert(numFound > 0);
+
+    // lines
+    vtkIdList* cellIds = vtkIdList::New();
+    double lx = bounds[1] - bounds[0], ly = bounds[3] - bounds[2], lz = bounds[5] - bounds[4];
+    const double lines[][6] = {{0.1, 0.1, 0.2, 0.9, 0.8, 0.7},
+                               {-0.1, 0.5, 0.5, 1.1, 0.5, 0.5},
+                               {0.01, 0.99, 0.3, 0.01, 0.01, 0.3},
+                               {0.3, 0.3, 0.3, 0.3, 0.3, 0.3}};
+    double tol = 1.e-3;
+    for (size_t m = 0; m < sizeof(lines)/sizeof(lines[0]); ++m) {
+        double p1[] = {bounds[0] + lx*lines[m][0], bounds[2] + ly*lines[m][1],
+                       bounds[4] + lz*lines[m][2]};
+        double p2[] = {bounds[0] + lx*lines[m][3], bounds[2] + ly*lines[m][4],
+                       bounds[4] + lz*lines[m][5]};
+        loc->FindCellsAlongLine(p1, p2, tol, cellIds);
+        assert(toVector(cellIds) == bruteForceAlongLine((vtkUnstructuredGrid*) grid, p1, p2, tol));
+    }
+
+    // box
+    double bbox[] = {bounds[0] + 0.2*lx, bounds[0] + 0.3*lx,
+                     bounds[2] + 0.1*ly, bounds[2] + 0.6*ly,
+                     bounds[4], bounds[4] + 0.5*lz};
+    loc->FindCellsWithinBounds(bbox, cellIds);
+    std::vector<vtkIdType> expected;
+    double b[6];
+    for (vtkIdType cellId = 0; cellId < grid->GetNumberOfCells(); ++cellId) {
+        grid->GetCellBounds(cellId, b);
+        if (b[1] >= bbox[0] && b[0] <= bbox[1] && b[3] >= bbox[2] && b[2] <= bbox[3] &&
+            b[5] >= bbox[4] && b[4] <= bbox[5]) {
+            expected.push_back(cellId);
+        }
+    }
+    assert(toVector(cellIds) == expected);
+
+    cellIds->Delete();
+    cell->Delete();
+    ref->Delete();
+    loc->Delete();
+}
+
+
+int main(int argc, char** argv) {
+
+    vtkPoints* points = vtkPoints::New();
+    vtkUnstructuredGrid* grid = createPolarRefinedGrid(36, 40, points);
+    testGrid(grid, 8);
+    testGrid(grid, 1);
+    grid->Delete();
+    points->Delete();
+
+    points = vtkPoints::New();
+    grid = createRefinedHexGrid(12, 5, 4, points);
+    testGrid(grid, 4);
+    grid->Delete();
+    points->Delete();
+
+    return 0;
+}
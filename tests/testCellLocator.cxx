@@ -1,6 +1,11 @@
 #include <mntCellLocator.h>
+#include <mntLocatorFile.h>
 #include <cassert>
 #undef NDEBUG // turn on asserts
+#include <cmath>
+#include <vector>
+#include <string>
+#include <cstdio>
 
 void test1Quad() {
     CellLocator_t* cloc;
@@ -60,11 +65,312 @@ void test1Hex() {
     mnt_celllocator_del(&cloc);
 }
 
+/**
+ * Sheared grid of nx * ny quads, x is shifted by shear * y
+ */
+std::vector<double> createShearedGridVerts(int nx, int ny, double shear) {
+    std::vector<double> verts;
+    for (int j = 0; j < ny; ++j) {
+        for (int i = 0; i < nx; ++i) {
+            const int di[] = {0, 1, 1, 0};
+            const int dj[] = {0, 0, 1, 1};
+            for (int k = 0; k < 4; ++k) {
+                double y = double(j + dj[k]);
+                verts.push_back(double(i + di[k]) + shear*y);
+                verts.push_back(y);
+                verts.push_back(0.);
+            }
+        }
+    }
+    return verts;
+}
+
+void testBatch(int numThreads) {
+    CellLocator_t* cloc;
+    mnt_celllocator_new(&cloc);
+    mnt_celllocator_setNumberOfThreads(&cloc, numThreads);
+
+    const int nx = 20, ny = 10;
+    std::vector<double> verts = createShearedGridVerts(nx, ny, 0.3);
+    mnt_celllocator_setPointsPtr(&cloc, 4, nx*ny, &verts[0]);
+    mnt_celllocator_build(&cloc, 8);
+
+    // the last point is outside the grid
+    const size_t npoints = 1001;
+    std::vector<double> points(3*npoints);
+    for (size_t i = 0; i < npoints; ++i) {
+        points[3*i + 0] = 0.5 + 18.*std::fabs(std::sin(1.3*i));
+        points[3*i + 1] = 9.5*std::fabs(std::cos(0.7*i));
+        points[3*i + 2] = 0.;
+        points[3*i + 0] += 0.3*points[3*i + 1];
+    }
+    points[3*(npoints - 1) + 0] = -10.;
+
+    std::vector<long long> cellIds(npoints);
+    std::vector<double> pcoords(3*npoints);
+    int ier = mnt_celllocator_findBatch(&cloc, npoints, &points[0], &cellIds[0], &pcoords[0]);
+    assert(ier == 0);
+
+    // same as one point at a time
+    for (size_t i = 0; i < npoints; ++i) {
+        long long cellId;
+        double pc[3];
+        mnt_celllocator_find(&cloc, &points[3*i], &cellId, pc);
+        assert(cellId == cellIds[i]);
+        if (cellId >= 0) {
+            for (size_t d = 0; d < 2; ++d) assert(pc[d] == pcoords[3*i + d]);
+        }
+    }
+    assert(cellIds[npoints - 1] < 0);
+
+    // back to the points
+    std::vector<double> interpPoints(3*npoints, 0.);
+    ier = mnt_celllocator_interpPointBatch(&cloc, npoints, &cellIds[0], &pcoords[0], &interpPoints[0]);
+    assert(ier == 1); // one point was not found
+    double error = 0;
+    for (size_t i = 0; i < npoints - 1; ++i) {
+        for (size_t d = 0; d < 3; ++d) {
+            error += std::fabs(interpPoints[3*i + d] - points[3*i + d]);
+        }
+    }
+    std::cout << "testBatch: num threads = " << numThreads << " interpolation error = " << error << '\n';
+    assert(error < 1.e-10);
+
+    mnt_celllocator_del(&cloc);
+}
+
+/**
+ * Check that the hint does not change the result
+ * @param locType locator type, the hint search tests the cells as the "octree" and 
+ *                "bins2d" buckets do and finds the same cell with the same parametric
+ *                coordinates. Other locators may find another cell sharing the point
+ */
+void testFindWithHint(const std::string& locType) {
+    CellLocator_t* cloc;
+    mnt_celllocator_new(&cloc);
+
+    const int nx = 20, ny = 10;
+    std::vector<double> verts = createShearedGridVerts(nx, ny, 0.3);
+    mnt_celllocator_setPointsPtr(&cloc, 4, nx*ny, &verts[0]);
+    mnt_celllocator_setLocatorType(&cloc, locType.c_str(), locType.size());
+    mnt_celllocator_build(&cloc, 8);
+    bool exact = (locType == "octree" || locType == "bins2d");
+
+    // points along a trajectory, passing through grid vertices and along 
+    // cell edges, then leaving the grid
+    const int npoints = 400;
+    long long hintCellId = -1;
+    int numSame = 0;
+    for (int i = 0; i < npoints; ++i) {
+        double y = 0.025*i;
+        double x = 1. + 0.3*y + 0.05*i;
+        const double point[] = {x, y, 0.};
+
+        long long cellId, cellIdHint;
+        double pcoords[3], pcoordsHint[3];
+        mnt_celllocator_find(&cloc, point, &cellId, pcoords);
+
+        // the previous cell, the same cell, a far away cell and no hint give the
+        // same result as without hint
+        const long long hints[] = {hintCellId, cellId, 0, nx*ny - 1, -1};
+        for (size_t k = 0; k < sizeof(hints)/sizeof(hints[0]); ++k) {
+            mnt_celllocator_findWithHint(&cloc, point, hints[k], &cellIdHint, pcoordsHint);
+            if (exact) {
+                assert(cellIdHint == cellId);
+                if (cellId >= 0) {
+                    for (size_t d = 0; d < 2; ++d) assert(pcoordsHint[d] == pcoords[d]);
+                }
+            }
+            else {
+                assert((cellIdHint >= 0) == (cellId >= 0));
+                if (cellId >= 0 && cellIdHint == cellId) {
+                    for (size_t d = 0; d < 2; ++d) assert(std::abs(pcoordsHint[d] - pcoords[d]) < 1.e-10);
+                }
+            }
+        }
+        numSame += (cellId == hintCellId? 1: 0);
+        hintCellId = cellId;
+    }
+    std::cout << "testFindWithHint: " << locType << " locator, " << numSame << " points out of " << npoints 
+              << " in the previous point's cell\n";
+
+    mnt_celllocator_del(&cloc);
+}
+
+void testSaveLoadLocator(double shear) {
+
+    const int nx = 20, ny = 10;
+    std::vector<double> verts = createShearedGridVerts(nx, ny, shear);
+    const std::string filename = "testSaveLoadLocator.bin";
+
+    // the default vtkCellLocator cannot be saved
+    CellLocator_t* cloc;
+    mnt_celllocator_new(&cloc);
+    mnt_celllocator_setPointsPtr(&cloc, 4, nx*ny, &verts[0]);
+    mnt_celllocator_build(&cloc, 8);
+    int ier = mnt_celllocator_saveLocator(&cloc, filename.c_str(), filename.size());
+    assert(ier != 0);
+    const std::string badType = "kdtree";
+    ier = mnt_celllocator_setLocatorType(&cloc, badType.c_str(), badType.size());
+    assert(ier != 0);
+    const std::string locType = "auto";
+    ier = mnt_celllocator_setLocatorType(&cloc, locType.c_str(), locType.size());
+    assert(ier == 0);
+    mnt_celllocator_build(&cloc, 8);
+    ier = mnt_celllocator_saveLocator(&cloc, filename.c_str(), filename.size());
+    assert(ier == 0);
+
+    // same grid, different vertex array
+    std::vector<double> verts2 = verts;
+    CellLocator_t* cloc2;
+    mnt_celllocator_new(&cloc2);
+    mnt_celllocator_setPointsPtr(&cloc2, 4, nx*ny, &verts2[0]);
+    ier = mnt_celllocator_loadLocator(&cloc2, filename.c_str(), filename.size());
+    assert(ier == 0);
+
+    for (int j = -2; j <= 4*ny + 2; ++j) {
+        for (int i = -2; i <= 4*nx + 10; ++i) {
+            const double point[] = {0.25*i + 0.01, 0.25*j + 0.02, 0.};
+            long long cellId, cellId2;
+            double pcoords[3], pcoords2[3];
+            mnt_celllocator_find(&cloc, point, &cellId, pcoords);
+            mnt_celllocator_find(&cloc2, point, &cellId2, pcoords2);
+            assert(cellId2 == cellId);
+            if (cellId >= 0) {
+                for (size_t d = 0; d < 2; ++d) assert(pcoords2[d] == pcoords[d]);
+            }
+        }
+    }
+
+    // the file does not apply to a modified grid, nor does a missing file
+    verts2[3*17 + 1] += 0.01;
+    CellLocator_t* cloc3;
+    mnt_celllocator_new(&cloc3);
+    mnt_celllocator_setPointsPtr(&cloc3, 4, nx*ny, &verts2[0]);
+    ier = mnt_celllocator_loadLocator(&cloc3, filename.c_str(), filename.size());
+    assert(ier != 0);
+    const std::string missing = "testSaveLoadLocator_missing.bin";
+    ier = mnt_celllocator_loadLocator(&cloc3, missing.c_str(), missing.size());
+    assert(ier != 0);
+    std::cout << "testSaveLoadLocator: shear = " << shear << " OK\n";
+
+    mnt_celllocator_del(&cloc3);
+    mnt_celllocator_del(&cloc2);
+    mnt_celllocator_del(&cloc);
+}
+
+/**
+ * Grid of nx * ny * nz hexahedra, x is shifted by shear * (y + z)
+ */
+std::vector<double> createShearedHexGridVerts(int nx, int ny, int nz, double shear) {
+    std::vector<double> verts;
+    for (int k = 0; k < nz; ++k) {
+        for (int j = 0; j < ny; ++j) {
+            for (int i = 0; i < nx; ++i) {
+                const int di[] = {0, 1, 1, 0, 0, 1, 1, 0};
+                const int dj[] = {0, 0, 1, 1, 0, 0, 1, 1};
+                const int dk[] = {0, 0, 0, 0, 1, 1, 1, 1};
+                for (int v = 0; v < 8; ++v) {
+                    double y = double(j + dj[v]);
+                    double z = double(k + dk[v]);
+                    verts.push_back(double(i + di[v]) + shear*(y + z));
+                    verts.push_back(y);
+                    verts.push_back(z);
+                }
+            }
+        }
+    }
+    return verts;
+}
+
+/**
+ * Build locators through a cache file and check that the file is reused for the same
+ * number of cells per bucket and replaced for another
+ * @param nz number of layers of hexahedra, 0 for a quad grid
+ */
+void testLocatorCacheFile(int nz, const std::string& expectedKind) {
+
+    const int nx = 20, ny = 10;
+    const int numVertsPerCell = (nz > 0? 8: 4);
+    const int ncells = nx*ny*(nz > 0? nz: 1);
+    std::vector<double> verts = (nz > 0? createShearedHexGridVerts(nx, ny, nz, 0.3):
+                                         createShearedGridVerts(nx, ny, 0.3));
+    const std::string filename = "testLocatorCacheFile.bin";
+    std::remove(filename.c_str());
+
+    // no file yet, the locator is built and saved
+    CellLocator_t* cloc;
+    mnt_celllocator_new(&cloc);
+    mnt_celllocator_setPointsPtr(&cloc, numVertsPerCell, ncells, &verts[0]);
+    mnt_celllocator_setLocatorCacheFile(&cloc, filename.c_str(), filename.size());
+    int ier = mnt_celllocator_build(&cloc, 8);
+    assert(ier == 0);
+    std::string kind;
+    int numCellsPerBucket;
+    ier = LocatorFile::getKind(filename.c_str(), kind, &numCellsPerBucket);
+    assert(ier == 0);
+    assert(kind == expectedKind);
+    assert(numCellsPerBucket == 8);
+
+    // the file is loaded
+    CellLocator_t* cloc2;
+    mnt_celllocator_new(&cloc2);
+    mnt_celllocator_setPointsPtr(&cloc2, numVertsPerCell, ncells, &verts[0]);
+    mnt_celllocator_setLocatorCacheFile(&cloc2, filename.c_str(), filename.size());
+    ier = mnt_celllocator_build(&cloc2, 8);
+    assert(ier == 0);
+
+    int numFound = 0;
+    for (int k = (nz > 0? -1: 0); k <= (nz > 0? 2*nz + 1: 0); ++k) {
+        for (int j = -1; j <= 2*ny + 1; ++j) {
+            for (int i = -1; i <= 2*nx + 8; ++i) {
+                const double point[] = {0.5*i + 0.01, 0.5*j + 0.02, (nz > 0? 0.5*k + 0.03: 0.)};
+                long long cellId, cellId2;
+                double pcoords[3], pcoords2[3];
+                mnt_celllocator_find(&cloc, point, &cellId, pcoords);
+                mnt_celllocator_find(&cloc2, point, &cellId2, pcoords2);
+                assert(cellId2 == cellId);
+                if (cellId >= 0) {
+                    for (size_t d = 0; d < 3; ++d) assert(pcoords2[d] == pcoords[d]);
+                    numFound++;
+                }
+            }
+        }
+    }
+    assert(numFound > 0);
+
+    // a file built with another number of cells per bucket is replaced, except by 
+    // the analytic locators which do not use buckets
+    CellLocator_t* cloc3;
+    mnt_celllocator_new(&cloc3);
+    mnt_celllocator_setPointsPtr(&cloc3, numVertsPerCell, ncells, &verts[0]);
+    mnt_celllocator_setLocatorCacheFile(&cloc3, filename.c_str(), filename.size());
+    ier = mnt_celllocator_build(&cloc3, 3);
+    assert(ier == 0);
+    ier = LocatorFile::getKind(filename.c_str(), kind, &numCellsPerBucket);
+    assert(ier == 0);
+    assert(kind == expectedKind);
+    assert(numCellsPerBucket == 3);
+    std::cout << "testLocatorCacheFile: " << kind << " OK, " << numFound << " points found\n";
+
+    mnt_celllocator_del(&cloc3);
+    mnt_celllocator_del(&cloc2);
+    mnt_celllocator_del(&cloc);
+}
 
 int main(int argc, char** argv) {
 
     test1Quad();
     test1Hex();
+    testBatch(1);
+    testBatch(3);
+    testFindWithHint("bins2d");
+    testFindWithHint("octree");
+    testFindWithHint("vtk");
+    testSaveLoadLocator(0.3); // 2d buckets
+    testSaveLoadLocator(0.0); // rectilinear
+    testLocatorCacheFile(0, "mvtkCellLocator2d");
+    testLocatorCacheFile(2, "mvtkCellLocator");
 
     return 0;
 }
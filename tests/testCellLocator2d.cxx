@@ -0,0 +1,190 @@
+#include <mvtkCellLocator2d.h>
+#undef NDEBUG // turn on asserts
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <iostream>
+#include <vtkUnstructuredGrid.h>
+#include <vtkPoints.h>
+#include <vtkCellLocator.h>
+#include <vtkIdList.h>
+#include <vtkGenericCell.h>
+#include "duplicatedPointsGrid.h"
+
+/**
+ * Create a lon-lat grid of nx * ny quads, with the points duplicated in each cell. The
+ * top vertices of each cell are raised to z
+ */
+vtkUnstructuredGrid* createGrid(int nx, int ny, vtkPoints* points, double z) {
+    return createDuplicatedPointsGrid(nx, ny, 0, [nx, ny, z](const int* cell, const int* node, double p[]) {
+        p[0] = 0. + 360.*double(node[0])/double(nx);
+        p[1] = -90. + 180.*double(node[1])/double(ny);
+        p[2] = (node[1] > cell[1]? z: 0.);
+    }, points);
+}
+
+/**
+ * Cells whose bounds, expanded by tol, intersect segment p1-p2
+ */
+std::vector<vtkIdType> bruteForceAlongLine(vtkUnstructuredGrid* grid, const double p1[],
+                                           const double p2[], double tol) {
+    std::vector<vtkIdType> res;
+    double b[6];
+    for (vtkIdType cellId = 0; cellId < grid->GetNumberOfCells(); ++cellId) {
+        grid->GetCellBounds(cellId, b);
+        double ta = 0., tb = 1.;
+        for (int d = 0; d < 2; ++d) {
+            double dir = p2[d] - p1[d];
+            if (dir == 0.) {
+                if (p1[d] < b[2*d] - tol || p1[d] > b[2*d + 1] + tol) {
+                    ta = 2.;
+                }
+                continue;
+            }
+            double t0 = (b[2*d] - tol - p1[d])/dir;
+            double t1 = (b[2*d + 1] + tol - p1[d])/dir;
+            ta = std::max(ta, std::min(t0, t1));
+            tb = std::min(tb, std::max(t0, t1));
+        }
+        if (ta <= tb) {
+            res.push_back(cellId);
+        }
+    }
+    return res;
+}
+
+std::vector<vtkIdType> toVector(vtkIdList* ids) {
+    std::vector<vtkIdType> res;
+    for (vtkIdType i = 0; i < ids->GetNumberOfIds(); ++i) {
+        res.push_back(ids->GetId(i));
+    }
+    return res;
+}
+
+void testBucketSize(int numCellsPerBucket) {
+
+    vtkPoints* points = vtkPoints::New();
+    vtkUnstructuredGrid* grid = createGrid(72, 36, points, 0.);
+    assert(mvtkCellLocator2d::IsPlanarQuadGrid(grid) == 1);
+
+    mvtkCellLocator2d* loc = mvtkCellLocator2d::New();
+    loc->SetDataSet(grid);
+    loc->SetNumberOfCellsPerBucket(numCellsPerBucket);
+    loc->BuildLocator();
+
+    // average and max number of cells per bucket
+    int divs[2];
+    loc->GetNumberOfDivisions(divs);
+    vtkIdType maxCells = 0, totCells = 0;
+    for (int bucket = 0; bucket < loc->GetNumberOfBuckets(); ++bucket) {
+        const vtkIdType* cellIds;
+        vtkIdType n = loc->GetBucketCells(bucket, &cellIds);
+        maxCells = std::max(maxCells, n);
+        totCells += n;
+    }
+    double avgCells = double(totCells)/double(loc->GetNumberOfBuckets());
+    std::cout << "testBucketSize: num cells per bucket = " << numCellsPerBucket
+              << " divisions = " << divs[0] << " x " << divs[1]
+              << " avg/max num cells = " << avgCells << '/' << maxCells << std::endl;
+    // same aspect ratio as the domain, up to rounding
+    assert(std::abs(divs[0] - 2*divs[1]) <= 1);
+    // cells touching a bucket boundary belong to both buckets, a bucket of
+    // n x n cells holds (n + 1)^2 cells at most
+    double n = std::sqrt(double(numCellsPerBucket));
+    assert(avgCells >= numCellsPerBucket && avgCells <= 1.1*(n + 1)*(n + 1));
+
+    loc->Delete();
+    grid->Delete();
+    points->Delete();
+}
+
+void testQueries() {
+
+    vtkPoints* points = vtkPoints::New();
+    vtkUnstructuredGrid* grid = createGrid(40, 20, points, 0.);
+
+    mvtkCellLocator2d* loc = mvtkCellLocator2d::New();
+    loc->SetDataSet(grid);
+    loc->SetNumberOfCellsPerBucket(7);
+    loc->BuildLocator();
+
+    vtkCellLocator* ref = vtkCellLocator::New();
+    ref->SetDataSet(grid);
+    ref->SetNumberOfCellsPerBucket(7);
+    ref->BuildLocator();
+
+    // points inside, on cell edges and on the boundary
+    vtkGenericCell* cell = vtkGenericCell::New();
+    double pcoords[3], weights[8];
+    double eps = 1.e-15;
+    for (int j = 0; j <= 40; ++j) {
+        for (int i = 0; i <= 80; ++i) {
+            double x[] = {360.*i/80., -90. + 180.*j/40., 0.};
+            vtkIdType cellId = loc->FindCell(x, eps, cell, pcoords, weights);
+            assert(cellId >= 0);
+            assert(cellId == ref->FindCell(x, eps, cell, pcoords, weights));
+        }
+    }
+    double xOut[] = {361., 0., 0.};
+    assert(loc->FindCell(xOut, eps, cell, pcoords, weights) < 0);
+
+    // lines: diagonal, reversed, along cell edges, degenerate, partially outside
+    const double lines[][4] = {{1., -89., 359., 89.},
+                               {359., 89., 1., -89.},
+                               {0., 0., 360., 0.},
+                               {45., -90., 45., 90.},
+                               {100., 10., 100., 10.},
+                               {-20., -100., 200., 30.},
+                               {400., 0., 500., 0.},
+                               {17.3, 60.1, 301.9, -44.7}};
+    vtkIdList* cellIds = vtkIdList::New();
+    double tol = 1.e-3;
+    for (size_t k = 0; k < sizeof(lines)/sizeof(lines[0]); ++k) {
+        double p1[] = {lines[k][0], lines[k][1], 0.};
+        double p2[] = {lines[k][2], lines[k][3], 0.};
+        loc->FindCellsAlongLine(p1, p2, tol, cellIds);
+        std::vector<vtkIdType> expected = bruteForceAlongLine(grid, p1, p2, tol);
+        std::cout << "testQueries: line " << k << " num cells = " << cellIds->GetNumberOfIds() << '\n';
+        assert(toVector(cellIds) == expected);
+    }
+
+    // box query
+    double bbox[] = {10., 50., -20., 5., 0., 0.};
+    loc->FindCellsWithinBounds(bbox, cellIds);
+    std::vector<vtkIdType> expected;
+    double b[6];
+    for (vtkIdType cellId = 0; cellId < grid->GetNumberOfCells(); ++cellId) {
+        grid->GetCellBounds(cellId, b);
+        if (b[1] >= bbox[0] && b[0] <= bbox[1] && b[3] >= bbox[2] && b[2] <= bbox[3]) {
+            expected.push_back(cellId);
+        }
+    }
+    assert(toVector(cellIds) == expected);
+
+    cellIds->Delete();
+    cell->Delete();
+    ref->Delete();
+    loc->Delete();
+    grid->Delete();
+    points->Delete();
+}
+
+void testNotPlanar() {
+    vtkPoints* points = vtkPoints::New();
+    vtkUnstructuredGrid* grid = createGrid(4, 2, points, 1.);
+    assert(mvtkCellLocator2d::IsPlanarQuadGrid(grid) == 0);
+    grid->Delete();
+    points->Delete();
+}
+
+int main(int argc, char** argv) {
+
+    testBucketSize(1);
+    testBucketSize(16);
+    testBucketSize(100);
+    testQueries();
+    testNotPlanar();
+
+    return 0;
+}
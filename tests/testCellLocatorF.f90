@@ -2,7 +2,7 @@ program test
     ! defines the C API
     use mnt_celllocator_capi_mod
 
-    use, intrinsic :: iso_c_binding, only: c_size_t, c_int, c_double, c_ptr
+    use, intrinsic :: iso_c_binding, only: c_size_t, c_int, c_long_long, c_double, c_ptr
 
     implicit none
     type(c_ptr)                  :: cloc 
@@ -13,6 +13,10 @@ program test
     real(c_double), allocatable  :: target_point(:) 
     real(c_double)               :: interp_point(3)
     real(c_double)               :: pcoords(3)
+    integer(c_size_t), parameter :: num_batch = 2
+    real(c_double)               :: batch_points(3*num_batch), batch_pcoords(3*num_batch)
+    real(c_double)               :: batch_interp_points(3*num_batch)
+    integer(c_long_long)         :: batch_cell_ids(num_batch)
     real(c_double)       :: diff2
     integer(c_int)       :: ier, num_cells_per_bucket
     integer(c_size_t)    :: cell_id
@@ -48,6 +52,19 @@ program test
     print *,'distance square error = ', diff2
     deallocate(target_point)
 
+    ! several points at once
+    ier = mnt_celllocator_setNumberOfThreads(cloc, 2)
+    if(ier /= 0) print*,'ERROR ier = after setnumberofthreads', ier
+    batch_points = [0.2_c_double, 0.3_c_double, 0.4_c_double, &
+                    0.9_c_double, 0.1_c_double, 0.5_c_double]
+    ier = mnt_celllocator_findBatch(cloc, num_batch, batch_points, batch_cell_ids, batch_pcoords)
+    if(ier /= 0) print*,'ERROR ier = after findbatch', ier
+    ier = mnt_celllocator_interpPointBatch(cloc, num_batch, batch_cell_ids, batch_pcoords, &
+                                           batch_interp_points)
+    if(ier /= 0) print*,'ERROR ier = after interppointbatch', ier
+    diff2 = dot_product(batch_interp_points - batch_points, batch_interp_points - batch_points)
+    print *,'batch distance square error = ', diff2
+
     ier = mnt_celllocator_del(cloc)
     if(ier /= 0) print*,'ERROR after del ier = ', ier
 
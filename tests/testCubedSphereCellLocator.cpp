@@ -0,0 +1,235 @@
+#include <mvtkCubedSphereCellLocator.h>
+#include <mntGrid.h>
+#undef NDEBUG // turn on asserts
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <iostream>
+#include <vtkUnstructuredGrid.h>
+#include <vtkPoints.h>
+#include <vtkCellLocator.h>
+#include <vtkIdList.h>
+#include <vtkGenericCell.h>
+
+std::vector<vtkIdType> toVector(vtkIdList* ids) {
+    std::vector<vtkIdType> res;
+    for (vtkIdType i = 0; i < ids->GetNumberOfIds(); ++i) {
+        res.push_back(ids->GetId(i));
+    }
+    return res;
+}
+
+void testGrid(vtkUnstructuredGrid* grid, int n) {
+
+    mvtkCubedSphereCellLocator* loc = mvtkCubedSphereCellLocator::New();
+    loc->SetDataSet(grid);
+    loc->BuildLocator();
+    std::cout << "testGrid: cubed-sphere = " << loc->IsCubedSphere()
+              << " N = " << loc->GetNumberOfPanelDivisions()
+              << " equiangular = " << loc->GetEquiangular() << std::endl;
+    assert(loc->IsCubedSphere() == 1);
+    assert(loc->GetNumberOfPanelDivisions() == n);
+
+    vtkCellLocator* ref = vtkCellLocator::New();
+    ref->SetDataSet(grid);
+    ref->SetNumberOfCellsPerBucket(8);
+    ref->BuildLocator();
+
+    // points spread over the grid's bounds, including the poles
+    const double* bounds = grid->GetBounds();
+    vtkGenericCell* cell = vtkGenericCell::New();
+    double pcoords[3], weights[8], pcoordsRef[3], weightsRef[8];
+    double eps = 1.e-15;
+    int numFound = 0;
+    const int nx = 211, ny = 97;
+    for (int j = 0; j <= ny; ++j) {
+        for (int i = 0; i <= nx; ++i) {
+            double x[] = {bounds[0] + (bounds[1] - bounds[0])*i/double(nx),
+                          bounds[2] + (bounds[3] - bounds[2])*j/double(ny), 0.};
+            vtkIdType cellId = loc->FindCell(x, eps, cell, pcoords, weights);
+            vtkIdType cellIdRef = ref->FindCell(x, eps, cell, pcoordsRef, weightsRef);
+            assert(cellId == cellIdRef);
+            if (cellId < 0) continue;
+            numFound++;
+            // the quads are inverted in closed form, vtkCellLocator iterates until the
+            // Newton steps are below 1.e-4
+            for (int k = 0; k < 2; ++k) {
+                assert(std::abs(pcoords[k] - pcoordsRef[k]) < 1.e-6);
+            }
+        }
+    }
+    std::cout << "testGrid: found " << numFound << " points out of "
+              << (nx + 1)*(ny + 1) << std::endl;
+
+    // cells along lines: all the cells containing points of the line must be
+    // found, and only cells whose bounds intersect the line
+    const double lines[][4] = {{10., -80., 350., 85.},
+                               {-30., 0., 300., 0.},
+                               {45., -90., 45., 90.},
+                               {100., 89.5, 280., 89.9},
+                               {179., -35.26, 181., -35.26},
+                               {200., 10., 200., 10.}};
+    vtkIdList* cellIds = vtkIdList::New();
+    double tol = 1.e-3;
+    for (size_t k = 0; k < sizeof(lines)/sizeof(lines[0]); ++k) {
+        double p1[] = {lines[k][0], lines[k][1], 0.};
+        double p2[] = {lines[k][2], lines[k][3], 0.};
+        loc->FindCellsAlongLine(p1, p2, tol, cellIds);
+        std::vector<vtkIdType> found = toVector(cellIds);
+        std::cout << "testGrid: line " << k << " num cells = " << found.size() << std::endl;
+        assert(std::is_sorted(found.begin(), found.end()));
+        for (size_t m = 0; m < found.size(); ++m) {
+            double b[6];
+            grid->GetCellBounds(found[m], b);
+            double bbox[] = {std::min(p1[0], p2[0]) - tol, std::max(p1[0], p2[0]) + tol,
+                             std::min(p1[1], p2[1]) - tol, std::max(p1[1], p2[1]) + tol};
+            assert(b[1] >= bbox[0] && b[0] <= bbox[1] && b[3] >= bbox[2] && b[2] <= bbox[3]);
+        }
+        const int numSamples = 2000;
+        for (int m = 0; m <= numSamples; ++m) {
+            double t = m/double(numSamples);
+            double x[] = {p1[0] + t*(p2[0] - p1[0]), p1[1] + t*(p2[1] - p1[1]), 0.};
+            vtkIdType cellId = ref->FindCell(x, eps, cell, pcoordsRef, weightsRef);
+            if (cellId >= 0) {
+                assert(std::binary_search(found.begin(), found.end(), cellId));
+            }
+        }
+    }
+
+    // cells within boxes: same as checking the bounds of all the cells
+    std::vector<std::vector<double> > boxes = {{-1000., 1000., -1000., 1000.},
+                                               {10., 11., -80., -79.},
+                                               {0., 360., 85., 90.},
+                                               {40., 50., -90., -60.},
+                                               {175., 185., -5., 5.},
+                                               {200., 200., 10., 10.},
+                                               {400., 500., 0., 10.}};
+    unsigned seed = 12345;
+    for (int k = 0; k < 200; ++k) {
+        double r[4];
+        for (int m = 0; m < 4; ++m) {
+            seed = 1103515245u*seed + 12345u;
+            r[m] = (seed >> 8) / double(1 << 24);
+        }
+        double lon = bounds[0] + (bounds[1] - bounds[0])*r[0];
+        double lat = bounds[2] + (bounds[3] - bounds[2])*r[1];
+        double dlon = 40.*r[2]*r[2], dlat = 20.*r[3]*r[3];
+        boxes.push_back({lon - dlon, lon + dlon, lat - dlat, lat + dlat});
+    }
+    for (size_t k = 0; k < boxes.size(); ++k) {
+        double* bbox = &boxes[k][0];
+        loc->FindCellsWithinBounds(bbox, cellIds);
+        std::vector<vtkIdType> found = toVector(cellIds);
+        std::vector<vtkIdType> expected;
+        for (vtkIdType cellId = 0; cellId < grid->GetNumberOfCells(); ++cellId) {
+            double b[6];
+            grid->GetCellBounds(cellId, b);
+            if (b[1] >= bbox[0] && b[0] <= bbox[1] && b[3] >= bbox[2] && b[2] <= bbox[3]) {
+                expected.push_back(cellId);
+            }
+        }
+        assert(found == expected);
+    }
+    std::cout << "testGrid: cells within " << boxes.size() << " boxes OK" << std::endl;
+
+    // the locator read back from a file gives the same results
+    assert(loc->WriteLocator("testCubedSphereCellLocator.bin") == 1);
+    mvtkCubedSphereCellLocator* loc2 = mvtkCubedSphereCellLocator::New();
+    loc2->SetDataSet(grid);
+    assert(loc2->ReadLocator("testCubedSphereCellLocator.bin") == 1);
+    assert(loc2->IsCubedSphere() == 1);
+    assert(loc2->GetNumberOfPanelDivisions() == n);
+    assert(loc2->GetEquiangular() == loc->GetEquiangular());
+    for (int j = 0; j <= ny; j += 3) {
+        for (int i = 0; i <= nx; i += 3) {
+            double x[] = {bounds[0] + (bounds[1] - bounds[0])*i/double(nx),
+                          bounds[2] + (bounds[3] - bounds[2])*j/double(ny), 0.};
+            assert(loc2->FindCell(x, eps, cell, pcoords, weights) ==
+                   loc->FindCell(x, eps, cell, pcoordsRef, weightsRef));
+        }
+    }
+    double p1[] = {lines[0][0], lines[0][1], 0.};
+    double p2[] = {lines[0][2], lines[0][3], 0.};
+    loc->FindCellsAlongLine(p1, p2, tol, cellIds);
+    std::vector<vtkIdType> found = toVector(cellIds);
+    loc2->FindCellsAlongLine(p1, p2, tol, cellIds);
+    assert(toVector(cellIds) == found);
+    loc2->Delete();
+
+    cellIds->Delete();
+    cell->Delete();
+    ref->Delete();
+    loc->Delete();
+}
+
+void testNotCubedSphere() {
+
+    // lon-lat grid with 6 * 4 * 4 cells
+    vtkPoints* points = vtkPoints::New();
+    points->SetDataTypeToDouble();
+    vtkUnstructuredGrid* grid = vtkUnstructuredGrid::New();
+    vtkIdList* ptIds = vtkIdList::New();
+    ptIds->SetNumberOfIds(4);
+    const int nx = 12, ny = 8;
+    for (int j = 0; j < ny; ++j) {
+        for (int i = 0; i < nx; ++i) {
+            double x0 = 360.*i/nx, x1 = 360.*(i + 1)/nx;
+            double y0 = -90. + 180.*j/ny, y1 = -90. + 180.*(j + 1)/ny;
+            ptIds->SetId(0, points->InsertNextPoint(x0, y0, 0.));
+            ptIds->SetId(1, points->InsertNextPoint(x1, y0, 0.));
+            ptIds->SetId(2, points->InsertNextPoint(x1, y1, 0.));
+            ptIds->SetId(3, points->InsertNextPoint(x0, y1, 0.));
+            grid->InsertNextCell(VTK_QUAD, ptIds);
+        }
+    }
+    grid->SetPoints(points);
+
+    mvtkCubedSphereCellLocator* loc = mvtkCubedSphereCellLocator::New();
+    loc->SetDataSet(grid);
+    loc->BuildLocator();
+    assert(loc->IsCubedSphere() == 0);
+
+    vtkGenericCell* cell = vtkGenericCell::New();
+    double pcoords[3], weights[8];
+    double x[] = {45., 10., 0.};
+    assert(loc->FindCell(x, 1.e-15, cell, pcoords, weights) < 0);
+
+    // the locator file saved for a cubed-sphere grid does not apply
+    assert(loc->ReadLocator("testCubedSphereCellLocator.bin") == 0);
+    assert(loc->IsCubedSphere() == 0);
+
+    cell->Delete();
+    loc->Delete();
+    ptIds->Delete();
+    grid->Delete();
+    points->Delete();
+}
+
+int main(int argc, char** argv) {
+
+    Grid_t* grd;
+    vtkUnstructuredGrid* grid;
+
+    mnt_grid_new(&grd);
+    mnt_grid_load(&grd, "${CMAKE_SOURCE_DIR}/data/cs_16.vtk");
+    mnt_grid_get(&grd, &grid);
+    testGrid(grid, 16);
+    mnt_grid_del(&grd);
+
+    mnt_grid_new(&grd);
+    mnt_grid_loadFrom2DUgrid(&grd, "${CMAKE_SOURCE_DIR}/data/cs_16.nc");
+    mnt_grid_get(&grd, &grid);
+    testGrid(grid, 16);
+    mnt_grid_del(&grd);
+
+    mnt_grid_new(&grd);
+    mnt_grid_loadFrom2DUgrid(&grd, "${CMAKE_SOURCE_DIR}/data/cs_4.nc");
+    mnt_grid_get(&grd, &grid);
+    testGrid(grid, 4);
+    mnt_grid_del(&grd);
+
+    testNotCubedSphere();
+
+    return 0;
+}
@@ -113,6 +113,45 @@ void testLatLon(size_t nElv, size_t nLat, size_t nLon, const double pa[], const
       std::cout << "line intersects with cell " << cellIds->GetId(i) << '\n';
     }
 
+    // the flat bucket storage must give the same buckets as one vtkIdList per bucket
+    mvtkCellLocator* locLists = mvtkCellLocator::New();
+    locLists->SetNumberOfCellsPerBucket(1);
+    locLists->UseFlatStorageOff();
+    locLists->SetDataSet(grid);
+    locLists->BuildLocator();
+    assert(loc->GetUseFlatStorage() == 1);
+    assert(loc->GetNumberOfBuckets() == locLists->GetNumberOfBuckets());
+    vtkIdList* cellIdsLists = vtkIdList::New();
+    double bbox[] = {0.0, 1.0, -90.0, 0.0, -180.0, 180.0};
+    loc->FindCellsWithinBounds(bbox, cellIds);
+    locLists->FindCellsWithinBounds(bbox, cellIdsLists);
+    assert(cellIds->GetNumberOfIds() > 0);
+    assert(cellIdsLists->GetNumberOfIds() == cellIds->GetNumberOfIds());
+    for (vtkIdType i = 0; i < cellIds->GetNumberOfIds(); ++i) {
+        assert(cellIdsLists->GetId(i) == cellIds->GetId(i));
+    }
+    vtkGenericCell* cell = vtkGenericCell::New();
+    for (vtkIdType i = 0; i < (vtkIdType) nCells; ++i) {
+        double pcoords[3], weights[8], x[3];
+        grid->GetPoint(8*i, p);
+        grid->GetPoint(8*i + 6, x);
+        for (size_t d = 0; d < 3; ++d) {
+            x[d] = 0.5*(p[d] + x[d]);
+        }
+        assert(loc->FindCell(x, 0.0, cell, pcoords, weights) ==
+               locLists->FindCell(x, 0.0, cell, pcoords, weights));
+    }
+    cell->Delete();
+
+    loc->FindCellsAlongLine((double*) pa, (double*) pb, tol, cellIds);
+    locLists->FindCellsAlongLine((double*) pa, (double*) pb, tol, cellIdsLists);
+    assert(cellIdsLists->GetNumberOfIds() == cellIds->GetNumberOfIds());
+    for (vtkIdType i = 0; i < cellIds->GetNumberOfIds(); ++i) {
+        assert(cellIdsLists->GetId(i) == cellIds->GetId(i));
+    }
+    cellIdsLists->Delete();
+    locLists->Delete();
+
     assert(cellIds->GetNumberOfIds() == expectedNumberOfCells);
 
     // clean up
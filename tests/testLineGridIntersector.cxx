@@ -4,6 +4,8 @@
 #include <cassert>
 #include <cmath>
 #include <iostream>
+#include <vector>
+#include <algorithm>
 
 
 void test1Cell() {
@@ -214,6 +216,120 @@ void testLatLon(size_t nElv, size_t nLat, size_t nLon) {
 }
 
 
+void testHexGrid() {
+
+    std::cout << "=======  testHexGrid ===========\n";
+
+    // 3x3x3 unit cells, 8 points per cell
+    const int di[] = {0, 1, 1, 0, 0, 1, 1, 0};
+    const int dj[] = {0, 0, 1, 1, 0, 0, 1, 1};
+    const int dk[] = {0, 0, 0, 0, 1, 1, 1, 1};
+    vtkPoints* points = vtkPoints::New();
+    points->SetDataTypeToDouble();
+    vtkUnstructuredGrid* grid = vtkUnstructuredGrid::New();
+    grid->Allocate(27, 1);
+    vtkIdList* ptIds = vtkIdList::New();
+    ptIds->SetNumberOfIds(8);
+    for (int k = 0; k < 3; ++k) {
+        for (int j = 0; j < 3; ++j) {
+            for (int i = 0; i < 3; ++i) {
+                for (int iv = 0; iv < 8; ++iv) {
+                    ptIds->SetId(iv, points->InsertNextPoint(i + di[iv], j + dj[iv], k + dk[iv]));
+                }
+                grid->InsertNextCell(VTK_HEXAHEDRON, ptIds);
+            }
+        }
+    }
+    grid->SetPoints(points);
+
+    vtkCellLocator* loc = vtkCellLocator::New();
+    loc->SetDataSet(grid);
+    loc->BuildLocator();
+
+    // oblique line crossing 2 planes in each direction
+    const double pa[] = {0.1, 0.2, 0.3};
+    const double pb[] = {2.9, 2.5, 2.2};
+    std::vector<double> tExact;
+    tExact.push_back(0.);
+    tExact.push_back(1.);
+    for (size_t d = 0; d < 3; ++d) {
+        tExact.push_back((1. - pa[d])/(pb[d] - pa[d]));
+        tExact.push_back((2. - pa[d])/(pb[d] - pa[d]));
+    }
+    std::sort(tExact.begin(), tExact.end());
+
+    // using a prebuilt locator
+    LineGridIntersector intersector(grid, loc);
+    intersector.setLine(pa, pb);
+    const std::vector<double>& tValues = intersector.getIntersectionLineParamCoords();
+    for (size_t i = 0; i < tValues.size(); ++i) {
+        std::cout << "\tintersect t value =  " << tValues[i] << '\n';
+    }
+    assert(tValues.size() == tExact.size());
+    for (size_t i = 0; i < tValues.size(); ++i) {
+        assert(std::abs(tValues[i] - tExact[i]) < 1.e-12);
+    }
+
+    // line through an edge shared by 4 cells, and along faces
+    const double pc[] = {1.0, 1.0, 0.5};
+    const double pd[] = {1.0, 1.0, 2.5};
+    intersector.setLine(pc, pd);
+    const std::vector<double>& tValues2 = intersector.getIntersectionLineParamCoords();
+    for (size_t i = 0; i < tValues2.size(); ++i) {
+        std::cout << "\tintersect t value =  " << tValues2[i] << '\n';
+    }
+    assert(tValues2.size() == 4);
+    assert(std::abs(tValues2[1] - 0.25) < 1.e-12);
+    assert(std::abs(tValues2[2] - 0.75) < 1.e-12);
+
+    loc->Delete();
+    ptIds->Delete();
+    grid->Delete();
+    points->Delete();
+}
+
+
+void testQuadCell() {
+
+    std::cout << "=======  testQuadCell ===========\n";
+
+    // a one quad grid in the z = 0 plane, the quad is not a hexahedron and 
+    // is intersected by the cell itself
+    vtkPoints* points = vtkPoints::New();
+    points->SetDataTypeToDouble();
+    points->InsertNextPoint(0., 0., 0.);
+    points->InsertNextPoint(1., 0., 0.);
+    points->InsertNextPoint(1., 1., 0.);
+    points->InsertNextPoint(0., 1., 0.);
+
+    vtkUnstructuredGrid* grid = vtkUnstructuredGrid::New();
+    grid->SetPoints(points);
+    grid->Allocate(1, 1);
+    vtkIdList* ptIds = vtkIdList::New();
+    ptIds->SetNumberOfIds(4);
+    for (vtkIdType i = 0; i < 4; ++i) {
+        ptIds->SetId(i, i);
+    }
+    grid->InsertNextCell(VTK_QUAD, ptIds);
+
+    LineGridIntersector intersector(grid);
+
+    // the line crosses the quad half way
+    const double p0[] = {0.2, 0.3, -1.};
+    const double p1[] = {0.4, 0.5, 1.};
+    intersector.setLine(p0, p1);
+    const std::vector<double>& tValues = intersector.getIntersectionLineParamCoords();
+    for (size_t i = 0; i < tValues.size(); ++i) {
+        std::cout << "\tintersect t value =  " << tValues[i] << '\n';
+    }
+    assert(tValues.size() == 1);
+    assert(std::abs(tValues[0] - 0.5) < 1.e-10);
+
+    ptIds->Delete();
+    grid->Delete();
+    points->Delete();
+}
+
 int main(int argc, char** argv) {
 
     testLatLon(10, 11, 12);
@@ -224,6 +340,8 @@ int main(int argc, char** argv) {
     testLatLon(1, 2, 4);
     testLatLon(1, 1, 1);
     test1Cell();
+    testQuadCell();
+    testHexGrid();
 
     return 0;
 }
@@ -1,4 +1,5 @@
 #include <mntLineLineIntersector.h>
+#include <mntQuadEdgeIter.h>
 #undef NDEBUG // turn on asserts
 #include <cassert>
 #include <cmath>
@@ -235,6 +236,88 @@ void testPInsideQ() {
     assert(abs(dot(dpbp1, u)) < tol);
 }
 
+void testQuadEdges() {
+    // compare the batched intersector against the single edge intersector
+    double tol = 1.e-10;
+    const double verts[4][3] = {{0., 0., 0.}, {1., 0.1, 0.}, {1.2, 1., 0.}, {-0.1, 0.9, 0.}};
+
+    // the edge convention must be that of QuadEdgeIter
+    QuadEdgeIter edgeIt;
+    for (int e = 0; e < 4; ++e) {
+        int i0, i1, j0, j1;
+        edgeIt.getCellPointIds(e, &i0, &i1);
+        LineQuadEdgesIntersector::getCellPointIds(e, &j0, &j1);
+        assert(i0 == j0 && i1 == j1);
+    }
+
+    // lines crossing the quad, along an edge, through a vertex and outside
+    const double lines[][4] = {{-0.5, 0.3, 1.5, 0.6},
+                               {0.0, 0.0, 0.5, 0.05},
+                               {-1.0, -1.0, 2.0, 2.0},
+                               {0.2, -0.5, 0.4, 1.5},
+                               {3.0, 3.0, 4.0, 3.0}};
+
+    LineQuadEdgesIntersector qli;
+    for (size_t iline = 0; iline < 5; ++iline) {
+        const double* p0 = &lines[iline][0];
+        const double* p1 = &lines[iline][2];
+        qli.setPoints(p0, p1, verts);
+        for (int e = 0; e < 4; ++e) {
+            int i0, i1;
+            LineQuadEdgesIntersector::getCellPointIds(e, &i0, &i1);
+            LineLineIntersector lli;
+            lli.setPoints(p0, p1, verts[i0], verts[i1]);
+
+            // must be the same bit for bit
+            assert(qli.getDet(e) == lli.getDet());
+            bool has = lli.hasSolution(tol);
+            assert(qli.hasSolution(e, tol) == has);
+            if (has && std::abs(lli.getDet()) > tol) {
+                double sol[2];
+                qli.getSolution(e, sol);
+                Vector<double> xi = lli.getSolution();
+                assert(sol[0] == xi[0] && sol[1] == xi[1]);
+            }
+            else if (has) {
+                assert(qli.getBegEndParamCoords() == lli.getBegEndParamCoords());
+            }
+        }
+    }
+}
+
+void testQuadEdgeParamCoords() {
+    // the analytic cell parametric coordinates must match those of QuadEdgeIter
+    const double verts[4][3] = {{0., 0., 0.}, {1., 0.1, 0.}, {1.2, 1., 0.}, {-0.1, 0.9, 0.}};
+    const double lams[] = {0., 0.25, 0.5, 1.};
+    QuadEdgeIter edgeIt;
+    LineQuadEdgesIntersector qli;
+    double p0[] = {-1., -1.};
+    double p1[] = {2., 2.};
+    qli.setPoints(p0, p1, verts);
+    for (int e = 0; e < 4; ++e) {
+        double* xiBeg;
+        double* xiEnd;
+        edgeIt.getParamCoords(e, &xiBeg, &xiEnd);
+        int i0, i1;
+        LineQuadEdgesIntersector::getCellPointIds(e, &i0, &i1);
+        for (size_t i = 0; i < 4; ++i) {
+            double xi[3];
+            LineQuadEdgesIntersector::getCellParamCoords(e, lams[i], xi);
+            for (size_t d = 0; d < 2; ++d) {
+                assert(std::abs(xi[d] - (xiBeg[d] + lams[i]*(xiEnd[d] - xiBeg[d]))) < 1.e-14);
+            }
+            assert(xi[2] == 0.);
+
+            // recover the edge parametric coordinate from the point
+            double p[2];
+            for (size_t d = 0; d < 2; ++d) {
+                p[d] = verts[i0][d] + lams[i]*(verts[i1][d] - verts[i0][d]);
+            }
+            assert(std::abs(qli.getEdgeParamCoord(e, p) - lams[i]) < 1.e-14);
+        }
+    }
+}
+
 
 int main(int argc, char** argv) {
 
@@ -248,6 +331,8 @@ int main(int argc, char** argv) {
     testPartialOverlap3();
     testQInsideP();
     testPInsideQ();
+    testQuadEdges();
+    testQuadEdgeParamCoords();
 
     return 0;
 }
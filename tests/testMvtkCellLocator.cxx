@@ -0,0 +1,253 @@
+#undef NDEBUG // turn on asserts
+#include <vtkUnstructuredGrid.h>
+#include <mvtkCellLocator.h>
+#include <mntParallel.h>
+#include <vtkPoints.h>
+#include <vtkIdList.h>
+#include <vtkGenericCell.h>
+#include "duplicatedPointsGrid.h"
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <algorithm>
+
+/**
+ * Create a grid of nx * ny * nz hexahedra over [0, 1]^3, with the points
+ * duplicated in each cell
+ */
+vtkUnstructuredGrid* createGrid(int nx, int ny, int nz, vtkPoints* points) {
+    return createDuplicatedPointsGrid(nx, ny, nz, [nx, ny, nz](const int*, const int* node, double p[]) {
+        p[0] = double(node[0])/double(nx);
+        p[1] = double(node[1])/double(ny);
+        p[2] = double(node[2])/double(nz);
+    }, points);
+}
+
+/**
+ * Get the content of each bucket, parent octants are flagged with a -1
+ */
+std::vector< std::vector<vtkIdType> > getBuckets(mvtkCellLocator* loc, int numLevels) {
+
+    // the leaf octants are the last ones
+    int numLeaves = 1;
+    for (int l = 0; l < numLevels; ++l) {
+        numLeaves *= 8;
+    }
+    int leafStart = loc->GetNumberOfBuckets() - numLeaves;
+
+    std::vector< std::vector<vtkIdType> > res(loc->GetNumberOfBuckets());
+    for (int bucket = 0; bucket < loc->GetNumberOfBuckets(); ++bucket) {
+        vtkIdList* cellIds = loc->GetCells(bucket);
+        if (!cellIds) {
+            continue;
+        }
+        if (bucket < leafStart) {
+            res[bucket].push_back(-1);
+            continue;
+        }
+        for (vtkIdType i = 0; i < cellIds->GetNumberOfIds(); ++i) {
+            res[bucket].push_back(cellIds->GetId(i));
+        }
+    }
+    return res;
+}
+
+void testParallelBuild(bool cacheCellBounds) {
+
+    vtkPoints* points = vtkPoints::New();
+    vtkUnstructuredGrid* grid = createGrid(13, 7, 5, points);
+
+    // reference: one vtkIdList per bucket
+    mvtkCellLocator* ref = mvtkCellLocator::New();
+    ref->SetNumberOfCellsPerBucket(2);
+    ref->UseFlatStorageOff();
+    ref->SetCacheCellBounds(cacheCellBounds);
+    ref->SetDataSet(grid);
+    ref->BuildLocator();
+    int numLevels = ref->GetLevel();
+    std::vector< std::vector<vtkIdType> > refBuckets = getBuckets(ref, numLevels);
+
+    int numThreadsList[] = {1, 2, 3, 8};
+    for (int numThreads : numThreadsList) {
+
+        mvtkCellLocator* loc = mvtkCellLocator::New();
+        loc->SetNumberOfCellsPerBucket(2);
+        loc->SetNumberOfThreads(numThreads);
+        loc->SetCacheCellBounds(cacheCellBounds);
+        loc->SetDataSet(grid);
+        loc->BuildLocator();
+
+        std::cout << "testParallelBuild: cacheCellBounds = " << cacheCellBounds
+                  << " numThreads = " << numThreads << " num levels = " << loc->GetLevel()
+                  << " num buckets = " << loc->GetNumberOfBuckets() << '\n';
+        assert(loc->GetLevel() == numLevels);
+        assert(getBuckets(loc, numLevels) == refBuckets);
+
+        // same cell found
+        vtkGenericCell* cell = vtkGenericCell::New();
+        double x[] = {0.51, 0.32, 0.77};
+        double pcoords[3], weights[8];
+        vtkIdType cellId = loc->FindCell(x, 0.0, cell, pcoords, weights);
+        assert(cellId >= 0);
+        assert(cellId == ref->FindCell(x, 0.0, cell, pcoords, weights));
+        cell->Delete();
+
+        loc->Delete();
+    }
+
+    ref->Delete();
+    grid->Delete();
+    points->Delete();
+}
+
+std::vector<vtkIdType> toVector(vtkIdList* ids) {
+    std::vector<vtkIdType> res(ids->GetNumberOfIds());
+    for (vtkIdType i = 0; i < ids->GetNumberOfIds(); ++i) {
+        res[i] = ids->GetId(i);
+    }
+    return res;
+}
+
+void testConcurrentQueries(bool cacheCellBounds) {
+
+    vtkPoints* points = vtkPoints::New();
+    vtkUnstructuredGrid* grid = createGrid(11, 9, 6, points);
+
+    mvtkCellLocator* loc = mvtkCellLocator::New();
+    loc->SetNumberOfCellsPerBucket(2);
+    loc->SetCacheCellBounds(cacheCellBounds);
+    loc->SetDataSet(grid);
+    loc->BuildLocator();
+
+    // query points, lines (p1, p2) and boxes (lo, hi), some of them outside [0, 1]^3
+    const size_t n = 1000;
+    std::vector<double> xyz(6*n);
+    for (size_t i = 0; i < 6*n; ++i) {
+        xyz[i] = -0.1 + 1.2*double((i*7919) % 1009)/1008.;
+    }
+
+    // serial reference
+    vtkGenericCell* cell = vtkGenericCell::New();
+    vtkIdList* ids = vtkIdList::New();
+    double pcoords[3], weights[8];
+    std::vector<vtkIdType> refCellIds(n);
+    std::vector< std::vector<vtkIdType> > refLineCells(n), refBoxCells(n);
+    for (size_t i = 0; i < n; ++i) {
+        double* p = &xyz[6*i];
+        refCellIds[i] = loc->FindCell(p, 0.0, cell, pcoords, weights);
+        loc->FindCellsAlongLine(p, p + 3, 1.e-3, ids);
+        refLineCells[i] = toVector(ids);
+        double bbox[] = {std::min(p[0], p[3]), std::max(p[0], p[3]),
+                         std::min(p[1], p[4]), std::max(p[1], p[4]),
+                         std::min(p[2], p[5]), std::max(p[2], p[5])};
+        loc->FindCellsWithinBounds(bbox, ids);
+        refBoxCells[i] = toVector(ids);
+    }
+    ids->Delete();
+    cell->Delete();
+
+    // all the threads share the locator, each has its own query context
+    const int numThreads = 4;
+    std::vector<vtkIdType> cellIds(n);
+    std::vector< std::vector<vtkIdType> > lineCells(n), boxCells(n);
+    mntParallelFor(numThreads, n, [&](int threadId, size_t beg, size_t end) {
+        mvtkCellLocatorQuery query;
+        vtkIdList* cells = vtkIdList::New();
+        double pc[3], w[8];
+        // several passes to interleave the queries of the threads
+        for (int pass = 0; pass < 3; ++pass) {
+            for (size_t i = beg; i < end; ++i) {
+                double* p = &xyz[6*i];
+                cellIds[i] = loc->FindCell(p, 0.0, &query, pc, w);
+                loc->FindCellsAlongLine(p, p + 3, 1.e-3, cells, &query);
+                lineCells[i] = toVector(cells);
+                double bbox[] = {std::min(p[0], p[3]), std::max(p[0], p[3]),
+                                 std::min(p[1], p[4]), std::max(p[1], p[4]),
+                                 std::min(p[2], p[5]), std::max(p[2], p[5])};
+                loc->FindCellsWithinBounds(bbox, cells, &query);
+                boxCells[i] = toVector(cells);
+            }
+        }
+        cells->Delete();
+    });
+
+    int numFound = 0;
+    for (size_t i = 0; i < n; ++i) {
+        assert(cellIds[i] == refCellIds[i]);
+        assert(lineCells[i] == refLineCells[i]);
+        assert(boxCells[i] == refBoxCells[i]);
+        numFound += (cellIds[i] >= 0? 1: 0);
+    }
+    std::cout << "testConcurrentQueries: cacheCellBounds = " << cacheCellBounds
+              << " found " << numFound << " points out of " << n << '\n';
+    assert(numFound > 0);
+
+    loc->Delete();
+    grid->Delete();
+    points->Delete();
+}
+
+void testBatchedFindCell(int numCellsPerBucket) {
+
+    vtkPoints* points = vtkPoints::New();
+    vtkUnstructuredGrid* grid = createGrid(13, 7, 5, points);
+
+    // reference: no cached bounds, one vtkIdList per bucket
+    mvtkCellLocator* ref = mvtkCellLocator::New();
+    ref->SetNumberOfCellsPerBucket(numCellsPerBucket);
+    ref->UseFlatStorageOff();
+    ref->SetCacheCellBounds(0);
+    ref->SetDataSet(grid);
+    ref->BuildLocator();
+
+    // the cached bounds are tested in batches
+    mvtkCellLocator* loc = mvtkCellLocator::New();
+    loc->SetNumberOfCellsPerBucket(numCellsPerBucket);
+    loc->SetCacheCellBounds(1);
+    loc->SetDataSet(grid);
+    loc->BuildLocator();
+
+    // points on the cell faces, edges and vertices, inside and outside the grid
+    vtkGenericCell* cell = vtkGenericCell::New();
+    double pcoords[3], weights[8], pcoordsRef[3], weightsRef[8];
+    int numFound = 0;
+    const int n = 26;
+    for (int k = -1; k <= n + 1; ++k) {
+        for (int j = -1; j <= n + 1; ++j) {
+            for (int i = -1; i <= n + 1; ++i) {
+                double x[] = {i/double(n), j/double(n), k/double(n)};
+                vtkIdType cellId = loc->FindCell(x, 0.0, cell, pcoords, weights);
+                vtkIdType cellIdRef = ref->FindCell(x, 0.0, cell, pcoordsRef, weightsRef);
+                assert(cellId == cellIdRef);
+                if (cellId < 0) continue;
+                numFound++;
+                for (int d = 0; d < 3; ++d) {
+                    assert(pcoords[d] == pcoordsRef[d]);
+                }
+            }
+        }
+    }
+    std::cout << "testBatchedFindCell: numCellsPerBucket = " << numCellsPerBucket
+              << " found " << numFound << " points\n";
+    assert(numFound == (n + 1)*(n + 1)*(n + 1));
+
+    cell->Delete();
+    loc->Delete();
+    ref->Delete();
+    grid->Delete();
+    points->Delete();
+}
+
+
+int main(int argc, char** argv) {
+
+    testParallelBuild(false);
+    testParallelBuild(true);
+    testConcurrentQueries(false);
+    testConcurrentQueries(true);
+    testBatchedFindCell(1);
+    testBatchedFindCell(13);
+    testBatchedFindCell(100);
+
+    return 0;
+}
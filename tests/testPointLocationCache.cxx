@@ -0,0 +1,108 @@
+#include <mntPointLocationCache.h>
+#undef NDEBUG // turn on asserts
+#include <cassert>
+#include <cmath>
+#include <vtkUnstructuredGrid.h>
+#include <vtkPoints.h>
+#include <vtkCellLocator.h>
+#include <vtkIdList.h>
+#include <vtkGenericCell.h>
+#include "duplicatedPointsGrid.h"
+#include <iostream>
+
+/**
+ * Create a grid of nx * ny quads over [0, 1] x [0, 1], with the points duplicated
+ * in each cell
+ */
+vtkUnstructuredGrid* createGrid(int nx, int ny, vtkPoints* points) {
+    return createDuplicatedPointsGrid(nx, ny, 0, [nx, ny](const int*, const int* node, double p[]) {
+        p[0] = double(node[0])/double(nx);
+        p[1] = double(node[1])/double(ny);
+    }, points);
+}
+
+void testShiftedGrid(int numThreads) {
+
+    vtkPoints* srcPoints = vtkPoints::New();
+    vtkUnstructuredGrid* srcGrid = createGrid(3, 2, srcPoints);
+    vtkCellLocator* loc = vtkCellLocator::New();
+    loc->SetDataSet(srcGrid);
+    loc->BuildLocator();
+
+    // the points to locate, shared by up to 4 cells
+    vtkPoints* dstPoints = vtkPoints::New();
+    vtkUnstructuredGrid* dstGrid = createGrid(4, 5, dstPoints);
+
+    PointLocationCache cache(2);
+    cache.build(dstPoints, loc, numThreads);
+
+    // 5 x 6 distinct points
+    std::cout << "testShiftedGrid: numThreads = " << numThreads
+              << " num unique points = " << cache.getNumberOfUniquePoints() << '\n';
+    assert(cache.getNumberOfUniquePoints() == 30);
+
+    // must match the locator
+    vtkGenericCell* cell = vtkGenericCell::New();
+    double eps = 1.e-15;
+    for (vtkIdType ptId = 0; ptId < dstPoints->GetNumberOfPoints(); ++ptId) {
+        double p[3];
+        double xi[3];
+        double weights[8];
+        dstPoints->GetPoint(ptId, p);
+        vtkIdType cellId = loc->FindCell(p, eps, cell, xi, weights);
+        assert(cellId >= 0);
+        assert(cache.getCellId(ptId) >= 0);
+
+        // shared points may be found in a different, adjacent cell, check
+        // that the parametric coordinates map back to the point
+        double x[3];
+        int subId = 0;
+        srcGrid->GetCell(cache.getCellId(ptId), cell);
+        cell->EvaluateLocation(subId, (double*) cache.getParamCoords(ptId), x, weights);
+        assert(std::abs(x[0] - p[0]) + std::abs(x[1] - p[1]) < 1.e-12);
+    }
+
+    cell->Delete();
+    dstGrid->Delete();
+    dstPoints->Delete();
+    loc->Delete();
+    srcGrid->Delete();
+    srcPoints->Delete();
+}
+
+void testOutside() {
+
+    vtkPoints* srcPoints = vtkPoints::New();
+    vtkUnstructuredGrid* srcGrid = createGrid(2, 2, srcPoints);
+    vtkCellLocator* loc = vtkCellLocator::New();
+    loc->SetDataSet(srcGrid);
+    loc->BuildLocator();
+
+    vtkPoints* points = vtkPoints::New();
+    points->SetDataTypeToDouble();
+    points->InsertNextPoint(0.3, 0.3, 0.);
+    points->InsertNextPoint(1.5, 0.3, 0.);
+    // same point in 2d
+    points->InsertNextPoint(0.3, 0.3, 1.);
+
+    PointLocationCache cache(2);
+    cache.build(points, loc, 2);
+    assert(cache.getNumberOfUniquePoints() == 2);
+    assert(cache.getCellId(0) >= 0);
+    assert(cache.getCellId(1) < 0);
+    assert(cache.getCellId(2) == cache.getCellId(0));
+
+    points->Delete();
+    loc->Delete();
+    srcGrid->Delete();
+    srcPoints->Delete();
+}
+
+int main(int argc, char** argv) {
+
+    testShiftedGrid(1);
+    testShiftedGrid(3);
+    testOutside();
+
+    return 0;
+}
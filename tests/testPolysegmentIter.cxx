@@ -1,4 +1,5 @@
 #include <mntPolysegmentIter.h>
+#include <mntCellAdjacency.h>
 #include <mntGrid.h>
 #undef NDEBUG // turn on asserts
 #include <cassert>
@@ -250,6 +251,181 @@ void test2CellsEdge() {
     points->Delete();
 }
 
+void testReuse() {
+    // a 3x3 grid of unit cells, 4 points per cell
+    vtkPoints* points = vtkPoints::New();
+    points->SetDataTypeToDouble();
+    vtkUnstructuredGrid* grid = vtkUnstructuredGrid::New();
+    size_t nx = 3;
+    grid->Allocate(nx*nx, 1);
+    vtkIdList* ptIds = vtkIdList::New();
+    ptIds->SetNumberOfIds(4);
+    for (size_t j = 0; j < nx; ++j) {
+        for (size_t i = 0; i < nx; ++i) {
+            double x = i;
+            double y = j;
+            vtkIdType k = points->GetNumberOfPoints();
+            points->InsertNextPoint(x      , y      , 0.);
+            points->InsertNextPoint(x + 1.0, y      , 0.);
+            points->InsertNextPoint(x + 1.0, y + 1.0, 0.);
+            points->InsertNextPoint(x      , y + 1.0, 0.);
+            for (vtkIdType iv = 0; iv < 4; ++iv) {
+                ptIds->SetId(iv, k + iv);
+            }
+            grid->InsertNextCell(VTK_QUAD, ptIds);
+        }
+    }
+    grid->SetPoints(points);
+
+    vtkCellLocator* loc = vtkCellLocator::New();
+    loc->SetDataSet(grid);
+    loc->BuildLocator();
+
+    // lines: oblique, along a grid line, within a cell, across the grid
+    const double lines[][4] = {{0.2, 0.3, 2.7, 1.9},
+                               {0.5, 1.0, 2.5, 1.0},
+                               {1.2, 1.3, 1.4, 1.5},
+                               {2.9, 0.1, 0.1, 2.9}};
+
+    // the same iterator is used for all the lines
+    PolysegmentIter psiReused(grid, loc);
+    for (size_t iline = 0; iline < 4; ++iline) {
+
+        const double* p0 = &lines[iline][0];
+        const double* p1 = &lines[iline][2];
+        psiReused.setLine(p0, p1);
+
+        PolysegmentIter psi(grid, loc, p0, p1);
+        PolysegmentIter psiCopy = psi;
+
+        size_t numSegs = psi.getNumberOfSegments();
+        assert(numSegs > 0);
+        assert(psiReused.getNumberOfSegments() == numSegs);
+        assert(psiCopy.getNumberOfSegments() == numSegs);
+
+        psi.reset();
+        psiReused.reset();
+        psiCopy.reset();
+        for (size_t i = 0; i < numSegs; ++i) {
+            assert(psiReused.getCellId() == psi.getCellId());
+            assert(psiReused.getBegLineParamCoord() == psi.getBegLineParamCoord());
+            assert(psiReused.getEndLineParamCoord() == psi.getEndLineParamCoord());
+            assert(psiReused.getCoefficient() == psi.getCoefficient());
+            assert(psiReused.getBegCellParamCoord() == psi.getBegCellParamCoord());
+            assert(psiReused.getEndCellParamCoord() == psi.getEndCellParamCoord());
+            assert(psiCopy.getCellId() == psi.getCellId());
+            assert(psiCopy.getEndCellParamCoord() == psi.getEndCellParamCoord());
+            psi.next();
+            psiReused.next();
+            psiCopy.next();
+        }
+
+        double error = psiReused.getIntegratedParamCoord() - 1.0;
+        std::cout << "testReuse: line " << iline << " num segments = " << numSegs 
+                  << " error = " << error << '\n';
+        assert(std::abs(error) < 1.e-10);
+    }
+
+    ptIds->Delete();
+    loc->Delete();
+    grid->Delete();
+    points->Delete();
+}
+
+
+void testWalk() {
+    // a 3x3 grid of unit cells, 4 points per cell
+    vtkPoints* points = vtkPoints::New();
+    points->SetDataTypeToDouble();
+    vtkUnstructuredGrid* grid = vtkUnstructuredGrid::New();
+    size_t nx = 3;
+    grid->Allocate(nx*nx, 1);
+    vtkIdList* ptIds = vtkIdList::New();
+    ptIds->SetNumberOfIds(4);
+    for (size_t j = 0; j < nx; ++j) {
+        for (size_t i = 0; i < nx; ++i) {
+            double x = i;
+            double y = j;
+            vtkIdType k = points->GetNumberOfPoints();
+            points->InsertNextPoint(x      , y      , 0.);
+            points->InsertNextPoint(x + 1.0, y      , 0.);
+            points->InsertNextPoint(x + 1.0, y + 1.0, 0.);
+            points->InsertNextPoint(x      , y + 1.0, 0.);
+            for (vtkIdType iv = 0; iv < 4; ++iv) {
+                ptIds->SetId(iv, k + iv);
+            }
+            grid->InsertNextCell(VTK_QUAD, ptIds);
+        }
+    }
+    grid->SetPoints(points);
+
+    vtkCellLocator* loc = vtkCellLocator::New();
+    loc->SetDataSet(grid);
+    loc->BuildLocator();
+
+    // derive the neighbours from the point coordinates
+    CellAdjacency adjacency;
+    std::vector<vtkIdType> noConnectivity;
+    adjacency.build(grid, noConnectivity);
+    assert(adjacency.getEdgeNeighbour(4, 0) == 1);
+    assert(adjacency.getEdgeNeighbour(4, 1) == 5);
+    assert(adjacency.getEdgeNeighbour(4, 2) == 7);
+    assert(adjacency.getEdgeNeighbour(4, 3) == 3);
+    assert(adjacency.getEdgeNeighbour(0, 0) < 0);
+    const vtkIdType* nodeCellIds;
+    assert(adjacency.getNodeCells(adjacency.getNodeId(4, 0), &nodeCellIds) == 4);
+
+    // lines: oblique, along a grid line, through vertices, within a cell, 
+    // from a vertex, leaving the grid
+    const double lines[][4] = {{0.2, 0.3, 2.7, 1.9},
+                               {0.5, 1.0, 2.5, 1.0},
+                               {0.5, 0.5, 2.5, 2.5},
+                               {1.2, 1.3, 1.4, 1.5},
+                               {1.0, 1.0, 2.5, 1.7},
+                               {2.5, 0.5, 3.5, 1.5}};
+
+    PolysegmentIter psiWalk(grid, loc);
+    psiWalk.setCellAdjacency(&adjacency);
+    PolysegmentIter psiLoc(grid, loc);
+    for (size_t iline = 0; iline < 6; ++iline) {
+
+        const double* p0 = &lines[iline][0];
+        const double* p1 = &lines[iline][2];
+        psiWalk.setLine(p0, p1);
+        psiLoc.setLine(p0, p1);
+
+        // same weighted length in each cell
+        std::vector<double> lengthWalk(nx*nx, 0.0);
+        std::vector<double> lengthLoc(nx*nx, 0.0);
+        psiWalk.reset();
+        for (size_t i = 0; i < psiWalk.getNumberOfSegments(); ++i) {
+            lengthWalk[psiWalk.getCellId()] += psiWalk.getCoefficient() * 
+                (psiWalk.getEndLineParamCoord() - psiWalk.getBegLineParamCoord());
+            psiWalk.next();
+        }
+        psiLoc.reset();
+        for (size_t i = 0; i < psiLoc.getNumberOfSegments(); ++i) {
+            lengthLoc[psiLoc.getCellId()] += psiLoc.getCoefficient() * 
+                (psiLoc.getEndLineParamCoord() - psiLoc.getBegLineParamCoord());
+            psiLoc.next();
+        }
+        double diff = 0;
+        for (size_t i = 0; i < nx*nx; ++i) {
+            diff += std::abs(lengthWalk[i] - lengthLoc[i]);
+        }
+        std::cout << "testWalk: line " << iline << " num segments = " 
+                  << psiWalk.getNumberOfSegments() << " (locator " << psiLoc.getNumberOfSegments()
+                  << ") diff = " << diff << '\n';
+        assert(diff < 1.e-12);
+        assert(std::abs(psiWalk.getIntegratedParamCoord() - psiLoc.getIntegratedParamCoord()) < 1.e-12);
+    }
+
+    ptIds->Delete();
+    loc->Delete();
+    grid->Delete();
+    points->Delete();
+}
+
 
 int main(int argc, char** argv) {
 
@@ -257,6 +433,8 @@ int main(int argc, char** argv) {
     test1Cell();
     test2Cells();
     test2CellsEdge();
+    testReuse();
+    testWalk();
 
     return 0;
 }
@@ -0,0 +1,130 @@
+#include <mntQuadPosition.h>
+#include <vtkQuad.h>
+#include <vtkPoints.h>
+#undef NDEBUG // turn on asserts
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <algorithm>
+
+/**
+ * Bilinear interpolation of the quad vertices
+ */
+void interpolate(const double verts[4][3], const double pcoords[], double x[]) {
+    double w[] = {(1. - pcoords[0])*(1. - pcoords[1]), pcoords[0]*(1. - pcoords[1]),
+                  pcoords[0]*pcoords[1], (1. - pcoords[0])*pcoords[1]};
+    for (int d = 0; d < 3; ++d) {
+        x[d] = 0.;
+        for (int i = 0; i < 4; ++i) {
+            x[d] += w[i]*verts[i][d];
+        }
+    }
+}
+
+/**
+ * Compare with vtkQuad::EvaluatePosition at points of parametric coordinates
+ * ranging from -0.5 to 1.5
+ */
+void testQuad(const std::string& name, const double verts[4][3]) {
+
+    vtkQuad* quad = vtkQuad::New();
+    for (int i = 0; i < 4; ++i) {
+        quad->GetPoints()->SetPoint(i, verts[i][0], verts[i][1], verts[i][2]);
+    }
+
+    double pcoords[3], weights[4], pcoordsRef[3], weightsRef[4], x[3], y[3], dist2;
+    int subId;
+    const int n = 40;
+    double maxDiff = 0.;
+    int numInside = 0;
+    for (int j = 0; j <= n; ++j) {
+        for (int i = 0; i <= n; ++i) {
+            double xi[] = {-0.5 + 2.*i/double(n), -0.5 + 2.*j/double(n)};
+            interpolate(verts, xi, x);
+
+            int inside = mntQuadEvaluatePosition(verts, x, pcoords, weights);
+            int insideRef = quad->EvaluatePosition(x, NULL, subId, pcoordsRef, dist2, weightsRef);
+
+            // the parametric coordinates are recovered inside the quad. Outside, the
+            // bilinear map may not be one to one but the point must be recovered
+            bool inQuad = xi[0] >= 0. && xi[0] <= 1. && xi[1] >= 0. && xi[1] <= 1.;
+            if (inQuad) {
+                assert(std::abs(pcoords[0] - xi[0]) < 1.e-10);
+                assert(std::abs(pcoords[1] - xi[1]) < 1.e-10);
+            }
+            assert(pcoords[2] == 0.);
+            interpolate(verts, pcoords, y);
+            for (int d = 0; d < 3; ++d) {
+                assert(std::abs(y[d] - x[d]) < 1.e-10);
+            }
+
+            // same inside test as vtkQuad, when the latter converges
+            if (insideRef >= 0) {
+                assert(inside == insideRef);
+                for (int k = 0; k < 2; ++k) {
+                    maxDiff = std::max(maxDiff, std::abs(pcoords[k] - pcoordsRef[k]));
+                }
+                if (inside == 1) {
+                    for (int k = 0; k < 4; ++k) {
+                        assert(std::abs(weights[k] - weightsRef[k]) < 1.e-5);
+                    }
+                }
+            }
+            numInside += (inside == 1);
+        }
+    }
+    std::cout << "testQuad(" << name << "): " << numInside << " points inside, max diff with vtkQuad = "
+              << maxDiff << std::endl;
+    // vtkQuad stops iterating once the Newton steps are below 1.e-4
+    assert(maxDiff < 1.e-5);
+    assert(numInside == 21*21);
+
+    quad->Delete();
+}
+
+void testTolerance() {
+    const double verts[4][3] = {{0., 0., 0.}, {1., 0., 0.}, {1., 1., 0.}, {0., 1., 0.}};
+    double pcoords[3], weights[4];
+    double x[] = {1.0009, -0.0009, 0.};
+    assert(mntQuadEvaluatePosition(verts, x, pcoords, weights) == 1);
+    x[0] = 1.0011;
+    assert(mntQuadEvaluatePosition(verts, x, pcoords, weights) == 0);
+    x[0] = 0.5; x[1] = -0.0011;
+    assert(mntQuadEvaluatePosition(verts, x, pcoords, weights) == 0);
+    std::cout << "testTolerance: OK\n";
+}
+
+void testDegenerate() {
+    // all the vertices on a line
+    const double verts[4][3] = {{0., 0., 0.}, {1., 0., 0.}, {2., 0., 0.}, {3., 0., 0.}};
+    double pcoords[3], weights[4];
+    double x[] = {0.5, 0.1, 0.};
+    assert(mntQuadEvaluatePosition(verts, x, pcoords, weights) == -1);
+    std::cout << "testDegenerate: OK\n";
+}
+
+
+int main(int argc, char** argv) {
+
+    const double square[4][3] = {{0., 0., 0.}, {1., 0., 0.}, {1., 1., 0.}, {0., 1., 0.}};
+    testQuad("square", square);
+
+    const double parallelogram[4][3] = {{10., -80., 0.}, {20., -78., 0.}, {25., -70., 0.}, {15., -72., 0.}};
+    testQuad("parallelogram", parallelogram);
+
+    const double trapezoid[4][3] = {{0., 0., 0.}, {4., 0., 0.}, {3., 1., 0.}, {1., 1., 0.}};
+    testQuad("trapezoid", trapezoid);
+
+    const double general[4][3] = {{0.1, 0.2, 0.}, {2.3, -0.1, 0.}, {2.0, 1.7, 0.}, {0.4, 1.1, 0.}};
+    testQuad("general", general);
+
+    // the above quad in the plane x = 0.2*y + 0.1*z, projected onto the y-z plane
+    const double tilted[4][3] = {{0.04, 0.1, 0.2}, {0.45, 2.3, -0.1}, {0.57, 2.0, 1.7}, {0.19, 0.4, 1.1}};
+    testQuad("tilted", tilted);
+
+    testTolerance();
+    testDegenerate();
+
+    return 0;
+}
@@ -0,0 +1,225 @@
+#include <mvtkRectilinearCellLocator.h>
+#undef NDEBUG // turn on asserts
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <iostream>
+#include <vtkUnstructuredGrid.h>
+#include <vtkPoints.h>
+#include <vtkCellLocator.h>
+#include <vtkIdList.h>
+#include <vtkGenericCell.h>
+#include "duplicatedPointsGrid.h"
+
+/**
+ * Create a lon-lat grid from the grid lines, the cells are numbered column by column
+ */
+vtkUnstructuredGrid* createGrid(const std::vector<double>& xs, const std::vector<double>& ys,
+                                vtkPoints* points) {
+    return createDuplicatedPointsGrid((int) xs.size() - 1, (int) ys.size() - 1, 0,
+                                      [&](const int*, const int* node, double p[]) {
+                                          p[0] = xs[node[0]];
+                                          p[1] = ys[node[1]];
+                                      }, points, false);
+}
+
+/**
+ * Cells whose bounds, expanded by tol, intersect segment p1-p2
+ */
+std::vector<vtkIdType> bruteForceAlongLine(vtkUnstructuredGrid* grid, const double p1[],
+                                           const double p2[], double tol) {
+    std::vector<vtkIdType> res;
+    double b[6];
+    for (vtkIdType cellId = 0; cellId < grid->GetNumberOfCells(); ++cellId) {
+        grid->GetCellBounds(cellId, b);
+        double ta = 0., tb = 1.;
+        for (int d = 0; d < 2; ++d) {
+            double dir = p2[d] - p1[d];
+            if (dir == 0.) {
+                if (p1[d] < b[2*d] - tol || p1[d] > b[2*d + 1] + tol) {
+                    ta = 2.;
+                }
+                continue;
+            }
+            double t0 = (b[2*d] - tol - p1[d])/dir;
+            double t1 = (b[2*d + 1] + tol - p1[d])/dir;
+            ta = std::max(ta, std::min(t0, t1));
+            tb = std::min(tb, std::max(t0, t1));
+        }
+        if (ta <= tb) {
+            res.push_back(cellId);
+        }
+    }
+    return res;
+}
+
+std::vector<vtkIdType> toVector(vtkIdList* ids) {
+    std::vector<vtkIdType> res;
+    for (vtkIdType i = 0; i < ids->GetNumberOfIds(); ++i) {
+        res.push_back(ids->GetId(i));
+    }
+    return res;
+}
+
+void testGrid(const std::vector<double>& xs, const std::vector<double>& ys) {
+
+    vtkPoints* points = vtkPoints::New();
+    vtkUnstructuredGrid* grid = createGrid(xs, ys, points);
+
+    mvtkRectilinearCellLocator* loc = mvtkRectilinearCellLocator::New();
+    loc->SetDataSet(grid);
+    loc->BuildLocator();
+    assert(loc->IsRectilinear() == 1);
+    int divs[2];
+    loc->GetNumberOfDivisions(divs);
+    std::cout << "testGrid: divisions = " << divs[0] << " x " << divs[1] << std::endl;
+    assert(divs[0] == (int) xs.size() - 1 && divs[1] == (int) ys.size() - 1);
+
+    vtkCellLocator* ref = vtkCellLocator::New();
+    ref->SetDataSet(grid);
+    ref->SetNumberOfCellsPerBucket(8);
+    ref->BuildLocator();
+
+    // grid points, cell centres and points outside
+    vtkGenericCell* cell = vtkGenericCell::New();
+    double pcoords[3], weights[8], pcoordsRef[3], weightsRef[8];
+    double eps = 1.e-15;
+    std::vector<double> xTargets, yTargets;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        xTargets.push_back(xs[i]);
+        if (i + 1 < xs.size()) xTargets.push_back(0.5*(xs[i] + 0.3*xs[i + 1])/0.8);
+    }
+    for (size_t j = 0; j < ys.size(); ++j) {
+        yTargets.push_back(ys[j]);
+        if (j + 1 < ys.size()) yTargets.push_back(0.5*(0.7*ys[j] + ys[j + 1])/0.85);
+    }
+    xTargets.push_back(xs.front() - 1.);
+    yTargets.push_back(ys.back() + 1.);
+    for (size_t j = 0; j < yTargets.size(); ++j) {
+        for (size_t i = 0; i < xTargets.size(); ++i) {
+            double x[] = {xTargets[i], yTargets[j], 0.};
+            vtkIdType cellId = loc->FindCell(x, eps, cell, pcoords, weights);
+            vtkIdType cellIdRef = ref->FindCell(x, eps, cell, pcoordsRef, weightsRef);
+            assert(cellId == cellIdRef);
+            if (cellId < 0) continue;
+            for (int k = 0; k < 2; ++k) {
+                assert(std::abs(pcoords[k] - pcoordsRef[k]) < 1.e-10);
+            }
+            for (int k = 0; k < 4; ++k) {
+                assert(std::abs(weights[k] - weightsRef[k]) < 1.e-10);
+            }
+        }
+    }
+
+    // points just outside the outer grid lines are in the outer cells within vtkQuad's 
+    // parametric tolerance (0.001)
+    double hx0 = xs[1] - xs[0], hxn = xs.back() - xs[xs.size() - 2];
+    double hy0 = ys[1] - ys[0], hyn = ys.back() - ys[ys.size() - 2];
+    double ym = 0.5*(ys[0] + ys[1]), xm = 0.5*(xs[0] + xs[1]);
+    const double nearPoints[][2] = {{xs.front() - 0.0005*hx0, ym}, {xs.back() + 0.0005*hxn, ym},
+                                    {xm, ys.front() - 0.0005*hy0}, {xm, ys.back() + 0.0005*hyn},
+                                    {xs.front() - 0.0005*hx0, ys.front() - 0.0005*hy0}};
+    for (size_t k = 0; k < sizeof(nearPoints)/sizeof(nearPoints[0]); ++k) {
+        double x[] = {nearPoints[k][0], nearPoints[k][1], 0.};
+        assert(loc->FindCell(x, eps, cell, pcoords, weights) >= 0);
+        for (int d = 0; d < 2; ++d) {
+            assert(pcoords[d] > -0.001 && pcoords[d] < 1.001);
+        }
+    }
+    const double farPoints[][2] = {{xs.front() - 0.002*hx0, ym}, {xm, ys.back() + 0.002*hyn}};
+    for (size_t k = 0; k < sizeof(farPoints)/sizeof(farPoints[0]); ++k) {
+        double x[] = {farPoints[k][0], farPoints[k][1], 0.};
+        assert(loc->FindCell(x, eps, cell, pcoords, weights) < 0);
+    }
+
+    // lines: diagonal, reversed, along grid lines, degenerate, partially outside
+    double x0 = xs.front(), x1 = xs.back(), y0 = ys.front(), y1 = ys.back();
+    double lx = x1 - x0, ly = y1 - y0;
+    const double lines[][4] = {{x0 + 0.01*lx, y0 + 0.01*ly, x1 - 0.01*lx, y1 - 0.01*ly},
+                               {x1 - 0.01*lx, y1 - 0.01*ly, x0 + 0.01*lx, y0 + 0.01*ly},
+                               {x0, ys[1], x1, ys[1]},
+                               {xs[2], y0, xs[2], y1},
+                               {x0 + 0.3*lx, y0 + 0.6*ly, x0 + 0.3*lx, y0 + 0.6*ly},
+                               {x0 - 0.1*lx, y0 - 0.1*ly, x0 + 0.6*lx, y0 + 0.7*ly},
+                               {x1 + 0.1*lx, y0, x1 + 0.3*lx, y1},
+                               {x0 + 0.048*lx, y0 + 0.83*ly, x0 + 0.839*lx, y0 + 0.25*ly}};
+    vtkIdList* cellIds = vtkIdList::New();
+    double tol = 1.e-3;
+    for (size_t k = 0; k < sizeof(lines)/sizeof(lines[0]); ++k) {
+        double p1[] = {lines[k][0], lines[k][1], 0.};
+        double p2[] = {lines[k][2], lines[k][3], 0.};
+        loc->FindCellsAlongLine(p1, p2, tol, cellIds);
+        std::vector<vtkIdType> expected = bruteForceAlongLine(grid, p1, p2, tol);
+        std::cout << "testGrid: line " << k << " num cells = " << cellIds->GetNumberOfIds() << std::endl;
+        assert(toVector(cellIds) == expected);
+    }
+
+    // box query
+    double bbox[] = {x0 + 0.1*lx, x0 + 0.4*lx, y0 + 0.35*ly, y0 + 0.5*ly, 0., 0.};
+    loc->FindCellsWithinBounds(bbox, cellIds);
+    std::vector<vtkIdType> expected;
+    double b[6];
+    for (vtkIdType cellId = 0; cellId < grid->GetNumberOfCells(); ++cellId) {
+        grid->GetCellBounds(cellId, b);
+        if (b[1] >= bbox[0] && b[0] <= bbox[1] && b[3] >= bbox[2] && b[2] <= bbox[3]) {
+            expected.push_back(cellId);
+        }
+    }
+    assert(toVector(cellIds) == expected);
+
+    cellIds->Delete();
+    cell->Delete();
+    ref->Delete();
+    loc->Delete();
+    grid->Delete();
+    points->Delete();
+}
+
+void testNotRectilinear() {
+
+    std::vector<double> xs, ys;
+    for (int i = 0; i <= 4; ++i) xs.push_back(90.*i);
+    for (int j = 0; j <= 2; ++j) ys.push_back(-90. + 90.*j);
+
+    // shift one vertex so that the cell is no longer a rectangle
+    vtkPoints* points = vtkPoints::New();
+    vtkUnstructuredGrid* grid = createGrid(xs, ys, points);
+    double x[3];
+    points->GetPoint(2, x);
+    x[0] += 1.;
+    points->SetPoint(2, x);
+
+    mvtkRectilinearCellLocator* loc = mvtkRectilinearCellLocator::New();
+    loc->SetDataSet(grid);
+    loc->BuildLocator();
+    assert(loc->IsRectilinear() == 0);
+
+    vtkGenericCell* cell = vtkGenericCell::New();
+    double pcoords[3], weights[8];
+    double xIn[] = {45., -45., 0.};
+    assert(loc->FindCell(xIn, 1.e-15, cell, pcoords, weights) < 0);
+
+    cell->Delete();
+    loc->Delete();
+    grid->Delete();
+    points->Delete();
+}
+
+int main(int argc, char** argv) {
+
+    // uniform
+    std::vector<double> xs, ys;
+    for (int i = 0; i <= 36; ++i) xs.push_back(-180. + 10.*i);
+    for (int j = 0; j <= 18; ++j) ys.push_back(-90. + 10.*j);
+    testGrid(xs, ys);
+
+    // variable spacing in latitude
+    ys.clear();
+    for (int j = 0; j <= 17; ++j) ys.push_back(90.*std::sin(M_PI*(-0.5 + j/17.)));
+    testGrid(xs, ys);
+
+    testNotRectilinear();
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+#include "mntRegridEdges3d.h"
+#include "mntLocatorFile.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#undef NDEBUG // turn on asserts
+#include <cassert>
+
+/**
+ * Create the vertices of a uniform hexahedral grid, 8 vertices per cell
+ * @param n number of cells along each direction
+ * @param xmin low corner
+ * @param xmax high corner
+ * @return flat array [x0, y0, z0, x1, y1, z1, ...]
+ */
+std::vector<double> createHexGrid(int n, double xmin, double xmax) {
+
+    // vertex offsets in VTK hexahedron order
+    const int di[] = {0, 1, 1, 0, 0, 1, 1, 0};
+    const int dj[] = {0, 0, 1, 1, 0, 0, 1, 1};
+    const int dk[] = {0, 0, 0, 0, 1, 1, 1, 1};
+
+    double h = (xmax - xmin) / double(n);
+    std::vector<double> verts;
+    for (int k = 0; k < n; ++k) {
+        for (int j = 0; j < n; ++j) {
+            for (int i = 0; i < n; ++i) {
+                for (int iv = 0; iv < 8; ++iv) {
+                    verts.push_back(xmin + h*(i + di[iv]));
+                    verts.push_back(xmin + h*(j + dj[iv]));
+                    verts.push_back(xmin + h*(k + dk[iv]));
+                }
+            }
+        }
+    }
+    return verts;
+}
+
+void testApplyThreads(int numThreads) {
+
+    int ier;
+    std::vector<double> srcVerts = createHexGrid(3, 0.0, 1.0);
+    std::vector<double> dstVerts = createHexGrid(2, 0.1, 0.9);
+    size_t numSrcCells = srcVerts.size() / 24;
+    size_t numDstCells = dstVerts.size() / 24;
+
+    RegridEdges3d_t* rg;
+    ier = mnt_regridedges3d_new(&rg);
+    assert(ier == 0);
+    ier = mnt_regridedges3d_setSrcPointsPtr(&rg, 8, numSrcCells, &srcVerts[0]);
+    assert(ier == 0);
+    ier = mnt_regridedges3d_setDstPointsPtr(&rg, 8, numDstCells, &dstVerts[0]);
+    assert(ier == 0);
+    ier = mnt_regridedges3d_build(&rg, 8);
+    assert(ier == 0);
+    assert(rg->weights.size() > 0);
+
+    int numEdgesPerCell;
+    ier = mnt_regridedges3d_getNumEdgesPerCell(&rg, &numEdgesPerCell);
+    assert(ier == 0);
+
+    std::vector<double> srcData(numSrcCells * numEdgesPerCell);
+    for (size_t i = 0; i < srcData.size(); ++i) {
+        srcData[i] = sin(0.7*i) + 1.0;
+    }
+
+    // reference, straight from the weights
+    std::vector<double> dstDataRef(numDstCells * numEdgesPerCell, 0.0);
+    for (std::map< std::pair<vtkIdType, vtkIdType>, std::vector<double> >::const_iterator 
+         it = rg->weights.begin(); it != rg->weights.end(); ++it) {
+        size_t kd = it->first.first * numEdgesPerCell;
+        size_t ks = it->first.second * numEdgesPerCell;
+        for (int ie = 0; ie < numEdgesPerCell; ++ie) {
+            dstDataRef[kd + ie] += it->second[ie] * srcData[ks + ie];
+        }
+    }
+
+    ier = mnt_regridedges3d_setNumberOfThreads(&rg, numThreads);
+    assert(ier == 0);
+
+    std::vector<double> dstData(numDstCells * numEdgesPerCell, -1.0);
+    ier = mnt_regridedges3d_applyWeights(&rg, &srcData[0], &dstData[0]);
+    assert(ier == 0);
+
+    // must be the same bit for bit
+    for (size_t i = 0; i < dstData.size(); ++i) {
+        assert(dstData[i] == dstDataRef[i]);
+    }
+    std::cout << "testApplyThreads(" << numThreads << "): " << rg->weights.size() 
+              << " weights...OK\n";
+
+    // invalid number of threads
+    ier = mnt_regridedges3d_setNumberOfThreads(&rg, 0);
+    assert(ier != 0);
+
+    ier = mnt_regridedges3d_del(&rg);
+    assert(ier == 0);
+}
+
+void testLocators() {
+
+    int ier;
+    std::vector<double> srcVerts = createHexGrid(3, 0.0, 1.0);
+    std::vector<double> dstVerts = createHexGrid(2, 0.1, 0.9);
+    size_t numSrcCells = srcVerts.size() / 24;
+    size_t numDstCells = dstVerts.size() / 24;
+
+    // the octree and hierarchy locators must give the same weights as vtkCellLocator
+    const char* locTypes[] = {"vtk", "auto", "octree", "bvh"};
+    std::map< std::pair<vtkIdType, vtkIdType>, std::vector<double> > refWeights;
+    for (size_t i = 0; i < sizeof(locTypes)/sizeof(locTypes[0]); ++i) {
+        std::string locType(locTypes[i]);
+        RegridEdges3d_t* rg;
+        ier = mnt_regridedges3d_new(&rg);
+        assert(ier == 0);
+        ier = mnt_regridedges3d_setSrcPointsPtr(&rg, 8, numSrcCells, &srcVerts[0]);
+        assert(ier == 0);
+        ier = mnt_regridedges3d_setDstPointsPtr(&rg, 8, numDstCells, &dstVerts[0]);
+        assert(ier == 0);
+        ier = mnt_regridedges3d_setSrcLocatorType(&rg, locType.c_str(), (int) locType.size());
+        assert(ier == 0);
+        ier = mnt_regridedges3d_build(&rg, 8);
+        assert(ier == 0);
+        if (i == 0) {
+            refWeights = rg->weights;
+        }
+        assert(rg->weights.size() == refWeights.size());
+        for (std::map< std::pair<vtkIdType, vtkIdType>, std::vector<double> >::const_iterator 
+             it = rg->weights.begin(); it != rg->weights.end(); ++it) {
+            const std::vector<double>& ref = refWeights[it->first];
+            assert(ref.size() == it->second.size());
+            for (size_t k = 0; k < ref.size(); ++k) {
+                assert(std::abs(it->second[k] - ref[k]) < 1.e-12);
+            }
+        }
+        std::cout << "testLocators(" << locType << "): " << rg->weights.size() 
+                  << " weights...OK\n";
+        ier = mnt_regridedges3d_del(&rg);
+        assert(ier == 0);
+    }
+
+    // the 2d locators do not support hexahedra
+    RegridEdges3d_t* rg;
+    ier = mnt_regridedges3d_new(&rg);
+    assert(ier == 0);
+    ier = mnt_regridedges3d_setSrcPointsPtr(&rg, 8, numSrcCells, &srcVerts[0]);
+    assert(ier == 0);
+    ier = mnt_regridedges3d_setDstPointsPtr(&rg, 8, numDstCells, &dstVerts[0]);
+    assert(ier == 0);
+    ier = mnt_regridedges3d_setSrcLocatorType(&rg, "bins2d", 6);
+    assert(ier == 0);
+    ier = mnt_regridedges3d_build(&rg, 8);
+    assert(ier != 0);
+    ier = mnt_regridedges3d_setSrcLocatorType(&rg, "unknown", 7);
+    assert(ier != 0);
+    ier = mnt_regridedges3d_del(&rg);
+    assert(ier == 0);
+}
+
+void testLocatorCacheFile() {
+
+    int ier;
+    std::vector<double> srcVerts = createHexGrid(3, 0.0, 1.0);
+    std::vector<double> dstVerts = createHexGrid(2, 0.1, 0.9);
+    size_t numSrcCells = srcVerts.size() / 24;
+    size_t numDstCells = dstVerts.size() / 24;
+    const std::string cacheFile = "testRegridEdges3d_locator.bin";
+    std::remove(cacheFile.c_str());
+
+    // the first build saves the octree, the second loads it
+    std::map< std::pair<vtkIdType, vtkIdType>, std::vector<double> > refWeights;
+    for (int iter = 0; iter < 2; ++iter) {
+        RegridEdges3d_t* rg;
+        ier = mnt_regridedges3d_new(&rg);
+        assert(ier == 0);
+        ier = mnt_regridedges3d_setSrcPointsPtr(&rg, 8, numSrcCells, &srcVerts[0]);
+        assert(ier == 0);
+        ier = mnt_regridedges3d_setDstPointsPtr(&rg, 8, numDstCells, &dstVerts[0]);
+        assert(ier == 0);
+        ier = mnt_regridedges3d_setSrcLocatorType(&rg, "octree", 6);
+        assert(ier == 0);
+        ier = mnt_regridedges3d_setSrcLocatorCacheFile(&rg, cacheFile.c_str(), (int) cacheFile.size());
+        assert(ier == 0);
+        ier = mnt_regridedges3d_build(&rg, 8);
+        assert(ier == 0);
+
+        std::string kind;
+        ier = LocatorFile::getKind(cacheFile.c_str(), kind);
+        assert(ier == 0);
+        assert(kind == "mvtkCellLocator");
+
+        if (iter == 0) {
+            refWeights = rg->weights;
+        }
+        assert(rg->weights == refWeights);
+        std::cout << "testLocatorCacheFile(" << iter << "): " << rg->weights.size() 
+                  << " weights...OK\n";
+        ier = mnt_regridedges3d_del(&rg);
+        assert(ier == 0);
+    }
+}
+
+
+int main() {
+
+    testApplyThreads(1);
+    testApplyThreads(3);
+    testLocators();
+    testLocatorCacheFile();
+
+    return 0;
+}
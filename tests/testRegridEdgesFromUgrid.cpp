@@ -1,5 +1,8 @@
 #include <mntRegridEdges.h>
+#include <mntLocatorFactory.h>
+#include <mvtkCellLocator.h>
 #include <cmath>
+#include <algorithm>
 #undef NDEBUG // turn on asserts
 
 double streamFunc(const double p[]) {
@@ -275,6 +278,407 @@ void regridUniqueEdgeIdFieldTest(const std::string& testName, const std::string&
 
 }
 
+void regridMultithreadTest(const std::string& testName, const std::string& srcFile, const std::string& dstFile,
+                           int numThreads) {
+
+    int ier;
+    RegridEdges_t* rg[2];
+    int nthreads[] = {1, numThreads};
+
+    for (int i = 0; i < 2; ++i) {
+        ier = mnt_regridedges_new(&rg[i]);
+        assert(ier == 0);
+        ier = mnt_regridedges_loadSrcGrid(&rg[i], srcFile.c_str(), (int) srcFile.size());
+        assert(ier == 0);
+        ier = mnt_regridedges_loadDstGrid(&rg[i], dstFile.c_str(), (int) dstFile.size());
+        assert(ier == 0);
+        ier = mnt_regridedges_setNumberOfThreads(&rg[i], nthreads[i]);
+        assert(ier == 0);
+        ier = mnt_regridedges_build(&rg[i], 8);
+        assert(ier == 0);
+    }
+    std::cerr << testName << ": build with 1 and " << numThreads << " threads...OK\n";
+
+    // the weights must be the same, in the same order
+    assert(rg[0]->weights.size() > 0);
+    assert(rg[0]->weights == rg[1]->weights);
+    assert(rg[0]->weightDstCellIds == rg[1]->weightDstCellIds);
+    assert(rg[0]->weightDstFaceEdgeIds == rg[1]->weightDstFaceEdgeIds);
+    assert(rg[0]->weightSrcCellIds == rg[1]->weightSrcCellIds);
+    assert(rg[0]->weightSrcFaceEdgeIds == rg[1]->weightSrcFaceEdgeIds);
+    std::cerr << testName << ": " << rg[0]->weights.size() << " weights are identical...OK\n";
+
+    // the results must be the same bit for bit
+    size_t numSrcEdges, numDstEdges;
+    ier = mnt_regridedges_getNumSrcUniqueEdges(&rg[0], &numSrcEdges);
+    assert(ier == 0);
+    ier = mnt_regridedges_getNumDstUniqueEdges(&rg[0], &numDstEdges);
+    assert(ier == 0);
+    std::vector<double> srcData(numSrcEdges);
+    for (size_t i = 0; i < numSrcEdges; ++i) {
+        srcData[i] = sin(0.2*i) + 1.2;
+    }
+    std::vector<double> dstData0(numDstEdges);
+    std::vector<double> dstData1(numDstEdges);
+    ier = mnt_regridedges_applyUniqueEdge(&rg[0], &srcData[0], &dstData0[0]);
+    assert(ier == 0);
+    ier = mnt_regridedges_applyUniqueEdge(&rg[1], &srcData[0], &dstData1[0]);
+    assert(ier == 0);
+    assert(dstData0 == dstData1);
+
+    size_t numSrc = rg[0]->numSrcCells * rg[0]->numEdgesPerCell;
+    size_t numDst = rg[0]->numDstCells * rg[0]->numEdgesPerCell;
+    srcData.resize(numSrc);
+    for (size_t i = 0; i < numSrc; ++i) {
+        srcData[i] = sin(0.2*i) + 1.2;
+    }
+    dstData0.resize(numDst);
+    dstData1.resize(numDst);
+    ier = mnt_regridedges_applyCellEdge(&rg[0], &srcData[0], &dstData0[0]);
+    assert(ier == 0);
+    ier = mnt_regridedges_applyCellEdge(&rg[1], &srcData[0], &dstData1[0]);
+    assert(ier == 0);
+    assert(dstData0 == dstData1);
+    std::cerr << testName << ": applied weights are identical...OK\n";
+
+    // invalid number of threads
+    ier = mnt_regridedges_setNumberOfThreads(&rg[0], 0);
+    assert(ier != 0);
+
+    for (int i = 0; i < 2; ++i) {
+        ier = mnt_regridedges_del(&rg[i]);
+        assert(ier == 0);
+    }
+}
+
+void regridCellEdgeCsrTest(const std::string& testName, const std::string& srcFile, const std::string& dstFile) {
+
+    int ier;
+    RegridEdges_t* rg;
+
+    ier = mnt_regridedges_new(&rg);
+    assert(ier == 0);
+    ier = mnt_regridedges_loadSrcGrid(&rg, srcFile.c_str(), (int) srcFile.size());
+    assert(ier == 0);
+    ier = mnt_regridedges_loadDstGrid(&rg, dstFile.c_str(), (int) dstFile.size());
+    assert(ier == 0);
+    ier = mnt_regridedges_build(&rg, 8);
+    assert(ier == 0);
+
+    size_t numEdgesPerCell = rg->numEdgesPerCell;
+    size_t numSrc = rg->numSrcCells * numEdgesPerCell;
+    size_t numDst = rg->numDstCells * numEdgesPerCell;
+
+    // one row per dst cell edge, duplicates have been merged
+    assert(rg->cellEdgeRowPtr.size() == numDst + 1);
+    assert(rg->cellEdgeWeights.size() <= rg->weights.size());
+    for (size_t row = 0; row < numDst; ++row) {
+        for (size_t k = rg->cellEdgeRowPtr[row] + 1; k < rg->cellEdgeRowPtr[row + 1]; ++k) {
+            assert(rg->cellEdgeSrcIds[k - 1] < rg->cellEdgeSrcIds[k]);
+        }
+    }
+    std::cerr << testName << ": " << rg->weights.size() << " weights -> " 
+              << rg->cellEdgeWeights.size() << " CSR entries\n";
+
+    std::vector<double> srcData(numSrc);
+    for (size_t i = 0; i < numSrc; ++i) {
+        srcData[i] = sin(0.1*i) + 0.5;
+    }
+
+    // reference, computed from the weights
+    std::vector<double> dstDataRef(numDst, 0.0);
+    for (size_t i = 0; i < rg->weights.size(); ++i) {
+        size_t dstK = rg->weightDstFaceEdgeIds[i] + numEdgesPerCell * rg->weightDstCellIds[i];
+        size_t srcK = rg->weightSrcFaceEdgeIds[i] + numEdgesPerCell * rg->weightSrcCellIds[i];
+        dstDataRef[dstK] += rg->weights[i] * srcData[srcK];
+    }
+
+    std::vector<double> dstData(numDst, -1.0);
+    ier = mnt_regridedges_applyCellEdge(&rg, &srcData[0], &dstData[0]);
+    assert(ier == 0);
+
+    double maxError = 0.0;
+    for (size_t i = 0; i < numDst; ++i) {
+        maxError = std::max(maxError, std::abs(dstData[i] - dstDataRef[i]));
+    }
+    std::cerr << testName << ": max error " << maxError << '\n';
+    assert(maxError < 1.e-12);
+
+    ier = mnt_regridedges_del(&rg);
+    assert(ier == 0);
+}
+
+void regridUniqueEdgeOperatorTest(const std::string& testName, const std::string& srcFile, const std::string& dstFile) {
+
+    int ier;
+    RegridEdges_t* rg;
+
+    ier = mnt_regridedges_new(&rg);
+    assert(ier == 0);
+    ier = mnt_regridedges_loadSrcGrid(&rg, srcFile.c_str(), (int) srcFile.size());
+    assert(ier == 0);
+    ier = mnt_regridedges_loadDstGrid(&rg, dstFile.c_str(), (int) dstFile.size());
+    assert(ier == 0);
+    ier = mnt_regridedges_build(&rg, 8);
+    assert(ier == 0);
+
+    size_t numSrcEdges, numDstEdges;
+    ier = mnt_regridedges_getNumSrcUniqueEdges(&rg, &numSrcEdges);
+    assert(ier == 0);
+    ier = mnt_regridedges_getNumDstUniqueEdges(&rg, &numDstEdges);
+    assert(ier == 0);
+    // built on first use
+    assert(rg->uniqueEdgeRowPtr.size() == 0);
+
+    std::vector<double> srcData(numSrcEdges);
+    for (size_t i = 0; i < numSrcEdges; ++i) {
+        srcData[i] = cos(0.3*i) + 1.5;
+    }
+
+    // reference, with the signs and multiplicity computed on the fly
+    std::vector<double> dstDataRef(numDstEdges, 0.0);
+    std::vector<double> dstMultiplicity(numDstEdges, 0.0);
+    for (size_t i = 0; i < rg->weights.size(); ++i) {
+        vtkIdType srcEdgeId, dstEdgeId;
+        int srcEdgeSign, dstEdgeSign;
+        ier = mnt_grid_getEdgeId(&rg->srcGridObj, rg->weightSrcCellIds[i], rg->weightSrcFaceEdgeIds[i], 
+                                 &srcEdgeId, &srcEdgeSign);
+        ier = mnt_grid_getEdgeId(&rg->dstGridObj, rg->weightDstCellIds[i], rg->weightDstFaceEdgeIds[i], 
+                                 &dstEdgeId, &dstEdgeSign);
+        double w = srcEdgeSign * dstEdgeSign * rg->weights[i];
+        dstDataRef[dstEdgeId] += w * srcData[srcEdgeId];
+        dstMultiplicity[dstEdgeId] += w;
+    }
+
+    std::vector<double> dstData(numDstEdges);
+    ier = mnt_regridedges_applyUniqueEdge(&rg, &srcData[0], &dstData[0]);
+    assert(ier == 0);
+    assert(rg->uniqueEdgeRowPtr.size() == numDstEdges + 1);
+
+    double maxError = 0.0;
+    for (size_t i = 0; i < numDstEdges; ++i) {
+        maxError = std::max(maxError, std::abs(dstData[i] - dstDataRef[i]/dstMultiplicity[i]));
+    }
+    std::cerr << testName << ": " << rg->uniqueEdgeWeights.size() << " unique edge weights, max error " 
+              << maxError << '\n';
+    assert(maxError < 1.e-12);
+
+    ier = mnt_regridedges_del(&rg);
+    assert(ier == 0);
+}
+
+void regridBatchTest(const std::string& testName, const std::string& srcFile, const std::string& dstFile) {
+
+    int ier;
+    RegridEdges_t* rg;
+
+    ier = mnt_regridedges_new(&rg);
+    assert(ier == 0);
+    ier = mnt_regridedges_loadSrcGrid(&rg, srcFile.c_str(), (int) srcFile.size());
+    assert(ier == 0);
+    ier = mnt_regridedges_loadDstGrid(&rg, dstFile.c_str(), (int) dstFile.size());
+    assert(ier == 0);
+    ier = mnt_regridedges_build(&rg, 8);
+    assert(ier == 0);
+    // the default locator, without cache file
+    assert(LocatorFactory::getName(rg->srcLoc) == "vtk");
+
+    size_t numSrcUniqueEdges, numDstUniqueEdges;
+    ier = mnt_regridedges_getNumSrcUniqueEdges(&rg, &numSrcUniqueEdges);
+    assert(ier == 0);
+    ier = mnt_regridedges_getNumDstUniqueEdges(&rg, &numDstUniqueEdges);
+    assert(ier == 0);
+
+    // cell by cell and unique edge fields
+    for (int unique = 0; unique < 2; ++unique) {
+
+        size_t numSrc = unique? numSrcUniqueEdges: rg->numSrcCells * rg->numEdgesPerCell;
+        size_t numDst = unique? numDstUniqueEdges: rg->numDstCells * rg->numEdgesPerCell;
+        const int nfields = 3;
+
+        // reference, one field at a time. Field f is stored at [f*num, (f + 1)*num)
+        std::vector<double> srcData(nfields * numSrc);
+        std::vector<double> dstDataRef(nfields * numDst);
+        for (int f = 0; f < nfields; ++f) {
+            for (size_t i = 0; i < numSrc; ++i) {
+                srcData[f*numSrc + i] = sin(0.1*i + f) + 2.0;
+            }
+            if (unique) {
+                ier = mnt_regridedges_applyUniqueEdge(&rg, &srcData[f*numSrc], &dstDataRef[f*numDst]);
+            }
+            else {
+                ier = mnt_regridedges_applyCellEdge(&rg, &srcData[f*numSrc], &dstDataRef[f*numDst]);
+            }
+            assert(ier == 0);
+        }
+
+        // field fastest and edge fastest layouts
+        for (int fieldFastest = 0; fieldFastest < 2; ++fieldFastest) {
+
+            std::vector<double> srcBatch(nfields * numSrc);
+            std::vector<double> dstBatch(nfields * numDst);
+            for (int f = 0; f < nfields; ++f) {
+                for (size_t i = 0; i < numSrc; ++i) {
+                    size_t k = fieldFastest? f + nfields*i: i + numSrc*f;
+                    srcBatch[k] = srcData[f*numSrc + i];
+                }
+            }
+
+            if (unique) {
+                ier = mnt_regridedges_applyUniqueEdgeBatch(&rg, nfields, fieldFastest, 
+                                                           &srcBatch[0], &dstBatch[0]);
+            }
+            else {
+                ier = mnt_regridedges_applyCellEdgeBatch(&rg, nfields, fieldFastest, 
+                                                         &srcBatch[0], &dstBatch[0]);
+            }
+            assert(ier == 0);
+
+            // must be the same bit for bit
+            for (int f = 0; f < nfields; ++f) {
+                for (size_t i = 0; i < numDst; ++i) {
+                    size_t k = fieldFastest? f + nfields*i: i + numDst*f;
+                    assert(dstBatch[k] == dstDataRef[f*numDst + i]);
+                }
+            }
+            std::cerr << testName << ": unique = " << unique << " fieldFastest = " << fieldFastest << "...OK\n";
+        }
+    }
+
+    // weights loaded without the destination grid: the number of dst edges, hence the
+    // stride between fields in the edge fastest layout, is unknown
+    const std::string weightFile = testName + "_weights.nc";
+    ier = mnt_regridedges_dumpWeights(&rg, weightFile.c_str(), (int) weightFile.size());
+    assert(ier == 0);
+    RegridEdges_t* rg2;
+    ier = mnt_regridedges_new(&rg2);
+    assert(ier == 0);
+    ier = mnt_regridedges_loadSrcGrid(&rg2, srcFile.c_str(), (int) srcFile.size());
+    assert(ier == 0);
+    ier = mnt_regridedges_loadWeights(&rg2, weightFile.c_str(), (int) weightFile.size());
+    assert(ier == 0);
+    std::vector<double> srcBatch(3 * rg->numSrcCells * rg->numEdgesPerCell, 1.0);
+    std::vector<double> dstBatch(3 * rg->numDstCells * rg->numEdgesPerCell);
+    ier = mnt_regridedges_applyCellEdgeBatch(&rg2, 3, 0, &srcBatch[0], &dstBatch[0]);
+    assert(ier != 0);
+    ier = mnt_regridedges_applyCellEdgeBatch(&rg2, 3, 1, &srcBatch[0], &dstBatch[0]);
+    assert(ier == 0);
+    ier = mnt_regridedges_del(&rg2);
+    assert(ier == 0);
+
+    ier = mnt_regridedges_del(&rg);
+    assert(ier == 0);
+}
+
+
+void regridLocatorTest(const std::string& testName, const std::string& srcFile, const std::string& dstFile) {
+
+    int ier;
+    const char* locTypes[] = {"auto", "vtk", "octree", "bins2d", "bvh", "structured"};
+    const int numLocTypes = sizeof(locTypes)/sizeof(locTypes[0]);
+    std::vector<double> refData;
+
+    for (int i = 0; i < numLocTypes; ++i) {
+        std::string locType(locTypes[i]);
+        RegridEdges_t* rg;
+        ier = mnt_regridedges_new(&rg);
+        assert(ier == 0);
+        ier = mnt_regridedges_loadSrcGrid(&rg, srcFile.c_str(), (int) srcFile.size());
+        assert(ier == 0);
+        ier = mnt_regridedges_loadDstGrid(&rg, dstFile.c_str(), (int) dstFile.size());
+        assert(ier == 0);
+        ier = mnt_regridedges_setNumberOfThreads(&rg, 2);
+        assert(ier == 0);
+        ier = mnt_regridedges_setSrcLocatorType(&rg, locType.c_str(), (int) locType.size());
+        assert(ier == 0);
+        ier = mnt_regridedges_build(&rg, 8);
+        assert(ier == 0);
+
+        size_t numSrcEdges, numDstEdges;
+        ier = mnt_regridedges_getNumSrcUniqueEdges(&rg, &numSrcEdges);
+        assert(ier == 0);
+        ier = mnt_regridedges_getNumDstUniqueEdges(&rg, &numDstEdges);
+        assert(ier == 0);
+        std::vector<double> srcData(numSrcEdges);
+        for (size_t j = 0; j < numSrcEdges; ++j) {
+            srcData[j] = sin(0.2*j) + 1.2;
+        }
+        std::vector<double> dstData(numDstEdges);
+        ier = mnt_regridedges_applyUniqueEdge(&rg, &srcData[0], &dstData[0]);
+        assert(ier == 0);
+
+        // all the locators must produce the same regridded field
+        if (i == 0) {
+            refData = dstData;
+        }
+        double error = 0;
+        for (size_t j = 0; j < numDstEdges; ++j) {
+            error = std::max(error, std::abs(dstData[j] - refData[j]));
+        }
+        std::cerr << testName << ": locator " << locType << " max error = " << error << '\n';
+        assert(error < 1.e-10);
+
+        ier = mnt_regridedges_del(&rg);
+        assert(ier == 0);
+    }
+
+    // invalid locator name
+    RegridEdges_t* rg;
+    ier = mnt_regridedges_new(&rg);
+    assert(ier == 0);
+    ier = mnt_regridedges_setSrcLocatorType(&rg, "kdtree", 6);
+    assert(ier != 0);
+    ier = mnt_regridedges_del(&rg);
+    assert(ier == 0);
+}
+
+void regridLocatorThreadsTest(const std::string& testName, const std::string& srcFile, 
+                              const std::string& dstFile, const std::string& locType) {
+
+    int ier;
+    const int nthreads[] = {1, 2, 3, 4, 7};
+    const int numCases = sizeof(nthreads)/sizeof(nthreads[0]);
+    RegridEdges_t* rg[numCases];
+
+    for (int i = 0; i < numCases; ++i) {
+        ier = mnt_regridedges_new(&rg[i]);
+        assert(ier == 0);
+        ier = mnt_regridedges_loadSrcGrid(&rg[i], srcFile.c_str(), (int) srcFile.size());
+        assert(ier == 0);
+        ier = mnt_regridedges_loadDstGrid(&rg[i], dstFile.c_str(), (int) dstFile.size());
+        assert(ier == 0);
+        ier = mnt_regridedges_setNumberOfThreads(&rg[i], nthreads[i]);
+        assert(ier == 0);
+        ier = mnt_regridedges_setSrcLocatorType(&rg[i], locType.c_str(), (int) locType.size());
+        assert(ier == 0);
+        ier = mnt_regridedges_build(&rg[i], 8);
+        assert(ier == 0);
+
+        // the threads share the locator
+        assert(LocatorFactory::getName(rg[i]->srcLoc) == locType);
+        assert(LocatorFactory::hasConcurrentQueries(rg[i]->srcLoc));
+        if (locType == "octree") {
+            // the octree buckets are filled with the regridder's threads
+            assert(dynamic_cast<mvtkCellLocator*>(rg[i]->srcLoc)->GetNumberOfThreads() == nthreads[i]);
+        }
+
+        // the weights must be the same, in the same order, for any number of threads
+        assert(rg[i]->weights.size() > 0);
+        assert(rg[i]->weights == rg[0]->weights);
+        assert(rg[i]->weightDstCellIds == rg[0]->weightDstCellIds);
+        assert(rg[i]->weightDstFaceEdgeIds == rg[0]->weightDstFaceEdgeIds);
+        assert(rg[i]->weightSrcCellIds == rg[0]->weightSrcCellIds);
+        assert(rg[i]->weightSrcFaceEdgeIds == rg[0]->weightSrcFaceEdgeIds);
+        std::cerr << testName << ": locator " << locType << " with " << nthreads[i] 
+                  << " threads, " << rg[i]->weights.size() << " weights are identical...OK\n";
+    }
+
+    for (int i = 0; i < numCases; ++i) {
+        ier = mnt_regridedges_del(&rg[i]);
+        assert(ier == 0);
+    }
+}
+
 
 int main() {
 
@@ -289,5 +693,18 @@ int main() {
 
     regridCellEdgeFieldTest("uniqueEdgeIdField_16->4", "@CMAKE_SOURCE_DIR@/data/cs_16.nc", "@CMAKE_SOURCE_DIR@/data/cs_4.nc"); 
 
+    regridCellEdgeCsrTest("csr_16->4", "@CMAKE_SOURCE_DIR@/data/cs_16.nc", "@CMAKE_SOURCE_DIR@/data/cs_4.nc");
+
+    regridUniqueEdgeOperatorTest("uniqueEdgeOperator_16->4", "@CMAKE_SOURCE_DIR@/data/cs_16.nc", "@CMAKE_SOURCE_DIR@/data/cs_4.nc");
+
+    regridBatchTest("batch_16->4", "@CMAKE_SOURCE_DIR@/data/cs_16.nc", "@CMAKE_SOURCE_DIR@/data/cs_4.nc");
+
+    regridMultithreadTest("multithread_16->4", "@CMAKE_SOURCE_DIR@/data/cs_16.nc", "@CMAKE_SOURCE_DIR@/data/cs_4.nc", 3);
+
+    regridLocatorTest("locator_16->4", "@CMAKE_SOURCE_DIR@/data/cs_16.nc", "@CMAKE_SOURCE_DIR@/data/cs_4.nc");
+
+    regridLocatorThreadsTest("octreeThreads_16->4", "@CMAKE_SOURCE_DIR@/data/cs_16.nc", 
+                             "@CMAKE_SOURCE_DIR@/data/cs_4.nc", "octree");
+
     return 0;
 }   
@@ -4,7 +4,7 @@
 #include <mntPolysegmentIter.h>
 #include <CmdLineArgParser.h>
 #include <vtkUnstructuredGrid.h>
-#include <vtkCellLocator.h>
+#include <mntLocatorFactory.h>
 #include <vtkCellData.h>
 #include <string>
 #include <iostream>
@@ -22,6 +22,9 @@ int main(int argc, char** argv) {
     args.set("-xline", std::string("180./4. + 0.2*180.*cos(5*pi*t/3. - 0.2)/pi"), "Parametric x coordinate (lon in [rad]) expression of 0 <= t <= 1");
     args.set("-yline", std::string("180./4. + 0.2*180.*sin(5*pi*t/3. - 0.2)/pi"), "Parametric y coordinate (lat in [rad]) expression of 0 <= t <= 1");
     args.set("-nline", 2, "Number of points defining the line (>= 2)");
+    args.set("-N", 25, "Average number of cells per bucket");
+    args.set("-locator", std::string(""), "Cell locator: auto, vtk, octree, bins2d, bvh or structured (default: vtk, auto with -cache)");
+    args.set("-cache", std::string(""), "Cell locator file, read if it matches the grid and written otherwise");
 
 
     bool success = args.parse(argc, argv);
@@ -63,6 +66,12 @@ int main(int argc, char** argv) {
             std::cerr << "ERROR: need at least two points to create a path\n";
             return 2;
         }
+        std::string locType = args.get<std::string>("-locator");
+        if (locType.size() != 0 && !LocatorFactory::isValid(locType)) {
+            std::cerr << "ERROR: unknown locator " << locType << " (-locator), valid names are "
+                      << LocatorFactory::getNames() << '\n';
+            return 4;
+        }
 
         std::cout << "Start point " << (*xs)[0] << " [deg east], " << (*ys)[0] << " [deg north] -> End point " 
                   << (*xs)[nline - 1] << " [deg east], " << (*ys)[nline -1] << " [deg north]\n";
@@ -87,13 +96,24 @@ int main(int argc, char** argv) {
         }
         double* srcData = (double*) aa->GetVoidPointer(0);
 
-        // build locator
-        vtkCellLocator* loc = vtkCellLocator::New();
-        loc->SetDataSet(grid);
-        loc->BuildLocator();
+        // build locator, or load it from the cache file
+        std::string cacheFile = args.get<std::string>("-cache");
+        if (locType.size() == 0) {
+            locType = LocatorFactory::getDefaultName(grid, cacheFile.size() != 0);
+        }
+        vtkAbstractCellLocator* loc = LocatorFactory::createCached(locType, grid, args.get<int>("-N"),
+                                                                   cacheFile);
+        if (!loc) {
+            std::cerr << "ERROR: locator " << locType << " does not support the grid\n";
+            mnt_grid_del(&srcGrid);
+            return 5;
+        }
 
         double flux = 0.0;
 
+        // breaks the segments into sub-segments
+        PolysegmentIter polyseg(grid, loc);
+
         // iterate over segments
         for (size_t ip0 = 0; ip0 < ts.size() - 1; ++ip0) {
 
@@ -102,7 +122,7 @@ int main(int argc, char** argv) {
             size_t ip1 = ip0 + 1;
             double p1[] = {(*xs)[ip1], (*ys)[ip1], 0.};
 
-            PolysegmentIter polyseg(grid, loc, p0, p1);
+            polyseg.setLine(p0, p1);
 
             size_t numSubSegs = polyseg.getNumberOfSegments();
             polyseg.reset();
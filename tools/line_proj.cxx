@@ -4,7 +4,7 @@
 #include <mntPolysegmentIter.h>
 #include <CmdLineArgParser.h>
 #include <vtkUnstructuredGrid.h>
-#include <vtkCellLocator.h>
+#include <mntLocatorFactory.h>
 #include <vtkCellData.h>
 #include <string>
 #include <iostream>
@@ -24,6 +24,8 @@ int main(int argc, char** argv) {
     args.set("-p", std::string("(0., 0.),(6.283185307179586, 0.)"), "Points defining the path.");
     args.set("-v", std::string("edgeData"), "Edge variable name.");
     args.set("-N", 128, "Average number of cells per bucket.");
+    args.set("-locator", std::string(""), "Cell locator: auto, vtk, octree, bins2d, bvh or structured (default: vtk, auto with -cache).");
+    args.set("-cache", std::string(""), "Cell locator file, read if it matches the grid and written otherwise.");
     args.set("-verbose", false, "Verbose mode.");
 
     bool success = args.parse(argc, argv);
@@ -45,6 +47,12 @@ int main(int argc, char** argv) {
             std::cerr << "ERROR: must specify a source grid file (-i)\n";
             return 1;
         }
+        std::string locType = args.get<std::string>("-locator");
+        if (locType.size() != 0 && !LocatorFactory::isValid(locType)) {
+            std::cerr << "ERROR: unknown locator " << locType << " (-locator), valid names are "
+                      << LocatorFactory::getNames() << '\n';
+            return 4;
+        }
         if (npts < 2) {
             std::cerr << "ERROR: must have at least two points\n";
             return 2;
@@ -73,15 +81,25 @@ int main(int argc, char** argv) {
 
         std::cout << "no of cells " << grid->GetNumberOfCells() << " no of points " << grid->GetNumberOfPoints() << '\n';
 
-        // build locator
-        vtkCellLocator* loc = vtkCellLocator::New();
-        loc->SetDataSet(grid);
-        loc->SetNumberOfCellsPerBucket(args.get<int>("-N"));
-        loc->BuildLocator();
+        // build locator, or load it from the cache file
+        std::string cacheFile = args.get<std::string>("-cache");
+        if (locType.size() == 0) {
+            locType = LocatorFactory::getDefaultName(grid, cacheFile.size() != 0);
+        }
+        vtkAbstractCellLocator* loc = LocatorFactory::createCached(locType, grid, args.get<int>("-N"),
+                                                                   cacheFile);
+        if (!loc) {
+            std::cerr << "ERROR: locator " << locType << " does not support the grid\n";
+            mnt_grid_del(&srcGrid);
+            return 5;
+        }
 
         double totFlux = 0.0;
         vtkDataArray* arr = grid->GetCellData()->GetArray(args.get<std::string>("-v").c_str());
 
+        // breaks the segments into sub-segments
+        PolysegmentIter polyseg(grid, loc);
+
         // iterate over segments
         size_t nsegs = npts - 1;
         for (size_t iseg0 = 0; iseg0 < nsegs; ++iseg0) {
@@ -97,7 +115,7 @@ int main(int argc, char** argv) {
             }
             std::cout << ")\n";
 
-            PolysegmentIter polyseg(grid, loc, &points[iseg0][0], &points[iseg1][0]);
+            polyseg.setLine(&points[iseg0][0], &points[iseg1][0]);
 
             double fluxFromSegment = 0;
             size_t numSegs = polyseg.getNumberOfSegments();
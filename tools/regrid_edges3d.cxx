@@ -19,6 +19,9 @@ int main(int argc, char** argv) {
     args.set("-w", std::string(""), "Write interpolation weights to file");
     args.set("-o", std::string(""), "Specify output VTK file where regridded edge data is saved");
     args.set("-N", 1024, "Average number of cells per bucket");
+    args.set("-nthreads", 1, "Number of threads used to apply the weights");
+    args.set("-locator", std::string(""), "Source grid locator: auto, vtk, octree or bvh (default: vtk, octree with -cache)");
+    args.set("-cache", std::string(""), "Source grid locator file, read if it matches the source grid and written otherwise");
 
     bool success = args.parse(argc, argv);
     bool help = args.get<bool>("-h");
@@ -62,6 +65,17 @@ int main(int argc, char** argv) {
         if (ier != 0) return 1;
         ier = mnt_regridedges3d_setDstGrid(&rge, dg);
         if (ier != 0) return 2;
+        ier = mnt_regridedges3d_setNumberOfThreads(&rge, args.get<int>("-nthreads"));
+        if (ier != 0) return 4;
+        std::string locType = args.get<std::string>("-locator");
+        if (locType.size() != 0) {
+            ier = mnt_regridedges3d_setSrcLocatorType(&rge, locType.c_str(), (int) locType.size());
+            if (ier != 0) return 5;
+        }
+        std::string cacheFile = args.get<std::string>("-cache");
+        if (cacheFile.size() != 0) {
+            mnt_regridedges3d_setSrcLocatorCacheFile(&rge, cacheFile.c_str(), (int) cacheFile.size());
+        }
         ier = mnt_regridedges3d_build(&rge, args.get<int>("-N"));
         if (ier != 0) return 3;
 